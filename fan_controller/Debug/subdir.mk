@@ -5,30 +5,87 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../adc.c \
+../command.c \
+../config.c \
+../crc.c \
 ../dcMotor.c \
+../eeprom.c \
+../energy.c \
+../error.c \
+../filter.c \
 ../gpio.c \
+../history.c \
 ../lcd.c \
 ../lm35.c \
 ../main.c \
-../pwm.c 
+../nvm.c \
+../predict.c \
+../probe.c \
+../pwm.c \
+../sensor.c \
+../sram.c \
+../telemetry.c \
+../timer.c \
+../trace.c \
+../uart.c \
+../vref.c \
+../watchdog.c 
 
 OBJS += \
 ./adc.o \
+./command.o \
+./config.o \
+./crc.o \
 ./dcMotor.o \
+./eeprom.o \
+./energy.o \
+./error.o \
+./filter.o \
 ./gpio.o \
+./history.o \
 ./lcd.o \
 ./lm35.o \
 ./main.o \
-./pwm.o 
+./nvm.o \
+./predict.o \
+./probe.o \
+./pwm.o \
+./sensor.o \
+./sram.o \
+./telemetry.o \
+./timer.o \
+./trace.o \
+./uart.o \
+./vref.o \
+./watchdog.o 
 
 C_DEPS += \
 ./adc.d \
+./command.d \
+./config.d \
+./crc.d \
 ./dcMotor.d \
+./eeprom.d \
+./energy.d \
+./error.d \
+./filter.d \
 ./gpio.d \
+./history.d \
 ./lcd.d \
 ./lm35.d \
 ./main.d \
-./pwm.d 
+./nvm.d \
+./predict.d \
+./probe.d \
+./pwm.d \
+./sensor.d \
+./sram.d \
+./telemetry.d \
+./timer.d \
+./trace.d \
+./uart.d \
+./vref.d \
+./watchdog.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
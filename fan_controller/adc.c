@@ -13,11 +13,18 @@
 #include<avr/io.h>
 #include<avr/interrupt.h>
 #include"common_macros.h"
+#include"trace.h"
+
+#define ADC_BANDGAP_MUX				0x1E /*1.22V VBG in ADMUX*/
 
 /*Global Variables */
 volatile static uint16 * ADC_g_digitalValue = NULL_PTR;
 volatile static uint8 * ADC_g_doneFlag = NULL_PTR;
 static uint8 ADC_g_initialized = FALSE;
+static ADC_WorkingModeType ADC_g_mode = ADC_POLLING;
+volatile static ADC_CallbackType ADC_g_autoCallback = NULL_PTR; /*NULL_PTR -> no auto trigger*/
+static uint8 ADC_g_autoChannel = 0;
+static ADC_TriggerType ADC_g_autoTrigger = ADC_TRIGGER_FREE_RUNNING;
 
 /*
  * @brief will be called once the ADC module finish reading a channel
@@ -25,8 +32,22 @@ static uint8 ADC_g_initialized = FALSE;
 ISR(ADC_vect)
 {
 	/*ADC flag is being cleared automatically*/
+	TRACE_EVENT(TRACE_ADC_ISR, ADC);
 
-	if(ADC_g_digitalValue != NULL_PTR && ADC_g_doneFlag != NULL_PTR )
+	if(ADC_g_autoCallback != NULL_PTR)
+	{
+		/*The trigger is the rising edge of the timer flag, clear it for the next event*/
+		if(ADC_g_autoTrigger == ADC_TRIGGER_TIMER0_OVERFLOW)
+		{
+			TIFR = (1 << TOV0);
+		}
+		else if(ADC_g_autoTrigger == ADC_TRIGGER_TIMER0_COMPARE)
+		{
+			TIFR = (1 << OCF0);
+		}
+		ADC_g_autoCallback(ADC);
+	}
+	else if(ADC_g_digitalValue != NULL_PTR && ADC_g_doneFlag != NULL_PTR )
 	{
 		/*To prevent a run-time error is some cases */
 		*ADC_g_digitalValue = ADC; /*save the digital value in the user passed variable */
@@ -38,6 +59,120 @@ ISR(ADC_vect)
 
 }
 
+/*
+ * @brief select the auto triggered channel and enable the trigger and the interrupt
+ * */
+static void ADC_resumeAutoTrigger(void)
+{
+	ADMUX = (ADMUX & 0xE0) | (ADC_g_autoChannel & 0x1F);
+	SFIOR = (SFIOR & ~((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0))) | (ADC_g_autoTrigger << ADTS0);
+	if(ADC_g_autoTrigger == ADC_TRIGGER_TIMER0_OVERFLOW)
+	{
+		TIFR = (1 << TOV0);/*only the next event starts a conversion*/
+	}
+	else if(ADC_g_autoTrigger == ADC_TRIGGER_TIMER0_COMPARE)
+	{
+		TIFR = (1 << OCF0);
+	}
+	/*writing one to ADIF clears the flag of the last polling read*/
+	ADCSRA |= (1 << ADIF) | (1 << ADATE) | (1 << ADIE);
+	if(ADC_g_autoTrigger == ADC_TRIGGER_FREE_RUNNING)
+	{
+		SET_BIT(ADCSRA, ADSC);
+	}
+}
+
+/*
+ * @brief wait for a bit of ADCSRA to reach a level
+ *
+ * @return uint8 FALSE if it did not within ADC_TIMEOUT_LOOPS
+ * */
+static uint8 ADC_waitFlag(uint8 a_bit, uint8 a_level)
+{
+	uint16 loops = 0;
+
+	while(GET_BIT(ADCSRA, a_bit) != a_level)
+	{
+		loops++;
+		if(loops >= ADC_TIMEOUT_LOOPS)
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * @brief disable the trigger and the interrupt and wait for a started conversion
+ *
+ * @return uint8 FALSE if the conversion never ended
+ * */
+static uint8 ADC_pauseAutoTrigger(void)
+{
+	uint8 ended = FALSE;
+
+	ADCSRA &= ~((1 << ADATE) | (1 << ADIE) | (1 << ADIF));
+	ended = ADC_waitFlag(ADSC, 0); /*a running conversion can not be stopped*/
+	SET_BIT(ADCSRA, ADIF); /*its result must not end the next polling read*/
+	return ended;
+}
+
+/*
+ * @brief convert a MUX selection a number of times in the polling mode and give the last result,
+ * the auto triggered channel gives the ADC for these conversions
+ *
+ * @return ADC_ErrorType ADC_ERROR_TIMEOUT if a conversion never ended
+ * */
+static ADC_ErrorType ADC_convertPolling(uint8 a_mux, uint8 a_conversions, uint16 * a_result)
+{
+	uint8 ended = TRUE;
+
+	if(ADC_g_autoCallback != NULL_PTR)
+	{
+		ended = ADC_pauseAutoTrigger();
+	}
+	ADMUX = (ADMUX & 0xE0) | (a_mux & 0x1F) ; /*Selecting the channel from the argument*/
+	while(a_conversions > 0 && ended)
+	{
+		SET_BIT(ADCSRA,  ADSC);/*starting the adc*/
+		ended = ADC_waitFlag(ADIF, 1); /* polling until the reading is over*/
+		SET_BIT(ADCSRA, ADIF); /*Clear the ADC flag by writing 1 to it*/
+		a_conversions--;
+	}
+	*a_result = ADC; /*save the read value*/
+	if(ADC_g_autoCallback != NULL_PTR)
+	{
+		ADC_resumeAutoTrigger();
+	}
+	return ended ? ADC_SUCCESS : ERROR_record(ADC_ERROR_TIMEOUT);
+}
+
+/*
+ * @brief return the MUX value of a differential pair at a gain, 0 if the ATmega32 has no such pair
+ * */
+static uint8 ADC_getDifferentialMux(uint8 a_positive, uint8 a_negative, ADC_GainType a_gain)
+{
+	if(a_gain == ADC_GAIN_1X)
+	{
+		/*every channel against ADC1, ADC0 -> ADC5 against ADC2*/
+		if(a_negative == 1 && a_positive < ADC_CHANNELS)
+		{
+			return 0x10 + a_positive;
+		}
+		if(a_negative == 2 && a_positive <= 5)
+		{
+			return 0x18 + a_positive;
+		}
+		return 0;
+	}
+	/*ADC0 or ADC1 against ADC0 and ADC2 or ADC3 against ADC2, with 10x or 200x*/
+	if((a_negative != 0 && a_negative != 2) || a_positive < a_negative || a_positive > a_negative + 1)
+	{
+		return 0;
+	}
+	return 0x08 + (a_negative == 2 ? 4 : 0) + (a_gain == ADC_GAIN_200X ? 2 : 0) + (a_positive - a_negative);
+}
+
 /*
  * @brief initialize the ADC module
  *
@@ -60,6 +195,8 @@ void ADC_init(const ADC_configType * a_config)
 	 * Apply the working mode (polling or interrupt)
 	 * */
 	ADCSRA = (1 << ADEN) | (a_config->prescaler << ADPS0) | (a_config->mode << ADIE);
+	ADC_g_mode = a_config->mode;
+	ADC_g_autoCallback = NULL_PTR;
 
 	if(a_config->mode == ADC_INTERRUPT)
 	{
@@ -84,6 +221,8 @@ void ADC_Deinit(void)
 	ADCSRA = 0; /*Disabling the ADC module*/
 	ADC_g_digitalValue = NULL_PTR;/*reset to the initial value */
 	ADC_g_doneFlag = NULL_PTR;/*reset to the initial value */
+	ADC_g_autoCallback = NULL_PTR;/*reset to the initial value */
+	ADC_g_mode = ADC_POLLING;/*reset to the initial value */
 	ADC_g_initialized = FALSE;/*reset to the initial value */
 }
 
@@ -115,7 +254,8 @@ uint8 ADC_isInitialized(void)
  * */
 uint8 ADC_isPolling(void)
 {
-	return GET_BIT(ADCSRA, ADIE) == 0? TRUE:FALSE;
+	/*the auto trigger also sets ADIE, the mode of ADC_init is kept aside*/
+	return ADC_g_mode == ADC_POLLING? TRUE:FALSE;
 }
 
 /*
@@ -136,35 +276,110 @@ uint8 ADC_readChannelPolling(uint8 a_channel, uint8 * a_doneFlag, uint16 * a_res
 	if(ADC_g_initialized == FALSE)
 	{
 		/*ADC module was not initialized */
-		return ADC_ERROR_NOT_INIT;
+		return ERROR_record(ADC_ERROR_NOT_INIT);
 	}
 	if(ADC_isPolling() == FALSE)
 	{
 		/*the user is trying to use interrupt mode with polling mode*/
-		return ADC_ERROR_WRONG_MODE;
+		return ERROR_record(ADC_ERROR_WRONG_MODE);
 	}
 
 	/*Validate user input*/
 	if(a_channel >= ADC_CHANNELS)
 	{
 		/*User sent wrong channel */
-		return ADC_ERROR_WRONG_CHANNEL;
+		return ERROR_record(ADC_ERROR_WRONG_CHANNEL);
 	}
 	if(a_doneFlag == NULL_PTR || a_result == NULL_PTR)
 	{
 		/*The user sent a null pointer*/
-		return ADC_ERROR_NULL_PTR;
+		return ERROR_record(ADC_ERROR_NULL_PTR);
 	}
-	ADMUX = (ADMUX & 0xE0) | (a_channel & 0x1F) ; /*Selecting the channel from the argument*/
 	*a_doneFlag = ADC_CONVERSION_STARTED;	/*Indicate the conversion starting*/
-	SET_BIT(ADCSRA,  ADSC);/*starting the adc*/
-	while(GET_BIT(ADCSRA, ADIF) == 0); /* polling until the reading is over*/
-	SET_BIT(ADCSRA, ADIF); /*Clear the ADC flag by writing 1 to it*/
+	if(ADC_convertPolling(a_channel, 1, a_result) != ADC_SUCCESS)
+	{
+		return ADC_ERROR_TIMEOUT;/*the flag stays started, the result is not valid*/
+	}
 	*a_doneFlag = ADC_CONVERSION_COMPLETED;
-	*a_result = ADC; /*save the read value*/
 	return ADC_SUCCESS;/*The function handled the request successfully*/
 }
 
+/*
+ * @brief read the signed difference of two channels at a gain in the polling mode.
+ * The first conversion after selecting a gain is thrown away, the offset
+ * cancellation of the gain stage settles during it.
+ *
+ * @param a_positive the positive input
+ *
+ * @param a_negative the negative input
+ *
+ * @param a_gain ADC_GAIN_1X, ADC_GAIN_10X or ADC_GAIN_200X
+ *
+ * @param a_result a pointer to the result, ADC_DIFFERENTIAL_MIN -> ADC_DIFFERENTIAL_MAX
+ * with one code = ADC_VREF / (512 * gain)
+ *
+ * @return ADC_ErrorType ADC_ERROR_WRONG_CHANNEL for a pair the ATmega32 does not have at this gain
+ * */
+ADC_ErrorType ADC_readDifferentialPolling(uint8 a_positive, uint8 a_negative, ADC_GainType a_gain, sint16 * a_result)
+{
+	uint8 mux = 0;
+	uint16 code = 0;
+
+	if(ADC_g_initialized == FALSE)
+	{
+		return ERROR_record(ADC_ERROR_NOT_INIT);
+	}
+	if(ADC_isPolling() == FALSE)
+	{
+		return ERROR_record(ADC_ERROR_WRONG_MODE);
+	}
+	if(a_gain > ADC_GAIN_200X)
+	{
+		return ERROR_record(ADC_ERROR_WRONG_GAIN);
+	}
+	mux = ADC_getDifferentialMux(a_positive, a_negative, a_gain);
+	if(mux == 0)
+	{
+		return ERROR_record(ADC_ERROR_WRONG_CHANNEL);
+	}
+	if(a_result == NULL_PTR)
+	{
+		return ERROR_record(ADC_ERROR_NULL_PTR);
+	}
+	if(ADC_convertPolling(mux, (a_gain == ADC_GAIN_1X) ? 1 : 2, &code) != ADC_SUCCESS)
+	{
+		return ADC_ERROR_TIMEOUT;
+	}
+	/*10-bit two's complement*/
+	*a_result = (code > (uint16)ADC_DIFFERENTIAL_MAX) ? (sint16)code - (2 * (ADC_DIFFERENTIAL_MAX + 1)) : (sint16)code;
+	return ADC_SUCCESS;
+}
+
+/*
+ * @brief read the internal bandgap against the reference in the polling mode,
+ * the first conversion after selecting it is thrown away while it settles.
+ *
+ * @param a_result a pointer to the result, ADC_BANDGAP_CODE at the nominal ADC_VREF
+ *
+ * @return ADC_ErrorType
+ * */
+ADC_ErrorType ADC_readBandgapPolling(uint16 * a_result)
+{
+	if(ADC_g_initialized == FALSE)
+	{
+		return ERROR_record(ADC_ERROR_NOT_INIT);
+	}
+	if(ADC_isPolling() == FALSE)
+	{
+		return ERROR_record(ADC_ERROR_WRONG_MODE);
+	}
+	if(a_result == NULL_PTR)
+	{
+		return ERROR_record(ADC_ERROR_NULL_PTR);
+	}
+	return ADC_convertPolling(ADC_BANDGAP_MUX, 2, a_result);
+}
+
 /*
  * @brief start the ADC on the passed channel with interrupt mode.
  * the digital value read by the ADC module will be handled on ISR
@@ -183,24 +398,24 @@ uint8 ADC_readChannelInterrupt(uint8 a_channel, uint8 * a_doneFlag, uint16 * a_r
 	if(ADC_g_initialized == FALSE)
 	{
 		/*ADC module was not initialized */
-		return ADC_ERROR_NOT_INIT;
+		return ERROR_record(ADC_ERROR_NOT_INIT);
 	}
 	if(ADC_isPolling() == FALSE)
 	{
 		/*the user is trying to use interrupt mode with polling mode*/
-		return ADC_ERROR_WRONG_MODE;
+		return ERROR_record(ADC_ERROR_WRONG_MODE);
 	}
 
 	/*Validate user input*/
 	if(a_channel >= ADC_CHANNELS)
 	{
 		/*User sent wrong channel */
-		return ADC_ERROR_WRONG_CHANNEL;
+		return ERROR_record(ADC_ERROR_WRONG_CHANNEL);
 	}
 	if(a_doneFlag == NULL_PTR || a_result == NULL_PTR)
 	{
 		/*The user sent a null pointer*/
-		return ADC_ERROR_NULL_PTR;
+		return ERROR_record(ADC_ERROR_NULL_PTR);
 	}
 
 	ADMUX = (ADMUX & 0xE0) | (a_channel & 0x1F) ; /*Selecting the channel from the argument*/
@@ -212,4 +427,62 @@ uint8 ADC_readChannelInterrupt(uint8 a_channel, uint8 * a_doneFlag, uint16 * a_r
 	return ADC_SUCCESS;/*The function handled the request successfully*/
 }
 
+/*
+ * @brief convert a channel on every event of a trigger source in the polling mode,
+ * the result of every conversion is passed to the callback from the ADC ISR with the
+ * interrupts disabled so it must be short. A polling read of any channel pauses it
+ * for its own conversion, the events during the pause are missed.
+ *
+ * @param a_channel the channel to be converted
+ *
+ * @param a_trigger the event that starts each conversion
+ *
+ * @param a_callback the function to be called with each result
+ *
+ * @return uint8 to indicate the an error or a SUCCESS of the process.
+ * */
+ADC_ErrorType ADC_startAutoTrigger(uint8 a_channel, ADC_TriggerType a_trigger, ADC_CallbackType a_callback)
+{
+	uint8 sreg = 0;
+	/*validate the configurations*/
+	if(ADC_g_initialized == FALSE)
+	{
+		return ERROR_record(ADC_ERROR_NOT_INIT);
+	}
+	if(ADC_isPolling() == FALSE)
+	{
+		/*the ISR of the interrupt mode reads are used by the auto trigger*/
+		return ERROR_record(ADC_ERROR_WRONG_MODE);
+	}
+	if(a_channel >= ADC_CHANNELS)
+	{
+		return ERROR_record(ADC_ERROR_WRONG_CHANNEL);
+	}
+	if(a_callback == NULL_PTR)
+	{
+		return ERROR_record(ADC_ERROR_NULL_PTR);
+	}
+	sreg = SREG;
+	cli();
+	ADC_g_autoChannel = a_channel;
+	ADC_g_autoTrigger = a_trigger;
+	ADC_g_autoCallback = a_callback;
+	ADC_resumeAutoTrigger();
+	SREG = sreg;
+	return ADC_SUCCESS;
+}
 
+/*
+ * @brief stop the conversions of ADC_startAutoTrigger
+ *
+ * @return void
+ * */
+void ADC_stopAutoTrigger(void)
+{
+	if(ADC_g_autoCallback == NULL_PTR)
+	{
+		return;
+	}
+	ADC_pauseAutoTrigger();
+	ADC_g_autoCallback = NULL_PTR;
+}
@@ -15,21 +15,37 @@
 #define ADC_H_
 
 #include"std_types.h"
+#include"error.h"
 
 #define ADC_BITS					10
 #define ADC_MAX						1023 /* ( 2 to the power of ADC_BITS ) - 1 */
 #define ADC_CHANNELS				8
 #define ADC_CONVERSION_COMPLETED	LOGIC_HIGH
 #define ADC_CONVERSION_STARTED		LOGIC_LOW
-#define ADC_VREF					2.56
+#define ADC_VREF					2.56 /*nominal, the chips are within 2.3V -> 2.7V, see vref.h*/
+#define ADC_BANDGAP					1.22 /*V of the internal bandgap channel*/
+#define ADC_BANDGAP_CODE			488 /*ADC_BANDGAP * 1024 / ADC_VREF*/
+
+/*Errors, see error.h*/
+#define ADC_SUCCESS					ERROR_NONE
+#define ADC_ERROR_NOT_INIT			ERROR_CODE(ERROR_MODULE_ADC, 1)
+#define ADC_ERROR_WRONG_CHANNEL		ERROR_CODE(ERROR_MODULE_ADC, 2)
+#define ADC_ERROR_WRONG_MODE		ERROR_CODE(ERROR_MODULE_ADC, 3)
+#define ADC_ERROR_NULL_PTR			ERROR_CODE(ERROR_MODULE_ADC, 4)
+#define ADC_ERROR_WRONG_GAIN		ERROR_CODE(ERROR_MODULE_ADC, 5)
+#define ADC_ERROR_TIMEOUT			ERROR_CODE(ERROR_MODULE_ADC, 6)
 
-#define ADC_SUCCESS					0
-#define ADC_ERROR_NOT_INIT			ADC_SUCCESS + 1
-#define ADC_ERROR_WRONG_CHANNEL		ADC_ERROR_NOT_INIT + 1
-#define ADC_ERROR_WRONG_MODE		ADC_ERROR_WRONG_CHANNEL + 1
-#define ADC_ERROR_NULL_PTR			ADC_ERROR_WRONG_MODE + 1
+/*
+ * a conversion takes at most 25 ADC clocks of 128 CPU cycles and a polling loop
+ * at least one cycle, a flag still not set after this many loops will never be
+ */
+#define ADC_TIMEOUT_LOOPS			4000
+
+/*signed results of the differential channels*/
+#define ADC_DIFFERENTIAL_MIN		(-512)
+#define ADC_DIFFERENTIAL_MAX		511
 
-typedef uint8 ADC_ErrorType;
+typedef ERROR_CodeType ADC_ErrorType;
 
 typedef enum
 {
@@ -48,6 +64,20 @@ typedef enum
 	ADC_PRESCALER_128 = 7
 } ADC_prescalerType;
 
+/*Auto trigger sources, the values of ADTS2:0 in SFIOR*/
+typedef enum
+{
+	ADC_TRIGGER_FREE_RUNNING = 0, ADC_TRIGGER_TIMER0_COMPARE = 3, ADC_TRIGGER_TIMER0_OVERFLOW = 4
+} ADC_TriggerType;
+
+/*Gain of the differential channels*/
+typedef enum
+{
+	ADC_GAIN_1X, ADC_GAIN_10X, ADC_GAIN_200X
+} ADC_GainType;
+
+typedef void (*ADC_CallbackType)(uint16 a_result);
+
 typedef struct
 {
 	ADC_VrefType vref;
@@ -111,6 +141,38 @@ uint8 ADC_isPolling(void);
  * */
 ADC_ErrorType ADC_readChannelPolling(uint8 a_channel, uint8 * a_doneFlag, uint16 * a_result);
 
+/*
+ * @brief read the signed difference of two channels at a gain in the polling mode.
+ * The pairs of the ATmega32 are:
+ * 	1x		ADC0 -> ADC7 against ADC1, ADC0 -> ADC5 against ADC2
+ * 	10x, 200x	ADC0 or ADC1 against ADC0, ADC2 or ADC3 against ADC2
+ * A pair of a channel with itself measures the offset of the gain stage.
+ * The first conversion after selecting a gain is thrown away, the offset
+ * cancellation of the gain stage settles during it.
+ *
+ * @param a_positive the positive input
+ *
+ * @param a_negative the negative input
+ *
+ * @param a_gain ADC_GAIN_1X, ADC_GAIN_10X or ADC_GAIN_200X
+ *
+ * @param a_result a pointer to the result, ADC_DIFFERENTIAL_MIN -> ADC_DIFFERENTIAL_MAX
+ * with one code = ADC_VREF / (512 * gain)
+ *
+ * @return ADC_ErrorType ADC_ERROR_WRONG_CHANNEL for a pair the ATmega32 does not have at this gain
+ * */
+ADC_ErrorType ADC_readDifferentialPolling(uint8 a_positive, uint8 a_negative, ADC_GainType a_gain, sint16 * a_result);
+
+/*
+ * @brief read the internal bandgap against the reference in the polling mode,
+ * the first conversion after selecting it is thrown away while it settles.
+ *
+ * @param a_result a pointer to the result, ADC_BANDGAP_CODE at the nominal ADC_VREF
+ *
+ * @return ADC_ErrorType
+ * */
+ADC_ErrorType ADC_readBandgapPolling(uint16 * a_result);
+
 /*
  * @brief start the ADC on the passed channel with interrupt mode.
  * the digital value read by the ADC module will be handled on ISR
@@ -125,4 +187,27 @@ ADC_ErrorType ADC_readChannelPolling(uint8 a_channel, uint8 * a_doneFlag, uint16
  * */
 ADC_ErrorType ADC_readChannelInterrupt(uint8 a_channel, uint8 * a_doneFlag, uint16 * a_result);
 
+/*
+ * @brief convert a channel on every event of a trigger source in the polling mode,
+ * the result of every conversion is passed to the callback from the ADC ISR with the
+ * interrupts disabled so it must be short. A polling read of any channel pauses it
+ * for its own conversion, the events during the pause are missed.
+ *
+ * @param a_channel the channel to be converted
+ *
+ * @param a_trigger the event that starts each conversion
+ *
+ * @param a_callback the function to be called with each result
+ *
+ * @return uint8 to indicate the an error or a SUCCESS of the process.
+ * */
+ADC_ErrorType ADC_startAutoTrigger(uint8 a_channel, ADC_TriggerType a_trigger, ADC_CallbackType a_callback);
+
+/*
+ * @brief stop the conversions of ADC_startAutoTrigger
+ *
+ * @return void
+ * */
+void ADC_stopAutoTrigger(void);
+
 #endif /* ADC_H_ */
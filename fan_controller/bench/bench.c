@@ -0,0 +1,253 @@
+/*
+ *
+ * Module: Bench
+ *
+ * File Name: bench.c
+ *
+ * Description: Cycle count harness of the driver entry points, built with the
+ * firmware modules into its own image and run under simavr (see bench/Makefile).
+ *
+ * Every call is timed alone by Timer1 running at F_CPU with the interrupts
+ * disabled, so the counts are exact CPU cycles of the call and do not include
+ * the ISRs. The cost of the measurement itself is measured first on an empty
+ * case and removed from every result. A call must take less than 65536 cycles.
+ *
+ * The results are sent on the UART as CSV lines starting with "bench,":
+ * 	bench,name,calls,min,max,mean
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"../main.h"
+#include"../crc.h"
+#include"../adc.h"
+#include<avr/io.h>
+#include<avr/interrupt.h>
+#include<avr/sleep.h>
+#include<stdlib.h>
+
+#define BENCH_CALLS				32
+#define BENCH_OVERFLOW			0xFFFF
+#define BENCH_LINE_PREFIX		"bench,"
+
+typedef void (*BENCH_FunctionType)(uint8 a_call);
+
+typedef struct
+{
+	const char * name;
+	BENCH_FunctionType function;
+	uint8 calls;
+}BENCH_CaseType;
+
+/*Global Variables */
+static MAIN_StateType BENCH_g_state = {0, FAN_INIT, MAIN_NOT_DISPLAYED, MAIN_NOT_DISPLAYED, 0, 0, SENSOR_OK};
+static uint8 BENCH_g_buffer[16];
+static uint16 BENCH_g_overhead = 0;
+static FILTER_Type BENCH_g_filter;
+static PREDICT_Type BENCH_g_predict; /*full after the first calls, then the slope is computed*/
+
+static void BENCH_empty(uint8 a_call)
+{
+	(void)a_call;
+}
+
+static void BENCH_crc(uint8 a_call)
+{
+	(void)a_call;
+	(void)CRC16_update(0xFFFF, BENCH_g_buffer, sizeof(BENCH_g_buffer));
+}
+
+static void BENCH_getTemperature(uint8 a_call)
+{
+	(void)a_call;
+	(void)LM35_getTemperature();
+}
+
+static void BENCH_getFanSpeed(uint8 a_call)
+{
+	/*walk over the whole curve so every branch is taken*/
+	(void)MAIN_getFanSpeed(&CONFIG_get()->curve, LM35_FROM_DEGREES((uint8)(a_call * 4)));
+}
+
+static void BENCH_rotate(uint8 a_call)
+{
+	(void)DC_MOTOR_Rotate(DC_MOTOR_CW, (uint8)((a_call * 3) % (DC_MOTOR_MAX_SPEED + 1)));
+}
+
+static void BENCH_displayCharacter(uint8 a_call)
+{
+	LCD_displayCharacter((uint8)('0' + (a_call % 10)));
+}
+
+static void BENCH_intgerToString(uint8 a_call)
+{
+	LCD_intgerToString(a_call);
+}
+
+static void BENCH_sendTelemetry(uint8 a_call)
+{
+	MAIN_sendTelemetry(a_call, a_call, FAN_ON, DC_MOTOR_NO_ERROR);
+}
+
+static void BENCH_updateHistory(uint8 a_call)
+{
+	HISTORY_update((sint16)(a_call / 4), a_call);
+}
+
+static void BENCH_processCommand(uint8 a_call)
+{
+	(void)a_call;
+	COMMAND_process();
+}
+
+static void BENCH_checkSensor(uint8 a_call)
+{
+	/*healthy codes, the fault path is only taken by MAIN_sample*/
+	(void)SENSOR_check((uint16)(200 + (a_call & 1)), 0, ADC_SUCCESS);
+}
+
+static void BENCH_updateFilter(uint8 a_call)
+{
+	/*the largest window, the codes jump over the whole window so every insertion moves the most*/
+	(void)FILTER_update(&BENCH_g_filter, (uint16)((a_call & 1) ? 200 + a_call : 600 - a_call));
+}
+
+static void BENCH_predict(uint8 a_call)
+{
+	PREDICT_update(&BENCH_g_predict, (uint16)(200 + a_call));
+	(void)PREDICT_project(&BENCH_g_predict, MAIN_getHorizonSamples(PREDICT_MAX_HORIZON_S, CONFIG_MIN_SAMPLE_PERIOD_MS));
+}
+
+static void BENCH_sample(uint8 a_call)
+{
+	(void)a_call;
+	MAIN_sample(&BENCH_g_state);
+}
+
+static const BENCH_CaseType BENCH_g_cases[] =
+{
+	{"CRC16_update_16B", BENCH_crc, BENCH_CALLS},
+	{"LM35_getTemperature", BENCH_getTemperature, BENCH_CALLS},
+	{"MAIN_getFanSpeed", BENCH_getFanSpeed, BENCH_CALLS},
+	{"SENSOR_check", BENCH_checkSensor, BENCH_CALLS},
+	{"FILTER_update_9_4", BENCH_updateFilter, BENCH_CALLS},
+	{"PREDICT_update_project", BENCH_predict, 2 * PREDICT_WINDOW},
+	{"DC_MOTOR_Rotate", BENCH_rotate, BENCH_CALLS},
+	{"LCD_displayCharacter", BENCH_displayCharacter, 16},
+	{"LCD_intgerToString", BENCH_intgerToString, 8},
+	{"MAIN_sendTelemetry", BENCH_sendTelemetry, BENCH_CALLS},
+	{"HISTORY_update", BENCH_updateHistory, BENCH_CALLS},
+	{"COMMAND_process", BENCH_processCommand, BENCH_CALLS},
+	{"MAIN_sample", BENCH_sample, BENCH_CALLS}
+};
+
+/*
+ * @brief wait until the UART has sent everything, so a case that queues
+ * bytes always finds the same room in the buffer
+ * */
+static void BENCH_flush(void)
+{
+	while(UART_getTxFree() != UART_TX_BUFFER_SIZE - 1)
+	{
+	}
+}
+
+/*
+ * @brief time one call with Timer1 counting the CPU cycles
+ *
+ * @return uint16 the cycles of the call, BENCH_OVERFLOW if it took too long
+ * */
+static uint16 BENCH_measure(BENCH_FunctionType a_function, uint8 a_call)
+{
+	uint16 cycles = 0;
+	uint8 sreg = SREG;
+
+	cli();
+	TCNT1 = 0;
+	TIFR = (1 << TOV1);
+	TCCR1B = (1 << CS10); /*F_CPU, no pre-scaler*/
+	a_function(a_call);
+	TCCR1B = 0;
+	cycles = TCNT1;
+	if(TIFR & (1 << TOV1))
+	{
+		cycles = BENCH_OVERFLOW;
+	}
+	SREG = sreg;
+	return cycles;
+}
+
+static void BENCH_print(const char * a_text)
+{
+	while(*a_text != '\0')
+	{
+		while(UART_sendByte((uint8)*a_text) != UART_SUCCESS)
+		{
+			/*the ISR makes room*/
+		}
+		a_text++;
+	}
+}
+
+static void BENCH_printNumber(uint32 a_number)
+{
+	char text[11];
+	ultoa(a_number, text, 10);
+	BENCH_print(",");
+	BENCH_print(text);
+}
+
+static void BENCH_run(const BENCH_CaseType * a_case)
+{
+	uint16 cycles = 0, minimum = BENCH_OVERFLOW, maximum = 0;
+	uint32 total = 0;
+	uint8 call = 0;
+
+	for(call = 0; call < a_case->calls; call++)
+	{
+		BENCH_flush();
+		cycles = BENCH_measure(a_case->function, call);
+		if(cycles != BENCH_OVERFLOW)
+		{
+			cycles -= BENCH_g_overhead;
+		}
+		minimum = (cycles < minimum) ? cycles : minimum;
+		maximum = (cycles > maximum) ? cycles : maximum;
+		total += cycles;
+	}
+
+	BENCH_print(BENCH_LINE_PREFIX);
+	BENCH_print(a_case->name);
+	BENCH_printNumber(a_case->calls);
+	BENCH_printNumber(minimum);
+	BENCH_printNumber(maximum);
+	BENCH_printNumber((total + (a_case->calls / 2)) / a_case->calls);
+	BENCH_print("\n");
+}
+
+int main(void)
+{
+	uint8 i = 0;
+
+	MAIN_init();
+	MAIN_applyConfig(&BENCH_g_state.displayMode, &BENCH_g_state.lcdValue, &BENCH_g_state.fanSpeed);
+	FILTER_init(&BENCH_g_filter, FILTER_MAX_MEDIAN, FILTER_MAX_SHIFT);
+	for(i = 0; i < sizeof(BENCH_g_buffer); i++)
+	{
+		BENCH_g_buffer[i] = i;
+	}
+	TCCR1A = 0; /*normal mode*/
+	BENCH_g_overhead = BENCH_measure(BENCH_empty, 0);
+
+	for(i = 0; i < sizeof(BENCH_g_cases) / sizeof(BENCH_g_cases[0]); i++)
+	{
+		BENCH_run(&BENCH_g_cases[i]);
+	}
+	BENCH_flush();
+
+	/*simavr stops when the CPU sleeps with the interrupts disabled*/
+	cli();
+	sleep_mode();
+	return 0;
+}
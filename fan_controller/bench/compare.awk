@@ -0,0 +1,51 @@
+################################################################################
+# Compare two CSV tables with a name in the first column and numbers after it
+#
+# awk -F, -v limit=2 -f compare.awk baseline.csv current.csv
+#
+# Prints every number that grew by more than limit percent and exits with 1
+# if there is one. New and removed rows are reported but do not fail.
+################################################################################
+
+FNR == 1 {
+	for(i = 1; i <= NF; i++)
+	{
+		column[i] = $i
+	}
+	next
+}
+
+NR == FNR {
+	seen[$1] = 1
+	for(i = 2; i <= NF; i++)
+	{
+		baseline[$1, i] = $i
+	}
+	next
+}
+
+{
+	if(!($1 in seen))
+	{
+		printf("%s: new\n", $1)
+		next
+	}
+	delete seen[$1]
+	for(i = 2; i <= NF; i++)
+	{
+		old = baseline[$1, i]
+		if($i > old * (1 + limit / 100.0) && $i > old)
+		{
+			printf("%s: %s %d -> %d\n", $1, column[i], old, $i)
+			failed = 1
+		}
+	}
+}
+
+END {
+	for(name in seen)
+	{
+		printf("%s: removed\n", name)
+	}
+	exit failed
+}
@@ -0,0 +1,638 @@
+/*
+ *
+ * Module: Command
+ *
+ * File Name: command.c
+ *
+ * Description: Source file for the runtime configuration command interface
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"command.h"
+#include"config.h"
+#include"uart.h"
+#include"telemetry.h"
+#include"nvm.h"
+#include"history.h"
+#include"probe.h"
+#include"trace.h"
+#include"sram.h"
+#include"sensor.h"
+#include"energy.h"
+#include"error.h"
+#include"vref.h"
+#include"watchdog.h"
+#include"adc.h"
+#include<string.h>
+
+#define COMMAND_SAVED		TRUE
+#define COMMAND_NOT_SAVED	FALSE /*the setter acts on a log or a counter*/
+
+/*
+ * @brief handlers of one command name, arguments are in COMMAND_g_arguments
+ * a setter returns FALSE if its arguments are not valid
+ * */
+typedef struct
+{
+	const char * name;
+	void (*get)(void);
+	uint8 (*set)(uint8 a_count);
+	uint8 saved; /*COMMAND_SAVED if a set changes the configuration kept by nvm.h*/
+}COMMAND_EntryType;
+
+/*Global Variables */
+static char COMMAND_g_line[COMMAND_LINE_SIZE];
+static uint8 COMMAND_g_length = 0;
+static uint8 COMMAND_g_overflow = FALSE;
+static char * COMMAND_g_arguments[COMMAND_MAX_ARGUMENTS];
+static char COMMAND_g_response[TELEMETRY_MAX_PAYLOAD];
+static uint8 COMMAND_g_responseLength = 0;
+
+/*pre-scaler values indexed by PWM_PrescalerType*/
+static const uint16 COMMAND_g_pwmDividers[] = {0, 1, 8, 64, 256, 1024};
+
+/*
+ * @brief append a string to the response
+ * */
+static void COMMAND_append(const char * a_text)
+{
+	while(*a_text != '\0' && COMMAND_g_responseLength < TELEMETRY_MAX_PAYLOAD)
+	{
+		COMMAND_g_response[COMMAND_g_responseLength++] = *a_text++;
+	}
+}
+
+/*
+ * @brief append a decimal number to the response
+ * */
+static void COMMAND_appendDigits(uint32 a_value)
+{
+	char digits[11];
+	uint8 i = sizeof(digits) - 1;
+	digits[i] = '\0';
+	do
+	{
+		digits[--i] = (char)('0' + (a_value % 10));
+		a_value /= 10;
+	}while(a_value != 0);
+	COMMAND_append(&digits[i]);
+}
+
+/*
+ * @brief append a space and a decimal number to the response
+ * */
+static void COMMAND_appendNumber(uint32 a_value)
+{
+	COMMAND_append(" ");
+	COMMAND_appendDigits(a_value);
+}
+
+/*
+ * @brief append a space and a signed decimal number to the response
+ * */
+static void COMMAND_appendSigned(sint16 a_value)
+{
+	COMMAND_append(a_value < 0 ? " -" : " ");
+	COMMAND_appendDigits((uint32)(a_value < 0 ? -(sint32)a_value : a_value));
+}
+
+/*
+ * @brief send the response frame and start a new one
+ * */
+static void COMMAND_sendResponse(void)
+{
+	TELEMETRY_sendFrame(TELEMETRY_FRAME_RESPONSE, (const uint8 *)COMMAND_g_response,
+			COMMAND_g_responseLength);
+	COMMAND_g_responseLength = 0;
+}
+
+/*
+ * @brief parse a decimal number from 0 to 65535
+ *
+ * @return uint8 FALSE if the text is not a number
+ * */
+static uint8 COMMAND_parseNumber(const char * a_text, uint16 * a_value)
+{
+	uint32 value = 0;
+	if(*a_text == '\0')
+	{
+		return FALSE;
+	}
+	while(*a_text != '\0')
+	{
+		if(*a_text < '0' || *a_text > '9')
+		{
+			return FALSE;
+		}
+		value = (value * 10) + (uint8)(*a_text++ - '0');
+		if(value > 0xFFFF)
+		{
+			return FALSE;
+		}
+	}
+	*a_value = (uint16)value;
+	return TRUE;
+}
+
+/*
+ * @brief parse argument a_index as a number, FALSE if it is not one or is above a_max
+ * */
+static uint8 COMMAND_getArgument(uint8 a_index, uint16 a_max, uint16 * a_value)
+{
+	return COMMAND_parseNumber(COMMAND_g_arguments[a_index], a_value) && *a_value <= a_max;
+}
+
+/*
+ * @brief parse argument a_index as a number that may start with '-',
+ * FALSE if it is not one or its magnitude is above a_limit
+ * */
+static uint8 COMMAND_getSignedArgument(uint8 a_index, uint16 a_limit, sint16 * a_value)
+{
+	const char * text = COMMAND_g_arguments[a_index];
+	uint16 magnitude = 0;
+	uint8 negative = (*text == '-');
+
+	if(!COMMAND_parseNumber(negative ? text + 1 : text, &magnitude) || magnitude > a_limit)
+	{
+		return FALSE;
+	}
+	*a_value = negative ? -(sint16)magnitude : (sint16)magnitude;
+	return TRUE;
+}
+
+static void COMMAND_getCurve(void)
+{
+	uint8 i = 0;
+	const CONFIG_CurveType * curve = &CONFIG_get()->curve;
+	for(i = 0; i < CONFIG_CURVE_POINTS; i++)
+	{
+		COMMAND_appendNumber(curve->temperature[i]);
+		COMMAND_appendNumber(curve->speed[i]);
+	}
+}
+
+static uint8 COMMAND_setCurve(uint8 a_count)
+{
+	CONFIG_CurveType curve;
+	uint16 value = 0;
+	uint8 i = 0;
+	if(a_count != 2 * CONFIG_CURVE_POINTS)
+	{
+		return FALSE;
+	}
+	for(i = 0; i < CONFIG_CURVE_POINTS; i++)
+	{
+		if(!COMMAND_getArgument(2 * i, 0xFF, &value))
+		{
+			return FALSE;
+		}
+		curve.temperature[i] = (uint8)value;
+		if(!COMMAND_getArgument((2 * i) + 1, 0xFF, &value))
+		{
+			return FALSE;
+		}
+		curve.speed[i] = (uint8)value;
+	}
+	return CONFIG_setCurve(&curve) == CONFIG_SUCCESS;
+}
+
+static void COMMAND_getPwm(void)
+{
+	COMMAND_appendNumber(COMMAND_g_pwmDividers[CONFIG_get()->pwmPrescaler]);
+}
+
+static uint8 COMMAND_setPwm(uint8 a_count)
+{
+	uint16 value = 0;
+	uint8 i = 0;
+	if(a_count != 1 || !COMMAND_getArgument(0, 0xFFFF, &value))
+	{
+		return FALSE;
+	}
+	for(i = PWM_PRESCALER_1; i <= PWM_PRESCALER_1024; i++)
+	{
+		if(COMMAND_g_pwmDividers[i] == value)
+		{
+			return CONFIG_setPwmPrescaler(i) == CONFIG_SUCCESS;
+		}
+	}
+	return FALSE;
+}
+
+static void COMMAND_getPeriod(void)
+{
+	COMMAND_appendNumber(CONFIG_get()->samplePeriod);
+}
+
+static uint8 COMMAND_setPeriod(uint8 a_count)
+{
+	uint16 value = 0;
+	return a_count == 1 && COMMAND_getArgument(0, 0xFFFF, &value)
+			&& CONFIG_setSamplePeriod(value) == CONFIG_SUCCESS;
+}
+
+static void COMMAND_getTelemetry(void)
+{
+	COMMAND_appendNumber(CONFIG_get()->telemetryPeriod);
+}
+
+static uint8 COMMAND_setTelemetry(uint8 a_count)
+{
+	uint16 value = 0;
+	return a_count == 1 && COMMAND_getArgument(0, 0xFFFF, &value)
+			&& CONFIG_setTelemetryPeriod(value) == CONFIG_SUCCESS;
+}
+
+static void COMMAND_getDisplay(void)
+{
+	COMMAND_append(CONFIG_get()->displayMode == CONFIG_DISPLAY_DUTY ? " duty" : " temp");
+}
+
+static uint8 COMMAND_setDisplay(uint8 a_count)
+{
+	if(a_count != 1)
+	{
+		return FALSE;
+	}
+	if(strcmp(COMMAND_g_arguments[0], "temp") == 0)
+	{
+		return CONFIG_setDisplayMode(CONFIG_DISPLAY_TEMPERATURE) == CONFIG_SUCCESS;
+	}
+	if(strcmp(COMMAND_g_arguments[0], "duty") == 0)
+	{
+		return CONFIG_setDisplayMode(CONFIG_DISPLAY_DUTY) == CONFIG_SUCCESS;
+	}
+	return FALSE;
+}
+
+static void COMMAND_getFilter(void)
+{
+	COMMAND_appendNumber(CONFIG_get()->filterMedian);
+	COMMAND_appendNumber(CONFIG_get()->filterShift);
+}
+
+static uint8 COMMAND_setFilter(uint8 a_count)
+{
+	uint16 median = 0, shift = 0;
+	return a_count == 2 && COMMAND_getArgument(0, 0xFF, &median) && COMMAND_getArgument(1, 0xFF, &shift)
+			&& CONFIG_setFilter((uint8)median, (uint8)shift) == CONFIG_SUCCESS;
+}
+
+static void COMMAND_getPredict(void)
+{
+	COMMAND_appendNumber(CONFIG_get()->predictHorizon);
+}
+
+static uint8 COMMAND_setPredict(uint8 a_count)
+{
+	uint16 value = 0;
+	return a_count == 1 && COMMAND_getArgument(0, 0xFF, &value)
+			&& CONFIG_setPredictHorizon((uint8)value) == CONFIG_SUCCESS;
+}
+
+static void COMMAND_getBoost(void)
+{
+	COMMAND_appendNumber(CONFIG_get()->boostSpeed);
+	COMMAND_appendNumber(CONFIG_get()->boostTime);
+}
+
+static uint8 COMMAND_setBoost(uint8 a_count)
+{
+	uint16 speed = 0, time = 0;
+	return a_count == 2 && COMMAND_getArgument(0, 0xFF, &speed) && COMMAND_getArgument(1, 0xFFFF, &time)
+			&& CONFIG_setBoost((uint8)speed, time) == CONFIG_SUCCESS;
+}
+
+static void COMMAND_getPower(void)
+{
+	COMMAND_appendNumber(CONFIG_get()->fanPower);
+}
+
+static uint8 COMMAND_setPower(uint8 a_count)
+{
+	uint16 value = 0;
+	return a_count == 1 && COMMAND_getArgument(0, 0xFFFF, &value)
+			&& CONFIG_setFanPower(value) == CONFIG_SUCCESS;
+}
+
+static void COMMAND_getFine(void)
+{
+	COMMAND_appendSigned(CONFIG_get()->fineLow);
+	COMMAND_appendSigned(CONFIG_get()->fineHigh);
+}
+
+static uint8 COMMAND_setFine(uint8 a_count)
+{
+	sint16 low = 0, high = 0;
+	return a_count == 2 && COMMAND_getSignedArgument(0, LM35_FINE_LIMIT, &low)
+			&& COMMAND_getSignedArgument(1, LM35_FINE_LIMIT, &high)
+			&& CONFIG_setFineWindow((sint8)low, (sint8)high) == CONFIG_SUCCESS;
+}
+
+static void COMMAND_getEnergy(void)
+{
+	ENERGY_CountersType counters;
+	uint32 running = 0;
+	uint8 i = 0;
+
+	ENERGY_getCounters(&counters);
+	for(i = 0; i < ENERGY_DUTY_BINS; i++)
+	{
+		running += counters.binSeconds[i];
+	}
+	/*the whole record follows this response as an ENERGY frame*/
+	COMMAND_append(ENERGY_startDump() ? "" : " busy");
+	COMMAND_appendNumber(ENERGY_toWattHours(counters.fullDutySeconds, CONFIG_get()->fanPower));
+	COMMAND_appendNumber(running / 3600);
+	COMMAND_appendNumber(counters.starts);
+	COMMAND_appendNumber(counters.speedChanges);
+}
+
+static void COMMAND_getVref(void)
+{
+	COMMAND_appendNumber(VREF_getFactor());
+	/*mV of the measured reference*/
+	COMMAND_appendNumber(((uint32)VREF_getFactor() * (uint32)(ADC_VREF * 1000)) >> LM35_VREF_FACTOR_BITS);
+}
+
+static void COMMAND_getResets(void)
+{
+	uint8 i = 0;
+
+	COMMAND_appendNumber(WATCHDOG_getCauses());
+	for(i = 0; i < WATCHDOG_CAUSES; i++)
+	{
+		COMMAND_appendNumber(WATCHDOG_getCount(i));
+	}
+}
+
+static uint8 COMMAND_setResets(uint8 a_count)
+{
+	if(a_count != 1 || strcmp(COMMAND_g_arguments[0], "clear") != 0)
+	{
+		return FALSE;
+	}
+	WATCHDOG_clearCounts();
+	return TRUE;
+}
+
+static void COMMAND_getErrors(void)
+{
+	/*the codes follow this response as ERROR frames*/
+	COMMAND_append(ERROR_startDump() ? "" : " busy");
+	COMMAND_appendNumber(ERROR_getCount());
+	COMMAND_appendNumber(ERROR_getTotal());
+}
+
+static uint8 COMMAND_setErrors(uint8 a_count)
+{
+	if(a_count != 1 || strcmp(COMMAND_g_arguments[0], "clear") != 0)
+	{
+		return FALSE;
+	}
+	ERROR_init();
+	return TRUE;
+}
+
+static void COMMAND_getDirection(void)
+{
+	COMMAND_append(CONFIG_get()->direction == DC_MOTOR_ACW ? " acw" : " cw");
+}
+
+static uint8 COMMAND_setDirection(uint8 a_count)
+{
+	if(a_count != 1)
+	{
+		return FALSE;
+	}
+	if(strcmp(COMMAND_g_arguments[0], "cw") == 0)
+	{
+		return CONFIG_setDirection(DC_MOTOR_CW) == CONFIG_SUCCESS;
+	}
+	if(strcmp(COMMAND_g_arguments[0], "acw") == 0)
+	{
+		return CONFIG_setDirection(DC_MOTOR_ACW) == CONFIG_SUCCESS;
+	}
+	return FALSE;
+}
+
+static void COMMAND_getHistory(void)
+{
+	/*the blocks follow this response as HISTORY frames*/
+	COMMAND_append(HISTORY_startDump() ? "" : " busy");
+	COMMAND_appendNumber(HISTORY_getBlockCount());
+	COMMAND_appendNumber(HISTORY_CHECKPOINT_SLOTS);
+}
+
+#if (TRACE_ENABLED == 1)
+static void COMMAND_getTrace(void)
+{
+	/*the records follow this response as TRACE frames*/
+	COMMAND_append(TRACE_startDump() ? "" : " busy");
+	COMMAND_appendNumber(TRACE_RING_SIZE);
+}
+#endif
+
+static void COMMAND_getSensor(void)
+{
+	COMMAND_append(" ");
+	COMMAND_append(SENSOR_getFaultName(SENSOR_getFault()));
+	COMMAND_appendNumber(SENSOR_getFaultCount());
+}
+
+#if (SRAM_ENABLED == 1)
+static void COMMAND_getMemory(void)
+{
+	SRAM_UsageType usage;
+	SRAM_getUsage(&usage);
+	COMMAND_appendNumber(usage.staticBytes);
+	COMMAND_appendNumber(usage.freeBytes);
+	COMMAND_appendNumber(usage.lowestFreeBytes);
+	COMMAND_appendNumber(SRAM_WARNING_BYTES);
+}
+#endif
+
+#if (PROBE_ENABLED == 1)
+static void COMMAND_getProbes(void)
+{
+	/*the histograms follow this response as PROBE frames*/
+	COMMAND_append(PROBE_startDump() ? "" : " busy");
+	COMMAND_appendNumber(PROBE_STAGES);
+}
+#endif
+
+static const COMMAND_EntryType COMMAND_g_table[] =
+{
+	{"curve", COMMAND_getCurve, COMMAND_setCurve, COMMAND_SAVED},
+	{"pwm", COMMAND_getPwm, COMMAND_setPwm, COMMAND_SAVED},
+	{"period", COMMAND_getPeriod, COMMAND_setPeriod, COMMAND_SAVED},
+	{"telemetry", COMMAND_getTelemetry, COMMAND_setTelemetry, COMMAND_SAVED},
+	{"display", COMMAND_getDisplay, COMMAND_setDisplay, COMMAND_SAVED},
+	{"dir", COMMAND_getDirection, COMMAND_setDirection, COMMAND_SAVED},
+	{"filter", COMMAND_getFilter, COMMAND_setFilter, COMMAND_SAVED},
+	{"predict", COMMAND_getPredict, COMMAND_setPredict, COMMAND_SAVED},
+	{"boost", COMMAND_getBoost, COMMAND_setBoost, COMMAND_SAVED},
+	{"power", COMMAND_getPower, COMMAND_setPower, COMMAND_SAVED},
+	{"fine", COMMAND_getFine, COMMAND_setFine, COMMAND_SAVED},
+	{"energy", COMMAND_getEnergy, NULL_PTR, COMMAND_NOT_SAVED},
+	{"vref", COMMAND_getVref, NULL_PTR, COMMAND_NOT_SAVED},
+	{"errors", COMMAND_getErrors, COMMAND_setErrors, COMMAND_NOT_SAVED},
+	{"resets", COMMAND_getResets, COMMAND_setResets, COMMAND_NOT_SAVED},
+	{"history", COMMAND_getHistory, NULL_PTR, COMMAND_NOT_SAVED},
+	{"sensor", COMMAND_getSensor, NULL_PTR, COMMAND_NOT_SAVED},
+#if (PROBE_ENABLED == 1)
+	{"probes", COMMAND_getProbes, NULL_PTR, COMMAND_NOT_SAVED},
+#endif
+#if (SRAM_ENABLED == 1)
+	{"memory", COMMAND_getMemory, NULL_PTR, COMMAND_NOT_SAVED},
+#endif
+#if (TRACE_ENABLED == 1)
+	{"trace", COMMAND_getTrace, NULL_PTR, COMMAND_NOT_SAVED},
+#endif
+};
+
+#define COMMAND_TABLE_SIZE		(sizeof(COMMAND_g_table) / sizeof(COMMAND_g_table[0]))
+
+/*
+ * @brief split the line on spaces and run the matching handler
+ * */
+static void COMMAND_execute(void)
+{
+	char * words[COMMAND_MAX_ARGUMENTS + 2];
+	uint8 count = 0, i = 0;
+	char * p = COMMAND_g_line;
+
+	/*Split the line in place, the number of words is limited so this is bounded*/
+	while(*p != '\0')
+	{
+		while(*p == ' ')
+		{
+			*p++ = '\0';
+		}
+		if(*p == '\0')
+		{
+			break;
+		}
+		if(count == COMMAND_MAX_ARGUMENTS + 2)
+		{
+			COMMAND_append("err syntax");
+			return;
+		}
+		words[count++] = p;
+		while(*p != ' ' && *p != '\0')
+		{
+			p++;
+		}
+	}
+	if(count == 0)
+	{
+		return; /*empty lines are not answered*/
+	}
+	if(count < 2)
+	{
+		COMMAND_append("err syntax");
+		return;
+	}
+
+	for(i = 0; i < COMMAND_TABLE_SIZE; i++)
+	{
+		if(strcmp(words[1], COMMAND_g_table[i].name) == 0)
+		{
+			break;
+		}
+	}
+	if(i == COMMAND_TABLE_SIZE)
+	{
+		COMMAND_append("err unknown");
+		return;
+	}
+
+	if(strcmp(words[0], "get") == 0 && count == 2)
+	{
+		COMMAND_append(COMMAND_g_table[i].name);
+		COMMAND_g_table[i].get();
+	}
+	else if(strcmp(words[0], "set") == 0 && COMMAND_g_table[i].set != NULL_PTR)
+	{
+		memcpy(COMMAND_g_arguments, &words[2], (count - 2) * sizeof(char *));
+		if(COMMAND_g_table[i].set(count - 2))
+		{
+			if(COMMAND_g_table[i].saved == COMMAND_SAVED)
+			{
+				NVM_requestSave();/*keep the new value after a reset*/
+			}
+			COMMAND_append("ok");
+		}
+		else
+		{
+			COMMAND_append("err value");
+		}
+	}
+	else
+	{
+		COMMAND_append("err syntax");
+	}
+}
+
+/*
+ * @brief reset the line parser
+ * */
+void COMMAND_init(void)
+{
+	COMMAND_g_length = 0;
+	COMMAND_g_overflow = FALSE;
+	COMMAND_g_responseLength = 0;
+}
+
+/*
+ * @brief take up to COMMAND_MAX_BYTES_PER_CALL received bytes and execute
+ * at most one complete line, so the time spent in every call is bounded.
+ * It must be called from the main loop, never from an ISR.
+ * */
+void COMMAND_process(void)
+{
+	uint8 i = 0, data = 0;
+	for(i = 0; i < COMMAND_MAX_BYTES_PER_CALL && UART_receiveByte(&data); i++)
+	{
+		if(data == '\r')
+		{
+			continue;
+		}
+		if(data != '\n')
+		{
+			if(COMMAND_g_length < COMMAND_LINE_SIZE - 1)
+			{
+				COMMAND_g_line[COMMAND_g_length++] = (char)data;
+			}
+			else
+			{
+				COMMAND_g_overflow = TRUE; /*drop the rest of the line*/
+			}
+			continue;
+		}
+
+		/*A complete line*/
+		COMMAND_g_line[COMMAND_g_length] = '\0';
+		TRACE_BEGIN(TRACE_COMMAND, COMMAND_g_length);
+		if(COMMAND_g_overflow || UART_getRxLost() != 0)
+		{
+			COMMAND_append("err line");
+		}
+		else
+		{
+			COMMAND_execute();
+		}
+		TRACE_END(TRACE_COMMAND, COMMAND_g_responseLength);
+		if(COMMAND_g_responseLength != 0)
+		{
+			COMMAND_sendResponse();
+		}
+		COMMAND_g_length = 0;
+		COMMAND_g_overflow = FALSE;
+		return; /*one command per call*/
+	}
+}
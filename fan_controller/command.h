@@ -0,0 +1,67 @@
+/*
+ *
+ * Module: Command
+ *
+ * File Name: command.h
+ *
+ * Description: Header file for the runtime configuration command interface.
+ * Commands are ASCII lines received on the UART and ended by '\n' ('\r' is ignored):
+ *
+ * 	get <name>
+ * 	set <name> <values...>
+ *
+ * 	name        values
+ * 	curve       t1 s1 t2 s2 t3 s3 t4 s4 (temperatures ascending, speeds in percent)
+ * 	pwm         1 | 8 | 64 | 256 | 1024 (timer 0 pre-scaler)
+ * 	period      sample period in ms
+ * 	telemetry   telemetry period in ms
+ * 	display     temp | duty
+ * 	dir         cw | acw
+ * 	filter      median size (odd, 1 -> off) and EMA shift (0 -> off) of the LM35 filter
+ * 	predict     horizon in seconds of the predictive mode (0 -> off, see predict.h)
+ * 	boost       speed in percent and time in ms of the kick-start boost (time 0 -> off, see dcMotor.h)
+ * 	fine        low and high temperature in C of the 10x LM35 reading, -25 -> 25 (equal -> off, see lm35.h)
+ * 	power       power of the fan at 100% in 0.1W for the energy estimate
+ * 	energy      get only, answers "<Wh> <running hours> <starts> <speed changes>" and sends
+ * 	            the counters as an ENERGY frame (see energy.h)
+ * 	errors      get answers "<codes> <occurrences>" and sends the error log as ERROR frames,
+ * 	            "set errors clear" empties it (see error.h)
+ * 	resets      get answers "<last causes> <power-on> <external> <brown-out> <watchdog> <JTAG>",
+ * 	            "set resets clear" sets the counts to 0 (see watchdog.h)
+ * 	history     get only, answers "<blocks> <summary slots>" and starts the dump (see history.h)
+ * 	sensor      get only, answers "<fault> <faults since the start>" (see sensor.h)
+ * 	vref        get only, answers "<factor> <mV>" of the calibrated ADC reference (see vref.h)
+ *
+ * Every line is answered by one TELEMETRY_FRAME_RESPONSE frame holding
+ * "<name> <values...>", "ok" or "err <reason>".
+ * Accepted changes of the configuration are saved to the EEPROM a moment later (see nvm.h),
+ * "set errors clear" and "set resets clear" are not configuration changes and are not saved.
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+#include"std_types.h"
+
+#define COMMAND_LINE_SIZE				48
+#define COMMAND_MAX_BYTES_PER_CALL		16
+#define COMMAND_MAX_ARGUMENTS			8
+
+/*
+ * @brief reset the line parser
+ * */
+void COMMAND_init(void);
+
+/*
+ * @brief take up to COMMAND_MAX_BYTES_PER_CALL received bytes and execute
+ * at most one complete line, so the time spent in every call is bounded.
+ * It must be called from the main loop, never from an ISR.
+ * */
+void COMMAND_process(void);
+
+#endif /* COMMAND_H_ */
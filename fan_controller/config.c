@@ -0,0 +1,268 @@
+/*
+ *
+ * Module: Config
+ *
+ * File Name: config.c
+ *
+ * Description: Source file for the runtime configuration of the fan controller
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"config.h"
+
+/*Global Variables */
+static CONFIG_Type CONFIG_g_config;
+static uint8 CONFIG_g_changed = FALSE;
+
+/*
+ * @brief load the default configuration
+ * */
+void CONFIG_init(void)
+{
+	const CONFIG_CurveType defaultCurve = {CONFIG_DEFAULT_CURVE_TEMPERATURES, CONFIG_DEFAULT_CURVE_SPEEDS};
+	CONFIG_g_config.curve = defaultCurve;
+	CONFIG_g_config.direction = CONFIG_DEFAULT_DIRECTION;
+	CONFIG_g_config.pwmPrescaler = CONFIG_DEFAULT_PWM_PRESCALER;
+	CONFIG_g_config.displayMode = CONFIG_DISPLAY_TEMPERATURE;
+	CONFIG_g_config.samplePeriod = CONFIG_DEFAULT_SAMPLE_PERIOD_MS;
+	CONFIG_g_config.telemetryPeriod = TELEMETRY_DEFAULT_PERIOD_MS;
+	CONFIG_g_config.filterMedian = CONFIG_DEFAULT_FILTER_MEDIAN;
+	CONFIG_g_config.filterShift = CONFIG_DEFAULT_FILTER_SHIFT;
+	CONFIG_g_config.predictHorizon = CONFIG_DEFAULT_PREDICT_HORIZON;
+	CONFIG_g_config.boostSpeed = CONFIG_DEFAULT_BOOST_SPEED;
+	CONFIG_g_config.boostTime = CONFIG_DEFAULT_BOOST_TIME_MS;
+	CONFIG_g_config.fanPower = CONFIG_DEFAULT_FAN_POWER;
+	CONFIG_g_config.fineLow = CONFIG_DEFAULT_FINE_LOW;
+	CONFIG_g_config.fineHigh = CONFIG_DEFAULT_FINE_HIGH;
+	CONFIG_g_changed = TRUE;
+}
+
+/*
+ * @brief replace the whole configuration after validating every field,
+ * the current configuration is kept if any field is not valid
+ *
+ * @return CONFIG_ErrorType CONFIG_ERROR_VALUE if any field is not valid
+ * */
+CONFIG_ErrorType CONFIG_load(const CONFIG_Type * a_config)
+{
+	CONFIG_Type backup = CONFIG_g_config;
+	if(a_config == NULL_PTR)
+	{
+		return CONFIG_ERROR_NULL_PTR;
+	}
+	/*reuse the setters so a stored configuration is checked like a received one*/
+	if(CONFIG_setCurve(&a_config->curve) != CONFIG_SUCCESS
+			|| CONFIG_setDirection(a_config->direction) != CONFIG_SUCCESS
+			|| CONFIG_setPwmPrescaler(a_config->pwmPrescaler) != CONFIG_SUCCESS
+			|| CONFIG_setDisplayMode(a_config->displayMode) != CONFIG_SUCCESS
+			|| CONFIG_setSamplePeriod(a_config->samplePeriod) != CONFIG_SUCCESS
+			|| CONFIG_setTelemetryPeriod(a_config->telemetryPeriod) != CONFIG_SUCCESS
+			|| CONFIG_setFilter(a_config->filterMedian, a_config->filterShift) != CONFIG_SUCCESS
+			|| CONFIG_setPredictHorizon(a_config->predictHorizon) != CONFIG_SUCCESS
+			|| CONFIG_setBoost(a_config->boostSpeed, a_config->boostTime) != CONFIG_SUCCESS
+			|| CONFIG_setFanPower(a_config->fanPower) != CONFIG_SUCCESS
+			|| CONFIG_setFineWindow(a_config->fineLow, a_config->fineHigh) != CONFIG_SUCCESS)
+	{
+		CONFIG_g_config = backup;
+		return CONFIG_ERROR_VALUE;
+	}
+	return CONFIG_SUCCESS;
+}
+
+/*
+ * @brief return a read-only pointer to the current configuration
+ * */
+const CONFIG_Type * CONFIG_get(void)
+{
+	return &CONFIG_g_config;
+}
+
+/*
+ * @brief return TRUE once after any change of the configuration,
+ * so the application can apply the new values
+ * */
+uint8 CONFIG_isChanged(void)
+{
+	uint8 changed = CONFIG_g_changed;
+	CONFIG_g_changed = FALSE;
+	return changed;
+}
+
+/*
+ * @brief replace the fan curve after validating it
+ *
+ * @return CONFIG_ErrorType CONFIG_ERROR_VALUE if the temperatures are not ascending
+ * or a speed is above DC_MOTOR_MAX_SPEED
+ * */
+CONFIG_ErrorType CONFIG_setCurve(const CONFIG_CurveType * a_curve)
+{
+	uint8 i = 0;
+	if(a_curve == NULL_PTR)
+	{
+		return CONFIG_ERROR_NULL_PTR;
+	}
+	for(i = 0; i < CONFIG_CURVE_POINTS; i++)
+	{
+		if(a_curve->speed[i] > DC_MOTOR_MAX_SPEED
+				|| (i > 0 && a_curve->temperature[i] <= a_curve->temperature[i - 1]))
+		{
+			return CONFIG_ERROR_VALUE;
+		}
+	}
+	CONFIG_g_config.curve = *a_curve;
+	CONFIG_g_changed = TRUE;
+	return CONFIG_SUCCESS;
+}
+
+/*
+ * @brief set the fan rotation direction, DC_MOTOR_ACW or DC_MOTOR_CW
+ * */
+CONFIG_ErrorType CONFIG_setDirection(uint8 a_direction)
+{
+	if(a_direction != DC_MOTOR_ACW && a_direction != DC_MOTOR_CW)
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	CONFIG_g_config.direction = a_direction;
+	CONFIG_g_changed = TRUE;
+	return CONFIG_SUCCESS;
+}
+
+/*
+ * @brief set the pwm pre-scaler (PWM_PrescalerType)
+ * */
+CONFIG_ErrorType CONFIG_setPwmPrescaler(uint8 a_prescaler)
+{
+	if(a_prescaler < PWM_PRESCALER_1 || a_prescaler > PWM_PRESCALER_1024)
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	CONFIG_g_config.pwmPrescaler = a_prescaler;
+	CONFIG_g_changed = TRUE;
+	return CONFIG_SUCCESS;
+}
+
+/*
+ * @brief set the time between two temperature samples,
+ * from CONFIG_MIN_SAMPLE_PERIOD_MS to CONFIG_MAX_SAMPLE_PERIOD_MS
+ * */
+CONFIG_ErrorType CONFIG_setSamplePeriod(uint16 a_period)
+{
+	if(a_period < CONFIG_MIN_SAMPLE_PERIOD_MS || a_period > CONFIG_MAX_SAMPLE_PERIOD_MS)
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	CONFIG_g_config.samplePeriod = a_period;
+	CONFIG_g_changed = TRUE;
+	return CONFIG_SUCCESS;
+}
+
+/*
+ * @brief set the time between two telemetry frames, at least TELEMETRY_MIN_PERIOD_MS
+ * */
+CONFIG_ErrorType CONFIG_setTelemetryPeriod(uint16 a_period)
+{
+	if(a_period < TELEMETRY_MIN_PERIOD_MS)
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	CONFIG_g_config.telemetryPeriod = a_period;
+	CONFIG_g_changed = TRUE;
+	return CONFIG_SUCCESS;
+}
+
+/*
+ * @brief set what the second row of the LCD shows (CONFIG_DisplayModeType)
+ * */
+CONFIG_ErrorType CONFIG_setDisplayMode(uint8 a_mode)
+{
+	if(a_mode > CONFIG_DISPLAY_DUTY)
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	CONFIG_g_config.displayMode = a_mode;
+	CONFIG_g_changed = TRUE;
+	return CONFIG_SUCCESS;
+}
+
+/*
+ * @brief set the LM35 filter, an odd median size up to FILTER_MAX_MEDIAN
+ * and an EMA shift up to FILTER_MAX_SHIFT
+ * */
+CONFIG_ErrorType CONFIG_setFilter(uint8 a_medianSize, uint8 a_shift)
+{
+	if((a_medianSize & 1) == 0 || a_medianSize > FILTER_MAX_MEDIAN || a_shift > FILTER_MAX_SHIFT)
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	CONFIG_g_config.filterMedian = a_medianSize;
+	CONFIG_g_config.filterShift = a_shift;
+	CONFIG_g_changed = TRUE;
+	return CONFIG_SUCCESS;
+}
+
+/*
+ * @brief set the horizon of the predictive mode in seconds,
+ * up to PREDICT_MAX_HORIZON_S, 0 turns the mode off
+ * */
+CONFIG_ErrorType CONFIG_setPredictHorizon(uint8 a_horizon)
+{
+	if(a_horizon > PREDICT_MAX_HORIZON_S)
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	CONFIG_g_config.predictHorizon = a_horizon;
+	CONFIG_g_changed = TRUE;
+	return CONFIG_SUCCESS;
+}
+
+/*
+ * @brief set the kick-start boost, a speed up to DC_MOTOR_MAX_SPEED
+ * and a time up to DC_MOTOR_MAX_BOOST_MS, a time of 0 turns it off
+ * */
+CONFIG_ErrorType CONFIG_setBoost(uint8 a_speed, uint16 a_time)
+{
+	if(a_speed > DC_MOTOR_MAX_SPEED || a_time > DC_MOTOR_MAX_BOOST_MS)
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	CONFIG_g_config.boostSpeed = a_speed;
+	CONFIG_g_config.boostTime = a_time;
+	CONFIG_g_changed = TRUE;
+	return CONFIG_SUCCESS;
+}
+
+/*
+ * @brief set the power of the fan at 100% in 0.1W for the energy estimate,
+ * up to CONFIG_MAX_FAN_POWER
+ * */
+CONFIG_ErrorType CONFIG_setFanPower(uint16 a_power)
+{
+	if(a_power > CONFIG_MAX_FAN_POWER)
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	CONFIG_g_config.fanPower = a_power;
+	CONFIG_g_changed = TRUE;
+	return CONFIG_SUCCESS;
+}
+
+/*
+ * @brief set the window where the temperature is read at 10x gain, both bounds
+ * within +/-LM35_FINE_LIMIT and ascending, equal bounds turn it off
+ * */
+CONFIG_ErrorType CONFIG_setFineWindow(sint8 a_low, sint8 a_high)
+{
+	if(a_low > a_high || a_low < -LM35_FINE_LIMIT || a_high > LM35_FINE_LIMIT)
+	{
+		return CONFIG_ERROR_VALUE;
+	}
+	CONFIG_g_config.fineLow = a_low;
+	CONFIG_g_config.fineHigh = a_high;
+	CONFIG_g_changed = TRUE;
+	return CONFIG_SUCCESS;
+}
@@ -0,0 +1,183 @@
+/*
+ *
+ * Module: Config
+ *
+ * File Name: config.h
+ *
+ * Description: Header file for the runtime configuration of the fan controller.
+ * The defaults below are used after reset, they can be changed at runtime
+ * through the command interface.
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#include"std_types.h"
+#include"dcMotor.h"
+#include"pwm.h"
+#include"telemetry.h"
+#include"fan_curve.h"
+#include"filter.h"
+#include"predict.h"
+#include"lm35.h"
+
+/*Fan curve, the fan is off below the first temperature*/
+#define CONFIG_CURVE_POINTS				4
+#define CONFIG_DEFAULT_CURVE_TEMPERATURES	FAN_CURVE_TEMPERATURES /*see fan_curve.h*/
+#define CONFIG_DEFAULT_CURVE_SPEEDS			FAN_CURVE_SPEEDS
+
+#define CONFIG_DEFAULT_DIRECTION		DC_MOTOR_CW
+#define CONFIG_DEFAULT_PWM_PRESCALER	PWM_DEFAULT_PRESCALER
+
+#define CONFIG_DEFAULT_SAMPLE_PERIOD_MS	100
+#define CONFIG_MIN_SAMPLE_PERIOD_MS		10
+#define CONFIG_MAX_SAMPLE_PERIOD_MS		10000
+
+/*LM35 filter, see filter.h*/
+#define CONFIG_DEFAULT_FILTER_MEDIAN	5
+#define CONFIG_DEFAULT_FILTER_SHIFT		2
+
+/*Predictive mode, see predict.h*/
+#define CONFIG_DEFAULT_PREDICT_HORIZON	0 /*s, 0 -> the reactive curve only*/
+
+/*Kick-start boost of the fan, see dcMotor.h*/
+#define CONFIG_DEFAULT_BOOST_SPEED		100
+#define CONFIG_DEFAULT_BOOST_TIME_MS	100 /*0 -> off*/
+
+/*Window of the 10x LM35 reading, see lm35.h*/
+#define CONFIG_DEFAULT_FINE_LOW			0 /*C, equal bounds -> off*/
+#define CONFIG_DEFAULT_FINE_HIGH		0
+
+/*Energy accounting, see energy.h*/
+#define CONFIG_DEFAULT_FAN_POWER		24 /*0.1W at 100%, a 12V 0.2A fan*/
+#define CONFIG_MAX_FAN_POWER			10000
+
+#define CONFIG_SUCCESS					0
+#define CONFIG_ERROR_VALUE				CONFIG_SUCCESS + 1
+#define CONFIG_ERROR_NULL_PTR			CONFIG_ERROR_VALUE + 1
+
+typedef uint8 CONFIG_ErrorType;
+
+typedef enum
+{
+	CONFIG_DISPLAY_TEMPERATURE, CONFIG_DISPLAY_DUTY
+}CONFIG_DisplayModeType;
+
+typedef struct
+{
+	uint8 temperature[CONFIG_CURVE_POINTS]; /*strictly ascending*/
+	uint8 speed[CONFIG_CURVE_POINTS]; /*0 -> DC_MOTOR_MAX_SPEED*/
+}CONFIG_CurveType;
+
+typedef struct
+{
+	CONFIG_CurveType curve;
+	uint8 direction; /*DcMotor_State, DC_MOTOR_ACW or DC_MOTOR_CW*/
+	uint8 pwmPrescaler; /*PWM_PrescalerType*/
+	uint8 displayMode; /*CONFIG_DisplayModeType*/
+	uint16 samplePeriod; /*ms between two temperature samples*/
+	uint16 telemetryPeriod; /*ms between two telemetry frames*/
+	uint8 filterMedian; /*codes of the median, odd, 1 -> off*/
+	uint8 filterShift; /*EMA weight 1/2^shift, 0 -> off*/
+	uint8 predictHorizon; /*s the temperature is projected ahead, 0 -> off*/
+	uint8 boostSpeed; /*speed of the kick-start boost*/
+	uint16 boostTime; /*ms of the kick-start boost, 0 -> off*/
+	uint16 fanPower; /*0.1W drawn by the fan at 100%*/
+	sint8 fineLow; /*C, the 10x reading is used from here*/
+	sint8 fineHigh; /*C, up to here*/
+}CONFIG_Type;
+
+/*
+ * @brief load the default configuration
+ * */
+void CONFIG_init(void);
+
+/*
+ * @brief replace the whole configuration after validating every field,
+ * the current configuration is kept if any field is not valid
+ *
+ * @return CONFIG_ErrorType CONFIG_ERROR_VALUE if any field is not valid
+ * */
+CONFIG_ErrorType CONFIG_load(const CONFIG_Type * a_config);
+
+/*
+ * @brief return a read-only pointer to the current configuration
+ * */
+const CONFIG_Type * CONFIG_get(void);
+
+/*
+ * @brief return TRUE once after any change of the configuration,
+ * so the application can apply the new values
+ * */
+uint8 CONFIG_isChanged(void);
+
+/*
+ * @brief replace the fan curve after validating it
+ *
+ * @return CONFIG_ErrorType CONFIG_ERROR_VALUE if the temperatures are not ascending
+ * or a speed is above DC_MOTOR_MAX_SPEED
+ * */
+CONFIG_ErrorType CONFIG_setCurve(const CONFIG_CurveType * a_curve);
+
+/*
+ * @brief set the fan rotation direction, DC_MOTOR_ACW or DC_MOTOR_CW
+ * */
+CONFIG_ErrorType CONFIG_setDirection(uint8 a_direction);
+
+/*
+ * @brief set the pwm pre-scaler (PWM_PrescalerType)
+ * */
+CONFIG_ErrorType CONFIG_setPwmPrescaler(uint8 a_prescaler);
+
+/*
+ * @brief set the time between two temperature samples,
+ * from CONFIG_MIN_SAMPLE_PERIOD_MS to CONFIG_MAX_SAMPLE_PERIOD_MS
+ * */
+CONFIG_ErrorType CONFIG_setSamplePeriod(uint16 a_period);
+
+/*
+ * @brief set the time between two telemetry frames, at least TELEMETRY_MIN_PERIOD_MS
+ * */
+CONFIG_ErrorType CONFIG_setTelemetryPeriod(uint16 a_period);
+
+/*
+ * @brief set what the second row of the LCD shows (CONFIG_DisplayModeType)
+ * */
+CONFIG_ErrorType CONFIG_setDisplayMode(uint8 a_mode);
+
+/*
+ * @brief set the LM35 filter, an odd median size up to FILTER_MAX_MEDIAN
+ * and an EMA shift up to FILTER_MAX_SHIFT
+ * */
+CONFIG_ErrorType CONFIG_setFilter(uint8 a_medianSize, uint8 a_shift);
+
+/*
+ * @brief set the horizon of the predictive mode in seconds,
+ * up to PREDICT_MAX_HORIZON_S, 0 turns the mode off
+ * */
+CONFIG_ErrorType CONFIG_setPredictHorizon(uint8 a_horizon);
+
+/*
+ * @brief set the kick-start boost, a speed up to DC_MOTOR_MAX_SPEED
+ * and a time up to DC_MOTOR_MAX_BOOST_MS, a time of 0 turns it off
+ * */
+CONFIG_ErrorType CONFIG_setBoost(uint8 a_speed, uint16 a_time);
+
+/*
+ * @brief set the power of the fan at 100% in 0.1W for the energy estimate,
+ * up to CONFIG_MAX_FAN_POWER
+ * */
+CONFIG_ErrorType CONFIG_setFanPower(uint16 a_power);
+
+/*
+ * @brief set the window where the temperature is read at 10x gain, both bounds
+ * within +/-LM35_FINE_LIMIT and ascending, equal bounds turn it off
+ * */
+CONFIG_ErrorType CONFIG_setFineWindow(sint8 a_low, sint8 a_high);
+
+#endif /* CONFIG_H_ */
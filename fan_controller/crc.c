@@ -0,0 +1,32 @@
+ /******************************************************************************
+ *
+ * Module: Common - CRC
+ *
+ * File Name: crc.c
+ *
+ * Description: Source file for the CRC-16/CCITT-FALSE calculation
+ *
+ * Author: Abdullah Mahmoud
+ *
+ *******************************************************************************/
+
+#include"crc.h"
+
+/*
+ * Description :
+ * Continue a CRC calculation over a_length bytes.
+ * Start with CRC16_INITIAL_VALUE and pass the returned value to the next call
+ * to calculate the CRC of data that is not contiguous in memory.
+ */
+uint16 CRC16_update(uint16 a_crc, const uint8 *a_data, uint16 a_length)
+{
+	uint8 x = 0;
+	while(a_length--)
+	{
+		/*Table-less byte update, it costs no flash for a 512 byte table*/
+		x = (uint8)(a_crc >> 8) ^ *a_data++;
+		x ^= x >> 4;
+		a_crc = (uint16)((a_crc << 8) ^ ((uint16)x << 12) ^ ((uint16)x << 5) ^ x);
+	}
+	return a_crc;
+}
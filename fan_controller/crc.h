@@ -0,0 +1,29 @@
+ /******************************************************************************
+ *
+ * Module: Common - CRC
+ *
+ * File Name: crc.h
+ *
+ * Description: CRC-16/CCITT-FALSE used to protect telemetry frames and stored records
+ * (polynomial 0x1021, initial value 0xFFFF, no reflection, no final xor)
+ *
+ * Author: Abdullah Mahmoud
+ *
+ *******************************************************************************/
+
+#ifndef CRC_H_
+#define CRC_H_
+
+#include"std_types.h"
+
+#define CRC16_INITIAL_VALUE		0xFFFF
+
+/*
+ * Description :
+ * Continue a CRC calculation over a_length bytes.
+ * Start with CRC16_INITIAL_VALUE and pass the returned value to the next call
+ * to calculate the CRC of data that is not contiguous in memory.
+ */
+uint16 CRC16_update(uint16 a_crc, const uint8 *a_data, uint16 a_length);
+
+#endif /* CRC_H_ */
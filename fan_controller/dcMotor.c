@@ -14,96 +14,325 @@
 #include"dcMotor.h"
 #include"gpio.h"
 #include"pwm.h"
+#include"timer.h"
+#include"adc.h"
+#include<avr/io.h>
+#include<avr/interrupt.h>
 
+/*What the tick is waiting for*/
+typedef enum
+{
+	DC_MOTOR_PHASE_IDLE, DC_MOTOR_PHASE_DEAD, DC_MOTOR_PHASE_BRAKE, DC_MOTOR_PHASE_BOOST, DC_MOTOR_PHASE_TRIP
+}DC_MOTOR_PhaseType;
+
+/*Global Variables */
+static uint8 DC_MOTOR_g_boostCompare = 0; /*0 -> no boost*/
+static uint16 DC_MOTOR_g_boostTime = 0;
+/*shared with the tick ISR*/
+static volatile DcMotor_State DC_MOTOR_g_state = DC_MOTOR_STOP; /*required by DC_MOTOR_Rotate*/
+static volatile uint8 DC_MOTOR_g_compare = 0; /*compare value of the required speed*/
+static volatile DcMotor_State DC_MOTOR_g_output = DC_MOTOR_STOP; /*driven on the bridge now*/
+static volatile uint8 DC_MOTOR_g_outputCompare = 0; /*compare value of the driven speed, after the boost*/
+static volatile DcMotor_State DC_MOTOR_g_spinning = DC_MOTOR_STOP; /*last direction driven and not braked since*/
+static volatile DC_MOTOR_PhaseType DC_MOTOR_g_phase = DC_MOTOR_PHASE_IDLE;
+static volatile uint16 DC_MOTOR_g_ticks = 0; /*ms left of the phase*/
+/*shared with the ADC ISR*/
+static volatile uint16 DC_MOTOR_g_blanking = 0; /*ms left without the current limit*/
+static volatile uint16 DC_MOTOR_g_current = 0;
+static volatile uint8 DC_MOTOR_g_tripsInRow = 0;
+static volatile uint16 DC_MOTOR_g_trips = 0;
+static volatile uint8 DC_MOTOR_g_stalled = FALSE;
 
 /*
- * @brief the function will stop the motor.
+ * @brief write the two direction pins of the bridge
+ * */
+static void DC_MOTOR_setPins(uint8 a_pin1, uint8 a_pin2)
+{
+	GPIO_writePin(DC_MOTOR_PORT, DC_MOTOR_PIN1, a_pin1);
+	GPIO_writePin(DC_MOTOR_PORT, DC_MOTOR_PIN2, a_pin2);
+}
+
+/*
+ * @brief the function will stop the motor, all off so it coasts,
+ * nothing else is driven before the dead time is over
  * */
 static void DC_MOTOR_stopMotor(void)
 {
-	GPIO_writePin(DC_MOTOR_PORT, DC_MOTOR_PIN1, LOGIC_LOW);
-	GPIO_writePin(DC_MOTOR_PORT, DC_MOTOR_PIN2, LOGIC_LOW);
+	DC_MOTOR_setPins(LOGIC_LOW, LOGIC_LOW);
 	PWM_deInit();
+	DC_MOTOR_g_output = DC_MOTOR_STOP;
+	DC_MOTOR_g_phase = DC_MOTOR_PHASE_DEAD;
+	DC_MOTOR_g_ticks = DC_MOTOR_DEAD_TIME_MS;
+}
+
+/*
+ * @brief short the motor with both pins high and the enable on
+ * */
+static void DC_MOTOR_brakeMotor(void)
+{
+	DC_MOTOR_setPins(LOGIC_HIGH, LOGIC_HIGH);
+	PWM_Timer0_Start(PWM_MAX_VALUE);
+	DC_MOTOR_g_output = DC_MOTOR_BRAKE;
+	DC_MOTOR_g_phase = DC_MOTOR_PHASE_BRAKE;
+	DC_MOTOR_g_ticks = DC_MOTOR_BRAKE_MS;
+}
+
+/*
+ * @brief drive the required direction and speed, with the boost when it starts
+ *
+ * @param uint8 a_start TRUE if the motor was stopped or at 0%
+ * */
+static void DC_MOTOR_driveMotor(uint8 a_start)
+{
+	/*
+	 * if the state is DC_MOTOR_ACW(in other words 1)
+	 * 	then we will write
+	 * 	LOGIC_LOW to DC_MOTOR_PIN1
+	 * 	and
+	 * 	LOGIC_HIGH to DC_MOTOR_PIN2
+	 *
+	 * if the state is DC_MOTOR_CW(in other words 2)
+	 * 	then we will write
+	 * 	LOGIC_HIGH to DC_MOTOR_PIN1
+	 * 	and
+	 * 	LOGIC_LOW to DC_MOTOR_PIN2
+	 * */
+	if(DC_MOTOR_g_state == DC_MOTOR_ACW)
+	{
+		DC_MOTOR_setPins(LOGIC_LOW, LOGIC_HIGH);
+	}
+	else
+	{
+		DC_MOTOR_setPins(LOGIC_HIGH, LOGIC_LOW);
+	}
+	if(a_start || DC_MOTOR_g_compare > DC_MOTOR_g_outputCompare + DC_MOTOR_BLANKING_STEP)
+	{
+		DC_MOTOR_g_blanking = DC_MOTOR_BLANKING_MS;/*the rotor draws more current until it is up to speed*/
+	}
+	DC_MOTOR_g_output = DC_MOTOR_g_state;
+	DC_MOTOR_g_outputCompare = DC_MOTOR_g_compare;
+	DC_MOTOR_g_spinning = DC_MOTOR_g_state;
+
+	if(a_start && DC_MOTOR_g_compare != 0 && DC_MOTOR_g_compare < DC_MOTOR_g_boostCompare)
+	{
+		DC_MOTOR_g_phase = DC_MOTOR_PHASE_BOOST;
+		DC_MOTOR_g_ticks = DC_MOTOR_g_boostTime;
+		PWM_Timer0_Start(DC_MOTOR_g_boostCompare);
+	}
+	else
+	{
+		DC_MOTOR_g_phase = DC_MOTOR_PHASE_IDLE;
+		DC_MOTOR_g_ticks = 0;
+		PWM_Timer0_Start(DC_MOTOR_g_compare);
+	}
+}
+
+/*
+ * @brief move the bridge one step towards the required state,
+ * called with the interrupts disabled after every change and every end of a phase
+ * */
+static void DC_MOTOR_update(void)
+{
+	if(DC_MOTOR_g_state == DC_MOTOR_STOP)
+	{
+		if(DC_MOTOR_g_output != DC_MOTOR_STOP)
+		{
+			DC_MOTOR_stopMotor();/*coasting is safe from any state*/
+		}
+		return;
+	}
+	if(DC_MOTOR_g_output == DC_MOTOR_g_state)
+	{
+		if(DC_MOTOR_g_output == DC_MOTOR_BRAKE)
+		{
+			return;/*braking to zero, then held*/
+		}
+		if(DC_MOTOR_g_phase != DC_MOTOR_PHASE_BOOST)
+		{
+			/*the same direction, a start only from 0%*/
+			DC_MOTOR_driveMotor(DC_MOTOR_g_outputCompare == 0);
+		}
+		else if(DC_MOTOR_g_compare == 0 || DC_MOTOR_g_compare >= DC_MOTOR_g_boostCompare)
+		{
+			DC_MOTOR_driveMotor(FALSE);/*the boost ends now*/
+		}
+		/*else the boost goes on and ends at the new speed*/
+		return;
+	}
+	if(DC_MOTOR_g_phase == DC_MOTOR_PHASE_DEAD || DC_MOTOR_g_phase == DC_MOTOR_PHASE_BRAKE
+			|| DC_MOTOR_g_phase == DC_MOTOR_PHASE_TRIP)
+	{
+		return;/*the tick calls again at the end of the phase*/
+	}
+	if(DC_MOTOR_g_output != DC_MOTOR_STOP)
+	{
+		DC_MOTOR_stopMotor();/*leave a driven state through the dead time*/
+		return;
+	}
+	if(DC_MOTOR_g_state == DC_MOTOR_BRAKE
+			|| (DC_MOTOR_g_spinning != DC_MOTOR_STOP && DC_MOTOR_g_spinning != DC_MOTOR_g_state))
+	{
+		DC_MOTOR_brakeMotor();
+		return;
+	}
+	DC_MOTOR_driveMotor(TRUE);
+}
+
+/*
+ * @brief called every 1ms from the tick ISR, it ends the running phase
+ * */
+static void DC_MOTOR_tick(void)
+{
+	if(DC_MOTOR_g_blanking != 0)
+	{
+		DC_MOTOR_g_blanking--;
+	}
+	if(DC_MOTOR_g_ticks == 0)
+	{
+		return;
+	}
+	DC_MOTOR_g_ticks--;
+	if(DC_MOTOR_g_ticks != 0)
+	{
+		return;
+	}
+	switch(DC_MOTOR_g_phase)
+	{
+	case DC_MOTOR_PHASE_BOOST:
+		PWM_setDutyCycle(DC_MOTOR_g_compare);
+		break;
+	case DC_MOTOR_PHASE_BRAKE:
+		DC_MOTOR_g_spinning = DC_MOTOR_STOP;/*braked to zero*/
+		break;
+	default:
+		break;
+	}
+	DC_MOTOR_g_phase = DC_MOTOR_PHASE_IDLE;
+	DC_MOTOR_update();
 }
+
+/*
+ * @brief called from the ADC ISR with every current sample,
+ * taken at the start of the on-phase of the PWM
+ * */
+static void DC_MOTOR_currentSample(uint16 a_code)
+{
+	uint8 shift = 0;
+
+	DC_MOTOR_g_current = a_code;
+	if(DC_MOTOR_g_output != DC_MOTOR_ACW && DC_MOTOR_g_output != DC_MOTOR_CW)
+	{
+		return;/*the brake current does not flow through the shunt*/
+	}
+	if(a_code < DC_MOTOR_CURRENT_SHORT_CODE && DC_MOTOR_g_blanking != 0)
+	{
+		return;
+	}
+	if(a_code < DC_MOTOR_CURRENT_LIMIT_CODE)
+	{
+		/*the rotor is up to speed, the retry went through*/
+		DC_MOTOR_g_tripsInRow = 0;
+		DC_MOTOR_g_stalled = FALSE;
+		return;
+	}
+	/*cut the bridge now, the tick drives the required state again after the back-off*/
+	DC_MOTOR_stopMotor();
+	shift = DC_MOTOR_g_tripsInRow < DC_MOTOR_TRIP_MAX_SHIFT ? DC_MOTOR_g_tripsInRow : DC_MOTOR_TRIP_MAX_SHIFT;
+	DC_MOTOR_g_phase = DC_MOTOR_PHASE_TRIP;
+	DC_MOTOR_g_ticks = (uint16)DC_MOTOR_TRIP_BACKOFF_MS << shift;
+	DC_MOTOR_g_blanking = 0;
+	DC_MOTOR_g_trips++;
+	if(DC_MOTOR_g_tripsInRow < 0xFF)
+	{
+		DC_MOTOR_g_tripsInRow++;
+	}
+	if(DC_MOTOR_g_tripsInRow >= DC_MOTOR_STALL_TRIPS)
+	{
+		DC_MOTOR_g_stalled = TRUE;
+	}
+}
+
 /*
  * @brief the function will setup the pins of the motor
- * using gpio. Also it will initlize the pwm Mode
+ * using gpio. Also it will initlize the pwm Mode and the current
+ * sensing when the ADC is initialized
  * */
 DC_MOTOR_ErrorType DC_MOTOR_Init(void)
 {
-	DC_MOTOR_ErrorType response = {DC_MOTOR_NO_ERROR, DC_MOTOR_NO_ERROR_MSG};
 	GPIO_setupPinDirection(DC_MOTOR_PORT, DC_MOTOR_PIN1, PIN_OUTPUT);
 	GPIO_setupPinDirection(DC_MOTOR_PORT, DC_MOTOR_PIN2, PIN_OUTPUT);
 	PWM_Timer0_Start(0);
-	return response;
+	DC_MOTOR_g_state = DC_MOTOR_STOP;
+	DC_MOTOR_g_compare = 0;
+	DC_MOTOR_g_output = DC_MOTOR_STOP;
+	DC_MOTOR_g_outputCompare = 0;
+	DC_MOTOR_g_spinning = DC_MOTOR_STOP;
+	DC_MOTOR_g_phase = DC_MOTOR_PHASE_IDLE;
+	DC_MOTOR_g_ticks = 0;
+	DC_MOTOR_g_blanking = 0;
+	DC_MOTOR_g_tripsInRow = 0;
+	DC_MOTOR_g_trips = 0;
+	DC_MOTOR_g_stalled = FALSE;
+	TIMER_setCallback(DC_MOTOR_tick);
+	/*sample at every overflow of timer 0, the PWM output is set there*/
+	ADC_startAutoTrigger(DC_MOTOR_CURRENT_CHANNEL, ADC_TRIGGER_TIMER0_OVERFLOW, DC_MOTOR_currentSample);
+	return DC_MOTOR_NO_ERROR;
+}
+
+/*
+ * @brief set the kick-start boost, it applies from the next start
+ *
+ * @param uint8 a_speed the speed of the boost, 0 -> no boost
+ *
+ * @param uint16 a_time the time of the boost in ms up to DC_MOTOR_MAX_BOOST_MS, 0 -> no boost
+ * */
+DC_MOTOR_ErrorType DC_MOTOR_setBoost(uint8 a_speed, uint16 a_time)
+{
+	if(a_speed > DC_MOTOR_MAX_SPEED)
+	{
+		return ERROR_record(DC_MOTOR_ERROR_SPEED);
+	}
+	if(a_time > DC_MOTOR_MAX_BOOST_MS)
+	{
+		return ERROR_record(DC_MOTOR_ERROR_TIME);
+	}
+	/*a running boost keeps its end, only the next start uses the new values*/
+	DC_MOTOR_g_boostCompare = (a_time == 0) ? 0 : (uint8)(((uint16)a_speed * PWM_MAX_VALUE) / DC_MOTOR_MAX_SPEED);
+	DC_MOTOR_g_boostTime = a_time;
+	return DC_MOTOR_NO_ERROR;
 }
 
 /*
  * @brief the function will spin the motor based on
- * the state and the speed of the motor
+ * the state and the speed of the motor, the bridge follows from the tick
  *
- * @param DcMotor_State a state of Clock wise or anti clock wise
+ * @param DcMotor_State a state of Clock wise, anti clock wise, coast or brake
  *
  * @param uint8 speed it the speed of the motor
  * */
 DC_MOTOR_ErrorType DC_MOTOR_Rotate(DcMotor_State a_state,uint8 a_speed)
 {
-	DC_MOTOR_ErrorType response = {DC_MOTOR_NO_ERROR, DC_MOTOR_NO_ERROR_MSG};
 	uint16 compareValue = 0;
+	uint8 sreg = 0;
 	/*Input validation*/
 
 	/*Check if states are correct*/
-	if(a_state > DC_MOTOR_CW)
+	if(a_state > DC_MOTOR_BRAKE)
 	{
 		/*if true then the state is incorrect */
-		response.code = DC_MOTOR_ERROR_STATE;
-		response.message = DC_MOTOR_ERROR_STATE_MSG;
-		return response;
+		return ERROR_record(DC_MOTOR_ERROR_STATE);
 	}
 
 	/*Check if the speed within the speed limits */
 	if(a_speed > DC_MOTOR_MAX_SPEED)
 	{
 		/*If true that means the speed is not correct*/
-		response.code = DC_MOTOR_ERROR_SPEED;
-		response.message = DC_MOTOR_ERROR_SPEED_MSG;
-		return response;
+		return ERROR_record(DC_MOTOR_ERROR_SPEED);
 	}
 
 	/*If we reach this area that means the function is safe to be executed
 	 * using these arguments */
 
-	/*
-	 * if the state is DC_MOTOR_STOP(in other words 0)
-	 * 	then we will write 00 to the both PINS
-	 *
-	 * if the state is DC_MOTOR_ACW(in other words 1)
-	 * 	then we will write
-	 * 	LOGIC_LOW to DC_MOTOR_PIN1
-	 * 	and
-	 * 	LOGIC_HIGH to DC_MOTOR_PIN2
-	 *
-	 * if the state is DC_MOTOR_CW(in other words 2)
-	 * 	then we will write
-	 * 	LOGIC_HIGH to DC_MOTOR_PIN1
-	 * 	and
-	 * 	LOGIC_LOW to DC_MOTOR_PIN2
-	 * */
-	switch(a_state)
-	{
-	case DC_MOTOR_ACW:
-		GPIO_writePin(DC_MOTOR_PORT, DC_MOTOR_PIN1, LOGIC_LOW);
-		GPIO_writePin(DC_MOTOR_PORT, DC_MOTOR_PIN2, LOGIC_HIGH);
-		break;
-	case DC_MOTOR_CW:
-		GPIO_writePin(DC_MOTOR_PORT, DC_MOTOR_PIN2, LOGIC_LOW);
-		GPIO_writePin(DC_MOTOR_PORT, DC_MOTOR_PIN1, LOGIC_HIGH);
-		break;
-	default:
-		DC_MOTOR_stopMotor();
-		return response;
-	}
-
 	/*
 	 * to find the required compare value based on the speed :
 	 *
@@ -119,6 +348,46 @@ DC_MOTOR_ErrorType DC_MOTOR_Rotate(DcMotor_State a_state,uint8 a_speed)
 	 * */
 	compareValue = (((uint16)a_speed * PWM_MAX_VALUE)/DC_MOTOR_MAX_SPEED);
 
-	PWM_Timer0_Start((uint8)compareValue);
-	return response;
+	sreg = SREG;
+	cli();/*the tick ISR must not move the bridge between these lines*/
+	DC_MOTOR_g_state = a_state;
+	DC_MOTOR_g_compare = (a_state == DC_MOTOR_ACW || a_state == DC_MOTOR_CW) ? (uint8)compareValue : 0;
+	DC_MOTOR_update();
+	SREG = sreg;
+	return DC_MOTOR_NO_ERROR;
+}
+
+/*
+ * @brief return TRUE while the motor is stalled, DC_MOTOR_STALL_TRIPS over-current
+ * cut-offs in a row and no successful retry since
+ * */
+uint8 DC_MOTOR_isStalled(void)
+{
+	return DC_MOTOR_g_stalled;
+}
+
+/*
+ * @brief return the last current sample, an ADC code of DC_MOTOR_CURRENT_CHANNEL
+ * */
+uint16 DC_MOTOR_getCurrent(void)
+{
+	uint16 current = 0;
+	uint8 sreg = SREG;
+	cli();/*2 bytes written by the ADC ISR*/
+	current = DC_MOTOR_g_current;
+	SREG = sreg;
+	return current;
+}
+
+/*
+ * @brief return the number of over-current cut-offs since DC_MOTOR_Init
+ * */
+uint16 DC_MOTOR_getTrips(void)
+{
+	uint16 trips = 0;
+	uint8 sreg = SREG;
+	cli();
+	trips = DC_MOTOR_g_trips;
+	SREG = sreg;
+	return trips;
 }
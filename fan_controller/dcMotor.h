@@ -6,6 +6,33 @@
  *
  * Description: Header file for the AVR DC motor driver
  *
+ * States of the H-bridge (PWM on the enable input):
+ * 	DC_MOTOR_STOP	coast, both pins low and the pwm off, the fan spins down freely
+ * 	DC_MOTOR_BRAKE	both pins high with the enable on, the motor is shorted and held
+ * 	DC_MOTOR_ACW/CW	driven at the speed
+ * DC_MOTOR_Rotate only records the required state, the bridge is moved to it by the
+ * 1ms tick of timer.h so the caller never waits:
+ * 	- every change between two driven states (a direction or the brake) goes through
+ * 	  DC_MOTOR_DEAD_TIME_MS with all off first, coasting is always at once
+ * 	- a reversal, or a start the other way while the fan may still turn, brakes for
+ * 	  DC_MOTOR_BRAKE_MS before the new direction is driven
+ *
+ * Kick-start boost: a fan started at a low duty may not overcome its static friction
+ * and stays energized but stalled. When the motor starts (from stopped, from 0% or
+ * in the other direction) at a speed below the boost speed, the boost speed is applied
+ * and the tick lowers it to the required speed once the boost time is over. A new
+ * speed during the boost only replaces the speed it ends at, a speed at or above the
+ * boost speed ends it.
+ *
+ * Over-current: the current sense amplifier of the bridge ground shunt is converted
+ * by the ADC at every overflow of timer 0, the start of the on-phase of the PWM, and
+ * compared in the ADC ISR. A sample above DC_MOTOR_CURRENT_LIMIT_CODE (not during the
+ * blanking after a start or a large speed step, the inrush of the rotor at rest) or
+ * above DC_MOTOR_CURRENT_SHORT_CODE (always) cuts the bridge in the same PWM period.
+ * The required state is driven again after DC_MOTOR_TRIP_BACKOFF_MS, doubled after
+ * every trip in a row, and DC_MOTOR_STALL_TRIPS trips in a row set the stall flag.
+ * The first sample under the limit after a blanking clears both.
+ *
  * Layer: Hardware Abstraction Layer (HAL)
  *
  * Author: Abdullah Mahmoud
@@ -15,46 +42,91 @@
 #define DCMOTOR_H_
 
 #include"std_types.h"
+#include"error.h"
 
 #define DC_MOTOR_MAX_SPEED		100
 #define DC_MOTOR_MIN_SPEED		0
 #define DC_MOTOR_PORT			PORTD_ID
 #define DC_MOTOR_PIN1			PIN5_ID
 #define DC_MOTOR_PIN2			PIN6_ID
+#define DC_MOTOR_MAX_BOOST_MS	2000
+
+/*all off between two driven states, 2 ticks are at least 1ms whatever the tick phase*/
+#define DC_MOTOR_DEAD_TIME_MS	2
+
+/*brake to zero of a reversal, a full speed fan stops within it (see host/stop_sim)*/
+#ifndef DC_MOTOR_BRAKE_MS
+#define DC_MOTOR_BRAKE_MS		1500
+#endif
 
-/*Error messages */
-#define DC_MOTOR_NO_ERROR_MSG		((uint8*)"Function success")
-#define DC_MOTOR_ERROR_STATE_MSG	((uint8*)"Incorrect Motor state")
-#define DC_MOTOR_ERROR_SPEED_MSG	((uint8*)"Incorrect Motor speed")
+/*current sensing, the amplifier gives 2V (code 800) at the stall current of the fan*/
+#define DC_MOTOR_CURRENT_CHANNEL		1
+#define DC_MOTOR_CURRENT_STALL_CODE		800
+#ifndef DC_MOTOR_CURRENT_LIMIT_CODE
+#define DC_MOTOR_CURRENT_LIMIT_CODE		160 /*20% of the stall current*/
+#endif
+#define DC_MOTOR_CURRENT_SHORT_CODE		1000 /*above the stall current, a short*/
+#define DC_MOTOR_BLANKING_MS			1000
+#define DC_MOTOR_BLANKING_STEP			38 /*compare value, a speed step above 15% is blanked*/
+#define DC_MOTOR_TRIP_BACKOFF_MS		500
+#define DC_MOTOR_TRIP_MAX_SHIFT			4 /*up to 8s between two retries*/
+#define DC_MOTOR_STALL_TRIPS			3
 
-typedef struct {
-	enum
-	{
-		DC_MOTOR_NO_ERROR, DC_MOTOR_ERROR_STATE, DC_MOTOR_ERROR_SPEED
-	}code;
-	uint8* message;
-}DC_MOTOR_ErrorType;
+/*Errors, the messages are in error.c*/
+#define DC_MOTOR_NO_ERROR		ERROR_NONE
+#define DC_MOTOR_ERROR_STATE	ERROR_CODE(ERROR_MODULE_DC_MOTOR, 1)
+#define DC_MOTOR_ERROR_SPEED	ERROR_CODE(ERROR_MODULE_DC_MOTOR, 2)
+#define DC_MOTOR_ERROR_TIME		ERROR_CODE(ERROR_MODULE_DC_MOTOR, 3)
+
+typedef ERROR_CodeType DC_MOTOR_ErrorType;
 
 typedef enum {
 
-	DC_MOTOR_STOP = 0, DC_MOTOR_ACW = 1, DC_MOTOR_CW = 2
+	DC_MOTOR_STOP = 0, DC_MOTOR_ACW = 1, DC_MOTOR_CW = 2, DC_MOTOR_BRAKE = 3,
+	DC_MOTOR_COAST = DC_MOTOR_STOP
 
 }DcMotor_State;
 
 /*
  * @brief the function will setup the pins of the motor
- * using gpio
+ * using gpio. It registers the sequencer tick so it is called once after TIMER_init,
+ * the boost is off until DC_MOTOR_setBoost
  * */
 DC_MOTOR_ErrorType DC_MOTOR_Init(void);
 
+/*
+ * @brief set the kick-start boost, it applies from the next start
+ *
+ * @param uint8 a_speed the speed of the boost, 0 -> no boost
+ *
+ * @param uint16 a_time the time of the boost in ms up to DC_MOTOR_MAX_BOOST_MS, 0 -> no boost
+ * */
+DC_MOTOR_ErrorType DC_MOTOR_setBoost(uint8 a_speed, uint16 a_time);
+
 /*
  * @brief the function will spin the motor based on
- * the state and the speed of the motor
+ * the state and the speed of the motor, the bridge follows from the tick
  *
- * @param DcMotor_State a state of Clock wise or anti clock wise
+ * @param DcMotor_State a state of Clock wise, anti clock wise, coast or brake
  *
  * @param uint8 speed it the speed of the motor
  * */
 DC_MOTOR_ErrorType DC_MOTOR_Rotate(DcMotor_State a_state,uint8 a_speed);
 
+/*
+ * @brief return TRUE while the motor is stalled, DC_MOTOR_STALL_TRIPS over-current
+ * cut-offs in a row and no successful retry since
+ * */
+uint8 DC_MOTOR_isStalled(void);
+
+/*
+ * @brief return the last current sample, an ADC code of DC_MOTOR_CURRENT_CHANNEL
+ * */
+uint16 DC_MOTOR_getCurrent(void);
+
+/*
+ * @brief return the number of over-current cut-offs since DC_MOTOR_Init
+ * */
+uint16 DC_MOTOR_getTrips(void);
+
 #endif /* DCMOTOR_H_ */
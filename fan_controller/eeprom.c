@@ -0,0 +1,148 @@
+/*
+ *
+ * Module: EEPROM
+ *
+ * File Name: eeprom.c
+ *
+ * Description: Source file for the AVR internal EEPROM driver
+ *
+ * Layer: Micro controller Abstraction Layer (MCAL)
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"eeprom.h"
+#include<avr/io.h>
+#include<avr/interrupt.h>
+#include"common_macros.h"
+#include"trace.h"
+
+#ifndef EEPROM_START_WRITE
+/*sbi EEMWE then sbi EEWE, 2 cycles apart at any optimization level, as in avr-libc*/
+#define EEPROM_START_WRITE()	__asm__ __volatile__("sbi %0, %1\n\tsbi %0, %2\n" \
+		: : "I" (_SFR_IO_ADDR(EECR)), "I" (EEMWE), "I" (EEWE) : "memory")
+#endif
+
+/*Global Variables */
+static const uint8 * volatile EEPROM_g_source = NULL_PTR;
+static volatile uint16 EEPROM_g_address = 0;
+static volatile uint16 EEPROM_g_remaining = 0;
+
+/*
+ * @brief read one byte, the caller makes sure no write is in progress
+ * */
+static uint8 EEPROM_readByte(uint16 a_address)
+{
+	EEAR = a_address;
+	SET_BIT(EECR, EERE);
+	return EEDR;
+}
+
+/*
+ * @brief will be called every time the EEPROM is ready for a new write
+ * */
+ISR(EE_RDY_vect)
+{
+	uint8 data = 0;
+	TRACE_EVENT(TRACE_EEPROM_ISR, EEPROM_g_remaining);
+	while(EEPROM_g_remaining != 0)
+	{
+		data = *EEPROM_g_source;
+		EEPROM_g_source++;
+		EEPROM_g_remaining--;
+		if(EEPROM_readByte(EEPROM_g_address) != data)
+		{
+			EEDR = data; /*EEAR is already set by the read*/
+			EEPROM_START_WRITE();
+			EEPROM_g_address++;
+			return; /*the ISR fires again when this byte is written*/
+		}
+		EEPROM_g_address++; /*same value, skip the slow write*/
+	}
+	/*The block is done*/
+	CLEAR_BIT(EECR, EERIE);
+	EEPROM_g_source = NULL_PTR;
+}
+
+/*
+ * @brief return TRUE while an asynchronous write is in progress
+ * */
+uint8 EEPROM_isBusy(void)
+{
+	return (EEPROM_g_source != NULL_PTR || BIT_IS_SET(EECR, EEWE)) ? TRUE : FALSE;
+}
+
+/*
+ * @brief read a block from the EEPROM, the read itself takes a few cycles per byte.
+ *
+ * @param a_address the first EEPROM address
+ *
+ * @param a_data pointer to the destination
+ *
+ * @param a_length number of bytes
+ *
+ * @return EEPROM_ErrorType EEPROM_ERROR_BUSY if a write is still in progress
+ * */
+EEPROM_ErrorType EEPROM_readBlock(uint16 a_address, uint8 * a_data, uint16 a_length)
+{
+	uint16 i = 0;
+	if(a_data == NULL_PTR)
+	{
+		return EEPROM_ERROR_NULL_PTR;
+	}
+	if(a_address >= EEPROM_SIZE || a_length > EEPROM_SIZE - a_address)
+	{
+		return EEPROM_ERROR_ADDRESS;
+	}
+	if(EEPROM_isBusy())
+	{
+		/*Never wait for the 8.5ms write time*/
+		return EEPROM_ERROR_BUSY;
+	}
+	for(i = 0; i < a_length; i++)
+	{
+		a_data[i] = EEPROM_readByte(a_address + i);
+	}
+	return EEPROM_SUCCESS;
+}
+
+/*
+ * @brief start writing a block to the EEPROM and return immediately.
+ * The buffer is used by the ISR so it must stay unchanged until EEPROM_isBusy is FALSE.
+ * Bytes that already hold the new value are skipped to save time and wear.
+ *
+ * @param a_address the first EEPROM address
+ *
+ * @param a_data pointer to the source
+ *
+ * @param a_length number of bytes
+ *
+ * @return EEPROM_ErrorType EEPROM_ERROR_BUSY if a write is still in progress
+ * */
+EEPROM_ErrorType EEPROM_writeBlock(uint16 a_address, const uint8 * a_data, uint16 a_length)
+{
+	if(a_data == NULL_PTR)
+	{
+		return EEPROM_ERROR_NULL_PTR;
+	}
+	if(a_address >= EEPROM_SIZE || a_length > EEPROM_SIZE - a_address)
+	{
+		return EEPROM_ERROR_ADDRESS;
+	}
+	if(EEPROM_isBusy())
+	{
+		return EEPROM_ERROR_BUSY;
+	}
+	if(a_length == 0)
+	{
+		return EEPROM_SUCCESS;
+	}
+	EEPROM_g_address = a_address;
+	EEPROM_g_remaining = a_length;
+	EEPROM_g_source = a_data;
+
+	SET_BIT(EECR, EERIE); /*The ready interrupt fires right away and writes the first byte*/
+	SREG |= (1 << SREG_I);/*Set the i-bit*/
+	return EEPROM_SUCCESS;
+}
@@ -0,0 +1,64 @@
+/*
+ *
+ * Module: EEPROM
+ *
+ * File Name: eeprom.h
+ *
+ * Description: Header file for the AVR internal EEPROM driver.
+ * Writes are asynchronous, every byte takes about 8.5ms so the bytes are
+ * written one by one from the EEPROM ready ISR.
+ *
+ * Layer: Micro controller Abstraction Layer (MCAL)
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef EEPROM_H_
+#define EEPROM_H_
+
+#include"std_types.h"
+
+#define EEPROM_SIZE					1024
+
+#define EEPROM_SUCCESS				0
+#define EEPROM_ERROR_BUSY			EEPROM_SUCCESS + 1
+#define EEPROM_ERROR_ADDRESS		EEPROM_ERROR_BUSY + 1
+#define EEPROM_ERROR_NULL_PTR		EEPROM_ERROR_ADDRESS + 1
+
+typedef uint8 EEPROM_ErrorType;
+
+/*
+ * @brief read a block from the EEPROM, the read itself takes a few cycles per byte.
+ *
+ * @param a_address the first EEPROM address
+ *
+ * @param a_data pointer to the destination
+ *
+ * @param a_length number of bytes
+ *
+ * @return EEPROM_ErrorType EEPROM_ERROR_BUSY if a write is still in progress
+ * */
+EEPROM_ErrorType EEPROM_readBlock(uint16 a_address, uint8 * a_data, uint16 a_length);
+
+/*
+ * @brief start writing a block to the EEPROM and return immediately.
+ * The buffer is used by the ISR so it must stay unchanged until EEPROM_isBusy is FALSE.
+ * Bytes that already hold the new value are skipped to save time and wear.
+ *
+ * @param a_address the first EEPROM address
+ *
+ * @param a_data pointer to the source
+ *
+ * @param a_length number of bytes
+ *
+ * @return EEPROM_ErrorType EEPROM_ERROR_BUSY if a write is still in progress
+ * */
+EEPROM_ErrorType EEPROM_writeBlock(uint16 a_address, const uint8 * a_data, uint16 a_length);
+
+/*
+ * @brief return TRUE while an asynchronous write is in progress
+ * */
+uint8 EEPROM_isBusy(void);
+
+#endif /* EEPROM_H_ */
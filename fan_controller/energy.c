@@ -0,0 +1,277 @@
+/*
+ *
+ * Module: Energy
+ *
+ * File Name: energy.c
+ *
+ * Description: Source file for the fan energy and runtime accounting
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"energy.h"
+#include"eeprom.h"
+#include"timer.h"
+#include"telemetry.h"
+#include"crc.h"
+#include<avr/io.h>
+#include<avr/interrupt.h>
+
+#define ENERGY_NO_BIN				0xFF /*the fan is off*/
+#define ENERGY_MS_PER_SECOND		1000
+
+/*the record fits in its slot and in one frame*/
+typedef char ENERGY_recordSizeCheck[(ENERGY_RECORD_SIZE <= ENERGY_SLOT_SIZE
+		&& ENERGY_RECORD_SIZE <= TELEMETRY_MAX_PAYLOAD) ? 1 : -1];
+
+/*Global Variables */
+/*shared with the tick ISR*/
+static volatile ENERGY_CountersType ENERGY_g_counters;
+static volatile uint32 ENERGY_g_percentMs = 0; /*duty * ms not yet moved to the full-duty seconds*/
+static volatile uint16 ENERGY_g_ms = 0; /*ms of the current second*/
+static volatile uint8 ENERGY_g_duty = 0;
+static volatile uint8 ENERGY_g_bin = ENERGY_NO_BIN;
+static volatile uint16 ENERGY_g_saveCountdown = ENERGY_SAVE_PERIOD_S;
+static volatile uint8 ENERGY_g_savePending = FALSE;
+
+static uint8 ENERGY_g_record[ENERGY_RECORD_SIZE]; /*used by the EEPROM ISR while saving*/
+static uint16 ENERGY_g_sequence = 0;
+static uint8 ENERGY_g_slot = ENERGY_SLOTS - 1;
+static uint8 ENERGY_g_dumpPending = FALSE;
+
+static void ENERGY_putUint32(uint8 * a_buffer, uint32 a_value)
+{
+	a_buffer[0] = (uint8)a_value;
+	a_buffer[1] = (uint8)(a_value >> 8);
+	a_buffer[2] = (uint8)(a_value >> 16);
+	a_buffer[3] = (uint8)(a_value >> 24);
+}
+
+static uint32 ENERGY_getUint32(const uint8 * a_buffer)
+{
+	return (uint32)a_buffer[0] | ((uint32)a_buffer[1] << 8) | ((uint32)a_buffer[2] << 16)
+			| ((uint32)a_buffer[3] << 24);
+}
+
+/*
+ * @brief called every 1ms from the tick ISR, only adds and compares
+ * */
+static void ENERGY_tick(void)
+{
+	ENERGY_g_percentMs += ENERGY_g_duty;
+	if(ENERGY_g_percentMs >= ENERGY_PERCENT_MS)
+	{
+		ENERGY_g_percentMs -= ENERGY_PERCENT_MS;
+		ENERGY_g_counters.fullDutySeconds++;
+	}
+	ENERGY_g_ms++;
+	if(ENERGY_g_ms < ENERGY_MS_PER_SECOND)
+	{
+		return;
+	}
+	ENERGY_g_ms = 0;
+	ENERGY_g_counters.seconds++;
+	if(ENERGY_g_bin != ENERGY_NO_BIN)
+	{
+		ENERGY_g_counters.binSeconds[ENERGY_g_bin]++;
+	}
+	ENERGY_g_saveCountdown--;
+	if(ENERGY_g_saveCountdown == 0)
+	{
+		ENERGY_g_saveCountdown = ENERGY_SAVE_PERIOD_S;
+		ENERGY_g_savePending = TRUE;
+	}
+}
+
+/*
+ * @brief write the counters as a record with the CRC
+ * */
+static void ENERGY_buildRecord(uint8 * a_record, uint16 a_sequence)
+{
+	ENERGY_CountersType counters;
+	uint16 crc = 0;
+	uint8 i = 0;
+
+	ENERGY_getCounters(&counters);
+	a_record[0] = (uint8)a_sequence;
+	a_record[1] = (uint8)(a_sequence >> 8);
+	ENERGY_putUint32(&a_record[2], counters.seconds);
+	ENERGY_putUint32(&a_record[6], counters.fullDutySeconds);
+	ENERGY_putUint32(&a_record[10], counters.starts);
+	ENERGY_putUint32(&a_record[14], counters.speedChanges);
+	for(i = 0; i < ENERGY_DUTY_BINS; i++)
+	{
+		ENERGY_putUint32(&a_record[18 + (4 * i)], counters.binSeconds[i]);
+	}
+	crc = CRC16_update(CRC16_INITIAL_VALUE, a_record, ENERGY_RECORD_SIZE - 2);
+	a_record[ENERGY_RECORD_SIZE - 2] = (uint8)crc;
+	a_record[ENERGY_RECORD_SIZE - 1] = (uint8)(crc >> 8);
+}
+
+/*
+ * @brief load the newest saved counters and register the tick,
+ * the timer and the EEPROM must be initialized before
+ * */
+void ENERGY_init(void)
+{
+	uint8 slot = 0, found = FALSE, i = 0;
+	uint16 sequence = 0, crc = 0;
+	uint8 * record = ENERGY_g_record;
+
+	ENERGY_g_counters.seconds = 0;
+	ENERGY_g_counters.fullDutySeconds = 0;
+	ENERGY_g_counters.starts = 0;
+	ENERGY_g_counters.speedChanges = 0;
+	for(i = 0; i < ENERGY_DUTY_BINS; i++)
+	{
+		ENERGY_g_counters.binSeconds[i] = 0;
+	}
+	ENERGY_g_percentMs = 0;
+	ENERGY_g_ms = 0;
+	ENERGY_g_duty = 0;
+	ENERGY_g_bin = ENERGY_NO_BIN;
+	ENERGY_g_saveCountdown = ENERGY_SAVE_PERIOD_S;
+	ENERGY_g_savePending = FALSE;
+	ENERGY_g_dumpPending = FALSE;
+	ENERGY_g_sequence = 0;
+	ENERGY_g_slot = ENERGY_SLOTS - 1;
+
+	for(slot = 0; slot < ENERGY_SLOTS; slot++)
+	{
+		if(EEPROM_readBlock(ENERGY_EEPROM_ADDRESS + ((uint16)slot * ENERGY_SLOT_SIZE),
+				record, ENERGY_RECORD_SIZE) != EEPROM_SUCCESS)
+		{
+			continue;
+		}
+		crc = CRC16_update(CRC16_INITIAL_VALUE, record, ENERGY_RECORD_SIZE - 2);
+		if(record[ENERGY_RECORD_SIZE - 2] != (uint8)crc || record[ENERGY_RECORD_SIZE - 1] != (uint8)(crc >> 8))
+		{
+			continue;
+		}
+		sequence = (uint16)(record[0] | ((uint16)record[1] << 8));
+		if(found == TRUE && (sint16)(sequence - ENERGY_g_sequence) <= 0)
+		{
+			continue;
+		}
+		found = TRUE;
+		ENERGY_g_sequence = sequence;
+		ENERGY_g_slot = slot;
+		ENERGY_g_counters.seconds = ENERGY_getUint32(&record[2]);
+		ENERGY_g_counters.fullDutySeconds = ENERGY_getUint32(&record[6]);
+		ENERGY_g_counters.starts = ENERGY_getUint32(&record[10]);
+		ENERGY_g_counters.speedChanges = ENERGY_getUint32(&record[14]);
+		for(i = 0; i < ENERGY_DUTY_BINS; i++)
+		{
+			ENERGY_g_counters.binSeconds[i] = ENERGY_getUint32(&record[18 + (4 * i)]);
+		}
+	}
+	TIMER_setCallback(ENERGY_tick);
+}
+
+/*
+ * @brief account the duty applied to the fan from now on
+ *
+ * @param uint8 a_duty the fan speed in percent
+ * */
+void ENERGY_setDuty(uint8 a_duty)
+{
+	uint8 sreg = 0;
+
+	if(a_duty == ENERGY_g_duty)
+	{
+		return;
+	}
+	/*only the main loop writes these two counters*/
+	ENERGY_g_counters.speedChanges++;
+	if(ENERGY_g_duty == 0)
+	{
+		ENERGY_g_counters.starts++;
+	}
+	sreg = SREG;
+	cli();/*the tick must see the duty and its bin together*/
+	ENERGY_g_duty = a_duty;
+	ENERGY_g_bin = (a_duty == 0) ? ENERGY_NO_BIN : (uint8)((a_duty - 1) / (100 / ENERGY_DUTY_BINS));
+	if(ENERGY_g_bin >= ENERGY_DUTY_BINS && a_duty != 0)
+	{
+		ENERGY_g_bin = ENERGY_DUTY_BINS - 1;
+	}
+	SREG = sreg;
+}
+
+/*
+ * @brief copy the counters
+ * */
+void ENERGY_getCounters(ENERGY_CountersType * a_counters)
+{
+	uint8 sreg = SREG;
+	uint8 i = 0;
+
+	cli();/*a consistent copy, the tick moves the time between the fields*/
+	a_counters->seconds = ENERGY_g_counters.seconds;
+	a_counters->fullDutySeconds = ENERGY_g_counters.fullDutySeconds;
+	a_counters->starts = ENERGY_g_counters.starts;
+	a_counters->speedChanges = ENERGY_g_counters.speedChanges;
+	for(i = 0; i < ENERGY_DUTY_BINS; i++)
+	{
+		a_counters->binSeconds[i] = ENERGY_g_counters.binSeconds[i];
+	}
+	SREG = sreg;
+}
+
+/*
+ * @brief return the energy in Wh of a number of full-duty seconds
+ *
+ * @param uint32 a_fullDutySeconds the time at 100%
+ *
+ * @param uint16 a_power the power of the fan at 100% in 0.1W
+ * */
+uint32 ENERGY_toWattHours(uint32 a_fullDutySeconds, uint16 a_power)
+{
+	/*3600s and 10 tenths of W, the product needs 48 bits*/
+	return (uint32)(((uint64)a_fullDutySeconds * a_power) / 36000UL);
+}
+
+/*
+ * @brief send the counters as one TELEMETRY_FRAME_ENERGY frame holding a record
+ *
+ * @return uint8 FALSE if a dump is already waiting
+ * */
+uint8 ENERGY_startDump(void)
+{
+	if(ENERGY_g_dumpPending)
+	{
+		return FALSE;
+	}
+	ENERGY_g_dumpPending = TRUE;
+	return TRUE;
+}
+
+/*
+ * @brief save the counters when it is time and the EEPROM is free and send
+ * a requested dump when the UART has room for it, it must be called from the main loop.
+ * */
+void ENERGY_process(void)
+{
+	uint8 record[ENERGY_RECORD_SIZE];
+
+	if(ENERGY_g_savePending && !EEPROM_isBusy())
+	{
+		ENERGY_g_savePending = FALSE;
+		ENERGY_g_sequence++;
+		ENERGY_g_slot = (ENERGY_g_slot + 1) % ENERGY_SLOTS;
+		ENERGY_buildRecord(ENERGY_g_record, ENERGY_g_sequence);
+		EEPROM_writeBlock(ENERGY_EEPROM_ADDRESS + ((uint16)ENERGY_g_slot * ENERGY_SLOT_SIZE),
+				ENERGY_g_record, ENERGY_RECORD_SIZE);
+	}
+
+	if(ENERGY_g_dumpPending && TELEMETRY_canSend(ENERGY_RECORD_SIZE))
+	{
+		/*a record of the counters now, the saved one may be an hour old*/
+		ENERGY_buildRecord(record, ENERGY_g_sequence);
+		TELEMETRY_sendFrame(TELEMETRY_FRAME_ENERGY, record, ENERGY_RECORD_SIZE);
+		ENERGY_g_dumpPending = FALSE;
+	}
+}
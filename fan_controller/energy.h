@@ -0,0 +1,100 @@
+/*
+ *
+ * Module: Energy
+ *
+ * File Name: energy.h
+ *
+ * Description: Header file for the fan energy and runtime accounting.
+ *
+ * The 1ms tick adds the applied duty to a counter of percent-ms and moves every
+ * full 100% * 1s out of it into the full-duty seconds, so the tick only adds and
+ * compares. The energy is the full-duty seconds times the power of the fan at 100%
+ * (set by the "power" command), it is computed when it is read:
+ *
+ * 	Wh = full-duty seconds * power(0.1W) / 36000
+ *
+ * Every second at a duty above 0 is counted in the bin of its duty (1-10%, 11-20% ...
+ * 91-100%), the bin is found when the duty changes and not in the tick. The speed
+ * changes and the starts (0 -> a duty) are counted by ENERGY_setDuty.
+ *
+ * The counters are saved every ENERGY_SAVE_PERIOD_S to two EEPROM slots in turn,
+ * the valid slot with the newest sequence is loaded by ENERGY_init:
+ *
+ * 	record = sequence(2) | seconds(4) | full-duty seconds(4) | starts(4)
+ * 	         | speed changes(4) | seconds per bin(4 * ENERGY_DUTY_BINS) | CRC16(2)
+ *
+ * A reset loses the counts since the last save, at most ENERGY_SAVE_PERIOD_S.
+ *
+ * EEPROM map:
+ * 	0x200 -> 0x27F	energy counters (this module)
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef ENERGY_H_
+#define ENERGY_H_
+
+#include"std_types.h"
+
+#define ENERGY_DUTY_BINS			10 /*10% each*/
+#define ENERGY_PERCENT_MS			100000UL /*100% for 1s*/
+#define ENERGY_SAVE_PERIOD_S		3600 /*each slot is written every 2 hours, 100k writes last 22 years*/
+
+#define ENERGY_EEPROM_ADDRESS		0x200
+#define ENERGY_SLOTS				2
+#define ENERGY_SLOT_SIZE			64
+#define ENERGY_RECORD_SIZE			(18 + (4 * ENERGY_DUTY_BINS) + 2)
+
+typedef struct
+{
+	uint32 seconds; /*since the first start of the firmware*/
+	uint32 fullDutySeconds; /*duty * time in seconds at 100%*/
+	uint32 starts; /*changes from 0 to a duty*/
+	uint32 speedChanges; /*changes of the applied duty*/
+	uint32 binSeconds[ENERGY_DUTY_BINS]; /*seconds at each duty bin*/
+}ENERGY_CountersType;
+
+/*
+ * @brief load the newest saved counters and register the tick,
+ * the timer and the EEPROM must be initialized before
+ * */
+void ENERGY_init(void);
+
+/*
+ * @brief account the duty applied to the fan from now on
+ *
+ * @param uint8 a_duty the fan speed in percent
+ * */
+void ENERGY_setDuty(uint8 a_duty);
+
+/*
+ * @brief copy the counters
+ * */
+void ENERGY_getCounters(ENERGY_CountersType * a_counters);
+
+/*
+ * @brief return the energy in Wh of a number of full-duty seconds
+ *
+ * @param uint32 a_fullDutySeconds the time at 100%
+ *
+ * @param uint16 a_power the power of the fan at 100% in 0.1W
+ * */
+uint32 ENERGY_toWattHours(uint32 a_fullDutySeconds, uint16 a_power);
+
+/*
+ * @brief send the counters as one TELEMETRY_FRAME_ENERGY frame holding a record
+ *
+ * @return uint8 FALSE if a dump is already waiting
+ * */
+uint8 ENERGY_startDump(void);
+
+/*
+ * @brief save the counters when it is time and the EEPROM is free and send
+ * a requested dump when the UART has room for it, it must be called from the main loop.
+ * */
+void ENERGY_process(void);
+
+#endif /* ENERGY_H_ */
@@ -0,0 +1,274 @@
+/*
+ *
+ * Module: Error
+ *
+ * File Name: error.c
+ *
+ * Description: Source file for the unified error codes and the error log.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"error.h"
+#include"adc.h"
+#include"gpio.h"
+#include"pwm.h"
+#include"dcMotor.h"
+#include"lcd.h"
+#include"timer.h"
+#include"telemetry.h"
+#include<avr/io.h>
+#include<avr/interrupt.h>
+#include<avr/pgmspace.h>
+#include<string.h>
+
+typedef struct
+{
+	ERROR_CodeType code;
+	char message[ERROR_MESSAGE_SIZE];
+}ERROR_MessageType;
+
+/*the frame of the longest message fits in the payload*/
+typedef char ERROR_frameSizeCheck[(ERROR_HEADER_SIZE + ERROR_MESSAGE_SIZE - 1 <= TELEMETRY_MAX_PAYLOAD) ? 1 : -1];
+
+/*in the flash only, read by ERROR_getMessage*/
+static const ERROR_MessageType ERROR_g_messages[] PROGMEM =
+{
+	{ERROR_NONE, "No error"},
+	{ADC_ERROR_NOT_INIT, "ADC not initialized"},
+	{ADC_ERROR_WRONG_CHANNEL, "ADC wrong channel"},
+	{ADC_ERROR_WRONG_MODE, "ADC wrong mode"},
+	{ADC_ERROR_NULL_PTR, "ADC null pointer"},
+	{ADC_ERROR_WRONG_GAIN, "ADC wrong gain"},
+	{ADC_ERROR_TIMEOUT, "ADC timeout"},
+	{GPIO_ERROR_PORT, "GPIO wrong port"},
+	{GPIO_ERROR_PIN, "GPIO wrong pin"},
+	{GPIO_ERROR_VALUE, "GPIO wrong pin value"},
+	{PWM_ERROR_PRESCALER, "PWM wrong pre-scaler"},
+	{DC_MOTOR_ERROR_STATE, "Incorrect Motor state"},
+	{DC_MOTOR_ERROR_SPEED, "Incorrect Motor speed"},
+	{DC_MOTOR_ERROR_TIME, "Incorrect boost time"},
+	{LCD_ERROR_POSITION, "LCD wrong position"},
+};
+
+static const char ERROR_g_unknown[] PROGMEM = "Unknown error";
+
+#define ERROR_MESSAGES		(sizeof(ERROR_g_messages) / sizeof(ERROR_g_messages[0]))
+
+/*Global Variables */
+/*written by ERROR_record from the ISRs*/
+static volatile ERROR_EntryType ERROR_g_log[ERROR_LOG_SIZE];
+static volatile uint8 ERROR_g_next = 0; /*slot of the next new code*/
+static volatile uint8 ERROR_g_count = 0;
+static volatile uint16 ERROR_g_total = 0;
+
+static uint8 ERROR_g_dumping = FALSE;
+static uint8 ERROR_g_dumpIndex = 0;
+
+static void ERROR_putUint32(uint8 * a_buffer, uint32 a_value)
+{
+	a_buffer[0] = (uint8)a_value;
+	a_buffer[1] = (uint8)(a_value >> 8);
+	a_buffer[2] = (uint8)(a_value >> 16);
+	a_buffer[3] = (uint8)(a_value >> 24);
+}
+
+/*
+ * @brief clear the log
+ * */
+void ERROR_init(void)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	ERROR_g_next = 0;
+	ERROR_g_count = 0;
+	ERROR_g_total = 0;
+	SREG = sreg;
+	ERROR_g_dumping = FALSE;
+	ERROR_g_dumpIndex = 0;
+}
+
+/*
+ * @brief add one occurrence of an error to the log, it can be called from an ISR
+ *
+ * @param ERROR_CodeType a_code the error, ERROR_NONE is not recorded
+ *
+ * @return ERROR_CodeType a_code so a driver can record and return in one line
+ * */
+ERROR_CodeType ERROR_record(ERROR_CodeType a_code)
+{
+	uint32 now = 0;
+	uint8 sreg = 0, i = 0, slot = 0;
+
+	if(a_code == ERROR_NONE)
+	{
+		return a_code;
+	}
+	now = TIMER_getTicks();
+	sreg = SREG;
+	cli();/*an ISR may record between the search and the write*/
+	if(ERROR_g_total != ERROR_MAX_OCCURRENCES)
+	{
+		ERROR_g_total++;
+	}
+	for(i = 0; i < ERROR_g_count; i++)
+	{
+		slot = (ERROR_g_next + ERROR_LOG_SIZE - 1 - i) % ERROR_LOG_SIZE; /*the newest first*/
+		if(ERROR_g_log[slot].code == a_code)
+		{
+			if(ERROR_g_log[slot].occurrences != ERROR_MAX_OCCURRENCES)
+			{
+				ERROR_g_log[slot].occurrences++;
+			}
+			ERROR_g_log[slot].last = now;
+			SREG = sreg;
+			return a_code;
+		}
+	}
+	/*a new code, it takes the place of the oldest one when the log is full*/
+	slot = ERROR_g_next;
+	ERROR_g_log[slot].code = a_code;
+	ERROR_g_log[slot].occurrences = 1;
+	ERROR_g_log[slot].first = now;
+	ERROR_g_log[slot].last = now;
+	ERROR_g_next = (slot + 1) % ERROR_LOG_SIZE;
+	if(ERROR_g_count < ERROR_LOG_SIZE)
+	{
+		ERROR_g_count++;
+	}
+	SREG = sreg;
+	return a_code;
+}
+
+/*
+ * @brief return the number of different codes in the log
+ * */
+uint8 ERROR_getCount(void)
+{
+	return ERROR_g_count;
+}
+
+/*
+ * @brief return the occurrences of all the errors since ERROR_init, with the ones
+ * of the codes that left the log
+ * */
+uint16 ERROR_getTotal(void)
+{
+	uint8 sreg = SREG;
+	uint16 total = 0;
+
+	cli();
+	total = ERROR_g_total;
+	SREG = sreg;
+	return total;
+}
+
+/*
+ * @brief copy an entry of the log
+ *
+ * @param uint8 a_index 0 is the oldest code
+ *
+ * @param ERROR_EntryType* a_entry the copy
+ *
+ * @return uint8 FALSE if there is no such entry
+ * */
+uint8 ERROR_getEntry(uint8 a_index, ERROR_EntryType * a_entry)
+{
+	uint8 sreg = SREG, slot = 0;
+
+	cli();/*a consistent copy*/
+	if(a_index >= ERROR_g_count)
+	{
+		SREG = sreg;
+		return FALSE;
+	}
+	slot = (ERROR_g_next + ERROR_LOG_SIZE - ERROR_g_count + a_index) % ERROR_LOG_SIZE;
+	a_entry->code = ERROR_g_log[slot].code;
+	a_entry->occurrences = ERROR_g_log[slot].occurrences;
+	a_entry->first = ERROR_g_log[slot].first;
+	a_entry->last = ERROR_g_log[slot].last;
+	SREG = sreg;
+	return TRUE;
+}
+
+/*
+ * @brief copy the message of a code from the flash
+ *
+ * @param ERROR_CodeType a_code the error
+ *
+ * @param char* a_buffer at least ERROR_MESSAGE_SIZE bytes
+ *
+ * @return uint8 the length of the message
+ * */
+uint8 ERROR_getMessage(ERROR_CodeType a_code, char * a_buffer)
+{
+	uint8 i = 0;
+
+	for(i = 0; i < ERROR_MESSAGES; i++)
+	{
+		if(pgm_read_byte(&ERROR_g_messages[i].code) == a_code)
+		{
+			/*the array may be full without the terminating 0*/
+			memcpy_P(a_buffer, ERROR_g_messages[i].message, ERROR_MESSAGE_SIZE - 1);
+			a_buffer[ERROR_MESSAGE_SIZE - 1] = '\0';
+			return (uint8)strlen(a_buffer);
+		}
+	}
+	strcpy_P(a_buffer, ERROR_g_unknown);
+	return (uint8)strlen(a_buffer);
+}
+
+/*
+ * @brief send the log as ERROR frames
+ *
+ * @return uint8 FALSE if a dump is already running
+ * */
+uint8 ERROR_startDump(void)
+{
+	if(ERROR_g_dumping)
+	{
+		return FALSE;
+	}
+	ERROR_g_dumping = TRUE;
+	ERROR_g_dumpIndex = 0;
+	return TRUE;
+}
+
+/*
+ * @brief send the next ERROR frame of a dump when the UART has room for it,
+ * it must be called from the main loop.
+ * */
+void ERROR_process(void)
+{
+	uint8 payload[ERROR_HEADER_SIZE + ERROR_MESSAGE_SIZE];
+	ERROR_EntryType entry;
+	uint8 count = 0, length = 2;
+
+	if(!ERROR_g_dumping || !TELEMETRY_canSend(sizeof(payload)))
+	{
+		return;
+	}
+	count = ERROR_g_count;
+	payload[0] = ERROR_g_dumpIndex;
+	payload[1] = count;
+	if(ERROR_getEntry(ERROR_g_dumpIndex, &entry))
+	{
+		payload[2] = entry.code;
+		payload[3] = (uint8)entry.occurrences;
+		payload[4] = (uint8)(entry.occurrences >> 8);
+		ERROR_putUint32(&payload[5], entry.first);
+		ERROR_putUint32(&payload[9], entry.last);
+		length = ERROR_HEADER_SIZE + ERROR_getMessage(entry.code, (char *)&payload[ERROR_HEADER_SIZE]);
+	}
+	TELEMETRY_sendFrame(TELEMETRY_FRAME_ERROR, payload, length);
+
+	ERROR_g_dumpIndex++;
+	if(ERROR_g_dumpIndex >= count)
+	{
+		ERROR_g_dumping = FALSE;
+	}
+}
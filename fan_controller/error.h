@@ -0,0 +1,125 @@
+/*
+ *
+ * Module: Error
+ *
+ * File Name: error.h
+ *
+ * Description: Header file for the unified error codes and the error log.
+ *
+ * Every driver returns its errors as one 8-bit code, the module in the high nibble
+ * and the error of the module in the low nibble, 0 is the success of all of them:
+ *
+ * 	0x1n ADC	0x2n GPIO	0x3n PWM	0x4n DC motor	0x5n LCD
+ *
+ * The drivers record every error they return with ERROR_record, from the main loop
+ * or from an ISR. The log is a RAM ring of the last ERROR_LOG_SIZE different codes,
+ * a code already in it only counts one more occurrence and moves its last time:
+ *
+ * 	code | occurrences | first ms | last ms	(TIMER_getTicks)
+ *
+ * The messages are kept in the flash only and copied when they are rendered,
+ * the firmware never holds them in RAM. "get errors" sends the log oldest first,
+ * one ERROR frame per code:
+ *
+ * 	index(1) | codes(1) | code(1) | occurrences(2) | first ms(4) | last ms(4) | message
+ *
+ * An empty log is sent as one frame of index 0 and 0 codes.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef ERROR_H_
+#define ERROR_H_
+
+#include"std_types.h"
+
+typedef uint8 ERROR_CodeType;
+
+#define ERROR_NONE					0
+#define ERROR_CODE(module, number)	((ERROR_CodeType)(((module) << 4) | (number)))
+#define ERROR_MODULE(code)			((code) >> 4)
+
+/*Modules*/
+#define ERROR_MODULE_ADC			1
+#define ERROR_MODULE_GPIO			2
+#define ERROR_MODULE_PWM			3
+#define ERROR_MODULE_DC_MOTOR		4
+#define ERROR_MODULE_LCD			5
+
+#define ERROR_LOG_SIZE				8
+#define ERROR_MAX_OCCURRENCES		0xFFFF /*the counter stops there*/
+#define ERROR_MESSAGE_SIZE			24 /*with the terminating 0*/
+#define ERROR_HEADER_SIZE			13
+
+typedef struct
+{
+	ERROR_CodeType code;
+	uint16 occurrences;
+	uint32 first; /*ms*/
+	uint32 last; /*ms*/
+}ERROR_EntryType;
+
+/*
+ * @brief clear the log
+ * */
+void ERROR_init(void);
+
+/*
+ * @brief add one occurrence of an error to the log, it can be called from an ISR
+ *
+ * @param ERROR_CodeType a_code the error, ERROR_NONE is not recorded
+ *
+ * @return ERROR_CodeType a_code so a driver can record and return in one line
+ * */
+ERROR_CodeType ERROR_record(ERROR_CodeType a_code);
+
+/*
+ * @brief return the number of different codes in the log
+ * */
+uint8 ERROR_getCount(void);
+
+/*
+ * @brief return the occurrences of all the errors since ERROR_init, with the ones
+ * of the codes that left the log
+ * */
+uint16 ERROR_getTotal(void);
+
+/*
+ * @brief copy an entry of the log
+ *
+ * @param uint8 a_index 0 is the oldest code
+ *
+ * @param ERROR_EntryType* a_entry the copy
+ *
+ * @return uint8 FALSE if there is no such entry
+ * */
+uint8 ERROR_getEntry(uint8 a_index, ERROR_EntryType * a_entry);
+
+/*
+ * @brief copy the message of a code from the flash
+ *
+ * @param ERROR_CodeType a_code the error
+ *
+ * @param char* a_buffer at least ERROR_MESSAGE_SIZE bytes
+ *
+ * @return uint8 the length of the message
+ * */
+uint8 ERROR_getMessage(ERROR_CodeType a_code, char * a_buffer);
+
+/*
+ * @brief send the log as ERROR frames
+ *
+ * @return uint8 FALSE if a dump is already running
+ * */
+uint8 ERROR_startDump(void);
+
+/*
+ * @brief send the next ERROR frame of a dump when the UART has room for it,
+ * it must be called from the main loop.
+ * */
+void ERROR_process(void);
+
+#endif /* ERROR_H_ */
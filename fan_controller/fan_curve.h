@@ -0,0 +1,24 @@
+/*
+ *
+ * Module: Fan curve
+ *
+ * File Name: fan_curve.h
+ *
+ * Description: Default fan curve of the firmware, see CONFIG_DEFAULT_CURVE_TEMPERATURES.
+ *
+ * host/curve_opt -o fan_curve.h replaces this file by the curve it found best on
+ * the simulated fleet. These are the hand chosen values of the first release.
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef FAN_CURVE_H_
+#define FAN_CURVE_H_
+
+#define FAN_CURVE_TEMPERATURES	{30, 60, 90, 120}
+#define FAN_CURVE_SPEEDS		{25, 50, 75, 100}
+
+#endif /* FAN_CURVE_H_ */
@@ -0,0 +1,149 @@
+/*
+ *
+ * Module: Filter
+ *
+ * File Name: filter.c
+ *
+ * Description: Source file for the filter of the LM35 ADC codes.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"filter.h"
+
+/*
+ * @brief set the filter lengths and clear it, the values must be checked
+ * by the caller (odd median size up to FILTER_MAX_MEDIAN, shift up to FILTER_MAX_SHIFT)
+ *
+ * @param FILTER_Type* a_filter the filter
+ *
+ * @param uint8 a_medianSize the number of codes of the median, 1 -> no median
+ *
+ * @param uint8 a_shift the EMA weight is 1/2^a_shift, 0 -> no EMA
+ * */
+void FILTER_init(FILTER_Type * a_filter, uint8 a_medianSize, uint8 a_shift)
+{
+	a_filter->medianSize = a_medianSize;
+	a_filter->shift = a_shift;
+	FILTER_reset(a_filter);
+}
+
+/*
+ * @brief clear the filter only if its lengths changed
+ * */
+void FILTER_configure(FILTER_Type * a_filter, uint8 a_medianSize, uint8 a_shift)
+{
+	if(a_filter->medianSize != a_medianSize || a_filter->shift != a_shift)
+	{
+		FILTER_init(a_filter, a_medianSize, a_shift);
+	}
+}
+
+/*
+ * @brief clear the samples of the filter, the next code starts it again
+ * */
+void FILTER_reset(FILTER_Type * a_filter)
+{
+	a_filter->count = 0;
+	a_filter->oldest = 0;
+	a_filter->average = FILTER_NO_AVERAGE;
+}
+
+/*
+ * @brief replace the oldest code of the full window by the new one,
+ * the sorted copy is fixed by moving the codes between the two places only
+ * */
+static void FILTER_replace(FILTER_Type * a_filter, uint16 a_code)
+{
+	uint16 old = a_filter->window[a_filter->oldest];
+	uint8 i = 0;
+
+	a_filter->window[a_filter->oldest] = a_code;
+	a_filter->oldest = (a_filter->oldest + 1 == a_filter->medianSize) ? 0 : a_filter->oldest + 1;
+
+	while(a_filter->sorted[i] != old)
+	{
+		i++;/*the old code is in the window, so it is found*/
+	}
+	if(a_code > old)
+	{
+		while(i + 1 < a_filter->medianSize && a_filter->sorted[i + 1] < a_code)
+		{
+			a_filter->sorted[i] = a_filter->sorted[i + 1];
+			i++;
+		}
+	}
+	else
+	{
+		while(i > 0 && a_filter->sorted[i - 1] > a_code)
+		{
+			a_filter->sorted[i] = a_filter->sorted[i - 1];
+			i--;
+		}
+	}
+	a_filter->sorted[i] = a_code;
+}
+
+/*
+ * @brief add a code to the window while it is not full yet
+ * */
+static void FILTER_insert(FILTER_Type * a_filter, uint16 a_code)
+{
+	uint8 i = a_filter->count;
+
+	a_filter->window[i] = a_code;
+	while(i > 0 && a_filter->sorted[i - 1] > a_code)
+	{
+		a_filter->sorted[i] = a_filter->sorted[i - 1];
+		i--;
+	}
+	a_filter->sorted[i] = a_code;
+	a_filter->count++;
+}
+
+/*
+ * @brief filter one ADC code
+ *
+ * @param FILTER_Type* a_filter the filter
+ *
+ * @param uint16 a_code the new raw code
+ *
+ * @return uint16 the filtered code
+ * */
+uint16 FILTER_update(FILTER_Type * a_filter, uint16 a_code)
+{
+	uint16 median = 0, target = 0;
+
+	if(a_filter->count < a_filter->medianSize)
+	{
+		FILTER_insert(a_filter, a_code);
+	}
+	else
+	{
+		FILTER_replace(a_filter, a_code);
+	}
+	/*the upper middle while the window fills up*/
+	median = a_filter->sorted[a_filter->count >> 1];
+
+	if(a_filter->shift == 0)
+	{
+		return median;
+	}
+	target = median << FILTER_FRACTION_BITS;
+	if(a_filter->average == FILTER_NO_AVERAGE)
+	{
+		a_filter->average = target;/*the first code starts the average*/
+	}
+	else if(target > a_filter->average)
+	{
+		a_filter->average += (target - a_filter->average) >> a_filter->shift;
+	}
+	else
+	{
+		a_filter->average -= (a_filter->average - target) >> a_filter->shift;
+	}
+	return (a_filter->average + (1 << (FILTER_FRACTION_BITS - 1))) >> FILTER_FRACTION_BITS;
+}
@@ -0,0 +1,81 @@
+/*
+ *
+ * Module: Filter
+ *
+ * File Name: filter.h
+ *
+ * Description: Header file for the filter of the LM35 ADC codes.
+ *
+ * Two stages, both without allocation and in bounded time:
+ * 	median	median of the last medianSize codes (odd, 1 -> off). The window is kept
+ * 			sorted, every sample removes the oldest code and inserts the new one
+ * 			with one pass of at most FILTER_MAX_MEDIAN moves, so a spike shorter
+ * 			than half the window never comes out.
+ * 	EMA		exponential moving average of the median with a weight of 1/2^shift
+ * 			(0 -> off), in fixed point with FILTER_FRACTION_BITS bits of fraction
+ * 			so the average still moves for a difference of one code.
+ *
+ * The filter keeps its whole state in a FILTER_Type, the host tools run the
+ * same code as the firmware on their own instances.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef FILTER_H_
+#define FILTER_H_
+
+#include"std_types.h"
+
+#define FILTER_MAX_MEDIAN			9
+#define FILTER_MAX_SHIFT			4
+#define FILTER_FRACTION_BITS		5 /*1023 << 5 fits in 16 bits*/
+#define FILTER_NO_AVERAGE			0xFFFF /*above any average, the next code starts it*/
+
+typedef struct
+{
+	uint16 window[FILTER_MAX_MEDIAN]; /*codes in arrival order, a ring*/
+	uint16 sorted[FILTER_MAX_MEDIAN]; /*the same codes ascending*/
+	uint16 average; /*EMA, code << FILTER_FRACTION_BITS, or FILTER_NO_AVERAGE*/
+	uint8 medianSize;
+	uint8 shift;
+	uint8 count; /*codes in the window*/
+	uint8 oldest; /*index of the oldest code in window*/
+}FILTER_Type;
+
+/*
+ * @brief set the filter lengths and clear it, the values must be checked
+ * by the caller (odd median size up to FILTER_MAX_MEDIAN, shift up to FILTER_MAX_SHIFT)
+ *
+ * @param FILTER_Type* a_filter the filter
+ *
+ * @param uint8 a_medianSize the number of codes of the median, 1 -> no median
+ *
+ * @param uint8 a_shift the EMA weight is 1/2^a_shift, 0 -> no EMA
+ * */
+void FILTER_init(FILTER_Type * a_filter, uint8 a_medianSize, uint8 a_shift);
+
+/*
+ * @brief clear the filter only if its lengths changed
+ * */
+void FILTER_configure(FILTER_Type * a_filter, uint8 a_medianSize, uint8 a_shift);
+
+/*
+ * @brief clear the samples of the filter, the next code starts it again
+ * */
+void FILTER_reset(FILTER_Type * a_filter);
+
+/*
+ * @brief filter one ADC code
+ *
+ * @param FILTER_Type* a_filter the filter
+ *
+ * @param uint16 a_code the new raw code
+ *
+ * @return uint16 the filtered code
+ * */
+uint16 FILTER_update(FILTER_Type * a_filter, uint16 a_code);
+
+#endif /* FILTER_H_ */
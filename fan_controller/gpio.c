@@ -28,18 +28,22 @@
  * The function will take the port id and the pin id and setup that pin as PIN_INPUT or PIN_OUTPUT
  * if the port id or the pin id are not correct, the function will return without doing anything
  *
- * Possible return value:
- * void
+ * Possible return values:
+ * GPIO_SUCCESS, GPIO_ERROR_PORT, GPIO_ERROR_PIN
  * */
-void GPIO_setupPinDirection(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, \
+GPIO_ErrorType GPIO_setupPinDirection(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, \
 		GPIO_PinDirectionType a_direction)
 {
 	/*Check the Correctness of port_id and pin_id*/
-	if( a_portId >= PORTS_NUM || a_portId < 0
-		||a_pinId >= PINS_PER_PORT_NUM || a_pinId < 0)
+	if( a_portId >= PORTS_NUM || a_portId < 0)
+	{
+		/*invalid input*/
+		return ERROR_record(GPIO_ERROR_PORT);/*Not handling the request*/
+	}
+	else if(a_pinId >= PINS_PER_PORT_NUM || a_pinId < 0)
 	{
 		/*invalid input*/
-		return;/*Not handling the request*/
+		return ERROR_record(GPIO_ERROR_PIN);/*Not handling the request*/
 	}
 	else
 	{
@@ -101,7 +105,7 @@ void GPIO_setupPinDirection(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, \
 			break;
 		}
 	}
-	return;
+	return GPIO_SUCCESS;
 }
 
 /*
@@ -109,16 +113,16 @@ void GPIO_setupPinDirection(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, \
  * The function will take port id and setup that port as PORT_INPUT or PORT_OUTPUT.
  * If the port id is not correct, the function will return without doing anything.
  *
- * Possible return value:
- * void
+ * Possible return values:
+ * GPIO_SUCCESS, GPIO_ERROR_PORT
  * */
-void GPIO_setupPortDirection(GPIO_PortIdType a_portId, GPIO_PortDirectionType a_direction)
+GPIO_ErrorType GPIO_setupPortDirection(GPIO_PortIdType a_portId, GPIO_PortDirectionType a_direction)
 {
 	/*Check the Correctness of port_id and pin_id*/
 	if( a_portId >= PORTS_NUM || a_portId < 0)
 	{
 		/*invalid input*/
-		return;/*Not handling the request*/
+		return ERROR_record(GPIO_ERROR_PORT);/*Not handling the request*/
 	}
 	else
 	{
@@ -170,7 +174,7 @@ void GPIO_setupPortDirection(GPIO_PortIdType a_portId, GPIO_PortDirectionType a_
 			break;
 		}
 	}
-	return;
+	return GPIO_SUCCESS;
 }
 
 /*
@@ -185,10 +189,16 @@ uint8 GPIO_readPin(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId)
 {
 	uint8 pinValue = 0x00; /*To store the return value*/
 	/*Check the Correctness of port_id and pin_id*/
-	if( a_portId >= PORTS_NUM || a_portId < 0
-		||a_pinId >= PINS_PER_PORT_NUM || a_pinId < 0)
+	if( a_portId >= PORTS_NUM || a_portId < 0)
+	{
+		/*invalid input*/
+		ERROR_record(GPIO_ERROR_PORT);
+		pinValue = LOGIC_LOW;/*setting the return value*/
+	}
+	else if(a_pinId >= PINS_PER_PORT_NUM || a_pinId < 0)
 	{
 		/*invalid input*/
+		ERROR_record(GPIO_ERROR_PIN);
 		pinValue = LOGIC_LOW;/*setting the return value*/
 	}
 	else
@@ -238,6 +248,7 @@ uint8 GPIO_readPort(GPIO_PortIdType a_portId)
 	if( a_portId >= PORTS_NUM || a_portId < 0)
 	{
 		/*invalid input*/
+		ERROR_record(GPIO_ERROR_PORT);
 		portValue = LOGIC_LOW;/*setting the return value*/
 	}
 	else
@@ -271,16 +282,24 @@ uint8 GPIO_readPort(GPIO_PortIdType a_portId)
  * if pin id or port id was not correct, the function will return without writing any value
  *
  * Possible return values:
- * void
+ * GPIO_SUCCESS, GPIO_ERROR_PORT, GPIO_ERROR_PIN, GPIO_ERROR_VALUE
  * */
-void GPIO_writePin(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, uint8 a_pinValue)
+GPIO_ErrorType GPIO_writePin(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, uint8 a_pinValue)
 {
-	if( a_portId >= PORTS_NUM || a_portId < 0
-		||a_pinId >= PINS_PER_PORT_NUM || a_pinId < 0
-		||a_pinValue > 1)
+	if( a_portId >= PORTS_NUM || a_portId < 0)
+	{
+		/*invalid input*/
+		return ERROR_record(GPIO_ERROR_PORT);/*not handling the request*/
+	}
+	else if(a_pinId >= PINS_PER_PORT_NUM || a_pinId < 0)
+	{
+		/*invalid input*/
+		return ERROR_record(GPIO_ERROR_PIN);/*not handling the request*/
+	}
+	else if(a_pinValue > 1)
 	{
 		/*invalid input*/
-		return;/*not handling the request*/
+		return ERROR_record(GPIO_ERROR_VALUE);/*not handling the request*/
 	}
 	else
 	{
@@ -340,7 +359,7 @@ void GPIO_writePin(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, uint8 a_pin
 			break;
 		}
 	}
-	return;
+	return GPIO_SUCCESS;
 }
 
 /*
@@ -349,15 +368,15 @@ void GPIO_writePin(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, uint8 a_pin
  * If the port id was not correct, the function will return without writing anything to the port.
  *
  * possible return values:
- * void
+ * GPIO_SUCCESS, GPIO_ERROR_PORT
  * */
-void GPIO_writePort(GPIO_PortIdType a_portId, uint8 a_portValue)
+GPIO_ErrorType GPIO_writePort(GPIO_PortIdType a_portId, uint8 a_portValue)
 {
 	/*Check the Correctness of port_id and pin_id*/
 	if( a_portId >= PORTS_NUM || a_portId < 0)
 	{
 		/*invalid input*/
-		return;/*setting the return value*/
+		return ERROR_record(GPIO_ERROR_PORT);/*not handling the request*/
 	}
 	else
 	{
@@ -381,6 +400,6 @@ void GPIO_writePort(GPIO_PortIdType a_portId, uint8 a_portValue)
 			break;
 		}
 	}
-	return;
+	return GPIO_SUCCESS;
 }
 
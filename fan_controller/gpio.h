@@ -16,12 +16,21 @@
 
 /******************Includes******************/
 #include"std_types.h"
+#include"error.h"
 
 /******************Definitions******************/
 #define PORTS_NUM			4
 #define PINS_PER_PORT_NUM	8
 
+/*Errors, see error.h*/
+#define GPIO_SUCCESS		ERROR_NONE
+#define GPIO_ERROR_PORT		ERROR_CODE(ERROR_MODULE_GPIO, 1)
+#define GPIO_ERROR_PIN		ERROR_CODE(ERROR_MODULE_GPIO, 2)
+#define GPIO_ERROR_VALUE	ERROR_CODE(ERROR_MODULE_GPIO, 3)
+
 /******************Types declarations******************/
+typedef ERROR_CodeType GPIO_ErrorType;
+
 typedef enum{
 	PIN_INPUT, PIN_OUTPUT
 }GPIO_PinDirectionType;
@@ -49,10 +58,10 @@ typedef enum{
  * The function will take the port_id and the pin_id and setup that pin as PIN_INPUT or PIN_OUTPUT
  * if the port_id or the pin_id are not correct, the function will return without doing anything
  *
- * Possible return value:
- * void
+ * Possible return values:
+ * GPIO_SUCCESS, GPIO_ERROR_PORT, GPIO_ERROR_PIN
  * */
-void GPIO_setupPinDirection(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, \
+GPIO_ErrorType GPIO_setupPinDirection(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, \
 		GPIO_PinDirectionType a_direction);
 
 /*
@@ -60,15 +69,15 @@ void GPIO_setupPinDirection(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, \
  * The function will take port_id and setup that port as PORT_INPUT or PORT_OUTPUT.
  * If the port_id is not correct, the function will return without doing anything.
  *
- * Possible return value:
- * void
+ * Possible return values:
+ * GPIO_SUCCESS, GPIO_ERROR_PORT
  * */
-void GPIO_setupPortDirection(GPIO_PortIdType a_portId, GPIO_PortDirectionType a_direction);
+GPIO_ErrorType GPIO_setupPortDirection(GPIO_PortIdType a_portId, GPIO_PortDirectionType a_direction);
 
 /*
  * Description:
  * The function will read pin_id from the port in port_id and return the read value.
- * if port_id or pin_id was not correct, the function will return LOGIC_LOW
+ * if port_id or pin_id was not correct, the function will record the error and return LOGIC_LOW
  *
  * Possible return values:
  * LOGIC_LOW, the pin value from the port (0, 255)
@@ -78,7 +87,7 @@ uint8 GPIO_readPin(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId);
 /*
  * Description:
  * The function will read the value on the port in port_id.
- * If the port_id was not correct, the function will return LOGIC_LOW
+ * If the port_id was not correct, the function will record the error and return LOGIC_LOW
  *
  * Possible return values:
  * LOGIC_LOW, the port value (0, 255)
@@ -91,9 +100,9 @@ uint8 GPIO_readPort(GPIO_PortIdType a_portId);
  * if pin_id or port_id was not correct, the function will return without writing any value
  *
  * Possible return values:
- * void
+ * GPIO_SUCCESS, GPIO_ERROR_PORT, GPIO_ERROR_PIN, GPIO_ERROR_VALUE
  * */
-void GPIO_writePin(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, uint8 a_pinValue);
+GPIO_ErrorType GPIO_writePin(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, uint8 a_pinValue);
 
 /*
  * Description:
@@ -101,9 +110,9 @@ void GPIO_writePin(GPIO_PortIdType a_portId, GPIO_PinIdType a_pinId, uint8 a_pin
  * If the port_id was not correct, the function will return without writing anything to the port.
  *
  * possible return values:
- * void
+ * GPIO_SUCCESS, GPIO_ERROR_PORT
  * */
-void GPIO_writePort(GPIO_PortIdType a_portId, uint8 a_portValue);
+GPIO_ErrorType GPIO_writePort(GPIO_PortIdType a_portId, uint8 a_portValue);
 
 
 #endif /* GPIO_H_ */
@@ -0,0 +1,336 @@
+/*
+ *
+ * Module: History
+ *
+ * File Name: history.c
+ *
+ * Description: Source file for the temperature and duty history recorder
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"history.h"
+#include"eeprom.h"
+#include"timer.h"
+#include"crc.h"
+
+/*A sample token is at most 5 bytes: tag, 3 bytes varint and the duty*/
+#define HISTORY_MAX_TOKEN_SIZE		5
+#define HISTORY_NO_RUN				0xFF
+
+/*Global Variables */
+static uint8 HISTORY_g_blocks[HISTORY_BLOCKS][HISTORY_BLOCK_SIZE];
+static uint8 HISTORY_g_used[HISTORY_BLOCKS];
+static uint8 HISTORY_g_newest = HISTORY_BLOCKS - 1;
+static uint8 HISTORY_g_count = 0;
+static uint8 HISTORY_g_runIndex = HISTORY_NO_RUN; /*last run token of the newest block*/
+static sint16 HISTORY_g_lastTemperature = 0;
+static uint8 HISTORY_g_lastDuty = 0;
+static uint32 HISTORY_g_seconds = 0;
+static uint32 HISTORY_g_lastTick = 0;
+
+/*Summary of the current checkpoint period*/
+static sint32 HISTORY_g_sum = 0;
+static uint32 HISTORY_g_dutySum = 0;
+static uint16 HISTORY_g_samples = 0;
+static sint16 HISTORY_g_min = 0;
+static sint16 HISTORY_g_max = 0;
+static uint8 HISTORY_g_maxDuty = 0;
+static uint8 HISTORY_g_checkpoint[HISTORY_CHECKPOINT_SIZE]; /*used by the EEPROM ISR while saving*/
+static uint8 HISTORY_g_checkpointPending = FALSE;
+static uint16 HISTORY_g_sequence = 0;
+static uint8 HISTORY_g_slot = HISTORY_CHECKPOINT_SLOTS - 1;
+
+/*Dump state*/
+static uint8 HISTORY_g_dumping = FALSE;
+static uint8 HISTORY_g_dumpIndex = 0; /*blocks then summary slots*/
+
+/*
+ * @brief write a_value as a varint, 7 bits per byte, low bits first
+ *
+ * @return uint8 the number of written bytes
+ * */
+static uint8 HISTORY_putVarint(uint8 * a_buffer, uint32 a_value)
+{
+	uint8 length = 0;
+	while(a_value >= 0x80)
+	{
+		a_buffer[length++] = (uint8)(a_value | 0x80);
+		a_value >>= 7;
+	}
+	a_buffer[length++] = (uint8)a_value;
+	return length;
+}
+
+/*
+ * @brief map a signed value to an unsigned one with small numbers for small magnitudes
+ * 0 -> 0, -1 -> 1, 1 -> 2, -2 -> 3 ...
+ * */
+static uint16 HISTORY_zigzag(sint16 a_value)
+{
+	return (uint16)(((uint16)a_value << 1) ^ (uint16)(a_value < 0 ? 0xFFFF : 0));
+}
+
+static void HISTORY_putUint16(uint8 * a_buffer, uint16 a_value)
+{
+	a_buffer[0] = (uint8)a_value;
+	a_buffer[1] = (uint8)(a_value >> 8);
+}
+
+/*
+ * @brief move to the next block, dropping the oldest one when the ring is full,
+ * and write the key frame of the sample
+ * */
+static void HISTORY_startBlock(sint16 a_temperature, uint8 a_duty)
+{
+	uint8 * block = NULL_PTR;
+	uint8 used = 0;
+
+	HISTORY_g_newest = (HISTORY_g_newest + 1) % HISTORY_BLOCKS;
+	if(HISTORY_g_count < HISTORY_BLOCKS)
+	{
+		HISTORY_g_count++;
+	}
+	block = HISTORY_g_blocks[HISTORY_g_newest];
+	used = HISTORY_putVarint(block, HISTORY_g_seconds);
+	used += HISTORY_putVarint(&block[used], HISTORY_zigzag(a_temperature));
+	block[used++] = a_duty;
+	HISTORY_g_used[HISTORY_g_newest] = used;
+	HISTORY_g_runIndex = HISTORY_NO_RUN;
+}
+
+/*
+ * @brief encode one sample after the previous one
+ * */
+static void HISTORY_record(sint16 a_temperature, uint8 a_duty)
+{
+	uint8 * block = HISTORY_g_blocks[HISTORY_g_newest];
+	uint8 used = HISTORY_g_used[HISTORY_g_newest];
+	sint16 delta = a_temperature - HISTORY_g_lastTemperature;
+
+	if(HISTORY_g_count == 0 || used > HISTORY_BLOCK_SIZE - HISTORY_MAX_TOKEN_SIZE)
+	{
+		HISTORY_startBlock(a_temperature, a_duty);
+		return;
+	}
+
+	if(delta == 0 && a_duty == HISTORY_g_lastDuty)
+	{
+		if(HISTORY_g_runIndex != HISTORY_NO_RUN && (block[HISTORY_g_runIndex] & HISTORY_MAX_RUN) < HISTORY_MAX_RUN)
+		{
+			block[HISTORY_g_runIndex]++; /*one more equal sample, no new byte*/
+			return;
+		}
+		HISTORY_g_runIndex = used;
+		block[used++] = HISTORY_TOKEN_RUN;
+	}
+	else if(a_duty == HISTORY_g_lastDuty && delta >= -32 && delta <= 31)
+	{
+		block[used++] = HISTORY_TOKEN_DELTA | ((uint8)delta & 0x3F);
+		HISTORY_g_runIndex = HISTORY_NO_RUN;
+	}
+	else
+	{
+		block[used++] = HISTORY_TOKEN_FULL;
+		used += HISTORY_putVarint(&block[used], HISTORY_zigzag(delta));
+		block[used++] = a_duty;
+		HISTORY_g_runIndex = HISTORY_NO_RUN;
+	}
+	HISTORY_g_used[HISTORY_g_newest] = used;
+}
+
+/*
+ * @brief add the sample to the checkpoint summary and build the
+ * summary record once the checkpoint period is over
+ * */
+static void HISTORY_summarize(sint16 a_temperature, uint8 a_duty)
+{
+	uint16 crc = 0;
+	if(HISTORY_g_samples == 0 || a_temperature < HISTORY_g_min)
+	{
+		HISTORY_g_min = a_temperature;
+	}
+	if(HISTORY_g_samples == 0 || a_temperature > HISTORY_g_max)
+	{
+		HISTORY_g_max = a_temperature;
+	}
+	if(HISTORY_g_samples == 0 || a_duty > HISTORY_g_maxDuty)
+	{
+		HISTORY_g_maxDuty = a_duty;
+	}
+	HISTORY_g_sum += a_temperature;
+	HISTORY_g_dutySum += a_duty;
+	HISTORY_g_samples++;
+
+	if(HISTORY_g_samples < HISTORY_CHECKPOINT_SAMPLES || HISTORY_g_checkpointPending)
+	{
+		/*a summary still waiting for the EEPROM covers a longer period instead*/
+		return;
+	}
+
+	HISTORY_g_sequence++;
+	HISTORY_putUint16(&HISTORY_g_checkpoint[0], HISTORY_g_sequence);
+	HISTORY_putUint16(&HISTORY_g_checkpoint[2], (uint16)HISTORY_g_seconds);
+	HISTORY_putUint16(&HISTORY_g_checkpoint[4], (uint16)(HISTORY_g_seconds >> 16));
+	HISTORY_putUint16(&HISTORY_g_checkpoint[6], (uint16)HISTORY_g_min);
+	HISTORY_putUint16(&HISTORY_g_checkpoint[8], (uint16)HISTORY_g_max);
+	HISTORY_putUint16(&HISTORY_g_checkpoint[10], (uint16)(sint16)(HISTORY_g_sum / HISTORY_g_samples));
+	HISTORY_g_checkpoint[12] = (uint8)(HISTORY_g_dutySum / HISTORY_g_samples);
+	HISTORY_g_checkpoint[13] = HISTORY_g_maxDuty;
+	crc = CRC16_update(CRC16_INITIAL_VALUE, HISTORY_g_checkpoint, HISTORY_CHECKPOINT_SIZE - 2);
+	HISTORY_putUint16(&HISTORY_g_checkpoint[14], crc);
+	HISTORY_g_checkpointPending = TRUE;
+
+	HISTORY_g_sum = 0;
+	HISTORY_g_dutySum = 0;
+	HISTORY_g_samples = 0;
+}
+
+/*
+ * @brief clear the RAM history and find the newest summary in the EEPROM
+ * so the summary ring continues after a reset
+ * */
+void HISTORY_init(void)
+{
+	uint8 slot = 0, found = FALSE;
+	uint16 sequence = 0, crc = 0;
+
+	HISTORY_g_count = 0;
+	HISTORY_g_newest = HISTORY_BLOCKS - 1;
+	HISTORY_g_seconds = 0;
+	HISTORY_g_samples = 0;
+	HISTORY_g_sum = 0;
+	HISTORY_g_dutySum = 0;
+	HISTORY_g_checkpointPending = FALSE;
+	HISTORY_g_dumping = FALSE;
+	HISTORY_g_lastTick = TIMER_getTicks();
+
+	for(slot = 0; slot < HISTORY_CHECKPOINT_SLOTS; slot++)
+	{
+		if(EEPROM_readBlock(HISTORY_EEPROM_ADDRESS + ((uint16)slot * HISTORY_CHECKPOINT_SLOT_SIZE),
+				HISTORY_g_checkpoint, HISTORY_CHECKPOINT_SIZE) != EEPROM_SUCCESS)
+		{
+			continue;
+		}
+		crc = CRC16_update(CRC16_INITIAL_VALUE, HISTORY_g_checkpoint, HISTORY_CHECKPOINT_SIZE - 2);
+		if(HISTORY_g_checkpoint[14] != (uint8)crc || HISTORY_g_checkpoint[15] != (uint8)(crc >> 8))
+		{
+			continue;
+		}
+		sequence = (uint16)(HISTORY_g_checkpoint[0] | ((uint16)HISTORY_g_checkpoint[1] << 8));
+		if(found == FALSE || (sint16)(sequence - HISTORY_g_sequence) > 0)
+		{
+			found = TRUE;
+			HISTORY_g_sequence = sequence;
+			HISTORY_g_slot = slot;
+		}
+	}
+}
+
+/*
+ * @brief record a sample if a second passed since the last one,
+ * it is cheap to call from every loop iteration
+ *
+ * @param sint16 a_temperature the current temperature
+ *
+ * @param uint8 a_duty the current fan speed in percent
+ * */
+void HISTORY_update(sint16 a_temperature, uint8 a_duty)
+{
+	if((uint32)(TIMER_getTicks() - HISTORY_g_lastTick) < HISTORY_SAMPLE_PERIOD_MS)
+	{
+		return;
+	}
+	if((uint32)(TIMER_getTicks() - HISTORY_g_lastTick) < 2 * HISTORY_SAMPLE_PERIOD_MS)
+	{
+		/*advance by the period, not to now, so the sample times do not drift*/
+		HISTORY_g_lastTick += HISTORY_SAMPLE_PERIOD_MS;
+	}
+	else
+	{
+		/*the caller samples slower than the history, do not try to catch up*/
+		HISTORY_g_lastTick = TIMER_getTicks();
+	}
+	HISTORY_g_seconds++;
+
+	HISTORY_record(a_temperature, a_duty);
+	HISTORY_summarize(a_temperature, a_duty);
+	HISTORY_g_lastTemperature = a_temperature;
+	HISTORY_g_lastDuty = a_duty;
+}
+
+/*
+ * @brief start sending the RAM blocks and the EEPROM summaries as telemetry frames
+ *
+ * @return uint8 FALSE if a dump is already running
+ * */
+uint8 HISTORY_startDump(void)
+{
+	if(HISTORY_g_dumping)
+	{
+		return FALSE;
+	}
+	HISTORY_g_dumping = TRUE;
+	HISTORY_g_dumpIndex = 0;
+	return TRUE;
+}
+
+/*
+ * @brief send the next dump frame when the UART has room for it and save a pending
+ * summary when the EEPROM is free, it must be called from the main loop.
+ * */
+void HISTORY_process(void)
+{
+	uint8 summary[HISTORY_CHECKPOINT_SIZE];
+	uint8 block = 0, count = 0;
+
+	if(HISTORY_g_checkpointPending && !EEPROM_isBusy())
+	{
+		HISTORY_g_slot = (HISTORY_g_slot + 1) % HISTORY_CHECKPOINT_SLOTS;
+		EEPROM_writeBlock(HISTORY_EEPROM_ADDRESS + ((uint16)HISTORY_g_slot * HISTORY_CHECKPOINT_SLOT_SIZE),
+				HISTORY_g_checkpoint, HISTORY_CHECKPOINT_SIZE);
+		HISTORY_g_checkpointPending = FALSE;
+	}
+
+	if(HISTORY_g_dumping == FALSE || TELEMETRY_canSend(HISTORY_BLOCK_SIZE) == FALSE)
+	{
+		/*one frame per call and only when it fits, the dump never waits for the UART*/
+		return;
+	}
+
+	if(HISTORY_g_dumpIndex < HISTORY_g_count)
+	{
+		/*oldest block first*/
+		block = (HISTORY_g_newest + HISTORY_BLOCKS + 1 - HISTORY_g_count + HISTORY_g_dumpIndex) % HISTORY_BLOCKS;
+		TELEMETRY_sendFrame(TELEMETRY_FRAME_HISTORY_BLOCK, HISTORY_g_blocks[block], HISTORY_g_used[block]);
+		HISTORY_g_dumpIndex++;
+	}
+	else if(HISTORY_g_dumpIndex < HISTORY_g_count + HISTORY_CHECKPOINT_SLOTS)
+	{
+		/*the EEPROM summaries are sent raw, the host checks their CRC*/
+		if(EEPROM_readBlock(HISTORY_EEPROM_ADDRESS +
+				((uint16)(HISTORY_g_dumpIndex - HISTORY_g_count) * HISTORY_CHECKPOINT_SLOT_SIZE),
+				summary, HISTORY_CHECKPOINT_SIZE) == EEPROM_SUCCESS)
+		{
+			TELEMETRY_sendFrame(TELEMETRY_FRAME_HISTORY_SUMMARY, summary, HISTORY_CHECKPOINT_SIZE);
+			HISTORY_g_dumpIndex++;
+		}
+	}
+	else
+	{
+		count = HISTORY_g_count;
+		TELEMETRY_sendFrame(TELEMETRY_FRAME_HISTORY_END, &count, 1);
+		HISTORY_g_dumping = FALSE;
+	}
+}
+
+/*
+ * @brief return the number of RAM blocks holding samples
+ * */
+uint8 HISTORY_getBlockCount(void)
+{
+	return HISTORY_g_count;
+}
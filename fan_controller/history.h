@@ -0,0 +1,94 @@
+/*
+ *
+ * Module: History
+ *
+ * File Name: history.h
+ *
+ * Description: Header file for the temperature and duty history recorder.
+ *
+ * One sample is recorded every second into a ring of RAM blocks. Every block
+ * starts with a key frame so it can be decoded on its own, the oldest block is
+ * dropped when the ring is full:
+ *
+ * 	key frame = seconds(varint) | zigzag(temperature)(varint) | duty(1)
+ *
+ * followed by one token per sample (or per run of equal samples):
+ *
+ * 	00nnnnnn	n + 1 samples equal to the previous one
+ * 	01dddddd	temperature changed by d (6-bit signed), same duty
+ * 	10000000	zigzag(temperature change)(varint) | duty(1)
+ *
+ * A steady temperature costs one byte per 64 seconds, so the RAM ring keeps hours
+ * of samples. Every HISTORY_CHECKPOINT_SAMPLES a summary record is saved to a ring
+ * of EEPROM slots so it survives a reset:
+ *
+ * 	summary = sequence(2) | seconds(4) | min(2) | max(2) | average(2)
+ * 	          | average duty(1) | max duty(1) | CRC16(2)
+ *
+ * EEPROM map:
+ * 	0x100 -> 0x1FF	history summaries (this module)
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include"std_types.h"
+#include"telemetry.h"
+
+#define HISTORY_SAMPLE_PERIOD_MS		1000
+#define HISTORY_BLOCKS					8
+#define HISTORY_BLOCK_SIZE				TELEMETRY_MAX_PAYLOAD /*one block per frame*/
+
+#define HISTORY_CHECKPOINT_SAMPLES		600 /*10 minutes*/
+#define HISTORY_EEPROM_ADDRESS			0x100
+#define HISTORY_CHECKPOINT_SLOTS		16
+#define HISTORY_CHECKPOINT_SLOT_SIZE	16
+#define HISTORY_CHECKPOINT_SIZE			16
+
+/*Tokens*/
+#define HISTORY_TOKEN_MASK				0xC0
+#define HISTORY_TOKEN_RUN				0x00
+#define HISTORY_TOKEN_DELTA				0x40
+#define HISTORY_TOKEN_FULL				0x80
+#define HISTORY_MAX_RUN					0x3F
+
+/*
+ * @brief clear the RAM history and find the newest summary in the EEPROM
+ * so the summary ring continues after a reset
+ * */
+void HISTORY_init(void);
+
+/*
+ * @brief record a sample if a second passed since the last one,
+ * it is cheap to call from every loop iteration
+ *
+ * @param sint16 a_temperature the current temperature
+ *
+ * @param uint8 a_duty the current fan speed in percent
+ * */
+void HISTORY_update(sint16 a_temperature, uint8 a_duty);
+
+/*
+ * @brief start sending the RAM blocks and the EEPROM summaries as telemetry frames
+ *
+ * @return uint8 FALSE if a dump is already running
+ * */
+uint8 HISTORY_startDump(void);
+
+/*
+ * @brief send the next dump frame when the UART has room for it and save a pending
+ * summary when the EEPROM is free, it must be called from the main loop.
+ * */
+void HISTORY_process(void);
+
+/*
+ * @brief return the number of RAM blocks holding samples
+ * */
+uint8 HISTORY_getBlockCount(void);
+
+#endif /* HISTORY_H_ */
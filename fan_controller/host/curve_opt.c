@@ -0,0 +1,555 @@
+/*
+ *
+ * Module: Host - Fan curve optimizer
+ *
+ * File Name: curve_opt.c
+ *
+ * Description: Search the fan curve that cools a fleet of enclosures (see fleet.h)
+ * with the least fan energy and fan speed changes while the peak temperature stays
+ * under the limit, then write it as fan_curve.h for the firmware build.
+ *
+ * A candidate curve is scored on the whole fleet:
+ * 	cost = mean fan energy (Wh) + change cost * mean speed changes
+ * 	     + OPT_PENALTY * (1 + excess) when the peak temperature percentile is over the limit
+ *
+ * 1. a grid of curves with evenly spaced points and linear speeds
+ * 2. Nelder-Mead from the best grid curve on the 4 temperatures and the 4 speeds,
+ *    the reflected, expanded and contracted points of an iteration are scored together
+ *
+ * All the (candidate, enclosure) pairs of a batch are spread on the CPU cores with
+ * the work stealing pool, a curve that was already scored is not scored again.
+ *
+ * Usage: curve_opt [-n enclosures] [-j threads] [-t hours] [-l limit] [-q percentile]
+ * 		[-w change_cost] [-i iterations] [-s seed] [-o fan_curve.h]
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"fleet.h"
+#include"pool.h"
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include<unistd.h>
+
+#define OPT_DIMENSIONS			(2 * CONFIG_CURVE_POINTS)
+#define OPT_VERTICES			(OPT_DIMENSIONS + 1)
+#define OPT_MAX_TEMPERATURE		150
+#define OPT_PENALTY				100.0
+#define OPT_CACHE_SIZE			8192
+#define OPT_MAX_BATCH			512
+#define OPT_TEMPERATURE_STEP	8.0 /*size of the first simplex*/
+#define OPT_SPEED_STEP			10.0
+#define OPT_TOLERANCE			1e-6
+
+/*Grid: first temperature, spacing of the points, first and last speed*/
+static const uint8 OPT_g_gridStarts[] = {25, 30, 35, 40, 45, 50, 55};
+static const uint8 OPT_g_gridSpacings[] = {5, 8, 12, 16, 20, 25};
+static const uint8 OPT_g_gridFirstSpeeds[] = {15, 30, 45};
+static const uint8 OPT_g_gridLastSpeeds[] = {60, 80, 100};
+
+#define OPT_COUNT(array)		(sizeof(array) / sizeof(array[0]))
+
+typedef struct
+{
+	CONFIG_CurveType curve;
+	float64 cost;
+	float64 fanEnergy;		/*mean over the fleet*/
+	float64 speedChanges;	/*mean over the fleet*/
+	float64 peakTemperature;	/*percentile of the fleet*/
+}OPT_ScoreType;
+
+typedef struct
+{
+	FLEET_ScenarioType scenario;
+	FLEET_EnclosureType * enclosures;
+	uint32 enclosureCount;
+	float64 percentile;
+	float64 changeCost;
+	uint16 threads;
+	/*batch being scored*/
+	const CONFIG_CurveType * batch;
+	FLEET_ResultType * results;
+	/*every curve scored so far*/
+	OPT_ScoreType cache[OPT_CACHE_SIZE];
+	uint32 cacheCount;
+	uint32 evaluations;
+}OPT_ContextType;
+
+static float64 OPT_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (float64)now.tv_sec + ((float64)now.tv_nsec / 1e9);
+}
+
+static void OPT_task(uint32 a_index, uint16 a_thread, void * a_context)
+{
+	OPT_ContextType * context = a_context;
+	uint32 candidate = a_index / context->enclosureCount, enclosure = a_index % context->enclosureCount;
+	(void)a_thread;
+	FLEET_simulate(&context->batch[candidate], &context->enclosures[enclosure], &context->scenario,
+			&context->results[a_index]);
+}
+
+static int OPT_compareFloat(const void * a_first, const void * a_second)
+{
+	float64 first = *(const float64 *)a_first, second = *(const float64 *)a_second;
+	return (first > second) - (first < second);
+}
+
+/*
+ * Description:
+ * Reduce the fleet results of one candidate to its score
+ * */
+static void OPT_reduce(OPT_ContextType * a_context, const FLEET_ResultType * a_results, OPT_ScoreType * a_score)
+{
+	float64 peaks[a_context->enclosureCount];
+	uint32 i = 0, rank = 0;
+
+	a_score->fanEnergy = 0;
+	a_score->speedChanges = 0;
+	for(i = 0; i < a_context->enclosureCount; i++)
+	{
+		a_score->fanEnergy += a_results[i].fanEnergy;
+		a_score->speedChanges += a_results[i].speedChanges;
+		peaks[i] = a_results[i].peakTemperature;
+	}
+	a_score->fanEnergy /= a_context->enclosureCount;
+	a_score->speedChanges /= a_context->enclosureCount;
+	qsort(peaks, a_context->enclosureCount, sizeof(float64), OPT_compareFloat);
+	rank = (uint32)ceil(a_context->percentile / 100.0 * a_context->enclosureCount);
+	a_score->peakTemperature = peaks[rank == 0 ? 0 : rank - 1];
+
+	a_score->cost = a_score->fanEnergy + (a_context->changeCost * a_score->speedChanges);
+	if(a_score->peakTemperature > a_context->scenario.limit)
+	{
+		a_score->cost += OPT_PENALTY * (1.0 + a_score->peakTemperature - a_context->scenario.limit);
+	}
+}
+
+static OPT_ScoreType * OPT_find(OPT_ContextType * a_context, const CONFIG_CurveType * a_curve)
+{
+	uint32 i = 0;
+	for(i = 0; i < a_context->cacheCount; i++)
+	{
+		if(memcmp(&a_context->cache[i].curve, a_curve, sizeof(CONFIG_CurveType)) == 0)
+		{
+			return &a_context->cache[i];
+		}
+	}
+	return NULL_PTR;
+}
+
+/*
+ * Description:
+ * Score a_count curves, the new ones in one parallel batch, a_scores gets a copy of each score
+ * */
+static void OPT_score(OPT_ContextType * a_context, const CONFIG_CurveType * a_curves, uint32 a_count,
+		OPT_ScoreType * a_scores)
+{
+	CONFIG_CurveType batch[OPT_MAX_BATCH];
+	uint32 count = 0, i = 0, j = 0;
+	uint8 duplicate = FALSE;
+
+	for(i = 0; i < a_count; i++)
+	{
+		duplicate = (OPT_find(a_context, &a_curves[i]) != NULL_PTR);
+		for(j = 0; j < count && !duplicate; j++)
+		{
+			duplicate = (memcmp(&batch[j], &a_curves[i], sizeof(CONFIG_CurveType)) == 0);
+		}
+		if(!duplicate && count < OPT_MAX_BATCH)
+		{
+			batch[count++] = a_curves[i];
+		}
+	}
+
+	if(count != 0)
+	{
+		a_context->batch = batch;
+		a_context->results = malloc((size_t)count * a_context->enclosureCount * sizeof(FLEET_ResultType));
+		if(a_context->results == NULL_PTR)
+		{
+			perror("results");
+			exit(1);
+		}
+		POOL_run(count * a_context->enclosureCount, a_context->threads, OPT_task, a_context);
+		for(i = 0; i < count && a_context->cacheCount < OPT_CACHE_SIZE; i++)
+		{
+			OPT_ScoreType * score = &a_context->cache[a_context->cacheCount++];
+			score->curve = batch[i];
+			OPT_reduce(a_context, &a_context->results[i * a_context->enclosureCount], score);
+		}
+		free(a_context->results);
+		a_context->evaluations += count;
+	}
+
+	for(i = 0; i < a_count; i++)
+	{
+		OPT_ScoreType * score = OPT_find(a_context, &a_curves[i]);
+		if(score == NULL_PTR)
+		{
+			/*only when the cache is full*/
+			fprintf(stderr, "curve_opt: the cache is full, use fewer iterations\n");
+			exit(1);
+		}
+		a_scores[i] = *score;
+	}
+}
+
+/*
+ * Description:
+ * The valid curve nearest to a point of the search: rounded, the temperatures
+ * ascending as CONFIG_setCurve wants them and the speeds not decreasing
+ * */
+static void OPT_toCurve(const float64 * a_point, CONFIG_CurveType * a_curve)
+{
+	float64 value = 0;
+	uint8 i = 0;
+	for(i = 0; i < CONFIG_CURVE_POINTS; i++)
+	{
+		value = fmin(fmax(round(a_point[i]), i), OPT_MAX_TEMPERATURE - (CONFIG_CURVE_POINTS - 1 - i));
+		a_curve->temperature[i] = (uint8)value;
+		if(i > 0 && a_curve->temperature[i] <= a_curve->temperature[i - 1])
+		{
+			a_curve->temperature[i] = a_curve->temperature[i - 1] + 1;
+		}
+		value = fmin(fmax(round(a_point[CONFIG_CURVE_POINTS + i]), 0), DC_MOTOR_MAX_SPEED);
+		a_curve->speed[i] = (uint8)value;
+		if(i > 0 && a_curve->speed[i] < a_curve->speed[i - 1])
+		{
+			a_curve->speed[i] = a_curve->speed[i - 1];
+		}
+	}
+}
+
+static void OPT_toPoint(const CONFIG_CurveType * a_curve, float64 * a_point)
+{
+	uint8 i = 0;
+	for(i = 0; i < CONFIG_CURVE_POINTS; i++)
+	{
+		a_point[i] = a_curve->temperature[i];
+		a_point[CONFIG_CURVE_POINTS + i] = a_curve->speed[i];
+	}
+}
+
+static void OPT_print(const char * a_name, const OPT_ScoreType * a_score)
+{
+	uint8 i = 0;
+	fprintf(stderr, "%-12s", a_name);
+	for(i = 0; i < CONFIG_CURVE_POINTS; i++)
+	{
+		fprintf(stderr, " %3u:%3u%%", a_score->curve.temperature[i], a_score->curve.speed[i]);
+	}
+	fprintf(stderr, "  cost %8.3f  energy %.3f Wh  changes %.0f  peak %.2f\n", a_score->cost,
+			a_score->fanEnergy, a_score->speedChanges, a_score->peakTemperature);
+}
+
+/*
+ * Description:
+ * Score the grid and return the best curve
+ * */
+static void OPT_searchGrid(OPT_ContextType * a_context, OPT_ScoreType * a_best)
+{
+	CONFIG_CurveType curves[OPT_MAX_BATCH];
+	OPT_ScoreType scores[OPT_MAX_BATCH];
+	uint32 count = 0, i = 0;
+	uint8 start = 0, spacing = 0, first = 0, last = 0, point = 0;
+
+	for(start = 0; start < OPT_COUNT(OPT_g_gridStarts); start++)
+	{
+		for(spacing = 0; spacing < OPT_COUNT(OPT_g_gridSpacings); spacing++)
+		{
+			for(first = 0; first < OPT_COUNT(OPT_g_gridFirstSpeeds); first++)
+			{
+				for(last = 0; last < OPT_COUNT(OPT_g_gridLastSpeeds); last++)
+				{
+					for(point = 0; point < CONFIG_CURVE_POINTS; point++)
+					{
+						curves[count].temperature[point] = OPT_g_gridStarts[start]
+								+ (point * OPT_g_gridSpacings[spacing]);
+						curves[count].speed[point] = OPT_g_gridFirstSpeeds[first]
+								+ (point * (OPT_g_gridLastSpeeds[last] - OPT_g_gridFirstSpeeds[first])
+								/ (CONFIG_CURVE_POINTS - 1));
+					}
+					count++;
+				}
+			}
+		}
+	}
+
+	OPT_score(a_context, curves, count, scores);
+	*a_best = scores[0];
+	for(i = 1; i < count; i++)
+	{
+		if(scores[i].cost < a_best->cost)
+		{
+			*a_best = scores[i];
+		}
+	}
+}
+
+/*
+ * Description:
+ * Nelder-Mead from a_best, a_best is replaced by the best curve found
+ * */
+static void OPT_searchNelderMead(OPT_ContextType * a_context, OPT_ScoreType * a_best, uint32 a_iterations)
+{
+	static const float64 coefficients[4] = {1.0, 2.0, 0.5, -0.5}; /*reflect, expand, outside and inside contraction*/
+	float64 points[OPT_VERTICES][OPT_DIMENSIONS], costs[OPT_VERTICES];
+	float64 centroid[OPT_DIMENSIONS], trials[4][OPT_DIMENSIONS], swap[OPT_DIMENSIONS];
+	CONFIG_CurveType curves[OPT_VERTICES];
+	OPT_ScoreType scores[OPT_VERTICES];
+	uint32 iteration = 0;
+	uint8 i = 0, j = 0, worst = 0, accepted = 0;
+	float64 cost = 0;
+
+	for(i = 0; i < OPT_VERTICES; i++)
+	{
+		OPT_toPoint(&a_best->curve, points[i]);
+		if(i > 0)
+		{
+			points[i][i - 1] += (i - 1 < CONFIG_CURVE_POINTS) ? OPT_TEMPERATURE_STEP : -OPT_SPEED_STEP;
+		}
+		OPT_toCurve(points[i], &curves[i]);
+	}
+	OPT_score(a_context, curves, OPT_VERTICES, scores);
+	for(i = 0; i < OPT_VERTICES; i++)
+	{
+		costs[i] = scores[i].cost;
+	}
+
+	for(iteration = 0; iteration < a_iterations; iteration++)
+	{
+		/*sort the vertices by cost, there are only 9*/
+		for(i = 1; i < OPT_VERTICES; i++)
+		{
+			for(j = i; j > 0 && costs[j] < costs[j - 1]; j--)
+			{
+				cost = costs[j];
+				costs[j] = costs[j - 1];
+				costs[j - 1] = cost;
+				memcpy(swap, points[j], sizeof(swap));
+				memcpy(points[j], points[j - 1], sizeof(swap));
+				memcpy(points[j - 1], swap, sizeof(swap));
+			}
+		}
+		worst = OPT_VERTICES - 1;
+		if(costs[worst] - costs[0] < OPT_TOLERANCE)
+		{
+			break; /*the simplex is flat, the rounding makes it stop moving*/
+		}
+
+		for(j = 0; j < OPT_DIMENSIONS; j++)
+		{
+			centroid[j] = 0;
+			for(i = 0; i < worst; i++)
+			{
+				centroid[j] += points[i][j] / worst;
+			}
+		}
+		for(i = 0; i < 4; i++)
+		{
+			for(j = 0; j < OPT_DIMENSIONS; j++)
+			{
+				trials[i][j] = centroid[j] + (coefficients[i] * (centroid[j] - points[worst][j]));
+			}
+			OPT_toCurve(trials[i], &curves[i]);
+		}
+		OPT_score(a_context, curves, 4, scores);
+
+		/*the usual choice between the four points, they were scored together*/
+		accepted = 4;
+		if(scores[0].cost < costs[0])
+		{
+			accepted = (scores[1].cost < scores[0].cost) ? 1 : 0;
+		}
+		else if(scores[0].cost < costs[worst - 1])
+		{
+			accepted = 0;
+		}
+		else if(scores[0].cost < costs[worst])
+		{
+			accepted = (scores[2].cost <= scores[0].cost) ? 2 : 0;
+		}
+		else if(scores[3].cost < costs[worst])
+		{
+			accepted = 3;
+		}
+
+		if(accepted < 4)
+		{
+			memcpy(points[worst], trials[accepted], sizeof(points[worst]));
+			costs[worst] = scores[accepted].cost;
+			continue;
+		}
+		/*shrink toward the best vertex*/
+		for(i = 1; i < OPT_VERTICES; i++)
+		{
+			for(j = 0; j < OPT_DIMENSIONS; j++)
+			{
+				points[i][j] = points[0][j] + (0.5 * (points[i][j] - points[0][j]));
+			}
+			OPT_toCurve(points[i], &curves[i - 1]);
+		}
+		OPT_score(a_context, curves, OPT_VERTICES - 1, scores);
+		for(i = 1; i < OPT_VERTICES; i++)
+		{
+			costs[i] = scores[i - 1].cost;
+		}
+	}
+
+	for(i = 0; i < OPT_VERTICES; i++)
+	{
+		OPT_toCurve(points[i], &curves[i]);
+	}
+	OPT_score(a_context, curves, OPT_VERTICES, scores);
+	for(i = 0; i < OPT_VERTICES; i++)
+	{
+		if(scores[i].cost < a_best->cost)
+		{
+			*a_best = scores[i];
+		}
+	}
+	fprintf(stderr, "nelder-mead: %lu iterations\n", (unsigned long)iteration);
+}
+
+/*
+ * Description:
+ * Write the curve as the fan_curve.h included by config.h
+ *
+ * Possible return values:
+ * FALSE if the file can not be written
+ * */
+static uint8 OPT_writeHeader(const char * a_path, const OPT_ContextType * a_context, const OPT_ScoreType * a_best,
+		uint32 a_seed)
+{
+	FILE * file = fopen(a_path, "w");
+	uint8 i = 0;
+	if(file == NULL_PTR)
+	{
+		return FALSE;
+	}
+	fprintf(file, "/*\n *\n * Module: Fan curve\n *\n * File Name: fan_curve.h\n *\n"
+			" * Description: Default fan curve of the firmware, see CONFIG_DEFAULT_CURVE_TEMPERATURES.\n"
+			" *\n * Generated by host/curve_opt on %lu enclosures (seed %lu) for %.1f h, limit %.1fC\n"
+			" * on the p%.0f peak temperature. Mean fan energy %.3f Wh, mean speed changes %.0f,\n"
+			" * peak temperature %.2fC.\n *\n * Layer: Application Layer\n *\n"
+			" * Author: Abdullah Mahmoud\n *\n * */\n\n#ifndef FAN_CURVE_H_\n#define FAN_CURVE_H_\n\n",
+			(unsigned long)a_context->enclosureCount, (unsigned long)a_seed, a_context->scenario.hours,
+			a_context->scenario.limit, a_context->percentile, a_best->fanEnergy, a_best->speedChanges,
+			a_best->peakTemperature);
+	fprintf(file, "#define FAN_CURVE_TEMPERATURES\t{");
+	for(i = 0; i < CONFIG_CURVE_POINTS; i++)
+	{
+		fprintf(file, "%s%u", i == 0 ? "" : ", ", a_best->curve.temperature[i]);
+	}
+	fprintf(file, "}\n#define FAN_CURVE_SPEEDS\t\t{");
+	for(i = 0; i < CONFIG_CURVE_POINTS; i++)
+	{
+		fprintf(file, "%s%u", i == 0 ? "" : ", ", a_best->curve.speed[i]);
+	}
+	fprintf(file, "}\n\n#endif /* FAN_CURVE_H_ */\n");
+	return fclose(file) == 0;
+}
+
+int main(int argc, char * argv[])
+{
+	static OPT_ContextType context;
+	OPT_ScoreType initial, best;
+	uint32 seed = 1, iterations = 200, i = 0;
+	const char * output = NULL_PTR;
+	float64 start = 0;
+	int option = 0;
+
+	CONFIG_init();
+	context.scenario.hours = 24;
+	context.scenario.samplePeriodMs = CONFIG_DEFAULT_SAMPLE_PERIOD_MS;
+	context.scenario.limit = 95;
+	context.scenario.horizon = CONFIG_DEFAULT_PREDICT_HORIZON;
+	context.enclosureCount = 32;
+	context.percentile = 100;
+	context.changeCost = 0.0001; /*Wh, 10000 speed changes weigh as much as 1 Wh*/
+	context.threads = POOL_getDefaultThreads();
+
+	while((option = getopt(argc, argv, "n:j:t:l:q:w:i:s:o:")) != -1)
+	{
+		switch(option)
+		{
+		case 'n':
+			context.enclosureCount = (uint32)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 'j':
+			context.threads = (uint16)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 't':
+			context.scenario.hours = strtod(optarg, NULL_PTR);
+			break;
+		case 'l':
+			context.scenario.limit = strtod(optarg, NULL_PTR);
+			break;
+		case 'q':
+			context.percentile = strtod(optarg, NULL_PTR);
+			break;
+		case 'w':
+			context.changeCost = strtod(optarg, NULL_PTR);
+			break;
+		case 'i':
+			iterations = (uint32)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 's':
+			seed = (uint32)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n enclosures] [-j threads] [-t hours] [-l limit] [-q percentile]\n"
+					"\t\t[-w change_cost] [-i iterations] [-s seed] [-o fan_curve.h]\n", argv[0]);
+			return 2;
+		}
+	}
+	if(context.enclosureCount == 0 || context.scenario.hours <= 0
+			|| context.percentile <= 0 || context.percentile > 100)
+	{
+		fprintf(stderr, "%s: the enclosures, the time and the percentile (0 -> 100] must be positive\n", argv[0]);
+		return 2;
+	}
+	context.enclosures = malloc(context.enclosureCount * sizeof(FLEET_EnclosureType));
+	if(context.enclosures == NULL_PTR)
+	{
+		perror("enclosures");
+		return 1;
+	}
+	for(i = 0; i < context.enclosureCount; i++)
+	{
+		FLEET_makeEnclosure(seed, i, &context.enclosures[i]);
+	}
+
+	start = OPT_now();
+	OPT_score(&context, &CONFIG_get()->curve, 1, &initial);
+	OPT_print("current", &initial);
+	OPT_searchGrid(&context, &best);
+	OPT_print("grid", &best);
+	OPT_searchNelderMead(&context, &best, iterations);
+	OPT_print("nelder-mead", &best);
+	fprintf(stderr, "%lu curves scored on %lu enclosures in %.1f s\n", (unsigned long)context.evaluations,
+			(unsigned long)context.enclosureCount, OPT_now() - start);
+	if(best.peakTemperature > context.scenario.limit)
+	{
+		fprintf(stderr, "no curve keeps the p%.0f peak temperature under %.1f\n", context.percentile,
+				context.scenario.limit);
+	}
+
+	if(output != NULL_PTR && !OPT_writeHeader(output, &context, &best, seed))
+	{
+		perror(output);
+		return 1;
+	}
+	free(context.enclosures);
+	return best.peakTemperature > context.scenario.limit;
+}
@@ -0,0 +1,180 @@
+/*
+ *
+ * Module: Host - Firmware on Linux
+ *
+ * File Name: fan_controller.c
+ *
+ * Description: Run the unmodified firmware on the simulated MCU (see port/mcu.h).
+ * The UART is a pseudo-terminal so fanctl and the decoders work as with the
+ * board, the LCD is printed every time it changes.
+ *
+ * Usage: fan_controller [-f] [-q] [-t seconds] [-T celsius] [-e eeprom.bin]
+ * 	-f	run as fast as possible instead of real time
+ * 	-q	do not print the LCD
+ * 	-t	stop after this virtual time
+ * 	-T	temperature seen by the LM35 (25 by default)
+ * 	-e	EEPROM image, loaded at start and saved at exit
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#define _GNU_SOURCE
+#include"port/mcu.h"
+#include"../lm35.h"
+#include<fcntl.h>
+#include<signal.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<termios.h>
+#include<time.h>
+#include<unistd.h>
+
+#define HOST_STEP_MS		10
+
+int FIRMWARE_main(void);
+
+static volatile sig_atomic_t HOST_g_stop = 0;
+
+static void HOST_onSignal(int a_signal)
+{
+	(void)a_signal;
+	HOST_g_stop = 1;
+}
+
+/*
+ * Description:
+ * UART bytes go to the pseudo-terminal, they are dropped if nobody reads them
+ * */
+static void HOST_onUartByte(uint8 a_data, void * a_context)
+{
+	if(write(*(int *)a_context, &a_data, 1) != 1)
+	{
+		/*no reader, like an unconnected TXD pin*/
+	}
+}
+
+/*
+ * Description:
+ * Create the pseudo-terminal of the UART and print the name of its slave side
+ *
+ * Possible return values:
+ * the master file descriptor or -1 on failure
+ * */
+static int HOST_openTerminal(void)
+{
+	struct termios options;
+	int master = posix_openpt(O_RDWR | O_NOCTTY), slave = -1;
+	if(master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+	{
+		return -1;
+	}
+	/*keep a raw slave open, the frames are binary and the link must stay up between clients*/
+	slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+	if(slave < 0 || tcgetattr(slave, &options) != 0)
+	{
+		return -1;
+	}
+	cfmakeraw(&options);
+	tcsetattr(slave, TCSANOW, &options);
+	fcntl(master, F_SETFL, O_NONBLOCK);
+	fprintf(stderr, "UART on %s\n", ptsname(master));
+	return master;
+}
+
+static float64 HOST_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (float64)now.tv_sec + ((float64)now.tv_nsec / 1e9);
+}
+
+int main(int argc, char * argv[])
+{
+	uint8 buffer[64], fast = FALSE, quiet = FALSE;
+	uint32 lcdUpdates = 0;
+	float64 seconds = 0, temperature = 25, start = 0, virtualTime = 0;
+	const char * eepromPath = NULL_PTR;
+	FILE * file = NULL_PTR;
+	int terminal = -1, option = 0;
+	ssize_t length = 0;
+
+	while((option = getopt(argc, argv, "fqt:T:e:")) != -1)
+	{
+		switch(option)
+		{
+		case 'f':
+			fast = TRUE;
+			break;
+		case 'q':
+			quiet = TRUE;
+			break;
+		case 't':
+			seconds = strtod(optarg, NULL_PTR);
+			break;
+		case 'T':
+			temperature = strtod(optarg, NULL_PTR);
+			break;
+		case 'e':
+			eepromPath = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-f] [-q] [-t seconds] [-T celsius] [-e eeprom.bin]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	MCU_init();
+	if(eepromPath != NULL_PTR && (file = fopen(eepromPath, "rb")) != NULL_PTR)
+	{
+		if(fread(MCU_getEeprom(), 1, MCU_EEPROM_SIZE, file) != MCU_EEPROM_SIZE)
+		{
+			fprintf(stderr, "%s: short EEPROM image\n", eepromPath);
+		}
+		fclose(file);
+	}
+	terminal = HOST_openTerminal();
+	if(terminal < 0)
+	{
+		perror("pseudo-terminal");
+		return 1;
+	}
+	MCU_setUartCallback(HOST_onUartByte, &terminal);
+	MCU_setAdcVoltage(LM35_CHANNEL, temperature * LM35_V_PER_DEGREE);
+	signal(SIGINT, HOST_onSignal);
+	signal(SIGTERM, HOST_onSignal);
+
+	MCU_start(FIRMWARE_main);
+	start = HOST_now();
+	while(!HOST_g_stop && (seconds <= 0 || virtualTime < seconds))
+	{
+		length = read(terminal, buffer, sizeof(buffer));
+		if(length > 0)
+		{
+			MCU_uartReceive(buffer, (uint16)length);
+		}
+		if(!MCU_run((uint64)HOST_STEP_MS * MCU_CYCLES_PER_MS))
+		{
+			break; /*main returned*/
+		}
+		virtualTime = (float64)MCU_getCycles() / F_CPU;
+
+		if(!quiet && MCU_getLcdUpdates() != lcdUpdates)
+		{
+			lcdUpdates = MCU_getLcdUpdates();
+			printf("[%10.3f] |%s|%s|\n", virtualTime, MCU_getLcdRow(0), MCU_getLcdRow(1));
+			fflush(stdout);
+		}
+		if(!fast && virtualTime > HOST_now() - start)
+		{
+			usleep((useconds_t)((virtualTime - (HOST_now() - start)) * 1e6));
+		}
+	}
+
+	if(eepromPath != NULL_PTR && (file = fopen(eepromPath, "wb")) != NULL_PTR)
+	{
+		fwrite(MCU_getEeprom(), 1, MCU_EEPROM_SIZE, file);
+		fclose(file);
+	}
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ *
+ * Module: Host - Command tool
+ *
+ * File Name: fanctl.c
+ *
+ * Description: Send one command line to the controller (serial port or the
+ * pseudo-terminal of the host build) and print the response frame.
+ *
+ * Usage: fanctl [-b baud] [-t seconds] device "get curve"
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"frame.h"
+#include<signal.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+
+/*
+ * Description:
+ * No response before the timeout
+ * */
+static void FANCTL_onTimeout(int a_signal)
+{
+	static const char message[] = "fanctl: no response\n";
+	(void)a_signal;
+	write(STDERR_FILENO, message, sizeof(message) - 1);
+	_exit(1);
+}
+
+/*
+ * Description:
+ * Print the response frame and stop, sample frames are skipped
+ * */
+static uint8 FANCTL_onFrame(const FRAME_Type * a_frame, void * a_context)
+{
+	if(a_frame->type != TELEMETRY_FRAME_RESPONSE)
+	{
+		return TRUE;
+	}
+	*(int *)a_context = (a_frame->length >= 3 && memcmp(a_frame->payload, "err", 3) == 0);
+	printf("%.*s\n", a_frame->length, (const char *)a_frame->payload);
+	return FALSE;
+}
+
+int main(int argc, char * argv[])
+{
+	char line[TELEMETRY_MAX_PAYLOAD];
+	uint32 baudRate = 9600;
+	unsigned timeout = 3;
+	int fd = 0, option = 0, failed = 1, length = 0;
+
+	while((option = getopt(argc, argv, "b:t:")) != -1)
+	{
+		if(option == 'b')
+		{
+			baudRate = strtoul(optarg, NULL_PTR, 10);
+		}
+		else if(option == 't')
+		{
+			timeout = (unsigned)strtoul(optarg, NULL_PTR, 10);
+		}
+		else
+		{
+			break;
+		}
+	}
+	if(argc - optind != 2)
+	{
+		fprintf(stderr, "usage: %s [-b baud] [-t seconds] device \"command\"\n", argv[0]);
+		return 2;
+	}
+
+	fd = FRAME_open(argv[optind], baudRate);
+	if(fd < 0)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+
+	length = snprintf(line, sizeof(line), "%s\n", argv[optind + 1]);
+	if(length < 0 || length >= (int)sizeof(line) || write(fd, line, length) != length)
+	{
+		fprintf(stderr, "fanctl: can not send the command\n");
+		return 1;
+	}
+
+	signal(SIGALRM, FANCTL_onTimeout);
+	alarm(timeout);
+	FRAME_read(fd, FANCTL_onFrame, &failed, NULL_PTR);
+	return failed;
+}
@@ -0,0 +1,248 @@
+/*
+ *
+ * Module: Host - Filter benchmark
+ *
+ * File Name: filter_bench.c
+ *
+ * Description: Run a noisy LM35 trace through the filter of the firmware (filter.h)
+ * with several median sizes and EMA shifts and count what the noise costs after
+ * the control path of MAIN_sample:
+ *
+ * 	median,shift,ns_per_sample,speed_changes,fan_toggles,lcd_updates,step_samples
+ *
+ * speed_changes are the DC_MOTOR_Rotate calls of MAIN_updateFanSpeed, fan_toggles the
+ * on/off changes, lcd_updates the redraws of the temperature and the fan state,
+ * step_samples the samples until a clean 10C step is within 1C (the delay of the filter).
+ * ns_per_sample is the host time of FILTER_update, the AVR cycles come from the
+ * FILTER_update case of the bench harness.
+ *
+ * The trace is a sine around a temperature (by default the first point of the curve,
+ * where the noise flips the fan) with gaussian noise and spikes, quantized like the
+ * ADC. The spikes stay under the slew limit of sensor.h so they reach the filter.
+ *
+ * Usage: filter_bench [-n samples] [-m celsius] [-a celsius] [-s sigma] [-p spikes] [-S seed]
+ * 	-n	samples, 864000 by default (a day at the 100ms sample period)
+ * 	-m	middle of the trace, 30C by default
+ * 	-a	amplitude of the sine, 3C by default, one period every 30 minutes
+ * 	-s	standard deviation of the noise in ADC codes, 1.0 by default
+ * 	-p	probability of a spike on a sample, 0.01 by default
+ * 	-S	seed of the noise
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"../filter.h"
+#include"../sensor.h"
+#include"../lm35.h"
+#include"../adc.h"
+#include"../config.h"
+#include"../main.h"
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<time.h>
+#include<unistd.h>
+
+#define FILTER_BENCH_SINE_SAMPLES	18000 /*30 minutes at 100ms*/
+#define FILTER_BENCH_SPIKE_MIN		4
+#define FILTER_BENCH_SPIKE_MAX		(SENSOR_MAX_SLEW_CODES - 4)
+#define FILTER_BENCH_STEP_FROM		20
+#define FILTER_BENCH_STEP_TO		30
+#define FILTER_BENCH_STEP_SAMPLES	200
+
+typedef struct
+{
+	uint8 medianSize;
+	uint8 shift;
+}FILTER_BENCH_SettingType;
+
+static const FILTER_BENCH_SettingType FILTER_BENCH_g_settings[] =
+{
+	{1, 0}, {3, 0}, {5, 0}, {9, 0}, {1, 2}, {1, 4},
+	{CONFIG_DEFAULT_FILTER_MEDIAN, CONFIG_DEFAULT_FILTER_SHIFT}, {9, 4}
+};
+
+#define FILTER_BENCH_SETTINGS	(sizeof(FILTER_BENCH_g_settings) / sizeof(FILTER_BENCH_g_settings[0]))
+
+static float64 FILTER_BENCH_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (float64)now.tv_sec + ((float64)now.tv_nsec / 1e9);
+}
+
+/*
+ * Description:
+ * xorshift64, uniform in [0, 1)
+ * */
+static float64 FILTER_BENCH_uniform(uint64 * a_state)
+{
+	*a_state ^= *a_state << 13;
+	*a_state ^= *a_state >> 7;
+	*a_state ^= *a_state << 17;
+	return (float64)(*a_state >> 11) / 9007199254740992.0;
+}
+
+static float64 FILTER_BENCH_gaussian(uint64 * a_state)
+{
+	float64 u = FILTER_BENCH_uniform(a_state);
+	float64 v = FILTER_BENCH_uniform(a_state);
+	return sqrt(-2.0 * log(u + 1e-300)) * cos(2.0 * M_PI * v);
+}
+
+static uint16 FILTER_BENCH_toCode(float64 a_code)
+{
+	if(a_code <= 0.0)
+	{
+		return 0;
+	}
+	return a_code >= ADC_MAX ? ADC_MAX : (uint16)a_code;
+}
+
+/*
+ * Description:
+ * Samples until the filtered temperature of a clean step is within 1C of the end
+ * */
+static uint32 FILTER_BENCH_step(const FILTER_BENCH_SettingType * a_setting)
+{
+	FILTER_Type filter;
+	uint16 from = FILTER_BENCH_toCode(FILTER_BENCH_STEP_FROM / (ADC_VREF / (ADC_MAX + 1) / LM35_V_PER_DEGREE));
+	uint16 to = FILTER_BENCH_toCode(FILTER_BENCH_STEP_TO / (ADC_VREF / (ADC_MAX + 1) / LM35_V_PER_DEGREE));
+	uint32 i = 0;
+
+	FILTER_init(&filter, a_setting->medianSize, a_setting->shift);
+	for(i = 0; i < FILTER_BENCH_STEP_SAMPLES; i++)
+	{
+		(void)FILTER_update(&filter, from);
+	}
+	for(i = 1; i < FILTER_BENCH_STEP_SAMPLES; i++)
+	{
+		if(LM35_TO_DEGREES(LM35_toTemperature(FILTER_update(&filter, to))) + 1 >= LM35_TO_DEGREES(LM35_toTemperature(to)))
+		{
+			return i;
+		}
+	}
+	return i;
+}
+
+/*
+ * Description:
+ * Run the trace through one setting and print its line
+ * */
+static void FILTER_BENCH_run(const FILTER_BENCH_SettingType * a_setting, const uint16 * a_codes, uint32 a_count,
+		uint16 * a_filtered)
+{
+	const CONFIG_CurveType * curve = &CONFIG_get()->curve;
+	FILTER_Type filter;
+	uint32 i = 0, speedChanges = 0, fanToggles = 0, lcdUpdates = 0;
+	LM35_TemperatureType temperature = 0;
+	sint16 lastTemperature = MAIN_NOT_DISPLAYED_VALUE;
+	uint8 speed = 0, fanOn = FALSE, lastSpeed = 0, lastFanOn = FAN_INIT;
+	float64 start = 0, elapsed = 0;
+
+	/*time the filter alone on the whole trace, then the control path on its output*/
+	FILTER_init(&filter, a_setting->medianSize, a_setting->shift);
+	start = FILTER_BENCH_now();
+	for(i = 0; i < a_count; i++)
+	{
+		a_filtered[i] = FILTER_update(&filter, a_codes[i]);
+	}
+	elapsed = FILTER_BENCH_now() - start;
+
+	for(i = 0; i < a_count; i++)
+	{
+		temperature = LM35_toTemperature(a_filtered[i]);
+		fanOn = temperature >= LM35_FROM_DEGREES(curve->temperature[0]);
+		speed = fanOn ? MAIN_getFanSpeed(curve, temperature) : 0;
+		if(speed != lastSpeed)
+		{
+			speedChanges++;
+			lastSpeed = speed;
+		}
+		if(fanOn != lastFanOn)
+		{
+			fanToggles++;
+			lcdUpdates++;
+			lastFanOn = fanOn;
+		}
+		if(LM35_TO_DEGREES(temperature) != lastTemperature)
+		{
+			lcdUpdates++;/*the LCD shows whole degrees*/
+			lastTemperature = LM35_TO_DEGREES(temperature);
+		}
+	}
+	printf("%u,%u,%.1f,%lu,%lu,%lu,%lu\n", a_setting->medianSize, a_setting->shift, elapsed * 1e9 / a_count,
+			(unsigned long)speedChanges, (unsigned long)fanToggles, (unsigned long)lcdUpdates,
+			(unsigned long)FILTER_BENCH_step(a_setting));
+}
+
+int main(int argc, char * argv[])
+{
+	uint32 count = 864000, i = 0;
+	float64 middle = 0, amplitude = 3.0, sigma = 1.0, spikes = 0.01;
+	float64 codesPerDegree = LM35_V_PER_DEGREE * (ADC_MAX + 1) / ADC_VREF, code = 0;
+	uint64 state = 0x2545F4914F6CDD1DULL;
+	uint16 * codes = NULL_PTR, * filtered = NULL_PTR;
+	int option = 0;
+
+	CONFIG_init();
+	middle = CONFIG_get()->curve.temperature[0];
+	while((option = getopt(argc, argv, "n:m:a:s:p:S:")) != -1)
+	{
+		switch(option)
+		{
+		case 'n':
+			count = (uint32)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 'm':
+			middle = atof(optarg);
+			break;
+		case 'a':
+			amplitude = atof(optarg);
+			break;
+		case 's':
+			sigma = atof(optarg);
+			break;
+		case 'p':
+			spikes = atof(optarg);
+			break;
+		case 'S':
+			state ^= strtoull(optarg, NULL_PTR, 10) * 0x9E3779B97F4A7C15ULL;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n samples] [-m celsius] [-a celsius] [-s sigma] [-p spikes] [-S seed]\n",
+					argv[0]);
+			return 2;
+		}
+	}
+	codes = malloc(count * sizeof(uint16));
+	filtered = malloc(count * sizeof(uint16));
+	if(count == 0 || codes == NULL_PTR || filtered == NULL_PTR)
+	{
+		fprintf(stderr, "filter_bench: no samples\n");
+		return 2;
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		code = (middle + (amplitude * sin(2.0 * M_PI * i / FILTER_BENCH_SINE_SAMPLES))) * codesPerDegree;
+		code += sigma * FILTER_BENCH_gaussian(&state);
+		if(FILTER_BENCH_uniform(&state) < spikes)
+		{
+			code += (FILTER_BENCH_uniform(&state) < 0.5 ? -1 : 1)
+					* (FILTER_BENCH_SPIKE_MIN + ((FILTER_BENCH_SPIKE_MAX - FILTER_BENCH_SPIKE_MIN)
+					* FILTER_BENCH_uniform(&state)));
+		}
+		codes[i] = FILTER_BENCH_toCode(code);
+	}
+
+	printf("median,shift,ns_per_sample,speed_changes,fan_toggles,lcd_updates,step_samples\n");
+	for(i = 0; i < FILTER_BENCH_SETTINGS; i++)
+	{
+		FILTER_BENCH_run(&FILTER_BENCH_g_settings[i], codes, count, filtered);
+	}
+	free(codes);
+	free(filtered);
+	return 0;
+}
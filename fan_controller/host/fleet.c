@@ -0,0 +1,152 @@
+/*
+ *
+ * Module: Host - Fleet model
+ *
+ * File Name: fleet.c
+ *
+ * Description: Source file of the controller and plant model used to evaluate a fan
+ * curve on many enclosures at once
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"fleet.h"
+#include"../main.h"
+#include"../adc.h"
+#include"../pwm.h"
+#include<math.h>
+
+/*Spread of the enclosures, every parameter is uniform between the two values*/
+#define FLEET_HEAT_CAPACITY_MIN		300.0
+#define FLEET_HEAT_CAPACITY_MAX		1200.0
+#define FLEET_NATURAL_COOLING_MIN	0.25
+#define FLEET_NATURAL_COOLING_MAX	0.6
+#define FLEET_FAN_COOLING_MIN		1.2
+#define FLEET_FAN_COOLING_MAX		3.0
+#define FLEET_LOAD_SCALE_MIN		0.5
+#define FLEET_LOAD_SCALE_MAX		1.2
+#define FLEET_AMBIENT_OFFSET_MIN	-3.0
+#define FLEET_AMBIENT_OFFSET_MAX	8.0
+#define FLEET_FAN_POWER_MIN			1.5
+#define FLEET_FAN_POWER_MAX			6.0
+
+#define FLEET_DUTY_LEVELS			(PWM_MAX_VALUE + 2) /*stopped, then OCR0 + 1*/
+
+/*
+ * Description:
+ * splitmix64, a good 64-bit mix of a counter
+ * */
+static uint64 FLEET_random(uint64 * a_state)
+{
+	uint64 z = (*a_state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static float64 FLEET_uniform(uint64 * a_state, float64 a_min, float64 a_max)
+{
+	return a_min + ((a_max - a_min) * ((float64)(FLEET_random(a_state) >> 11) / 9007199254740992.0));
+}
+
+void FLEET_makeEnclosure(uint32 a_seed, uint32 a_index, FLEET_EnclosureType * a_enclosure)
+{
+	uint64 state = ((uint64)a_seed << 32) | a_index;
+
+	PLANT_init(&a_enclosure->plant, 0.0);
+	a_enclosure->plant.heatCapacity = FLEET_uniform(&state, FLEET_HEAT_CAPACITY_MIN, FLEET_HEAT_CAPACITY_MAX);
+	a_enclosure->plant.naturalCooling = FLEET_uniform(&state, FLEET_NATURAL_COOLING_MIN, FLEET_NATURAL_COOLING_MAX);
+	a_enclosure->plant.fanCooling = FLEET_uniform(&state, FLEET_FAN_COOLING_MIN, FLEET_FAN_COOLING_MAX);
+	a_enclosure->loadScale = FLEET_uniform(&state, FLEET_LOAD_SCALE_MIN, FLEET_LOAD_SCALE_MAX);
+	a_enclosure->ambientOffset = FLEET_uniform(&state, FLEET_AMBIENT_OFFSET_MIN, FLEET_AMBIENT_OFFSET_MAX);
+	a_enclosure->fanPower = FLEET_uniform(&state, FLEET_FAN_POWER_MIN, FLEET_FAN_POWER_MAX);
+}
+
+/*
+ * Description:
+ * The code of the ADC for the LM35 at a_temperature, the ADC truncates
+ * */
+static uint16 FLEET_getAdcCode(float64 a_temperature)
+{
+	float64 code = a_temperature * LM35_V_PER_DEGREE * (ADC_MAX + 1) / ADC_VREF;
+	if(code <= 0.0)
+	{
+		return 0;
+	}
+	return code >= ADC_MAX ? ADC_MAX : (uint16)code;
+}
+
+void FLEET_simulate(const CONFIG_CurveType * a_curve, const FLEET_EnclosureType * a_enclosure,
+		const FLEET_ScenarioType * a_scenario, FLEET_ResultType * a_result)
+{
+	PLANT_Type plant = a_enclosure->plant;
+	FILTER_Type filter;
+	PREDICT_Type predict;
+	float64 decay[FLEET_DUTY_LEVELS]; /*e^(-step/tau) of every duty, the step never changes*/
+	float64 step = a_scenario->samplePeriodMs / 1000.0, end = a_scenario->hours * PLANT_SECONDS_PER_HOUR;
+	float64 seconds = 0, duty = 0, ambient = 0, power = 0, target = 0;
+	uint16 level = 0, i = 0, code = 0;
+	uint16 horizon = MAIN_getHorizonSamples(a_scenario->horizon, a_scenario->samplePeriodMs);
+	LM35_TemperatureType temperature = 0;
+	uint8 speed = 0, lastSpeed = 0;
+
+	for(i = 0; i < FLEET_DUTY_LEVELS; i++)
+	{
+		decay[i] = -1.0;
+	}
+	ambient = PLANT_getDayAmbient(0) + a_enclosure->ambientOffset;
+	plant.temperature = ambient;
+	a_result->fanEnergy = 0;
+	a_result->peakTemperature = plant.temperature;
+	a_result->secondsOverLimit = 0;
+	a_result->speedChanges = 0;
+	FILTER_init(&filter, CONFIG_DEFAULT_FILTER_MEDIAN, CONFIG_DEFAULT_FILTER_SHIFT);
+	PREDICT_init(&predict);
+
+	for(seconds = 0; seconds < end; seconds += step)
+	{
+		/*MAIN_sample: the code is filtered and projected in the predictive mode, the motor
+		is stopped under the first point, otherwise it runs at the curve speed*/
+		code = FILTER_update(&filter, FLEET_getAdcCode(plant.temperature));
+		PREDICT_update(&predict, code);
+		temperature = LM35_toTemperature(a_scenario->horizon != 0 ? PREDICT_project(&predict, horizon) : code);
+		speed = MAIN_getFanSpeed(a_curve, temperature);
+		if(temperature < LM35_FROM_DEGREES(a_curve->temperature[0]))
+		{
+			speed = 0;
+			level = 0;
+		}
+		else
+		{
+			/*the OC0 duty of DC_MOTOR_Rotate, fast PWM is high for OCR0 + 1 counts*/
+			level = ((uint16)speed * PWM_MAX_VALUE / DC_MOTOR_MAX_SPEED) + 1;
+		}
+		duty = level / 256.0;
+		if(speed != lastSpeed)
+		{
+			a_result->speedChanges++;
+			lastSpeed = speed;
+		}
+
+		/*PLANT_step with the decay of the duty computed once*/
+		ambient = PLANT_getDayAmbient(seconds) + a_enclosure->ambientOffset;
+		power = PLANT_getDayLoad(seconds) * a_enclosure->loadScale;
+		if(decay[level] < 0.0)
+		{
+			decay[level] = exp(-step * (plant.naturalCooling + (plant.fanCooling * duty)) / plant.heatCapacity);
+		}
+		target = PLANT_getSteadyState(&plant, power, ambient, duty);
+		plant.temperature = target + ((plant.temperature - target) * decay[level]);
+
+		a_result->fanEnergy += a_enclosure->fanPower * duty * duty * duty * step / PLANT_SECONDS_PER_HOUR;
+		if(plant.temperature > a_result->peakTemperature)
+		{
+			a_result->peakTemperature = plant.temperature;
+		}
+		if(plant.temperature > a_scenario->limit)
+		{
+			a_result->secondsOverLimit += step;
+		}
+	}
+}
@@ -0,0 +1,69 @@
+/*
+ *
+ * Module: Host - Fleet model
+ *
+ * File Name: fleet.h
+ *
+ * Description: Header file of the controller and plant model used to evaluate a fan
+ * curve on many enclosures at once.
+ *
+ * Running the whole firmware on the simulated MCU takes about 20s per simulated day,
+ * too slow for thousands of enclosures, and the simulated MCU is a single global
+ * machine. The fleet model runs only the control path of main.c instead: every
+ * sample period the temperature of the plant is quantized by the ADC, converted by
+ * LM35_toTemperature and mapped to a speed by MAIN_getFanSpeed, then the speed
+ * becomes the OC0 duty as DC_MOTOR_Rotate sets it. Those functions have no side
+ * effect, so any number of enclosures can be simulated on parallel threads.
+ *
+ * Every enclosure has its own plant, load, ambient and fan. They are drawn from a
+ * seed and the enclosure index, so a fleet is the same whatever the threads do.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef FLEET_H_
+#define FLEET_H_
+
+#include"plant.h"
+#include"../config.h"
+
+typedef struct
+{
+	PLANT_Type plant;		/*parameters, the temperature is set at the start*/
+	float64 loadScale;		/*multiplies the load of the day scenario*/
+	float64 ambientOffset;	/*C added to the ambient of the day scenario*/
+	float64 fanPower;		/*W drawn by the fan at 100% duty, it goes with duty^3*/
+}FLEET_EnclosureType;
+
+typedef struct
+{
+	float64 hours;			/*simulated time from midnight*/
+	uint16 samplePeriodMs;	/*the sample period of the firmware*/
+	float64 limit;			/*maximum allowed temperature*/
+	uint8 horizon;			/*s of the predictive mode, 0 -> the reactive curve*/
+}FLEET_ScenarioType;
+
+typedef struct
+{
+	float64 fanEnergy;		/*Wh*/
+	float64 peakTemperature;
+	float64 secondsOverLimit;
+	uint32 speedChanges;
+}FLEET_ResultType;
+
+/*
+ * Description:
+ * Draw the parameters of enclosure a_index of the fleet a_seed
+ * */
+void FLEET_makeEnclosure(uint32 a_seed, uint32 a_index, FLEET_EnclosureType * a_enclosure);
+
+/*
+ * Description:
+ * Run the control path with a_curve on one enclosure for the whole scenario,
+ * it only uses its arguments so it can run on any thread.
+ * */
+void FLEET_simulate(const CONFIG_CurveType * a_curve, const FLEET_EnclosureType * a_enclosure,
+		const FLEET_ScenarioType * a_scenario, FLEET_ResultType * a_result);
+
+#endif /* FLEET_H_ */
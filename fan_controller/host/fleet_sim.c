@@ -0,0 +1,291 @@
+/*
+ *
+ * Module: Host - Fleet simulator
+ *
+ * File Name: fleet_sim.c
+ *
+ * Description: Evaluate one fan curve on a fleet of enclosures with different thermal
+ * characteristics (see fleet.h), on all the CPU cores with the work stealing pool of
+ * pool.h. It prints the fan energy, the peak temperature and the number of fan speed
+ * changes over the fleet, -c adds one CSV line per enclosure.
+ *
+ * Usage: fleet_sim [-n enclosures] [-j threads] [-t hours] [-p period_ms] [-l limit]
+ * 		[-s seed] [-C t1,s1,t2,s2,t3,s3,t4,s4] [-H horizon] [-c] [-S]
+ * 	-n	number of enclosures, 1000 by default
+ * 	-j	number of threads, the online CPUs by default
+ * 	-t	simulated time, 24 hours by default
+ * 	-p	sample period of the firmware, 100ms by default
+ * 	-l	temperature limit, 95C by default
+ * 	-s	seed of the fleet, the same seed gives the same enclosures
+ * 	-C	the fan curve, the firmware default curve otherwise
+ * 	-H	horizon of the predictive mode in seconds, the fleet is then run with the reactive
+ * 		curve too and the change of the peak temperatures is printed
+ * 	-c	print a CSV line per enclosure
+ * 	-S	run with 1, 2, 4... threads and print the speed up of each
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"fleet.h"
+#include"pool.h"
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include<unistd.h>
+
+typedef struct
+{
+	CONFIG_CurveType curve;
+	FLEET_ScenarioType scenario;
+	uint32 seed;
+	FLEET_ResultType * results;
+}FLEET_SIM_ContextType;
+
+static float64 FLEET_SIM_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (float64)now.tv_sec + ((float64)now.tv_nsec / 1e9);
+}
+
+static void FLEET_SIM_task(uint32 a_index, uint16 a_thread, void * a_context)
+{
+	FLEET_SIM_ContextType * context = a_context;
+	FLEET_EnclosureType enclosure;
+	(void)a_thread;
+	FLEET_makeEnclosure(context->seed, a_index, &enclosure);
+	FLEET_simulate(&context->curve, &enclosure, &context->scenario, &context->results[a_index]);
+}
+
+/*
+ * Description:
+ * Parse "t1,s1,...,t4,s4", the curve must be valid for the firmware
+ *
+ * Possible return values:
+ * FALSE if the text is not a valid curve
+ * */
+static uint8 FLEET_SIM_parseCurve(const char * a_text, CONFIG_CurveType * a_curve)
+{
+	char * end = NULL_PTR;
+	unsigned long value = 0;
+	uint8 i = 0;
+	for(i = 0; i < 2 * CONFIG_CURVE_POINTS; i++)
+	{
+		value = strtoul(a_text, &end, 10);
+		if(end == a_text || value > 0xFF || (*end != ',' && i + 1 < 2 * CONFIG_CURVE_POINTS))
+		{
+			return FALSE;
+		}
+		if(i % 2 == 0)
+		{
+			a_curve->temperature[i / 2] = (uint8)value;
+		}
+		else
+		{
+			a_curve->speed[i / 2] = (uint8)value;
+		}
+		a_text = end + 1;
+	}
+	return *end == '\0' && CONFIG_setCurve(a_curve) == CONFIG_SUCCESS; /*the validation of the firmware*/
+}
+
+static int FLEET_SIM_compare(const void * a_first, const void * a_second)
+{
+	float64 first = *(const float64 *)a_first, second = *(const float64 *)a_second;
+	return (first > second) - (first < second);
+}
+
+static void FLEET_SIM_printSummary(const FLEET_SIM_ContextType * a_context, uint32 a_count)
+{
+	float64 * peaks = malloc(a_count * sizeof(float64));
+	float64 energy = 0, maxEnergy = 0, changes = 0;
+	uint32 maxChanges = 0, overLimit = 0, i = 0;
+
+	for(i = 0; i < a_count; i++)
+	{
+		const FLEET_ResultType * result = &a_context->results[i];
+		energy += result->fanEnergy;
+		maxEnergy = result->fanEnergy > maxEnergy ? result->fanEnergy : maxEnergy;
+		changes += result->speedChanges;
+		maxChanges = result->speedChanges > maxChanges ? result->speedChanges : maxChanges;
+		overLimit += (result->secondsOverLimit > 0);
+		peaks[i] = result->peakTemperature;
+	}
+	qsort(peaks, a_count, sizeof(float64), FLEET_SIM_compare);
+
+	fprintf(stderr, "fan energy: mean %.2f Wh, max %.2f Wh, fleet %.1f Wh\n",
+			energy / a_count, maxEnergy, energy);
+	fprintf(stderr, "peak temperature: median %.2f, p95 %.2f, max %.2f, %lu enclosures over %.1f\n",
+			peaks[a_count / 2], peaks[(uint32)(a_count * 0.95)], peaks[a_count - 1],
+			(unsigned long)overLimit, a_context->scenario.limit);
+	fprintf(stderr, "fan speed changes: mean %.1f, max %lu\n", changes / a_count, (unsigned long)maxChanges);
+	free(peaks);
+}
+
+/*
+ * Description:
+ * Compare the predictive run with the reactive run of the same fleet, the overshoot
+ * of an enclosure is how much higher its peak temperature is with the reactive curve
+ * */
+static void FLEET_SIM_printComparison(const FLEET_SIM_ContextType * a_reactive,
+		const FLEET_SIM_ContextType * a_predictive, uint32 a_count)
+{
+	float64 * overshoots = malloc(a_count * sizeof(float64));
+	float64 overshoot = 0, energy = 0, reactiveEnergy = 0;
+	uint32 lower = 0, reactiveOver = 0, predictiveOver = 0, i = 0;
+
+	for(i = 0; i < a_count; i++)
+	{
+		overshoots[i] = a_reactive->results[i].peakTemperature - a_predictive->results[i].peakTemperature;
+		overshoot += overshoots[i];
+		lower += (overshoots[i] > 0.005);
+		energy += a_predictive->results[i].fanEnergy;
+		reactiveEnergy += a_reactive->results[i].fanEnergy;
+		reactiveOver += (a_reactive->results[i].secondsOverLimit > 0);
+		predictiveOver += (a_predictive->results[i].secondsOverLimit > 0);
+	}
+	qsort(overshoots, a_count, sizeof(float64), FLEET_SIM_compare);
+	fprintf(stderr, "reactive overshoot over the %us horizon: mean %.2f, median %.2f, p95 %.2f, max %.2f C, "
+			"%lu enclosures cooler\n", a_predictive->scenario.horizon, overshoot / a_count,
+			overshoots[a_count / 2], overshoots[(uint32)(a_count * 0.95)], overshoots[a_count - 1],
+			(unsigned long)lower);
+	fprintf(stderr, "over %.1f: %lu enclosures reactive, %lu predictive, fan energy %+.1f%%\n",
+			a_predictive->scenario.limit, (unsigned long)reactiveOver, (unsigned long)predictiveOver,
+			100.0 * (energy - reactiveEnergy) / reactiveEnergy);
+	free(overshoots);
+}
+
+int main(int argc, char * argv[])
+{
+	FLEET_SIM_ContextType context, reactive;
+	uint32 count = 1000, steals = 0, i = 0;
+	uint16 threads = POOL_getDefaultThreads(), maxThreads = 0;
+	uint8 csv = FALSE, scaling = FALSE;
+	float64 start = 0, elapsed = 0, single = 0;
+	int option = 0;
+
+	CONFIG_init();
+	context.curve = CONFIG_get()->curve;
+	context.scenario.hours = 24;
+	context.scenario.samplePeriodMs = CONFIG_DEFAULT_SAMPLE_PERIOD_MS;
+	context.scenario.limit = 95;
+	context.scenario.horizon = CONFIG_DEFAULT_PREDICT_HORIZON;
+	context.seed = 1;
+
+	while((option = getopt(argc, argv, "n:j:t:p:l:s:C:H:cS")) != -1)
+	{
+		switch(option)
+		{
+		case 'n':
+			count = (uint32)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 'j':
+			threads = (uint16)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 't':
+			context.scenario.hours = strtod(optarg, NULL_PTR);
+			break;
+		case 'p':
+			context.scenario.samplePeriodMs = (uint16)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 'l':
+			context.scenario.limit = strtod(optarg, NULL_PTR);
+			break;
+		case 's':
+			context.seed = (uint32)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 'C':
+			if(!FLEET_SIM_parseCurve(optarg, &context.curve))
+			{
+				fprintf(stderr, "%s: the curve is not valid\n", argv[0]);
+				return 2;
+			}
+			break;
+		case 'H':
+			context.scenario.horizon = (uint8)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 'c':
+			csv = TRUE;
+			break;
+		case 'S':
+			scaling = TRUE;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n enclosures] [-j threads] [-t hours] [-p period_ms] [-l limit]\n"
+					"\t\t[-s seed] [-C t1,s1,t2,s2,t3,s3,t4,s4] [-H horizon] [-c] [-S]\n", argv[0]);
+			return 2;
+		}
+	}
+	if(count == 0 || context.scenario.samplePeriodMs == 0 || context.scenario.hours <= 0)
+	{
+		fprintf(stderr, "%s: the enclosures, the period and the time must be positive\n", argv[0]);
+		return 2;
+	}
+	context.results = calloc(count, sizeof(FLEET_ResultType));
+	if(context.results == NULL_PTR)
+	{
+		perror("results");
+		return 1;
+	}
+
+	/*with -S the fleet is run for every power of two of threads, then once with all of them*/
+	maxThreads = threads;
+	threads = scaling ? 1 : maxThreads;
+	while(1)
+	{
+		start = FLEET_SIM_now();
+		steals = POOL_run(count, threads, FLEET_SIM_task, &context);
+		elapsed = FLEET_SIM_now() - start;
+		single = (threads == 1) ? elapsed : single;
+		fprintf(stderr, "%lu enclosures x %.1f h on %u threads in %.2f s (%.0f enclosure-days/s, %lu steals)",
+				(unsigned long)count, context.scenario.hours, threads, elapsed,
+				count * context.scenario.hours / 24.0 / elapsed, (unsigned long)steals);
+		if(scaling)
+		{
+			fprintf(stderr, ", speed up %.2f", single / elapsed);
+		}
+		fprintf(stderr, "\n");
+		if(threads == maxThreads)
+		{
+			break;
+		}
+		threads = (threads * 2 > maxThreads) ? maxThreads : threads * 2;
+	}
+
+	if(csv)
+	{
+		printf("enclosure,heat_capacity,natural_cooling,fan_cooling,load_scale,ambient_offset,fan_power,"
+				"fan_energy_wh,peak_temperature,seconds_over_limit,speed_changes\n");
+		for(i = 0; i < count; i++)
+		{
+			FLEET_EnclosureType enclosure;
+			const FLEET_ResultType * result = &context.results[i];
+			FLEET_makeEnclosure(context.seed, i, &enclosure);
+			printf("%lu,%.1f,%.3f,%.3f,%.3f,%.2f,%.2f,%.3f,%.2f,%.0f,%lu\n", (unsigned long)i,
+					enclosure.plant.heatCapacity, enclosure.plant.naturalCooling, enclosure.plant.fanCooling,
+					enclosure.loadScale, enclosure.ambientOffset, enclosure.fanPower, result->fanEnergy,
+					result->peakTemperature, result->secondsOverLimit, (unsigned long)result->speedChanges);
+		}
+	}
+	FLEET_SIM_printSummary(&context, count);
+	if(context.scenario.horizon != 0)
+	{
+		reactive = context;
+		reactive.scenario.horizon = 0;
+		reactive.results = calloc(count, sizeof(FLEET_ResultType));
+		if(reactive.results == NULL_PTR)
+		{
+			perror("results");
+			return 1;
+		}
+		POOL_run(count, maxThreads, FLEET_SIM_task, &reactive);
+		fprintf(stderr, "reactive curve:\n");
+		FLEET_SIM_printSummary(&reactive, count);
+		FLEET_SIM_printComparison(&reactive, &context, count);
+		free(reactive.results);
+	}
+	free(context.results);
+	return 0;
+}
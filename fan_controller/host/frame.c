@@ -0,0 +1,195 @@
+/*
+ *
+ * Module: Host - Frame reader
+ *
+ * File Name: frame.c
+ *
+ * Description: Host side reader for the COBS framed stream sent by the telemetry module.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"frame.h"
+#include"../crc.h"
+#include<fcntl.h>
+#include<string.h>
+#include<termios.h>
+#include<unistd.h>
+
+/*Encoded frames are one byte longer than the decoded ones*/
+#define FRAME_MAX_ENCODED_SIZE		(FRAME_MAX_SIZE + 1)
+
+/*
+ * Description:
+ * Map a baud rate to the termios speed constant, unknown rates fall back to 9600
+ * */
+static speed_t FRAME_getSpeed(uint32 a_baudRate)
+{
+	switch(a_baudRate)
+	{
+	case 4800: return B4800;
+	case 19200: return B19200;
+	case 38400: return B38400;
+	case 57600: return B57600;
+	case 115200: return B115200;
+	default: return B9600;
+	}
+}
+
+/*
+ * Description:
+ * Decode one COBS frame, the delimiter is not part of a_encoded.
+ *
+ * Possible return values:
+ * the decoded length or -1 if the frame is not a valid COBS frame
+ * */
+static int FRAME_cobsDecode(const uint8 * a_encoded, int a_length, uint8 * a_decoded)
+{
+	int in = 0, out = 0, i = 0;
+	uint8 code = 0;
+	while(in < a_length)
+	{
+		code = a_encoded[in++];
+		if(code == 0 || in + code - 1 > a_length)
+		{
+			return -1;
+		}
+		for(i = 1; i < code; i++)
+		{
+			a_decoded[out++] = a_encoded[in++];
+		}
+		if(code != 0xFF && in < a_length)
+		{
+			a_decoded[out++] = 0;
+		}
+	}
+	return out;
+}
+
+uint16 FRAME_getUint16(const uint8 * a_buffer)
+{
+	return (uint16)(a_buffer[0] | ((uint16)a_buffer[1] << 8));
+}
+
+uint32 FRAME_getUint32(const uint8 * a_buffer)
+{
+	return (uint32)FRAME_getUint16(a_buffer) | ((uint32)FRAME_getUint16(a_buffer + 2) << 16);
+}
+
+/*
+ * Description:
+ * Open a serial device, pseudo-terminal or capture file for reading.
+ * Terminals are switched to raw mode with the passed baud rate.
+ * "-" opens the standard input.
+ *
+ * Possible return values:
+ * the file descriptor or -1 on failure
+ * */
+int FRAME_open(const char * a_path, uint32 a_baudRate)
+{
+	struct termios tty;
+	int fd = 0;
+	if(strcmp(a_path, "-") == 0)
+	{
+		return STDIN_FILENO;
+	}
+	fd = open(a_path, O_RDWR | O_NOCTTY);
+	if(fd < 0)
+	{
+		/*capture files can be read-only*/
+		fd = open(a_path, O_RDONLY);
+	}
+	if(fd >= 0 && isatty(fd) && tcgetattr(fd, &tty) == 0)
+	{
+		cfmakeraw(&tty);
+		cfsetispeed(&tty, FRAME_getSpeed(a_baudRate));
+		cfsetospeed(&tty, FRAME_getSpeed(a_baudRate));
+		tty.c_cc[VMIN] = 1;
+		tty.c_cc[VTIME] = 0;
+		tcsetattr(fd, TCSANOW, &tty);
+	}
+	return fd;
+}
+
+/*
+ * Description:
+ * Read frames from a_fd until the end of the stream or until the callback returns FALSE.
+ * a_stats can be NULL_PTR.
+ * */
+void FRAME_read(int a_fd, FRAME_CallbackType a_callback, void * a_context, FRAME_StatsType * a_stats)
+{
+	uint8 chunk[4096], encoded[FRAME_MAX_ENCODED_SIZE], decoded[FRAME_MAX_SIZE];
+	FRAME_StatsType stats;
+	FRAME_Type frame;
+	int encodedLength = 0, decodedLength = 0, overflow = FALSE;
+	uint8 expectedSequence = 0, synchronized = FALSE;
+	ssize_t count = 0, i = 0;
+
+	memset(&stats, 0, sizeof(stats));
+	while((count = read(a_fd, chunk, sizeof(chunk))) > 0)
+	{
+		for(i = 0; i < count; i++)
+		{
+			if(chunk[i] != 0)
+			{
+				if(encodedLength < FRAME_MAX_ENCODED_SIZE)
+				{
+					encoded[encodedLength++] = chunk[i];
+				}
+				else
+				{
+					overflow = TRUE; /*keep skipping until the next delimiter*/
+				}
+				continue;
+			}
+
+			/*A delimiter, a complete frame is in the buffer*/
+			if(encodedLength == 0)
+			{
+				continue;
+			}
+			decodedLength = overflow ? -1 : FRAME_cobsDecode(encoded, encodedLength, decoded);
+			encodedLength = 0;
+			overflow = FALSE;
+			if(decodedLength < 4)
+			{
+				stats.cobsErrors++;
+				continue;
+			}
+			if(CRC16_update(CRC16_INITIAL_VALUE, decoded, decodedLength - 2) !=
+					FRAME_getUint16(&decoded[decodedLength - 2]))
+			{
+				stats.crcErrors++;
+				continue;
+			}
+
+			frame.type = decoded[0];
+			frame.sequence = decoded[1];
+			frame.length = (uint8)(decodedLength - 4);
+			memcpy(frame.payload, &decoded[2], frame.length);
+
+			if(synchronized)
+			{
+				stats.sequenceGaps += (uint8)(frame.sequence - expectedSequence);
+			}
+			synchronized = TRUE;
+			expectedSequence = frame.sequence + 1;
+			stats.frames++;
+
+			if(a_callback(&frame, a_context) == FALSE)
+			{
+				count = 0;
+				break;
+			}
+		}
+		if(count == 0)
+		{
+			break;
+		}
+	}
+	if(a_stats != NULL_PTR)
+	{
+		*a_stats = stats;
+	}
+}
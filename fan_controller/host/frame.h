@@ -0,0 +1,70 @@
+/*
+ *
+ * Module: Host - Frame reader
+ *
+ * File Name: frame.h
+ *
+ * Description: Host side reader for the COBS framed stream sent by the telemetry module.
+ * It splits the stream on the 0x00 delimiter, COBS decodes each frame and checks its CRC.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include"../std_types.h"
+#include"../telemetry.h"
+
+/*Largest decoded frame: type + sequence + payload + CRC*/
+#define FRAME_MAX_SIZE		(TELEMETRY_MAX_PAYLOAD + 4)
+
+typedef struct
+{
+	uint8 type;
+	uint8 sequence;
+	uint8 length; /*payload length*/
+	uint8 payload[TELEMETRY_MAX_PAYLOAD];
+}FRAME_Type;
+
+typedef struct
+{
+	uint32 frames; /*valid frames*/
+	uint32 crcErrors;
+	uint32 cobsErrors; /*wrong COBS codes or too long frames*/
+	uint32 sequenceGaps; /*frames lost between two valid frames*/
+}FRAME_StatsType;
+
+/*
+ * Description:
+ * called for every valid frame, returning FALSE stops the reader
+ * */
+typedef uint8 (*FRAME_CallbackType)(const FRAME_Type * a_frame, void * a_context);
+
+/*
+ * Description:
+ * Open a serial device, pseudo-terminal or capture file for reading.
+ * Terminals are switched to raw mode with the passed baud rate.
+ * "-" opens the standard input.
+ *
+ * Possible return values:
+ * the file descriptor or -1 on failure
+ * */
+int FRAME_open(const char * a_path, uint32 a_baudRate);
+
+/*
+ * Description:
+ * Read frames from a_fd until the end of the stream or until the callback returns FALSE.
+ * a_stats can be NULL_PTR.
+ * */
+void FRAME_read(int a_fd, FRAME_CallbackType a_callback, void * a_context, FRAME_StatsType * a_stats);
+
+/*
+ * Description:
+ * Read little endian values from a frame payload
+ * */
+uint16 FRAME_getUint16(const uint8 * a_buffer);
+uint32 FRAME_getUint32(const uint8 * a_buffer);
+
+#endif /* FRAME_H_ */
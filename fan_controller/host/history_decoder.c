@@ -0,0 +1,216 @@
+/*
+ *
+ * Module: Host - History decoder
+ *
+ * File Name: history_decoder.c
+ *
+ * Description: Decode a history dump (see history.h) to CSV.
+ * The samples are printed as "seconds,temperature,duty", with -s the EEPROM
+ * summaries are printed instead. With -r the "get history" command is sent first.
+ *
+ * Usage: history_decoder [-b baud] [-r] [-s] device|capture|-
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"frame.h"
+#include"../history.h"
+#include"../crc.h"
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+
+typedef struct
+{
+	uint8 summaries; /*print the summaries instead of the samples*/
+	uint32 blocks;
+	uint32 errors; /*blocks or summaries that could not be decoded*/
+}HISTORY_DECODER_ContextType;
+
+/*
+ * Description:
+ * Read a varint, return the number of used bytes or 0 if it runs past the end
+ * */
+static uint8 HISTORY_DECODER_getVarint(const uint8 * a_buffer, uint8 a_length, uint32 * a_value)
+{
+	uint8 i = 0;
+	*a_value = 0;
+	for(i = 0; i < a_length && i < 5; i++)
+	{
+		*a_value |= (uint32)(a_buffer[i] & 0x7F) << (7 * i);
+		if((a_buffer[i] & 0x80) == 0)
+		{
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+static sint32 HISTORY_DECODER_unzigzag(uint32 a_value)
+{
+	return (a_value & 1) ? -(sint32)(a_value >> 1) - 1 : (sint32)(a_value >> 1);
+}
+
+/*
+ * Description:
+ * Print every sample of one block
+ * */
+static uint8 HISTORY_DECODER_printBlock(const uint8 * a_block, uint8 a_length)
+{
+	uint32 seconds = 0, value = 0;
+	sint16 temperature = 0; /*the recorder takes the changes modulo 2^16, as its sint16 samples*/
+	uint8 duty = 0, i = 0, used = 0, run = 0;
+
+	used = HISTORY_DECODER_getVarint(a_block, a_length, &seconds);
+	if(used == 0)
+	{
+		return FALSE;
+	}
+	i = used;
+	used = HISTORY_DECODER_getVarint(&a_block[i], a_length - i, &value);
+	if(used == 0 || i + used >= a_length)
+	{
+		return FALSE;
+	}
+	i += used;
+	temperature = (sint16)HISTORY_DECODER_unzigzag(value);
+	duty = a_block[i++];
+	printf("%lu,%ld,%u\n", (unsigned long)seconds, (long)temperature, duty);
+
+	while(i < a_length)
+	{
+		switch(a_block[i] & HISTORY_TOKEN_MASK)
+		{
+		case HISTORY_TOKEN_RUN:
+			for(run = 0; run <= (a_block[i] & HISTORY_MAX_RUN); run++)
+			{
+				printf("%lu,%ld,%u\n", (unsigned long)++seconds, (long)temperature, duty);
+			}
+			i++;
+			continue;
+		case HISTORY_TOKEN_DELTA:
+			/*sign extend the 6-bit change*/
+			temperature = (sint16)(temperature + ((sint16)((a_block[i] & 0x3F) ^ 0x20) - 0x20));
+			i++;
+			break;
+		case HISTORY_TOKEN_FULL:
+			used = HISTORY_DECODER_getVarint(&a_block[i + 1], a_length - i - 1, &value);
+			if(used == 0 || i + 1 + used >= a_length)
+			{
+				return FALSE;
+			}
+			temperature = (sint16)(temperature + HISTORY_DECODER_unzigzag(value));
+			duty = a_block[i + 1 + used];
+			i += used + 2;
+			break;
+		default:
+			return FALSE;
+		}
+		printf("%lu,%ld,%u\n", (unsigned long)++seconds, (long)temperature, duty);
+	}
+	return TRUE;
+}
+
+/*
+ * Description:
+ * Print one summary slot, empty or corrupted slots are skipped
+ * */
+static void HISTORY_DECODER_printSummary(const uint8 * a_summary)
+{
+	if(CRC16_update(CRC16_INITIAL_VALUE, a_summary, HISTORY_CHECKPOINT_SIZE - 2)
+			!= FRAME_getUint16(&a_summary[14]))
+	{
+		return;
+	}
+	printf("%u,%lu,%d,%d,%d,%u,%u\n", FRAME_getUint16(&a_summary[0]),
+			(unsigned long)FRAME_getUint32(&a_summary[2]),
+			(sint16)FRAME_getUint16(&a_summary[6]), (sint16)FRAME_getUint16(&a_summary[8]),
+			(sint16)FRAME_getUint16(&a_summary[10]), a_summary[12], a_summary[13]);
+}
+
+static uint8 HISTORY_DECODER_onFrame(const FRAME_Type * a_frame, void * a_context)
+{
+	HISTORY_DECODER_ContextType * context = a_context;
+
+	switch(a_frame->type)
+	{
+	case TELEMETRY_FRAME_HISTORY_BLOCK:
+		context->blocks++;
+		if(!context->summaries && !HISTORY_DECODER_printBlock(a_frame->payload, a_frame->length))
+		{
+			context->errors++;
+		}
+		break;
+	case TELEMETRY_FRAME_HISTORY_SUMMARY:
+		if(a_frame->length != HISTORY_CHECKPOINT_SIZE)
+		{
+			context->errors++;
+		}
+		else if(context->summaries)
+		{
+			HISTORY_DECODER_printSummary(a_frame->payload);
+		}
+		break;
+	case TELEMETRY_FRAME_HISTORY_END:
+		return FALSE;
+	default:
+		break; /*samples and responses are mixed with the dump*/
+	}
+	return TRUE;
+}
+
+int main(int argc, char * argv[])
+{
+	HISTORY_DECODER_ContextType context = {FALSE, 0, 0};
+	FRAME_StatsType stats = {0, 0, 0, 0};
+	uint32 baudRate = 9600;
+	uint8 request = FALSE;
+	int fd = 0, option = 0;
+
+	while((option = getopt(argc, argv, "b:rs")) != -1)
+	{
+		if(option == 'b')
+		{
+			baudRate = strtoul(optarg, NULL_PTR, 10);
+		}
+		else if(option == 'r')
+		{
+			request = TRUE;
+		}
+		else if(option == 's')
+		{
+			context.summaries = TRUE;
+		}
+		else
+		{
+			break;
+		}
+	}
+	if(argc - optind != 1)
+	{
+		fprintf(stderr, "usage: %s [-b baud] [-r] [-s] device|capture|-\n", argv[0]);
+		return 2;
+	}
+
+	fd = FRAME_open(argv[optind], baudRate);
+	if(fd < 0)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+	if(request && write(fd, "get history\n", 12) != 12)
+	{
+		fprintf(stderr, "history_decoder: can not send the command\n");
+		return 1;
+	}
+
+	printf(context.summaries ? "sequence,seconds,min,max,average,average_duty,max_duty\n"
+			: "seconds,temperature,duty\n");
+	FRAME_read(fd, HISTORY_DECODER_onFrame, &context, &stats);
+	fprintf(stderr, "blocks: %lu, decode errors: %lu, crc errors: %lu, lost frames: %lu\n",
+			(unsigned long)context.blocks, (unsigned long)context.errors,
+			(unsigned long)stats.crcErrors, (unsigned long)stats.sequenceGaps);
+	return context.errors != 0 || stats.crcErrors != 0;
+}
@@ -0,0 +1,158 @@
+/*
+ *
+ * Module: Host - Kick-start simulation
+ *
+ * File Name: kick_sim.c
+ *
+ * Description: Start the fan of rotor.h from rest through the DC motor driver of the
+ * firmware on the simulated MCU and measure the time to the target speed, for
+ * several target speeds and kick-start boosts (see dcMotor.h):
+ *
+ * 	boost_speed,boost_ms,target,time_ms,peak
+ *
+ * The boost is ended by the real 1ms tick ISR of timer.h, the drive of the rotor is
+ * read back from OC0 and the motor pins every millisecond. time_ms is the settling
+ * time, the last time the rotor speed was more than 10% away from the speed it
+ * settles at, or "stall" when the rotor is still stopped at the end. peak is the
+ * highest speed on the way in percent of the full speed.
+ *
+ * Usage: kick_sim [-t seconds] [-k breakaway] [-f friction] [-c time_constant]
+ * 	-t	length of a start, 5s by default
+ * 	-k	duty that starts the stopped rotor, 0.30 by default
+ * 	-f	duty lost to the friction of the running rotor, 0.05 by default
+ * 	-c	mechanical time constant in seconds, 0.5 by default
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"port/mcu.h"
+#include"rotor.h"
+#include"../config.h"
+#include"../dcMotor.h"
+#include"../timer.h"
+#include"../gpio.h"
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+
+#define KICK_SIM_BAND		0.1 /*settled within 10% of the final speed*/
+
+typedef struct
+{
+	uint8 speed;
+	uint16 time;
+}KICK_SIM_BoostType;
+
+static const KICK_SIM_BoostType KICK_SIM_g_boosts[] =
+{
+	{0, 0}, {100, 50}, {CONFIG_DEFAULT_BOOST_SPEED, CONFIG_DEFAULT_BOOST_TIME_MS}, {100, 300}, {60, 300}
+};
+
+static const uint8 KICK_SIM_g_targets[] = {10, 20, 25, 30, 40, 50, 75};
+
+#define KICK_SIM_BOOSTS		(sizeof(KICK_SIM_g_boosts) / sizeof(KICK_SIM_g_boosts[0]))
+#define KICK_SIM_TARGETS	(sizeof(KICK_SIM_g_targets) / sizeof(KICK_SIM_g_targets[0]))
+
+/*
+ * Description:
+ * Drive seen by the rotor, the duty signed by the direction the motor pins select
+ */
+static float64 KICK_SIM_getDrive(void)
+{
+	uint8 pin1 = MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN1);
+	uint8 pin2 = MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN2);
+	if(pin1 == 0xFF || pin2 == 0xFF || pin1 == pin2)
+	{
+		return 0.0;
+	}
+	return pin1 ? MCU_getPwmDuty() : -MCU_getPwmDuty();
+}
+
+/*
+ * Description:
+ * Start the stopped rotor at a_target with a_boost and print its line
+ * */
+static void KICK_SIM_run(const ROTOR_Type * a_model, const KICK_SIM_BoostType * a_boost, uint8 a_target,
+		uint32 a_ms)
+{
+	ROTOR_Type rotor = *a_model;
+	float64 final = 0, peak = 0;
+	uint32 ms = 0, settled = 0;
+
+	MCU_init();
+	TIMER_init();
+	DC_MOTOR_Init();
+	DC_MOTOR_setBoost(a_boost->speed, a_boost->time);
+	rotor.speed = 0.0;
+	final = ROTOR_getSteadyState(&rotor, (float64)a_target / DC_MOTOR_MAX_SPEED);
+
+	DC_MOTOR_Rotate(DC_MOTOR_CW, a_target);
+	for(ms = 1; ms <= a_ms; ms++)
+	{
+		MCU_delay(MCU_CYCLES_PER_MS);
+		ROTOR_step(&rotor, KICK_SIM_getDrive(), FALSE, 0.001);
+		peak = rotor.speed > peak ? rotor.speed : peak;
+		if(fabs(rotor.speed - final) > KICK_SIM_BAND * final)
+		{
+			settled = ms;
+		}
+	}
+	TIMER_deInit();
+
+	if(rotor.speed == 0.0)
+	{
+		printf("%u,%u,%u,stall,%.0f\n", a_boost->speed, a_boost->time, a_target, peak * 100);
+	}
+	else
+	{
+		printf("%u,%u,%u,%lu,%.0f\n", a_boost->speed, a_boost->time, a_target, (unsigned long)settled, peak * 100);
+	}
+}
+
+int main(int argc, char * argv[])
+{
+	ROTOR_Type model;
+	float64 seconds = 5.0;
+	uint32 i = 0, j = 0;
+	int option = 0;
+
+	ROTOR_init(&model);
+	while((option = getopt(argc, argv, "t:k:f:c:")) != -1)
+	{
+		switch(option)
+		{
+		case 't':
+			seconds = atof(optarg);
+			break;
+		case 'k':
+			model.breakaway = atof(optarg);
+			break;
+		case 'f':
+			model.friction = atof(optarg);
+			break;
+		case 'c':
+			model.timeConstant = atof(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-t seconds] [-k breakaway] [-f friction] [-c time_constant]\n", argv[0]);
+			return 2;
+		}
+	}
+	if(seconds <= 0.0 || model.timeConstant <= 0.0)
+	{
+		fprintf(stderr, "kick_sim: the time and the time constant must be positive\n");
+		return 2;
+	}
+
+	printf("boost_speed,boost_ms,target,time_ms,peak\n");
+	for(i = 0; i < KICK_SIM_BOOSTS; i++)
+	{
+		for(j = 0; j < KICK_SIM_TARGETS; j++)
+		{
+			KICK_SIM_run(&model, &KICK_SIM_g_boosts[i], KICK_SIM_g_targets[j], (uint32)(seconds * 1000));
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,345 @@
+/*
+ *
+ * Module: Host - Pipeline regression
+ *
+ * File Name: pipeline_test.c
+ *
+ * Description: Exhaustive check of the sense to actuate pipeline on the simulated MCU:
+ * 	adc		every ADC code through LM35_getTemperature
+ * 	curve	every temperature through MAIN_getFanSpeed with the default curve
+ * 	motor	every speed through DC_MOTOR_Rotate, the output is OCR0 or the error code
+ * 	chain	every ADC code through the three stages as MAIN_sample chains them
+ * 	lifted	every ADC code over a noisy lifted ground through LM35_getTemperature, fixed point
+ * 	fault	the same samples through SENSOR_check with the code of the ground pin
+ *
+ * Every output is compared with two models:
+ * 	1. the reference model, exact integer arithmetic of what the code means to do
+ * 	   (truncated degrees saturated at LM35_MAX_DEGREE, the curve ladder, the rounded compare value).
+ * 	   Its divergences are listed, they are known rounding choices of the drivers,
+ * 	   -s makes them fail the test.
+ * 	2. the golden run (golden/pipeline.csv), the outputs of the drivers when the file
+ * 	   was made. A change of any output fails the test, so an optimization of the
+ * 	   pipeline is verified bit for bit. -u writes the golden run again.
+ *
+ * Usage: pipeline_test [-s] [-u] [-v] [-g golden.csv]
+ * 	-s	fail on a divergence from the reference model too
+ * 	-u	write the golden run instead of comparing with it
+ * 	-v	print every divergence, only the first of each stage otherwise
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include<avr/io.h>
+#include"port/mcu.h"
+#include"../adc.h"
+#include"../lm35.h"
+#include"../config.h"
+#include"../sensor.h"
+#include"../main.h"
+#include<stdio.h>
+#include<string.h>
+#include<unistd.h>
+
+#define PIPELINE_LINE_SIZE		64
+#define PIPELINE_MAX_SPEED		0xFF /*every uint8 speed, above 100 the driver reports an error*/
+#define PIPELINE_ERROR_FLAG		0x100 /*marks an error code in the motor outputs*/
+#define PIPELINE_GROUND_CODE	480 /*LM35_GROUND_VOLTS*/
+#define PIPELINE_GROUND_NOISE	7 /*codes, the ground moves by +/-3 codes from sample to sample*/
+
+typedef enum
+{
+	PIPELINE_ADC, PIPELINE_CURVE, PIPELINE_MOTOR, PIPELINE_CHAIN, PIPELINE_LIFTED, PIPELINE_FAULT,
+	PIPELINE_STAGES
+}PIPELINE_StageType;
+
+typedef struct
+{
+	FILE * golden; /*read, or written with -u*/
+	uint8 update;
+	uint8 verbose;
+	uint32 divergences[PIPELINE_STAGES];
+	uint32 changes;
+	uint32 lines;
+}PIPELINE_ContextType;
+
+static const char * const PIPELINE_g_stageNames[PIPELINE_STAGES] = {"adc", "curve", "motor", "chain", "lifted", "fault"};
+
+/*
+ * Description:
+ * Reference: degrees = code * VREF / (ADC_MAX * V_PER_DEGREE) truncated, in integers
+ * (2560mV * code / (1023 * 10mV)), saturated at the end of the range of the lifted ground
+ * */
+static uint16 PIPELINE_referenceTemperature(uint16 a_code)
+{
+	uint32 millivolts = (uint32)(ADC_VREF * 1000 + 0.5);
+	uint32 degrees = ((uint32)a_code * millivolts) / ((uint32)ADC_MAX * LM35_MV_PER_DEGREE);
+	return degrees > LM35_MAX_DEGREE ? LM35_MAX_DEGREE : (uint16)degrees;
+}
+
+/*
+ * Description:
+ * Reference: the fixed point temperature above the ground pin rounded down, also below 0,
+ * (code - ground) * 2560mV * LM35_ONE_DEGREE / (1023 * 10mV) saturated at LM35_MAX_DEGREE
+ * */
+static uint16 PIPELINE_referenceLifted(uint16 a_code, uint16 a_ground)
+{
+	sint32 millivolts = (sint32)(ADC_VREF * 1000 + 0.5);
+	sint32 scaled = ((sint32)a_code - (sint32)a_ground) * millivolts * LM35_ONE_DEGREE;
+	sint32 divisor = (sint32)ADC_MAX * LM35_MV_PER_DEGREE;
+	sint32 temperature = (scaled >= 0 ? scaled : scaled - divisor + 1) / divisor;
+	return (uint16)(temperature > LM35_FROM_DEGREES(LM35_MAX_DEGREE) ? LM35_FROM_DEGREES(LM35_MAX_DEGREE)
+			: temperature);
+}
+
+/*
+ * Description:
+ * Reference: open under 0.01V or 60C under the ground pin, short at the last code
+ * or 155C above the ground pin, past the -55C -> 150C range of the LM35
+ * */
+static uint16 PIPELINE_referenceFault(uint16 a_code, uint16 a_ground)
+{
+	float64 volts = (float64)a_code * ADC_VREF / ADC_MAX;
+	float64 degrees = ((float64)a_code - a_ground) * ADC_VREF / ADC_MAX / LM35_V_PER_DEGREE;
+	if(volts < 0.01 || degrees < -60)
+	{
+		return SENSOR_FAULT_OPEN;
+	}
+	return (a_code >= ADC_MAX || degrees > 155) ? SENSOR_FAULT_SHORT : SENSOR_OK;
+}
+
+/*
+ * Description:
+ * Reference: the speed of the hottest point at or below the temperature, 0 under the first one
+ * */
+static uint16 PIPELINE_referenceSpeed(const CONFIG_CurveType * a_curve, uint16 a_temperature)
+{
+	uint16 speed = 0;
+	uint8 i = 0;
+	for(i = 0; i < CONFIG_CURVE_POINTS; i++)
+	{
+		if(a_temperature >= a_curve->temperature[i])
+		{
+			speed = a_curve->speed[i];
+		}
+	}
+	return speed;
+}
+
+/*
+ * Description:
+ * Reference: compare value = speed * 255 / 100 rounded to the nearest, an error above 100%
+ * */
+static uint16 PIPELINE_referenceCompare(uint16 a_speed)
+{
+	if(a_speed > DC_MOTOR_MAX_SPEED)
+	{
+		return PIPELINE_ERROR_FLAG | DC_MOTOR_ERROR_SPEED;
+	}
+	return (uint16)((((uint32)a_speed * PWM_MAX_VALUE) + (DC_MOTOR_MAX_SPEED / 2)) / DC_MOTOR_MAX_SPEED);
+}
+
+/*
+ * Description:
+ * Compare one output with the reference model and with the golden run
+ * (or write it to the golden run)
+ * */
+static void PIPELINE_check(PIPELINE_ContextType * a_context, PIPELINE_StageType a_stage, uint16 a_input,
+		uint16 a_output, uint16 a_reference)
+{
+	char line[PIPELINE_LINE_SIZE], golden[PIPELINE_LINE_SIZE];
+
+	if(a_output != a_reference)
+	{
+		if(a_context->verbose || a_context->divergences[a_stage] == 0)
+		{
+			printf("%s %u: %u, reference %u\n", PIPELINE_g_stageNames[a_stage], a_input, a_output, a_reference);
+		}
+		a_context->divergences[a_stage]++;
+	}
+
+	snprintf(line, sizeof(line), "%s,%u,%u\n", PIPELINE_g_stageNames[a_stage], a_input, a_output);
+	a_context->lines++;
+	if(a_context->update)
+	{
+		fputs(line, a_context->golden);
+	}
+	else if(fgets(golden, sizeof(golden), a_context->golden) == NULL_PTR || strcmp(line, golden) != 0)
+	{
+		if(a_context->changes < 10)
+		{
+			printf("golden line %lu changed: %s", (unsigned long)a_context->lines, line);
+		}
+		a_context->changes++;
+	}
+}
+
+/*
+ * Description:
+ * Output of DC_MOTOR_Rotate: OCR0, or the error code with PIPELINE_ERROR_FLAG
+ * */
+static uint16 PIPELINE_rotate(uint8 a_speed)
+{
+	DC_MOTOR_ErrorType response = DC_MOTOR_Rotate(DC_MOTOR_CW, a_speed);
+	if(response != DC_MOTOR_NO_ERROR)
+	{
+		return PIPELINE_ERROR_FLAG | response;
+	}
+	return OCR0;
+}
+
+/*
+ * Description:
+ * Read one code and the code of the ground pin through the real ADC driver,
+ * the inputs are the middle of the code steps
+ * */
+static LM35_TemperatureType PIPELINE_readLifted(uint16 a_code, uint16 a_ground)
+{
+	LM35_TemperatureType temperature = 0;
+	MCU_setAdcVoltage(LM35_CHANNEL, ((float64)a_code + 0.5) * MCU_INTERNAL_VREF / (ADC_MAX + 1));
+	MCU_setAdcVoltage(LM35_REFERENCE_CHANNEL, ((float64)a_ground + 0.5) * MCU_INTERNAL_VREF / (ADC_MAX + 1));
+	temperature = LM35_getTemperature();
+	if(LM35_getLastDigitalValue() != a_code || LM35_getReference() != a_ground
+			|| LM35_getLastError() != ADC_SUCCESS)
+	{
+		printf("adc %u/%u: the simulated ADC read %u/%u\n", a_code, a_ground, LM35_getLastDigitalValue(),
+				LM35_getReference());
+	}
+	return temperature;
+}
+
+/*
+ * Description:
+ * Read one code with the ground pin at 0V, in whole degrees
+ * */
+static uint8 PIPELINE_read(uint16 a_code)
+{
+	return (uint8)LM35_TO_DEGREES(PIPELINE_readLifted(a_code, 0));
+}
+
+/*
+ * Description:
+ * Code of the lifted ground pin of a sample, the same noise on every run
+ * */
+static uint16 PIPELINE_ground(uint32 * a_seed)
+{
+	*a_seed = (*a_seed * 1103515245UL) + 12345;
+	return PIPELINE_GROUND_CODE + (uint16)((*a_seed >> 16) % PIPELINE_GROUND_NOISE) - (PIPELINE_GROUND_NOISE / 2);
+}
+
+static void PIPELINE_run(PIPELINE_ContextType * a_context)
+{
+	const CONFIG_CurveType * curve = NULL_PTR;
+	uint16 code = 0, input = 0, reference = 0, output = 0, ground = 0;
+	uint8 temperature = 0;
+	uint32 seed = 1;
+	SENSOR_FaultType faults[ADC_MAX + 1];
+
+	MCU_init();
+	CONFIG_init();
+	LM35_init();
+	DC_MOTOR_Init();
+	curve = &CONFIG_get()->curve;
+
+	for(code = 0; code <= ADC_MAX; code++)
+	{
+		PIPELINE_check(a_context, PIPELINE_ADC, code, PIPELINE_read(code), PIPELINE_referenceTemperature(code));
+	}
+	for(input = 0; input <= 0xFF; input++)
+	{
+		PIPELINE_check(a_context, PIPELINE_CURVE, input, MAIN_getFanSpeed(curve, LM35_FROM_DEGREES(input)),
+				PIPELINE_referenceSpeed(curve, input));
+	}
+	for(input = 0; input <= PIPELINE_MAX_SPEED; input++)
+	{
+		PIPELINE_check(a_context, PIPELINE_MOTOR, input, PIPELINE_rotate((uint8)input),
+				PIPELINE_referenceCompare(input));
+	}
+	/*MAIN_sample stops the motor under the first point, the chain output is then 0*/
+	for(code = 0; code <= ADC_MAX; code++)
+	{
+		temperature = PIPELINE_read(code);
+		output = temperature < curve->temperature[0] ? 0 : PIPELINE_rotate(MAIN_getFanSpeed(curve,
+				LM35_FROM_DEGREES(temperature)));
+		reference = PIPELINE_referenceTemperature(code);
+		reference = reference < curve->temperature[0] ? 0
+				: PIPELINE_referenceCompare(PIPELINE_referenceSpeed(curve, reference));
+		PIPELINE_check(a_context, PIPELINE_CHAIN, code, output, reference);
+	}
+	/*each sample is checked alone, the slew and the recovery of a sweep are not the point*/
+	for(code = 0; code <= ADC_MAX; code++)
+	{
+		ground = PIPELINE_ground(&seed);
+		output = (uint16)PIPELINE_readLifted(code, ground);
+		SENSOR_init();
+		faults[code] = SENSOR_check(LM35_getLastDigitalValue(), LM35_getReference(), LM35_getLastError());
+		PIPELINE_check(a_context, PIPELINE_LIFTED, code, output, PIPELINE_referenceLifted(code, ground));
+	}
+	seed = 1;
+	for(code = 0; code <= ADC_MAX; code++)
+	{
+		PIPELINE_check(a_context, PIPELINE_FAULT, code, faults[code], PIPELINE_referenceFault(code,
+				PIPELINE_ground(&seed)));
+	}
+}
+
+int main(int argc, char * argv[])
+{
+	PIPELINE_ContextType context;
+	const char * path = "golden/pipeline.csv";
+	uint8 strict = FALSE, i = 0;
+	uint32 divergences = 0;
+	int option = 0;
+
+	memset(&context, 0, sizeof(context));
+	while((option = getopt(argc, argv, "suvg:")) != -1)
+	{
+		switch(option)
+		{
+		case 's':
+			strict = TRUE;
+			break;
+		case 'u':
+			context.update = TRUE;
+			break;
+		case 'v':
+			context.verbose = TRUE;
+			break;
+		case 'g':
+			path = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-s] [-u] [-v] [-g golden.csv]\n", argv[0]);
+			return 2;
+		}
+	}
+	context.golden = fopen(path, context.update ? "w" : "r");
+	if(context.golden == NULL_PTR)
+	{
+		perror(path);
+		return 2;
+	}
+
+	PIPELINE_run(&context);
+	if(!context.update && fgetc(context.golden) != EOF)
+	{
+		printf("the golden run has more lines\n");
+		context.changes++;
+	}
+	fclose(context.golden);
+
+	for(i = 0; i < PIPELINE_STAGES; i++)
+	{
+		printf("pipeline_test: %s: %lu divergences from the reference\n", PIPELINE_g_stageNames[i],
+				(unsigned long)context.divergences[i]);
+		divergences += context.divergences[i];
+	}
+	if(context.update)
+	{
+		printf("pipeline_test: %lu lines written to %s\n", (unsigned long)context.lines, path);
+		return 0;
+	}
+	printf("pipeline_test: %lu of %lu outputs changed from the golden run\n", (unsigned long)context.changes,
+			(unsigned long)context.lines);
+	return context.changes != 0 || (strict && divergences != 0);
+}
@@ -0,0 +1,88 @@
+/*
+ *
+ * Module: Host - Thermal plant
+ *
+ * File Name: plant.c
+ *
+ * Description: Source file of the first order thermal model
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"plant.h"
+#include<math.h>
+
+#define PLANT_AMBIENT_MEAN		25.0
+#define PLANT_AMBIENT_SWING		5.0
+#define PLANT_AMBIENT_PEAK_HOUR	15.0
+
+typedef struct
+{
+	float64 hour;	/*start of the segment in the day*/
+	float64 power;	/*W until the next segment*/
+}PLANT_LoadType;
+
+/*idle at night, working hours, a heavy job after lunch and a short spike*/
+static const PLANT_LoadType PLANT_g_dayLoad[] =
+{
+	{0.0, 10.0},
+	{8.0, 45.0},
+	{13.0, 70.0},
+	{14.5, 45.0},
+	{16.0, 90.0},
+	{16.25, 45.0},
+	{18.0, 10.0}
+};
+
+static float64 PLANT_getConductance(const PLANT_Type * a_plant, float64 a_duty)
+{
+	if(a_duty < 0.0)
+	{
+		a_duty = 0.0;
+	}
+	else if(a_duty > 1.0)
+	{
+		a_duty = 1.0;
+	}
+	return a_plant->naturalCooling + (a_plant->fanCooling * a_duty);
+}
+
+void PLANT_init(PLANT_Type * a_plant, float64 a_temperature)
+{
+	a_plant->heatCapacity = PLANT_DEFAULT_HEAT_CAPACITY;
+	a_plant->naturalCooling = PLANT_DEFAULT_NATURAL_COOLING;
+	a_plant->fanCooling = PLANT_DEFAULT_FAN_COOLING;
+	a_plant->temperature = a_temperature;
+}
+
+float64 PLANT_getSteadyState(const PLANT_Type * a_plant, float64 a_power, float64 a_ambient, float64 a_duty)
+{
+	return a_ambient + (a_power / PLANT_getConductance(a_plant, a_duty));
+}
+
+float64 PLANT_step(PLANT_Type * a_plant, float64 a_power, float64 a_ambient, float64 a_duty, float64 a_seconds)
+{
+	float64 target = PLANT_getSteadyState(a_plant, a_power, a_ambient, a_duty);
+	float64 timeConstant = a_plant->heatCapacity / PLANT_getConductance(a_plant, a_duty);
+	/*T(t) = Tss + (T0 - Tss) * e^(-t/tau)*/
+	a_plant->temperature = target + ((a_plant->temperature - target) * exp(-a_seconds / timeConstant));
+	return a_plant->temperature;
+}
+
+float64 PLANT_getDayAmbient(float64 a_seconds)
+{
+	float64 hour = fmod(a_seconds, PLANT_SECONDS_PER_DAY) / PLANT_SECONDS_PER_HOUR;
+	return PLANT_AMBIENT_MEAN + (PLANT_AMBIENT_SWING * cos(2 * M_PI * (hour - PLANT_AMBIENT_PEAK_HOUR) / 24.0));
+}
+
+float64 PLANT_getDayLoad(float64 a_seconds)
+{
+	float64 hour = fmod(a_seconds, PLANT_SECONDS_PER_DAY) / PLANT_SECONDS_PER_HOUR;
+	uint8 i = 0;
+	while(i + 1 < sizeof(PLANT_g_dayLoad) / sizeof(PLANT_g_dayLoad[0]) && hour >= PLANT_g_dayLoad[i + 1].hour)
+	{
+		i++;
+	}
+	return PLANT_g_dayLoad[i].power;
+}
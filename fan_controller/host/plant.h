@@ -0,0 +1,73 @@
+/*
+ *
+ * Module: Host - Thermal plant
+ *
+ * File Name: plant.h
+ *
+ * Description: Header file of a first order thermal model of the cooled device.
+ *
+ * A single heat capacity C is heated by P watts and loses heat to the ambient air
+ * through a conductance that grows with the fan duty:
+ * 	C * dT/dt = P - (G_natural + G_fan * duty) * (T - T_ambient)
+ *
+ * The day scenario is a device in a room: the ambient follows a sine from 20C
+ * at 03:00 to 30C at 15:00 and the load is a table of idle, working hours, a
+ * heavy job after lunch and a short spike (see plant.c).
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef PLANT_H_
+#define PLANT_H_
+
+#include"../std_types.h"
+
+/*Defaults, a small heat sink that reaches ~65C at 50W with the fan at half speed*/
+#define PLANT_DEFAULT_HEAT_CAPACITY		600.0	/*J/C*/
+#define PLANT_DEFAULT_NATURAL_COOLING	0.4		/*W/C, fan stopped*/
+#define PLANT_DEFAULT_FAN_COOLING		2.0		/*W/C added at 100% duty*/
+
+#define PLANT_SECONDS_PER_HOUR			3600.0
+#define PLANT_SECONDS_PER_DAY			(24 * PLANT_SECONDS_PER_HOUR)
+
+typedef struct
+{
+	float64 heatCapacity;
+	float64 naturalCooling;
+	float64 fanCooling;
+	float64 temperature;
+}PLANT_Type;
+
+/*
+ * Description:
+ * Set the default parameters and start at a_temperature
+ * */
+void PLANT_init(PLANT_Type * a_plant, float64 a_temperature);
+
+/*
+ * Description:
+ * Advance the model by a_seconds with constant inputs, the exact solution of the
+ * equation is used so the step can be as long as wanted.
+ * a_duty is the fan duty from 0.0 to 1.0 (0 when the motor is stopped)
+ *
+ * Possible return values:
+ * the new temperature
+ * */
+float64 PLANT_step(PLANT_Type * a_plant, float64 a_power, float64 a_ambient, float64 a_duty, float64 a_seconds);
+
+/*
+ * Description:
+ * Temperature reached when the inputs stay constant forever
+ * */
+float64 PLANT_getSteadyState(const PLANT_Type * a_plant, float64 a_power, float64 a_ambient, float64 a_duty);
+
+/*
+ * Description:
+ * Ambient temperature and load of the day scenario a_seconds after midnight,
+ * the day repeats after 24 hours
+ * */
+float64 PLANT_getDayAmbient(float64 a_seconds);
+float64 PLANT_getDayLoad(float64 a_seconds);
+
+#endif /* PLANT_H_ */
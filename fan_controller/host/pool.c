@@ -0,0 +1,175 @@
+/*
+ *
+ * Module: Host - Thread pool
+ *
+ * File Name: pool.c
+ *
+ * Description: Source file of a work stealing thread pool for the host simulations
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"pool.h"
+#include<pthread.h>
+#include<unistd.h>
+
+/*a range is padded to its own cache line so the owners do not slow each other*/
+typedef struct
+{
+	pthread_mutex_t lock;
+	uint32 begin;
+	uint32 end;
+	uint32 steals;
+	uint8 padding[64];
+}POOL_RangeType;
+
+typedef struct
+{
+	POOL_RangeType ranges[POOL_MAX_THREADS];
+	uint16 threads;
+	POOL_TaskType task;
+	void * context;
+}POOL_Type;
+
+typedef struct
+{
+	POOL_Type * pool;
+	uint16 thread;
+}POOL_WorkerType;
+
+/*
+ * Description:
+ * Take the next index of the own range
+ * */
+static uint8 POOL_take(POOL_RangeType * a_range, uint32 * a_index)
+{
+	uint8 taken = FALSE;
+	pthread_mutex_lock(&a_range->lock);
+	if(a_range->begin < a_range->end)
+	{
+		*a_index = a_range->begin++;
+		taken = TRUE;
+	}
+	pthread_mutex_unlock(&a_range->lock);
+	return taken;
+}
+
+/*
+ * Description:
+ * Move the back half of the range of another thread to the empty range of a_thread,
+ * the victims are tried in turn from the next thread
+ *
+ * Possible return values:
+ * FALSE if every range is empty, the work is then over for this thread
+ * */
+static uint8 POOL_steal(POOL_Type * a_pool, uint16 a_thread)
+{
+	POOL_RangeType * own = &a_pool->ranges[a_thread], * victim = NULL_PTR;
+	uint32 begin = 0, end = 0;
+	uint16 i = 0;
+
+	for(i = 1; i < a_pool->threads; i++)
+	{
+		victim = &a_pool->ranges[(a_thread + i) % a_pool->threads];
+		pthread_mutex_lock(&victim->lock);
+		if(victim->begin < victim->end)
+		{
+			/*a single index left goes to the thief, its owner may be busy for long*/
+			begin = victim->begin + ((victim->end - victim->begin) / 2);
+			end = victim->end;
+			victim->end = begin;
+		}
+		pthread_mutex_unlock(&victim->lock);
+		if(begin < end)
+		{
+			pthread_mutex_lock(&own->lock);
+			own->begin = begin;
+			own->end = end;
+			own->steals++;
+			pthread_mutex_unlock(&own->lock);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static void * POOL_work(void * a_worker)
+{
+	POOL_WorkerType * worker = a_worker;
+	POOL_Type * pool = worker->pool;
+	uint32 index = 0;
+
+	do
+	{
+		while(POOL_take(&pool->ranges[worker->thread], &index))
+		{
+			pool->task(index, worker->thread, pool->context);
+		}
+	}while(POOL_steal(pool, worker->thread));
+	return NULL_PTR;
+}
+
+uint16 POOL_getDefaultThreads(void)
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	if(count < 1)
+	{
+		return 1;
+	}
+	return count > POOL_MAX_THREADS ? POOL_MAX_THREADS : (uint16)count;
+}
+
+uint32 POOL_run(uint32 a_count, uint16 a_threads, POOL_TaskType a_task, void * a_context)
+{
+	POOL_Type pool;
+	pthread_t handles[POOL_MAX_THREADS];
+	POOL_WorkerType workers[POOL_MAX_THREADS];
+	uint32 steals = 0;
+	uint16 i = 0;
+
+	if(a_threads == 0)
+	{
+		a_threads = 1;
+	}
+	else if(a_threads > POOL_MAX_THREADS)
+	{
+		a_threads = POOL_MAX_THREADS;
+	}
+	pool.threads = a_threads;
+	pool.task = a_task;
+	pool.context = a_context;
+	for(i = 0; i < a_threads; i++)
+	{
+		pthread_mutex_init(&pool.ranges[i].lock, NULL_PTR);
+		pool.ranges[i].begin = (uint32)(((uint64)a_count * i) / a_threads);
+		pool.ranges[i].end = (uint32)(((uint64)a_count * (i + 1)) / a_threads);
+		pool.ranges[i].steals = 0;
+		workers[i].pool = &pool;
+		workers[i].thread = i;
+	}
+
+	for(i = 1; i < a_threads; i++)
+	{
+		if(pthread_create(&handles[i], NULL_PTR, POOL_work, &workers[i]) != 0)
+		{
+			/*the thread is missing, its range is stolen by the others*/
+			handles[i] = 0;
+		}
+	}
+	POOL_work(&workers[0]);
+	for(i = 1; i < a_threads; i++)
+	{
+		if(handles[i] != 0)
+		{
+			pthread_join(handles[i], NULL_PTR);
+		}
+	}
+
+	for(i = 0; i < a_threads; i++)
+	{
+		steals += pool.ranges[i].steals;
+		pthread_mutex_destroy(&pool.ranges[i].lock);
+	}
+	return steals;
+}
@@ -0,0 +1,49 @@
+/*
+ *
+ * Module: Host - Thread pool
+ *
+ * File Name: pool.h
+ *
+ * Description: Header file of a work stealing thread pool for the host simulations.
+ *
+ * POOL_run calls a task for every index of 0 -> count - 1 on all the threads.
+ * Every thread starts with an equal range of indexes and takes them from the
+ * front. A thread whose range is empty steals the back half of the range of
+ * another one, so threads that got the slow tasks are helped and all of them
+ * stay busy until the end. The tasks must be independent.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef POOL_H_
+#define POOL_H_
+
+#include"../std_types.h"
+
+#define POOL_MAX_THREADS		256
+
+/*
+ * Description:
+ * One task, a_thread is the number of the running thread (0 -> threads - 1)
+ * so the task can use per thread buffers
+ * */
+typedef void (*POOL_TaskType)(uint32 a_index, uint16 a_thread, void * a_context);
+
+/*
+ * Description:
+ * Number of threads to use when none is given: the online CPUs
+ * */
+uint16 POOL_getDefaultThreads(void);
+
+/*
+ * Description:
+ * Run a_task for the indexes 0 -> a_count - 1 on a_threads threads and return when
+ * all of them are done. The calling thread is one of the workers.
+ *
+ * Possible return values:
+ * the number of stolen ranges, a measure of the load imbalance
+ * */
+uint32 POOL_run(uint32 a_count, uint16 a_threads, POOL_TaskType a_task, void * a_context);
+
+#endif /* POOL_H_ */
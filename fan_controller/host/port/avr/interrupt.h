@@ -0,0 +1,27 @@
+/*
+ *
+ * Module: Host port - Interrupts
+ *
+ * File Name: interrupt.h
+ *
+ * Description: Host replacement of <avr/interrupt.h>.
+ * An ISR is a plain function named after its vector (__vector_N, see io.h),
+ * the port calls it when the interrupt flag, its enable bit and the I-bit are set.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef _AVR_INTERRUPT_H_
+#define _AVR_INTERRUPT_H_
+
+#include<avr/io.h>
+
+#define ISR(vector, ...)	void vector(void); void vector(void)
+#define EMPTY_INTERRUPT(vector)		ISR(vector){}
+#define reti()				return
+
+#define sei()				(SREG |= (1 << SREG_I))
+#define cli()				(SREG &= (uint8_t)~(1 << SREG_I))
+
+#endif /* _AVR_INTERRUPT_H_ */
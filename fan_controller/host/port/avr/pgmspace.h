@@ -0,0 +1,32 @@
+/*
+ *
+ * Module: Host port - Program memory
+ *
+ * File Name: pgmspace.h
+ *
+ * Description: Host replacement of <avr/pgmspace.h>, there is a single address space
+ * on the host so the flash data is plain constant data.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef _AVR_PGMSPACE_H_
+#define _AVR_PGMSPACE_H_
+
+#include<stdint.h>
+#include<string.h>
+
+#define PROGMEM
+#define PSTR(text)				(text)
+#define PGM_P					const char *
+#define pgm_read_byte(address)	(*(const uint8_t *)(address))
+#define pgm_read_word(address)	(*(const uint16_t *)(address))
+#define pgm_read_dword(address)	(*(const uint32_t *)(address))
+#define pgm_read_ptr(address)	(*(void * const *)(address))
+#define memcpy_P				memcpy
+#define strcpy_P				strcpy
+#define strlen_P				strlen
+#define strcmp_P				strcmp
+
+#endif /* _AVR_PGMSPACE_H_ */
@@ -0,0 +1,32 @@
+/*
+ *
+ * Module: Host port - Sleep
+ *
+ * File Name: sleep.h
+ *
+ * Description: Host replacement of <avr/sleep.h>.
+ * Sleeping moves the virtual clock straight to the next interrupt, so an idle
+ * firmware runs much faster than real time.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef _AVR_SLEEP_H_
+#define _AVR_SLEEP_H_
+
+#include<avr/io.h>
+
+#define SLEEP_MODE_IDLE			0
+#define SLEEP_MODE_ADC			(1 << SM0)
+#define SLEEP_MODE_PWR_DOWN		(1 << SM1)
+#define SLEEP_MODE_PWR_SAVE		((1 << SM0) | (1 << SM1))
+#define SLEEP_MODE_STANDBY		((1 << SM1) | (1 << SM2))
+
+#define set_sleep_mode(mode)	(MCUCR = (MCUCR & ~((1 << SM0) | (1 << SM1) | (1 << SM2))) | (mode))
+#define sleep_enable()			(MCUCR |= (1 << SE))
+#define sleep_disable()			(MCUCR &= (uint8_t)~(1 << SE))
+#define sleep_cpu()				MCU_sleep()
+#define sleep_mode()			do{ sleep_enable(); sleep_cpu(); sleep_disable(); }while(0)
+
+#endif /* _AVR_SLEEP_H_ */
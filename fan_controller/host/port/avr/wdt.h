@@ -0,0 +1,31 @@
+/*
+ *
+ * Module: Host port - Watchdog
+ *
+ * File Name: wdt.h
+ *
+ * Description: Host replacement of <avr/wdt.h>.
+ * The WDR instruction restarts the timeout of the simulated watchdog,
+ * WDTCR is written by the firmware like on the target.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef _AVR_WDT_H_
+#define _AVR_WDT_H_
+
+#include<avr/io.h>
+
+#define WDTO_15MS		0
+#define WDTO_30MS		1
+#define WDTO_60MS		2
+#define WDTO_120MS		3
+#define WDTO_250MS		4
+#define WDTO_500MS		5
+#define WDTO_1S			6
+#define WDTO_2S			7
+
+#define wdt_reset()		MCU_watchdogReset()
+
+#endif /* _AVR_WDT_H_ */
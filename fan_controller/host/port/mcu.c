@@ -0,0 +1,1417 @@
+/*
+ *
+ * Module: Host port - Simulated MCU
+ *
+ * File Name: mcu.c
+ *
+ * Description: Source file for the simulated ATmega32 used to run the firmware on a PC
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"mcu.h"
+#include<avr/io.h>
+#include"../../gpio.h"
+#include"../../lcd.h"
+#include<stdlib.h>
+#include<string.h>
+#include<ucontext.h>
+
+/*
+ * Inside this file the register names access the I/O array directly,
+ * the drivers go through MCU_io8()/MCU_io16() instead
+ * */
+#undef _SFR_IO8
+#undef _SFR_IO16
+#define _SFR_IO8(address)		(MCU_g_io.bytes[address])
+#define _SFR_IO16(address)		(MCU_g_io.words[(address) >> 1])
+
+#define MCU_ADDRESS(reg)		((uint8)(&(reg) - MCU_g_io.bytes))
+/*a change made by a peripheral model is not a write of the firmware*/
+#define MCU_g_shadow			MCU_g_shadowIo.bytes
+#define MCU_SET(reg, value)		((reg) = (value), MCU_g_shadow[MCU_ADDRESS(reg)] = (reg))
+
+#define MCU_NEVER				0xFFFFFFFFFFFFFFFFULL
+#define MCU_STACK_SIZE			(1024UL * 1024UL)
+#define MCU_VECTORS				21
+#define MCU_ISR_CYCLES			4
+#define MCU_EEMWE_CYCLES		4
+#define MCU_EEPROM_WRITE_CYCLES	((uint64)F_CPU * 85 / 10000) /*8.5ms*/
+#define MCU_NO_FLAG				0xFF
+
+#define MCU_PORTS				4
+#define MCU_PIN(port)			MCU_g_io.bytes[MCU_g_pinAddress[port]]
+#define MCU_DDR(port)			MCU_g_io.bytes[MCU_g_pinAddress[port] + 1]
+#define MCU_PORT(port)			MCU_g_io.bytes[MCU_g_pinAddress[port] + 2]
+
+typedef struct
+{
+	uint64 last; /*cycle of the last counted timer clock*/
+	uint16 count;
+	uint16 divider; /*0 when the timer is stopped*/
+	uint16 top;
+	uint16 max;
+	uint8 ctc; /*in CTC mode the overflow flag is only set at MAX*/
+	uint16 compare[2];
+	uint8 compareFlag[2]; /*TIFR bit of each compare unit*/
+	uint8 overflowFlag;
+}MCU_TimerType;
+
+enum
+{
+	MCU_TIMER0, MCU_TIMER1, MCU_TIMER2, MCU_TIMERS
+};
+
+typedef union
+{
+	uint8 bytes[MCU_IO_SIZE];
+	uint16 words[MCU_IO_SIZE / 2];
+	uint64 quads[MCU_IO_SIZE / 8]; /*compared 8 registers at a time to find the writes*/
+}MCU_IoType;
+
+/*Global Variables */
+static MCU_IoType MCU_g_io;
+static MCU_IoType MCU_g_shadowIo; /*register values after the last applied write*/
+static uint64 MCU_g_cycles = 0;
+static uint64 MCU_g_nextEvent = MCU_NEVER;
+static uint32 MCU_g_interruptCounts[MCU_VECTORS];
+
+static const uint8 MCU_g_pinAddress[MCU_PORTS] = {0x19, 0x16, 0x13, 0x10}; /*PINA, PINB, PINC, PIND*/
+static uint8 MCU_g_pinInputs[MCU_PORTS];
+
+static MCU_TimerType MCU_g_timers[MCU_TIMERS];
+static const uint16 MCU_g_timer01Dividers[8] = {0, 1, 8, 64, 256, 1024, 0, 0}; /*6 and 7 are the T0/T1 pins*/
+static const uint16 MCU_g_timer2Dividers[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+static float64 MCU_g_adcVolts[MCU_ADC_CHANNELS];
+static float64 MCU_g_aref = MCU_AVCC;
+static uint64 MCU_g_adcDone = MCU_NEVER;
+static uint8 MCU_g_adcMux = 0; /*ADMUX latched at the start of the conversion*/
+static uint8 MCU_g_adcFirst = TRUE;
+/*positive input, negative input and gain of the differential MUX values 0x08 -> 0x1D*/
+static const uint8 MCU_g_adcDifferential[22][3] =
+{
+	{0, 0, 10}, {1, 0, 10}, {0, 0, 200}, {1, 0, 200}, {2, 2, 10}, {3, 2, 10}, {2, 2, 200}, {3, 2, 200},
+	{0, 1, 1}, {1, 1, 1}, {2, 1, 1}, {3, 1, 1}, {4, 1, 1}, {5, 1, 1}, {6, 1, 1}, {7, 1, 1},
+	{0, 2, 1}, {1, 2, 1}, {2, 2, 1}, {3, 2, 1}, {4, 2, 1}, {5, 2, 1}
+};
+
+static uint8 MCU_g_ucsrc = 0;
+static uint8 MCU_g_ubrrh = 0;
+static uint8 MCU_g_udrAccessed = FALSE;
+static uint8 MCU_g_inUdreIsr = FALSE;
+static uint64 MCU_g_txDone = MCU_NEVER;
+static uint8 MCU_g_txShift = 0;
+static uint8 MCU_g_txBuffered = FALSE;
+static uint8 MCU_g_txBuffer = 0;
+static uint8 MCU_g_rxQueue[MCU_UART_RX_SIZE];
+static uint16 MCU_g_rxHead = 0;
+static uint16 MCU_g_rxCount = 0;
+static uint8 MCU_g_rxData[2]; /*the two level receive buffer*/
+static uint8 MCU_g_rxReceived = 0;
+static uint64 MCU_g_rxDone = MCU_NEVER;
+static MCU_UartCallbackType MCU_g_uartCallback = NULL_PTR;
+static void * MCU_g_uartContext = NULL_PTR;
+
+static uint8 MCU_g_eeprom[MCU_EEPROM_SIZE];
+static uint8 MCU_g_eepromErased = FALSE;
+static uint64 MCU_g_eepromDone = MCU_NEVER;
+static uint16 MCU_g_eepromAddress = 0;
+static uint8 MCU_g_eepromData = 0;
+static uint64 MCU_g_eemweTime = 0;
+
+static uint64 MCU_g_watchdogExpiry = MCU_NEVER;
+static uint8 MCU_g_watchdogFired = FALSE;
+static uint32 MCU_g_watchdogResets = 0;
+
+static char MCU_g_lcdRam[0x80];
+static char MCU_g_lcdRows[MCU_LCD_ROWS][MCU_LCD_COLUMNS + 1];
+static uint8 MCU_g_lcdAddress = 0;
+static uint8 MCU_g_lcd8Bit = TRUE;
+static uint8 MCU_g_lcdHighNibble = 0;
+static uint8 MCU_g_lcdHaveHigh = FALSE;
+static uint8 MCU_g_lcdEnable = LOGIC_LOW;
+static uint32 MCU_g_lcdUpdates = 0;
+
+static ucontext_t MCU_g_hostContext;
+static ucontext_t MCU_g_firmwareContext;
+static void * MCU_g_stack = NULL_PTR;
+static int (*MCU_g_entry)(void) = NULL_PTR;
+static uint8 MCU_g_inFirmware = FALSE;
+static uint8 MCU_g_finished = FALSE;
+static uint64 MCU_g_stop = MCU_NEVER;
+
+/*
+ * The .data and .bss of the firmware objects are renamed by the Makefile so a reset
+ * can set them back like the C start up code does, .noinit keeps its name and its values
+ * */
+extern uint8 __start_firmware_data[] __attribute__((weak));
+extern uint8 __stop_firmware_data[] __attribute__((weak));
+extern uint8 __start_firmware_bss[] __attribute__((weak));
+extern uint8 __stop_firmware_bss[] __attribute__((weak));
+static uint8 * MCU_g_firmwareData = NULL_PTR; /*initial values of the firmware .data*/
+
+/*
+ * The vectors the firmware does not define do nothing,
+ * on the target they would jump to the reset vector
+ * */
+#define MCU_VECTOR(n)	void __vector_##n(void) __attribute__((weak)); void __vector_##n(void){}
+MCU_VECTOR(1) MCU_VECTOR(2) MCU_VECTOR(3) MCU_VECTOR(4) MCU_VECTOR(5)
+MCU_VECTOR(6) MCU_VECTOR(7) MCU_VECTOR(8) MCU_VECTOR(9) MCU_VECTOR(10)
+MCU_VECTOR(11) MCU_VECTOR(12) MCU_VECTOR(13) MCU_VECTOR(14) MCU_VECTOR(15)
+MCU_VECTOR(16) MCU_VECTOR(17) MCU_VECTOR(18) MCU_VECTOR(19) MCU_VECTOR(20)
+
+static void (* const MCU_g_vectors[MCU_VECTORS])(void) =
+{
+	NULL_PTR, __vector_1, __vector_2, __vector_3, __vector_4, __vector_5, __vector_6, __vector_7,
+	__vector_8, __vector_9, __vector_10, __vector_11, __vector_12, __vector_13, __vector_14,
+	__vector_15, __vector_16, __vector_17, __vector_18, __vector_19, __vector_20
+};
+
+static void MCU_commit(void);
+static uint8 MCU_adcTriggerFlag(void);
+static void MCU_adcStart(void);
+
+/******************************************************************************
+ * Timers
+ ******************************************************************************/
+
+/*
+ * Description:
+ * Number of timer clocks until the counter becomes a_value
+ * */
+static uint32 MCU_timerSteps(const MCU_TimerType * a_timer, uint16 a_value)
+{
+	uint32 period = (uint32)a_timer->top + 1;
+	uint32 steps = ((uint32)a_value + period - a_timer->count) % period;
+	return steps == 0 ? period : steps;
+}
+
+/*
+ * Description:
+ * Count the timer clocks since the last sync and set the flags that were passed
+ * */
+static void MCU_syncTimer(MCU_TimerType * a_timer)
+{
+	uint64 ticks = 0;
+	uint32 period = (uint32)a_timer->top + 1;
+	uint8 i = 0, flags = TIFR, trigger = MCU_NO_FLAG;
+
+	if(a_timer->divider == 0)
+	{
+		a_timer->last = MCU_g_cycles;
+		return;
+	}
+	ticks = (MCU_g_cycles - a_timer->last) / a_timer->divider;
+	if(ticks == 0)
+	{
+		return;
+	}
+	a_timer->last += ticks * a_timer->divider;
+
+	for(i = 0; i < 2; i++)
+	{
+		if(a_timer->compareFlag[i] != MCU_NO_FLAG && a_timer->compare[i] <= a_timer->top
+				&& ticks >= MCU_timerSteps(a_timer, a_timer->compare[i]))
+		{
+			MCU_SET(TIFR, TIFR | (1 << a_timer->compareFlag[i]));
+		}
+	}
+	if(ticks >= period - a_timer->count && (!a_timer->ctc || a_timer->top == a_timer->max))
+	{
+		MCU_SET(TIFR, TIFR | (1 << a_timer->overflowFlag));
+	}
+	a_timer->count = (uint16)((a_timer->count + ticks) % period);
+
+	/*the auto trigger of the ADC starts a conversion on the rising edge of its flag*/
+	trigger = MCU_adcTriggerFlag();
+	if(trigger != MCU_NO_FLAG && !(flags & (1 << trigger)) && (TIFR & (1 << trigger)) && MCU_g_adcDone == MCU_NEVER)
+	{
+		MCU_adcStart();
+	}
+}
+
+/*
+ * Description:
+ * Cycle of the next flag of the timer that has its interrupt enabled
+ * or that triggers the ADC
+ * */
+static uint64 MCU_nextTimerEvent(const MCU_TimerType * a_timer)
+{
+	uint32 steps = 0xFFFFFFFF;
+	uint8 i = 0, enabled = TIMSK;
+	if(MCU_adcTriggerFlag() != MCU_NO_FLAG)
+	{
+		enabled |= (1 << MCU_adcTriggerFlag());
+	}
+	if(a_timer->divider == 0)
+	{
+		return MCU_NEVER;
+	}
+	for(i = 0; i < 2; i++)
+	{
+		if(a_timer->compareFlag[i] != MCU_NO_FLAG && (enabled & (1 << a_timer->compareFlag[i]))
+				&& a_timer->compare[i] <= a_timer->top && MCU_timerSteps(a_timer, a_timer->compare[i]) < steps)
+		{
+			steps = MCU_timerSteps(a_timer, a_timer->compare[i]);
+		}
+	}
+	if((enabled & (1 << a_timer->overflowFlag)) && (uint32)a_timer->top + 1 - a_timer->count < steps)
+	{
+		steps = (uint32)a_timer->top + 1 - a_timer->count;
+	}
+	return steps == 0xFFFFFFFF ? MCU_NEVER : a_timer->last + ((uint64)steps * a_timer->divider);
+}
+
+/*
+ * Description:
+ * Read the mode, pre-scaler and compare values from the registers,
+ * the timers must be in sync before
+ * */
+static void MCU_configureTimers(void)
+{
+	MCU_TimerType * timer = &MCU_g_timers[MCU_TIMER0];
+	uint8 mode = 0;
+	static const uint16 timer1Tops[16] = {0xFFFF, 0xFF, 0x1FF, 0x3FF, 0, 0xFF, 0x1FF, 0x3FF,
+			0, 0, 0, 0, 0, 0xFFFF, 0, 0};
+
+	/*Timer 0: WGM01 selects CTC, WGM00 selects PWM*/
+	mode = ((TCCR0 >> WGM01) & 1) << 1 | ((TCCR0 >> WGM00) & 1);
+	timer->divider = MCU_g_timer01Dividers[TCCR0 & 0x07];
+	timer->compare[0] = OCR0;
+	timer->ctc = (mode == 2);
+	timer->top = timer->ctc ? OCR0 : 0xFF;
+
+	timer = &MCU_g_timers[MCU_TIMER2];
+	mode = ((TCCR2 >> WGM21) & 1) << 1 | ((TCCR2 >> WGM20) & 1);
+	timer->divider = MCU_g_timer2Dividers[TCCR2 & 0x07];
+	timer->compare[0] = OCR2;
+	timer->ctc = (mode == 2);
+	timer->top = timer->ctc ? OCR2 : 0xFF;
+
+	/*Timer 1, the phase correct modes are counted like the fast PWM ones*/
+	timer = &MCU_g_timers[MCU_TIMER1];
+	mode = (((TCCR1B >> WGM12) & 3) << 2) | (TCCR1A & 3);
+	timer->divider = MCU_g_timer01Dividers[TCCR1B & 0x07];
+	timer->compare[0] = OCR1A;
+	timer->compare[1] = OCR1B;
+	timer->ctc = (mode == 4 || mode == 12);
+	if(mode == 4 || mode == 9 || mode == 11 || mode == 15)
+	{
+		timer->top = OCR1A;
+	}
+	else if(mode == 8 || mode == 10 || mode == 12 || mode == 14)
+	{
+		timer->top = ICR1;
+	}
+	else
+	{
+		timer->top = timer1Tops[mode];
+	}
+
+	for(timer = MCU_g_timers; timer < &MCU_g_timers[MCU_TIMERS]; timer++)
+	{
+		if(timer->count > timer->top)
+		{
+			/*the top moved below the counter, the target would count up to MAX first*/
+			timer->count = 0;
+		}
+	}
+}
+
+static void MCU_syncTimers(void)
+{
+	uint8 i = 0;
+	for(i = 0; i < MCU_TIMERS; i++)
+	{
+		MCU_syncTimer(&MCU_g_timers[i]);
+	}
+}
+
+/******************************************************************************
+ * ADC
+ ******************************************************************************/
+
+/*
+ * Description:
+ * Digital value of the latched channel, single ended results are 0 -> 1023,
+ * differential ones are two's complement -512 -> 511
+ * */
+static uint16 MCU_adcConvert(void)
+{
+	uint8 mux = MCU_g_adcMux & 0x1F, reference = MCU_g_adcMux >> REFS0;
+	float64 vref = MCU_INTERNAL_VREF, value = 0;
+	sint32 code = 0;
+
+	if(reference == 0)
+	{
+		vref = MCU_g_aref;
+	}
+	else if(reference == 1)
+	{
+		vref = MCU_AVCC;
+	}
+
+	if(mux < MCU_ADC_CHANNELS || mux >= 0x1E)
+	{
+		value = mux < MCU_ADC_CHANNELS ? MCU_g_adcVolts[mux] : (mux == 0x1E ? MCU_BANDGAP : 0.0);
+		code = (sint32)(value * 1024.0 / vref);
+		code = code < 0 ? 0 : (code > 1023 ? 1023 : code);
+	}
+	else
+	{
+		const uint8 * input = MCU_g_adcDifferential[mux - 0x08];
+		value = (MCU_g_adcVolts[input[0]] - MCU_g_adcVolts[input[1]]) * input[2];
+		code = (sint32)(value * 512.0 / vref);
+		code = code < -512 ? -512 : (code > 511 ? 511 : code);
+		code &= 0x3FF;
+	}
+	return (MCU_g_adcMux & (1 << ADLAR)) ? (uint16)(code << 6) : (uint16)code;
+}
+
+/*
+ * Description:
+ * TIFR bit of the timer source of the auto trigger, MCU_NO_FLAG if the ADC
+ * is not triggered by a timer (the other sources are not simulated)
+ * */
+static uint8 MCU_adcTriggerFlag(void)
+{
+	static const uint8 flags[8] = {MCU_NO_FLAG, MCU_NO_FLAG, MCU_NO_FLAG, OCF0, TOV0, OCF1B, TOV1, MCU_NO_FLAG};
+	if(!(ADCSRA & (1 << ADEN)) || !(ADCSRA & (1 << ADATE)))
+	{
+		return MCU_NO_FLAG;
+	}
+	return flags[(SFIOR >> ADTS0) & 0x07];
+}
+
+static void MCU_adcStart(void)
+{
+	static const uint8 dividers[8] = {2, 2, 4, 8, 16, 32, 64, 128};
+	/*the first conversion after enabling the ADC takes 25 ADC clocks instead of 13*/
+	MCU_g_adcDone = MCU_g_cycles + ((MCU_g_adcFirst ? 25 : 13) * dividers[ADCSRA & 0x07]);
+	MCU_g_adcFirst = FALSE;
+	MCU_g_adcMux = ADMUX;
+	MCU_SET(ADCSRA, ADCSRA | (1 << ADSC));
+}
+
+static void MCU_adcUpdate(void)
+{
+	uint16 result = 0;
+	if(MCU_g_cycles < MCU_g_adcDone)
+	{
+		return;
+	}
+	result = MCU_adcConvert();
+	MCU_SET(ADCL, (uint8)result);
+	MCU_SET(ADCH, (uint8)(result >> 8));
+	MCU_SET(ADCSRA, (ADCSRA & ~(1 << ADSC)) | (1 << ADIF));
+	MCU_g_adcDone = MCU_NEVER;
+	if((ADCSRA & (1 << ADATE)) && (SFIOR >> ADTS0) == 0)
+	{
+		MCU_adcStart(); /*free running mode*/
+	}
+}
+
+static void MCU_adcWrite(uint8 a_old)
+{
+	uint8 value = ADCSRA;
+	if(value & (1 << ADIF))
+	{
+		value &= ~(1 << ADIF); /*the flag is cleared by writing one to it*/
+	}
+	else if(a_old & (1 << ADIF))
+	{
+		value |= (1 << ADIF); /*writing zero keeps it*/
+	}
+	MCU_SET(ADCSRA, value);
+
+	if(!(value & (1 << ADEN)))
+	{
+		MCU_g_adcDone = MCU_NEVER;
+		MCU_g_adcFirst = TRUE;
+		MCU_SET(ADCSRA, value & ~(1 << ADSC));
+	}
+	else if(MCU_g_adcDone != MCU_NEVER)
+	{
+		MCU_SET(ADCSRA, value | (1 << ADSC)); /*a running conversion can not be stopped*/
+	}
+	else if(value & (1 << ADSC))
+	{
+		MCU_adcStart();
+	}
+}
+
+/******************************************************************************
+ * UART
+ ******************************************************************************/
+
+static uint64 MCU_uartFrameCycles(void)
+{
+	uint16 ubrr = ((uint16)(MCU_g_ubrrh & 0x0F) << 8) | UBRRL;
+	uint8 bits = 1 + 5 + ((MCU_g_ucsrc >> UCSZ0) & 3); /*start and data bits*/
+	if(UCSRB & (1 << UCSZ2))
+	{
+		bits++; /*9 data bits*/
+	}
+	if(MCU_g_ucsrc & (1 << UPM1))
+	{
+		bits++; /*parity*/
+	}
+	bits += (MCU_g_ucsrc & (1 << USBS)) ? 2 : 1;
+	return (uint64)((UCSRA & (1 << U2X)) ? 8 : 16) * (ubrr + 1) * bits;
+}
+
+static void MCU_uartTransmit(uint8 a_data)
+{
+	if(!(UCSRB & (1 << TXEN)))
+	{
+		return;
+	}
+	if(MCU_g_txDone == MCU_NEVER)
+	{
+		/*the shift register is free, UDR is empty again right away*/
+		MCU_g_txShift = a_data;
+		MCU_g_txDone = MCU_g_cycles + MCU_uartFrameCycles();
+	}
+	else if(!MCU_g_txBuffered)
+	{
+		MCU_g_txBuffer = a_data;
+		MCU_g_txBuffered = TRUE;
+		MCU_SET(UCSRA, UCSRA & ~(1 << UDRE));
+	}
+	/*a write while UDRE is clear is lost like on the target*/
+}
+
+static void MCU_uartRead(void)
+{
+	if(MCU_g_rxReceived == 0)
+	{
+		return;
+	}
+	MCU_g_rxData[0] = MCU_g_rxData[1];
+	MCU_g_rxReceived--;
+	MCU_SET(UCSRA, UCSRA & ~((1 << DOR) | (MCU_g_rxReceived == 0 ? (1 << RXC) : 0)));
+}
+
+static void MCU_uartScheduleReceive(void)
+{
+	if(MCU_g_rxDone == MCU_NEVER && MCU_g_rxCount != 0 && (UCSRB & (1 << RXEN)))
+	{
+		MCU_g_rxDone = MCU_g_cycles + MCU_uartFrameCycles();
+	}
+}
+
+static void MCU_uartUpdate(void)
+{
+	while(MCU_g_cycles >= MCU_g_txDone)
+	{
+		if(MCU_g_uartCallback != NULL_PTR)
+		{
+			MCU_g_uartCallback(MCU_g_txShift, MCU_g_uartContext);
+		}
+		if(MCU_g_txBuffered)
+		{
+			MCU_g_txShift = MCU_g_txBuffer;
+			MCU_g_txBuffered = FALSE;
+			MCU_g_txDone += MCU_uartFrameCycles();
+			MCU_SET(UCSRA, UCSRA | (1 << UDRE));
+		}
+		else
+		{
+			MCU_g_txDone = MCU_NEVER;
+			MCU_SET(UCSRA, UCSRA | (1 << TXC));
+		}
+	}
+
+	while(MCU_g_cycles >= MCU_g_rxDone)
+	{
+		if(MCU_g_rxReceived < 2)
+		{
+			MCU_g_rxData[MCU_g_rxReceived++] = MCU_g_rxQueue[MCU_g_rxHead];
+			MCU_SET(UCSRA, UCSRA | (1 << RXC));
+		}
+		else
+		{
+			MCU_SET(UCSRA, UCSRA | (1 << DOR)); /*the byte is lost*/
+		}
+		MCU_g_rxHead = (MCU_g_rxHead + 1) % MCU_UART_RX_SIZE;
+		MCU_g_rxCount--;
+		MCU_g_rxDone = MCU_g_rxCount != 0 ? MCU_g_rxDone + MCU_uartFrameCycles() : MCU_NEVER;
+	}
+	MCU_SET(UDR, MCU_g_rxData[0]);
+}
+
+/*
+ * Description:
+ * A read and a write of UDR can not be told apart from the register value alone:
+ * UDR is written if its value changed, if it was accessed by the UDRE ISR
+ * or if nothing was received, otherwise it was read.
+ * */
+static void MCU_uartAccess(uint8 a_value, uint8 a_changed, uint8 a_received)
+{
+	if(MCU_g_inUdreIsr || a_changed || !a_received)
+	{
+		MCU_uartTransmit(a_value);
+	}
+	else
+	{
+		MCU_uartRead();
+	}
+	MCU_SET(UDR, MCU_g_rxData[0]);
+}
+
+/******************************************************************************
+ * EEPROM
+ ******************************************************************************/
+
+static void MCU_eepromWrite(uint8 a_old)
+{
+	uint8 value = EECR;
+	if((value & (1 << EEMWE)) && !(a_old & (1 << EEMWE)))
+	{
+		MCU_g_eemweTime = MCU_g_cycles;
+	}
+	if(MCU_g_eepromDone != MCU_NEVER)
+	{
+		value |= (1 << EEWE); /*EEWE stays set until the write is over*/
+		value &= ~(1 << EERE); /*no read while writing*/
+	}
+	else if(value & (1 << EEWE))
+	{
+		if((value & (1 << EEMWE)) && MCU_g_cycles - MCU_g_eemweTime <= MCU_EEMWE_CYCLES)
+		{
+			MCU_g_eepromAddress = EEAR & E2END;
+			MCU_g_eepromData = EEDR;
+			MCU_g_eepromDone = MCU_g_cycles + MCU_EEPROM_WRITE_CYCLES;
+			value &= ~(1 << EEMWE);
+		}
+		else
+		{
+			value &= ~(1 << EEWE); /*EEWE without EEMWE does nothing*/
+		}
+	}
+	if(value & (1 << EERE))
+	{
+		MCU_SET(EEDR, MCU_g_eeprom[EEAR & E2END]);
+		value &= ~(1 << EERE);
+		MCU_g_cycles += 4; /*the CPU is halted for 4 cycles*/
+	}
+	MCU_SET(EECR, value);
+}
+
+static void MCU_eepromUpdate(void)
+{
+	if((EECR & (1 << EEMWE)) && MCU_g_cycles - MCU_g_eemweTime > MCU_EEMWE_CYCLES)
+	{
+		MCU_SET(EECR, EECR & ~(1 << EEMWE));
+	}
+	if(MCU_g_cycles >= MCU_g_eepromDone)
+	{
+		MCU_g_eeprom[MCU_g_eepromAddress] = MCU_g_eepromData;
+		MCU_g_eepromDone = MCU_NEVER;
+		MCU_SET(EECR, EECR & ~(1 << EEWE));
+	}
+}
+
+/******************************************************************************
+ * Watchdog
+ ******************************************************************************/
+
+/*
+ * Description:
+ * Start the timeout again from now, WDP2:0 selects 16K -> 2048K cycles
+ * of the 1MHz watchdog oscillator
+ * */
+static void MCU_watchdogRestart(void)
+{
+	MCU_g_watchdogExpiry = (WDTCR & (1 << WDE))
+			? MCU_g_cycles + ((((uint64)16384) << (WDTCR & 0x07)) * F_CPU / 1000000UL) : MCU_NEVER;
+}
+
+/*
+ * Description:
+ * WDE is only cleared by the write after one of WDTOE and WDE, the 4 cycles limit is not checked
+ * */
+static void MCU_watchdogWrite(uint8 a_old)
+{
+	uint8 value = WDTCR;
+	if((a_old & (1 << WDE)) && !(a_old & (1 << WDTOE)))
+	{
+		value |= (1 << WDE);
+	}
+	MCU_SET(WDTCR, value);
+	MCU_watchdogRestart();
+}
+
+static void MCU_watchdogUpdate(void)
+{
+	if(MCU_g_cycles >= MCU_g_watchdogExpiry)
+	{
+		/*the firmware is started again by MCU_run*/
+		MCU_g_watchdogExpiry = MCU_NEVER;
+		MCU_g_watchdogFired = TRUE;
+		MCU_g_watchdogResets++;
+	}
+}
+
+/******************************************************************************
+ * Pins and LCD
+ ******************************************************************************/
+
+static uint8 MCU_pinLevel(uint8 a_port, uint8 a_pin)
+{
+	return (MCU_PORT(a_port) & MCU_DDR(a_port) & (1 << a_pin)) ? LOGIC_HIGH : LOGIC_LOW;
+}
+
+static void MCU_lcdNextAddress(void)
+{
+	/*the first line is 0x00 -> 0x27 and the second one 0x40 -> 0x67*/
+	MCU_g_lcdAddress = MCU_g_lcdAddress == 0x27 ? 0x40 : (MCU_g_lcdAddress == 0x67 ? 0x00 : MCU_g_lcdAddress + 1);
+}
+
+static void MCU_lcdExecute(uint8 a_rs, uint8 a_data)
+{
+	if(a_rs)
+	{
+		MCU_g_lcdRam[MCU_g_lcdAddress & 0x7F] = (char)a_data;
+		MCU_lcdNextAddress();
+		MCU_g_lcdUpdates++;
+	}
+	else if(a_data & 0x80)
+	{
+		MCU_g_lcdAddress = a_data & 0x7F;
+	}
+	else if(a_data & 0x40)
+	{
+		/*character generator RAM is not modelled*/
+	}
+	else if(a_data & 0x20)
+	{
+		MCU_g_lcd8Bit = (a_data & 0x10) ? TRUE : FALSE; /*function set, DL bit*/
+		MCU_g_lcdHaveHigh = FALSE;
+	}
+	else if(a_data & 0x1C)
+	{
+		/*shift, display control and entry mode are not modelled*/
+	}
+	else if(a_data & 0x02)
+	{
+		MCU_g_lcdAddress = 0;
+	}
+	else if(a_data & 0x01)
+	{
+		memset(MCU_g_lcdRam, ' ', sizeof(MCU_g_lcdRam));
+		MCU_g_lcdAddress = 0;
+		MCU_g_lcdUpdates++;
+	}
+}
+
+/*
+ * Description:
+ * The LCD reads its inputs on the falling edge of E
+ * */
+static void MCU_lcdUpdate(void)
+{
+	uint8 enable = MCU_pinLevel(LCD_E_PORT_ID, LCD_E_PIN_ID), data = 0;
+	if(enable == MCU_g_lcdEnable)
+	{
+		return;
+	}
+	MCU_g_lcdEnable = enable;
+	if(enable == LOGIC_HIGH)
+	{
+		return;
+	}
+
+#if(LCD_DATA_BITS_MODE == 8)
+	data = MCU_PORT(LCD_DATA_PORT_ID) & MCU_DDR(LCD_DATA_PORT_ID);
+#else
+	data = (MCU_pinLevel(LCD_DATA_PORT_ID, LCD_DB4_PIN_ID) << 4) | (MCU_pinLevel(LCD_DATA_PORT_ID, LCD_DB5_PIN_ID) << 5)
+			| (MCU_pinLevel(LCD_DATA_PORT_ID, LCD_DB6_PIN_ID) << 6) | (MCU_pinLevel(LCD_DATA_PORT_ID, LCD_DB7_PIN_ID) << 7);
+#endif
+	if(MCU_g_lcd8Bit)
+	{
+		MCU_lcdExecute(MCU_pinLevel(LCD_RS_PORT_ID, LCD_RS_PIN_ID), data);
+	}
+	else if(!MCU_g_lcdHaveHigh)
+	{
+		MCU_g_lcdHighNibble = data & 0xF0;
+		MCU_g_lcdHaveHigh = TRUE;
+	}
+	else
+	{
+		MCU_lcdExecute(MCU_pinLevel(LCD_RS_PORT_ID, LCD_RS_PIN_ID), MCU_g_lcdHighNibble | (data >> 4));
+		MCU_g_lcdHaveHigh = FALSE;
+	}
+}
+
+/******************************************************************************
+ * Core
+ ******************************************************************************/
+
+/*
+ * Description:
+ * Bring every peripheral up to the current cycle
+ * */
+static void MCU_update(void)
+{
+	MCU_syncTimers();
+	MCU_adcUpdate();
+	MCU_uartUpdate();
+	MCU_eepromUpdate();
+	MCU_watchdogUpdate();
+}
+
+/*
+ * Description:
+ * Find the next cycle at which a peripheral changes a flag on its own
+ * */
+static void MCU_schedule(void)
+{
+	uint64 next = MCU_g_adcDone;
+	uint8 i = 0;
+	for(i = 0; i < MCU_TIMERS; i++)
+	{
+		if(MCU_nextTimerEvent(&MCU_g_timers[i]) < next)
+		{
+			next = MCU_nextTimerEvent(&MCU_g_timers[i]);
+		}
+	}
+	next = MCU_g_txDone < next ? MCU_g_txDone : next;
+	next = MCU_g_rxDone < next ? MCU_g_rxDone : next;
+	next = MCU_g_eepromDone < next ? MCU_g_eepromDone : next;
+	next = MCU_g_watchdogExpiry < next ? MCU_g_watchdogExpiry : next;
+	if((EECR & (1 << EEMWE)) && MCU_g_eemweTime + MCU_EEMWE_CYCLES + 1 < next)
+	{
+		next = MCU_g_eemweTime + MCU_EEMWE_CYCLES + 1;
+	}
+	MCU_g_nextEvent = next;
+}
+
+/*
+ * Description:
+ * Apply the side effect of a write of the firmware, a_old is the value before it
+ * */
+static void MCU_write(uint8 a_address, uint8 a_old)
+{
+	uint8 value = MCU_g_io.bytes[a_address];
+	switch(a_address)
+	{
+	case 0x06: /*ADCSRA*/
+		MCU_adcWrite(a_old);
+		break;
+	case 0x0B: /*UCSRA, only U2X and MPCM are written, TXC is cleared by writing one*/
+		MCU_SET(UCSRA, (a_old & ~((1 << U2X) | (1 << MPCM) | ((value & (1 << TXC)) ? (1 << TXC) : 0)))
+				| (value & ((1 << U2X) | (1 << MPCM))));
+		break;
+	case 0x0A: /*UCSRB*/
+		MCU_uartScheduleReceive();
+		break;
+	case 0x0C: /*UDR*/
+		MCU_uartTransmit(value);
+		MCU_SET(UDR, MCU_g_rxData[0]);
+		break;
+	case 0x1C: /*EECR*/
+		MCU_eepromWrite(a_old);
+		break;
+	case 0x21: /*WDTCR*/
+		MCU_watchdogWrite(a_old);
+		break;
+	case 0x20: /*UBRRH or UCSRC*/
+		if(value & (1 << URSEL))
+		{
+			MCU_g_ucsrc = value;
+		}
+		else
+		{
+			MCU_g_ubrrh = value & 0x0F;
+		}
+		MCU_SET(UBRRH, MCU_g_ubrrh);
+		break;
+	case 0x38: /*TIFR, flags are cleared by writing one*/
+		MCU_SET(TIFR, a_old & ~value);
+		break;
+	case 0x32: /*TCNT0*/
+		MCU_g_timers[MCU_TIMER0].count = value;
+		break;
+	case 0x24: /*TCNT2*/
+		MCU_g_timers[MCU_TIMER2].count = value;
+		break;
+	case 0x2C: /*TCNT1*/
+	case 0x2D:
+		MCU_g_timers[MCU_TIMER1].count = TCNT1;
+		break;
+	default:
+		break;
+	}
+
+	if((a_address >= 0x23 && a_address <= 0x2F) || a_address == 0x33 || a_address == 0x3C)
+	{
+		MCU_configureTimers();
+	}
+	else if(a_address >= 0x10 && a_address <= 0x1B)
+	{
+		MCU_lcdUpdate();
+	}
+}
+
+/*
+ * Description:
+ * Find the registers the firmware wrote since the previous access
+ * */
+static void MCU_commit(void)
+{
+	uint8 written[MCU_IO_SIZE], changed[MCU_IO_SIZE];
+	uint8 count = 0, i = 0, address = 0, old = 0, passive = TRUE;
+	uint8 udrAccessed = MCU_g_udrAccessed, udr = UDR, udrChanged = FALSE, received = FALSE;
+
+	if(!udrAccessed && memcmp(MCU_g_io.bytes, MCU_g_shadow, MCU_IO_SIZE) == 0)
+	{
+		return;
+	}
+	MCU_g_udrAccessed = FALSE;
+	udrChanged = (udr != MCU_g_shadow[MCU_ADDRESS(UDR)]);
+	received = (UCSRA & (1 << RXC)) ? TRUE : FALSE;
+
+	/*the peripherals ran with the old values until now, the writes are applied after that*/
+	for(i = 0; i < MCU_IO_SIZE / 8; i++)
+	{
+		if(MCU_g_io.quads[i] == MCU_g_shadowIo.quads[i])
+		{
+			continue;
+		}
+		for(address = i * 8; address < (i + 1) * 8; address++)
+		{
+			if(MCU_g_io.bytes[address] != MCU_g_shadow[address])
+			{
+				written[address] = MCU_g_io.bytes[address];
+				MCU_g_io.bytes[address] = MCU_g_shadow[address];
+				changed[count++] = address;
+				passive &= (address == MCU_ADDRESS(SREG) || address == MCU_ADDRESS(MCUCR));
+			}
+		}
+	}
+	if(passive && !udrAccessed)
+	{
+		/*cli()/sei() and the sleep enable, no peripheral has to be brought up to date*/
+		for(i = 0; i < count; i++)
+		{
+			MCU_g_io.bytes[changed[i]] = written[changed[i]];
+			MCU_g_shadow[changed[i]] = written[changed[i]];
+		}
+		return;
+	}
+	MCU_update();
+
+	if(udrAccessed)
+	{
+		MCU_uartAccess(udr, udrChanged, received);
+	}
+	for(i = 0; i < count; i++)
+	{
+		address = changed[i];
+		if(address == MCU_ADDRESS(UDR) && udrAccessed)
+		{
+			continue;
+		}
+		old = MCU_g_shadow[address];
+		MCU_g_io.bytes[address] = written[address];
+		MCU_g_shadow[address] = written[address];
+		MCU_write(address, old);
+	}
+	MCU_schedule();
+}
+
+/*
+ * Description:
+ * Return the highest priority interrupt with its flag and enable bit set, 0 if none
+ * */
+static uint8 MCU_pendingVector(void)
+{
+	static const uint8 timerVectors[8] = {11, 10, 9, 8, 7, 0, 5, 4}; /*by TIFR bit*/
+	uint8 flags = TIFR & TIMSK, vector = 0xFF, i = 0;
+	for(i = 0; i < 8; i++)
+	{
+		if((flags & (1 << i)) && timerVectors[i] != 0 && timerVectors[i] < vector)
+		{
+			vector = timerVectors[i];
+		}
+	}
+	if(vector != 0xFF)
+	{
+		return vector;
+	}
+	if((UCSRA & (1 << RXC)) && (UCSRB & (1 << RXCIE)))
+	{
+		return 13;
+	}
+	if((UCSRA & (1 << UDRE)) && (UCSRB & (1 << UDRIE)))
+	{
+		return 14;
+	}
+	if((UCSRA & (1 << TXC)) && (UCSRB & (1 << TXCIE)))
+	{
+		return 15;
+	}
+	if((ADCSRA & (1 << ADIF)) && (ADCSRA & (1 << ADIE)))
+	{
+		return 16;
+	}
+	if((EECR & (1 << EERIE)) && !(EECR & (1 << EEWE)))
+	{
+		return 17;
+	}
+	return 0;
+}
+
+/*
+ * Description:
+ * Serve the pending interrupts while the I-bit is set
+ * */
+static void MCU_dispatch(void)
+{
+	static const uint8 timerFlags[12] = {0, 0, 0, 0, OCF2, TOV2, ICF1, OCF1A, OCF1B, TOV1, OCF0, TOV0};
+	uint8 vector = 0, inUdreIsr = FALSE;
+
+	while((SREG & (1 << SREG_I)) && (vector = MCU_pendingVector()) != 0)
+	{
+		/*the flags of the edge interrupts are cleared by the hardware, the level ones by the ISR*/
+		if(vector >= 4 && vector <= 11)
+		{
+			MCU_SET(TIFR, TIFR & ~(1 << timerFlags[vector]));
+		}
+		else if(vector == 15)
+		{
+			MCU_SET(UCSRA, UCSRA & ~(1 << TXC));
+		}
+		else if(vector == 16)
+		{
+			MCU_SET(ADCSRA, ADCSRA & ~(1 << ADIF));
+		}
+		MCU_SET(SREG, SREG & ~(1 << SREG_I));
+		MCU_g_interruptCounts[vector]++;
+		MCU_g_cycles += MCU_ISR_CYCLES;
+
+		inUdreIsr = MCU_g_inUdreIsr;
+		MCU_g_inUdreIsr = (vector == 14);
+		MCU_g_vectors[vector]();
+		MCU_commit();
+		MCU_g_inUdreIsr = inUdreIsr;
+
+		MCU_SET(SREG, SREG | (1 << SREG_I)); /*RETI*/
+		MCU_g_cycles += MCU_ISR_CYCLES;
+		if(MCU_g_cycles >= MCU_g_nextEvent)
+		{
+			MCU_update();
+			MCU_schedule();
+		}
+	}
+}
+
+/*
+ * Description:
+ * Give the control back to MCU_run when the run time is over or the watchdog reset the MCU
+ * */
+static void MCU_yield(void)
+{
+	if(MCU_g_inFirmware && (MCU_g_cycles >= MCU_g_stop || MCU_g_watchdogFired))
+	{
+		swapcontext(&MCU_g_firmwareContext, &MCU_g_hostContext);
+	}
+}
+
+/*
+ * Description:
+ * Move the clock to a_target, serving the peripherals and the interrupts on the way
+ * */
+static void MCU_advance(uint64 a_target)
+{
+	uint64 next = 0;
+	while(MCU_g_cycles < a_target)
+	{
+		next = a_target;
+		next = MCU_g_nextEvent < next ? MCU_g_nextEvent : next;
+		next = MCU_g_stop < next ? MCU_g_stop : next;
+		if(next > MCU_g_cycles)
+		{
+			MCU_g_cycles = next;
+		}
+		if(MCU_g_cycles >= MCU_g_nextEvent)
+		{
+			MCU_update();
+			MCU_schedule();
+		}
+		MCU_yield();
+		MCU_dispatch();
+	}
+}
+
+/*
+ * Description:
+ * Update the registers whose value depends on the time or on the inputs before they are read
+ * */
+static void MCU_refresh(uint8 a_address)
+{
+	uint8 port = 0;
+	switch(a_address)
+	{
+	case 0x32: /*TCNT0*/
+		MCU_syncTimer(&MCU_g_timers[MCU_TIMER0]);
+		MCU_SET(TCNT0, (uint8)MCU_g_timers[MCU_TIMER0].count);
+		break;
+	case 0x24: /*TCNT2*/
+		MCU_syncTimer(&MCU_g_timers[MCU_TIMER2]);
+		MCU_SET(TCNT2, (uint8)MCU_g_timers[MCU_TIMER2].count);
+		break;
+	case 0x2C: /*TCNT1*/
+	case 0x2D:
+		MCU_syncTimer(&MCU_g_timers[MCU_TIMER1]);
+		MCU_SET(TCNT1L, (uint8)MCU_g_timers[MCU_TIMER1].count);
+		MCU_SET(TCNT1H, (uint8)(MCU_g_timers[MCU_TIMER1].count >> 8));
+		break;
+	case 0x38: /*TIFR*/
+		MCU_syncTimers();
+		break;
+	case 0x10: /*PIND*/
+	case 0x13: /*PINC*/
+	case 0x16: /*PINB*/
+	case 0x19: /*PINA*/
+		port = (0x19 - a_address) / 3;
+		MCU_SET(MCU_PIN(port), (MCU_PORT(port) & MCU_DDR(port)) | (MCU_g_pinInputs[port] & ~MCU_DDR(port)));
+		break;
+	default:
+		break;
+	}
+}
+
+volatile uint8 * MCU_io8(uint8 a_address)
+{
+	MCU_commit();
+	MCU_g_cycles++;
+	if(MCU_g_cycles >= MCU_g_nextEvent)
+	{
+		MCU_update();
+		MCU_schedule();
+	}
+	MCU_yield();
+	MCU_dispatch();
+	MCU_refresh(a_address);
+	if(a_address == MCU_ADDRESS(UDR))
+	{
+		MCU_g_udrAccessed = TRUE;
+	}
+	return &MCU_g_io.bytes[a_address];
+}
+
+volatile uint16 * MCU_io16(uint8 a_address)
+{
+	MCU_io8(a_address);
+	MCU_refresh(a_address + 1);
+	return &MCU_g_io.words[a_address >> 1];
+}
+
+void MCU_watchdogReset(void)
+{
+	MCU_commit();
+	MCU_g_cycles++;
+	MCU_watchdogRestart();
+}
+
+void MCU_delay(uint64 a_cycles)
+{
+	MCU_commit();
+	MCU_advance(MCU_g_cycles + a_cycles);
+}
+
+void MCU_sleep(void)
+{
+	uint64 next = 0;
+	MCU_commit();
+	if(!(SREG & (1 << SREG_I)))
+	{
+		return; /*the target would never wake up*/
+	}
+	while(MCU_pendingVector() == 0)
+	{
+		next = MCU_g_nextEvent < MCU_g_stop ? MCU_g_nextEvent : MCU_g_stop;
+		if(next == MCU_NEVER)
+		{
+			return; /*nothing can wake the CPU and there is no end of run to wait for*/
+		}
+		if(next > MCU_g_cycles)
+		{
+			MCU_g_cycles = next;
+		}
+		if(MCU_g_cycles >= MCU_g_nextEvent)
+		{
+			MCU_update();
+			MCU_schedule();
+		}
+		MCU_yield();
+	}
+	MCU_dispatch();
+}
+
+/******************************************************************************
+ * Host interface
+ ******************************************************************************/
+
+/*
+ * Description:
+ * Keep the initial values of the firmware .data before any code changes them
+ * */
+static void MCU_saveFirmwareData(void) __attribute__((constructor));
+static void MCU_saveFirmwareData(void)
+{
+	size_t size = (size_t)(__stop_firmware_data - __start_firmware_data);
+	if(size != 0)
+	{
+		MCU_g_firmwareData = malloc(size);
+		memcpy(MCU_g_firmwareData, __start_firmware_data, size);
+	}
+}
+
+/*
+ * Description:
+ * What the C start up code does after a reset: copy the initial values of .data
+ * and clear .bss, the firmware variables in .noinit keep their values
+ * */
+static void MCU_startUp(void)
+{
+	if(MCU_g_firmwareData != NULL_PTR)
+	{
+		memcpy(__start_firmware_data, MCU_g_firmwareData, (size_t)(__stop_firmware_data - __start_firmware_data));
+	}
+	if(__start_firmware_bss != NULL_PTR)
+	{
+		memset(__start_firmware_bss, 0, (size_t)(__stop_firmware_bss - __start_firmware_bss));
+	}
+}
+
+/*
+ * Description:
+ * Put the registers and the peripherals of the MCU in their reset state, a_flags are
+ * added to the reset causes of MCUCSR. The clock, the pin inputs, the bytes on the
+ * RXD line, the EEPROM and the LCD are outside of the MCU and are kept.
+ * */
+static void MCU_reset(uint8 a_flags)
+{
+	uint8 i = 0, causes = MCUCSR & 0x1F;
+	memset(&MCU_g_io, 0, sizeof(MCU_g_io));
+	memset(MCU_g_timers, 0, sizeof(MCU_g_timers));
+	for(i = 0; i < MCU_TIMERS; i++)
+	{
+		MCU_g_timers[i].compareFlag[1] = MCU_NO_FLAG;
+	}
+	MCU_g_timers[MCU_TIMER0].compareFlag[0] = OCF0;
+	MCU_g_timers[MCU_TIMER0].overflowFlag = TOV0;
+	MCU_g_timers[MCU_TIMER0].max = 0xFF;
+	MCU_g_timers[MCU_TIMER1].compareFlag[0] = OCF1A;
+	MCU_g_timers[MCU_TIMER1].compareFlag[1] = OCF1B;
+	MCU_g_timers[MCU_TIMER1].overflowFlag = TOV1;
+	MCU_g_timers[MCU_TIMER1].max = 0xFFFF;
+	MCU_g_timers[MCU_TIMER2].compareFlag[0] = OCF2;
+	MCU_g_timers[MCU_TIMER2].overflowFlag = TOV2;
+	MCU_g_timers[MCU_TIMER2].max = 0xFF;
+
+	MCU_g_adcDone = MCU_NEVER;
+	MCU_g_adcFirst = TRUE;
+	MCU_g_ucsrc = (1 << URSEL) | (1 << UCSZ1) | (1 << UCSZ0);
+	MCU_g_ubrrh = 0;
+	MCU_g_udrAccessed = FALSE;
+	MCU_g_inUdreIsr = FALSE;
+	MCU_g_txDone = MCU_NEVER;
+	MCU_g_txBuffered = FALSE;
+	MCU_g_rxReceived = 0;
+	MCU_g_rxData[0] = 0;
+	MCU_g_rxDone = MCU_NEVER;
+	MCU_g_watchdogExpiry = MCU_NEVER;
+	MCU_g_watchdogFired = FALSE;
+
+	/*reset values*/
+	UCSRA = (1 << UDRE);
+	UCSRC = MCU_g_ubrrh;
+	MCUCSR = causes | a_flags;
+	if(MCU_g_eepromDone != MCU_NEVER)
+	{
+		EECR = (1 << EEWE); /*a started write is finished by the EEPROM*/
+	}
+	SP = RAMEND; /*set by the C start up code*/
+	memcpy(MCU_g_shadow, MCU_g_io.bytes, MCU_IO_SIZE);
+	MCU_configureTimers();
+	MCU_schedule();
+}
+
+void MCU_init(void)
+{
+	memset(MCU_g_pinInputs, 0, sizeof(MCU_g_pinInputs));
+	memset(MCU_g_interruptCounts, 0, sizeof(MCU_g_interruptCounts));
+	MCU_g_cycles = 0;
+	MCU_g_stop = MCU_NEVER;
+	MCU_g_rxHead = 0;
+	MCU_g_rxCount = 0;
+	MCU_g_eepromDone = MCU_NEVER;
+	if(!MCU_g_eepromErased)
+	{
+		memset(MCU_g_eeprom, 0xFF, sizeof(MCU_g_eeprom));
+		MCU_g_eepromErased = TRUE;
+	}
+	memset(MCU_g_lcdRam, ' ', sizeof(MCU_g_lcdRam));
+	MCU_g_lcdAddress = 0;
+	MCU_g_lcd8Bit = TRUE;
+	MCU_g_lcdHaveHigh = FALSE;
+	MCU_g_lcdEnable = LOGIC_LOW;
+	MCU_g_lcdUpdates = 0;
+	MCU_g_watchdogResets = 0;
+	MCUCSR = 0;
+	MCU_reset((1 << PORF));
+	MCU_startUp(); /*the firmware starts from its initial values, .noinit is not cleared either*/
+}
+
+static void MCU_firmwareEntry(void)
+{
+	MCU_g_entry();
+	MCU_g_finished = TRUE; /*uc_link goes back to MCU_run*/
+}
+
+void MCU_start(int (*a_entry)(void))
+{
+	if(MCU_g_stack == NULL_PTR)
+	{
+		MCU_g_stack = malloc(MCU_STACK_SIZE);
+	}
+	getcontext(&MCU_g_firmwareContext);
+	MCU_g_firmwareContext.uc_stack.ss_sp = MCU_g_stack;
+	MCU_g_firmwareContext.uc_stack.ss_size = MCU_STACK_SIZE;
+	MCU_g_firmwareContext.uc_link = &MCU_g_hostContext;
+	makecontext(&MCU_g_firmwareContext, MCU_firmwareEntry, 0);
+	MCU_g_entry = a_entry;
+	MCU_g_finished = FALSE;
+}
+
+uint8 MCU_run(uint64 a_cycles)
+{
+	if(MCU_g_entry == NULL_PTR || MCU_g_finished)
+	{
+		return FALSE;
+	}
+	MCU_g_stop = MCU_g_cycles + a_cycles;
+	MCU_g_inFirmware = TRUE;
+	swapcontext(&MCU_g_hostContext, &MCU_g_firmwareContext);
+	while(MCU_g_watchdogFired && !MCU_g_finished)
+	{
+		/*the firmware starts again from its entry, only .noinit keeps its values*/
+		MCU_reset((1 << WDRF));
+		MCU_startUp();
+		MCU_start(MCU_g_entry);
+		swapcontext(&MCU_g_hostContext, &MCU_g_firmwareContext);
+	}
+	MCU_g_inFirmware = FALSE;
+	MCU_g_stop = MCU_NEVER;
+	return MCU_g_finished ? FALSE : TRUE;
+}
+
+uint64 MCU_getCycles(void)
+{
+	return MCU_g_cycles;
+}
+
+uint32 MCU_getWatchdogResets(void)
+{
+	return MCU_g_watchdogResets;
+}
+
+void MCU_setAdcVoltage(uint8 a_channel, float64 a_volts)
+{
+	if(a_channel < MCU_ADC_CHANNELS)
+	{
+		MCU_g_adcVolts[a_channel] = a_volts;
+	}
+}
+
+void MCU_setAref(float64 a_volts)
+{
+	MCU_g_aref = a_volts;
+}
+
+void MCU_setPinInput(uint8 a_port, uint8 a_pin, uint8 a_level)
+{
+	if(a_port < MCU_PORTS && a_pin < 8)
+	{
+		MCU_g_pinInputs[a_port] = (MCU_g_pinInputs[a_port] & ~(1 << a_pin)) | ((a_level ? 1 : 0) << a_pin);
+	}
+}
+
+uint8 MCU_getPinOutput(uint8 a_port, uint8 a_pin)
+{
+	if(a_port >= MCU_PORTS || a_pin >= 8 || !(MCU_DDR(a_port) & (1 << a_pin)))
+	{
+		return 0xFF;
+	}
+	return MCU_pinLevel(a_port, a_pin);
+}
+
+float64 MCU_getPwmDuty(void)
+{
+	uint8 output = MCU_getPinOutput(PORTB_ID, PB3);
+	uint8 com = (TCCR0 >> COM00) & 3;
+	float64 duty = ((float64)OCR0 + 1.0) / 256.0;
+	if(output == 0xFF)
+	{
+		return 0.0;
+	}
+	/*fast PWM with OC0 connected, otherwise the pin follows PORTB*/
+	if((TCCR0 & (1 << WGM00)) && (TCCR0 & (1 << WGM01)) && (TCCR0 & 0x07) != 0 && com >= 2)
+	{
+		return com == 2 ? duty : 1.0 - duty;
+	}
+	return output == LOGIC_HIGH ? 1.0 : 0.0;
+}
+
+uint16 MCU_uartReceive(const uint8 * a_data, uint16 a_length)
+{
+	uint16 i = 0;
+	for(i = 0; i < a_length && MCU_g_rxCount < MCU_UART_RX_SIZE; i++)
+	{
+		MCU_g_rxQueue[(MCU_g_rxHead + MCU_g_rxCount) % MCU_UART_RX_SIZE] = a_data[i];
+		MCU_g_rxCount++;
+	}
+	MCU_uartScheduleReceive();
+	MCU_schedule();
+	return i;
+}
+
+void MCU_setUartCallback(MCU_UartCallbackType a_callback, void * a_context)
+{
+	MCU_g_uartCallback = a_callback;
+	MCU_g_uartContext = a_context;
+}
+
+uint8 * MCU_getEeprom(void)
+{
+	if(!MCU_g_eepromErased)
+	{
+		memset(MCU_g_eeprom, 0xFF, sizeof(MCU_g_eeprom));
+		MCU_g_eepromErased = TRUE;
+	}
+	return MCU_g_eeprom;
+}
+
+const char * MCU_getLcdRow(uint8 a_row)
+{
+	a_row = (a_row == 0) ? 0 : 1;
+	memcpy(MCU_g_lcdRows[a_row], &MCU_g_lcdRam[a_row * 0x40], MCU_LCD_COLUMNS);
+	MCU_g_lcdRows[a_row][MCU_LCD_COLUMNS] = '\0';
+	return MCU_g_lcdRows[a_row];
+}
+
+uint32 MCU_getLcdUpdates(void)
+{
+	return MCU_g_lcdUpdates;
+}
+
+uint32 MCU_getInterruptCount(uint8 a_vector)
+{
+	return a_vector < MCU_VECTORS ? MCU_g_interruptCounts[a_vector] : 0;
+}
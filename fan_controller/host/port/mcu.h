@@ -0,0 +1,175 @@
+/*
+ *
+ * Module: Host port - Simulated MCU
+ *
+ * File Name: mcu.h
+ *
+ * Description: Header file for the simulated ATmega32 used to run the firmware on a PC.
+ *
+ * The 64 I/O registers live in a byte array. Every register access made by the
+ * drivers goes through MCU_io8()/MCU_io16(), which:
+ * 	1. finds the registers written since the previous access and applies their
+ * 	   side effects (start of an ADC conversion, EEPROM write, UART data, LCD strobe...)
+ * 	2. moves the virtual clock by one cycle and brings the peripherals up to date
+ * 	3. calls the pending ISR (__vector_N) when the I-bit is set
+ *
+ * Modelled peripherals: timer 0/1/2 (normal, CTC and fast PWM), the ADC with
+ * single ended, differential and band-gap channels, the UART with its data
+ * register buffering and baud rate timing, the EEPROM with its 8.5ms write time,
+ * the port pins, the watchdog timer and a HD44780 LCD wired as in lcd.h.
+ *
+ * The firmware code itself takes no virtual time, only the register accesses,
+ * the delays and the peripherals do. Sleeping moves the clock to the next interrupt,
+ * so an idle firmware runs thousands of times faster than real time.
+ *
+ * The firmware runs as a coroutine: MCU_start() prepares it and MCU_run() runs it
+ * for a number of cycles, the caller can then change the inputs and read the outputs.
+ * Drivers can also be called directly without MCU_start().
+ *
+ * When the watchdog times out MCU_run() resets the registers, sets WDRF and starts the
+ * firmware again from its entry. Like the C start up code of the target it sets the
+ * .data of the firmware objects back to its initial values and clears their .bss,
+ * only the variables in .noinit keep their values. MCU_init() does the same for the
+ * power-on reset, so every test starts the firmware from its initial values.
+ * The Makefile renames these sections of the firmware sources to firmware_data and
+ * firmware_bss, the ones of the host are not touched.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef MCU_H_
+#define MCU_H_
+
+#include"../../std_types.h"
+
+#define MCU_IO_SIZE				64
+#define MCU_EEPROM_SIZE			1024
+#define MCU_LCD_COLUMNS			16
+#define MCU_LCD_ROWS			2
+#define MCU_ADC_CHANNELS		8
+#define MCU_UART_RX_SIZE		256
+
+#define MCU_AVCC				5.0
+#define MCU_INTERNAL_VREF		2.56
+#define MCU_BANDGAP				1.22
+
+#define MCU_CYCLES_PER_MS		(F_CPU / 1000UL)
+
+/*
+ * Description:
+ * called for every byte sent by the UART when its stop bit is over
+ * */
+typedef void (*MCU_UartCallbackType)(uint8 a_data, void * a_context);
+
+/*
+ * Description:
+ * Register access used by the <avr/io.h> of the port, not by the application
+ * */
+volatile uint8 * MCU_io8(uint8 a_address);
+volatile uint16 * MCU_io16(uint8 a_address);
+void MCU_delay(uint64 a_cycles);
+void MCU_sleep(void);
+void MCU_watchdogReset(void);
+
+/*
+ * Description:
+ * Reset the registers, the peripherals and the clock to their power on state.
+ * The EEPROM keeps its content like a real one, see MCU_getEeprom().
+ * */
+void MCU_init(void);
+
+/*
+ * Description:
+ * Prepare a_entry (the firmware main) to run as a coroutine with its own stack
+ * */
+void MCU_start(int (*a_entry)(void));
+
+/*
+ * Description:
+ * Run the firmware for a_cycles of virtual time.
+ *
+ * Possible return values:
+ * FALSE if the firmware entry returned, TRUE otherwise
+ * */
+uint8 MCU_run(uint64 a_cycles);
+
+/*
+ * Description:
+ * Virtual time since MCU_init
+ * */
+uint64 MCU_getCycles(void);
+
+/*
+ * Description:
+ * Number of watchdog resets since MCU_init
+ * */
+uint32 MCU_getWatchdogResets(void);
+
+/*
+ * Description:
+ * Analog inputs in volts, AREF is only used when REFS1:0 selects it
+ * */
+void MCU_setAdcVoltage(uint8 a_channel, float64 a_volts);
+void MCU_setAref(float64 a_volts);
+
+/*
+ * Description:
+ * Level seen on an input pin, output pins read their PORT bit
+ * */
+void MCU_setPinInput(uint8 a_port, uint8 a_pin, uint8 a_level);
+
+/*
+ * Description:
+ * Level driven on a pin: LOGIC_HIGH or LOGIC_LOW, 0xFF for an input pin
+ * */
+uint8 MCU_getPinOutput(uint8 a_port, uint8 a_pin);
+
+/*
+ * Description:
+ * Average level of the OC0/PB3 pin from 0.0 to 1.0
+ * */
+float64 MCU_getPwmDuty(void);
+
+/*
+ * Description:
+ * Queue bytes on the UART RXD line, they are received at the configured baud rate.
+ *
+ * Possible return values:
+ * the number of queued bytes, less than a_length if the queue is full
+ * */
+uint16 MCU_uartReceive(const uint8 * a_data, uint16 a_length);
+
+/*
+ * Description:
+ * Set the function called for every byte sent by the UART
+ * */
+void MCU_setUartCallback(MCU_UartCallbackType a_callback, void * a_context);
+
+/*
+ * Description:
+ * The EEPROM content, it can be loaded before MCU_start and saved after a run
+ * */
+uint8 * MCU_getEeprom(void);
+
+/*
+ * Description:
+ * The first MCU_LCD_COLUMNS characters of an LCD row as a string,
+ * each row has its own buffer so both can be used in the same call
+ * */
+const char * MCU_getLcdRow(uint8 a_row);
+
+/*
+ * Description:
+ * Incremented every time a character or a clear command reaches the LCD,
+ * a caller can poll it to print the screen only when it changed
+ * */
+uint32 MCU_getLcdUpdates(void);
+
+/*
+ * Description:
+ * Number of times an interrupt vector was served
+ * */
+uint32 MCU_getInterruptCount(uint8 a_vector);
+
+#endif /* MCU_H_ */
@@ -0,0 +1,70 @@
+/*
+ *
+ * Module: Host port - Standard library
+ *
+ * File Name: stdlib.c
+ *
+ * Description: The avr-libc number conversions that glibc does not have
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include<stdlib.h>
+
+/*
+ * Description:
+ * Write a_value in base a_radix (2 -> 36) with a '-' before it if a_negative
+ * */
+static char * HOST_toString(unsigned long a_value, int a_negative, char * a_string, int a_radix)
+{
+	char digits[sizeof(long) * 8 + 1];
+	int length = 0, i = 0;
+
+	if(a_radix < 2 || a_radix > 36)
+	{
+		a_string[0] = '\0';
+		return a_string;
+	}
+	do
+	{
+		digits[length++] = "0123456789abcdefghijklmnopqrstuvwxyz"[a_value % a_radix];
+		a_value /= a_radix;
+	}while(a_value != 0);
+	if(a_negative)
+	{
+		a_string[i++] = '-';
+	}
+	while(length > 0)
+	{
+		a_string[i++] = digits[--length];
+	}
+	a_string[i] = '\0';
+	return a_string;
+}
+
+char * ltoa(long a_value, char * a_string, int a_radix)
+{
+	/*avr-libc only prints a sign in base 10, other bases show the bit pattern*/
+	if(a_value < 0 && a_radix == 10)
+	{
+		return HOST_toString(-(unsigned long)a_value, 1, a_string, a_radix);
+	}
+	return HOST_toString((unsigned long)a_value, 0, a_string, a_radix);
+}
+
+char * ultoa(unsigned long a_value, char * a_string, int a_radix)
+{
+	return HOST_toString(a_value, 0, a_string, a_radix);
+}
+
+char * itoa(int a_value, char * a_string, int a_radix)
+{
+	/*avr-libc only prints a sign in base 10, other bases show the 16-bit pattern*/
+	return a_radix == 10 ? ltoa(a_value, a_string, a_radix) : ltoa((unsigned short)a_value, a_string, a_radix);
+}
+
+char * utoa(unsigned int a_value, char * a_string, int a_radix)
+{
+	return ltoa((long)a_value, a_string, a_radix);
+}
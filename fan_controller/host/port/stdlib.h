@@ -0,0 +1,24 @@
+/*
+ *
+ * Module: Host port - Standard library
+ *
+ * File Name: stdlib.h
+ *
+ * Description: Adds the avr-libc number conversions that glibc does not have
+ * on top of the host <stdlib.h>.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef HOST_PORT_STDLIB_H_
+#define HOST_PORT_STDLIB_H_
+
+#include_next<stdlib.h>
+
+char * itoa(int a_value, char * a_string, int a_radix);
+char * utoa(unsigned int a_value, char * a_string, int a_radix);
+char * ltoa(long a_value, char * a_string, int a_radix);
+char * ultoa(unsigned long a_value, char * a_string, int a_radix);
+
+#endif /* HOST_PORT_STDLIB_H_ */
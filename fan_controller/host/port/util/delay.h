@@ -0,0 +1,26 @@
+/*
+ *
+ * Module: Host port - Delays
+ *
+ * File Name: delay.h
+ *
+ * Description: Host replacement of <util/delay.h>, a delay moves the virtual clock
+ * and the interrupts keep being served during it like on the target.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef _UTIL_DELAY_H_
+#define _UTIL_DELAY_H_
+
+#include<avr/io.h>
+
+#ifndef F_CPU
+#error "F_CPU must be defined for the delays"
+#endif
+
+#define _delay_ms(ms)		MCU_delay((uint64)((double)(ms) * (F_CPU / 1000.0)))
+#define _delay_us(us)		MCU_delay((uint64)((double)(us) * (F_CPU / 1000000.0)))
+
+#endif /* _UTIL_DELAY_H_ */
@@ -0,0 +1,856 @@
+/*
+ *
+ * Module: Host - Port tests
+ *
+ * File Name: port_test.c
+ *
+ * Description: Checks of the drivers and of the whole firmware running on the
+ * simulated MCU, the exit code is the number of failed checks.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#define _GNU_SOURCE
+#include<avr/io.h>
+#include"../adc.h"
+#include"../timer.h"
+#include"../lm35.h"
+#include"../nvm.h"
+#include"../config.h"
+#include"../gpio.h"
+#include"../dcMotor.h"
+#include"../energy.h"
+#include"../error.h"
+#include"../vref.h"
+#include"../watchdog.h"
+#include"../lcd.h"
+#include"../crc.h"
+#include"../uart.h"
+#include"../telemetry.h"
+#include"../history.h"
+#include"frame.h"
+#include<math.h>
+#include<stdlib.h>
+#include<stdio.h>
+#include<string.h>
+#include<unistd.h>
+
+#define TEST_CHECK(condition)	TEST_check((condition) ? TRUE : FALSE, #condition, __LINE__)
+#define TEST_TX_SIZE			8192
+#define TEST_FAILSAFE_LIMIT_MS	1000
+#define TEST_CUT_LIMIT_US		2200 /*one PWM period and the conversion*/
+#define TEST_STALL_VOLTS		2.0 /*code 800, the stall current*/
+#define TEST_RECOVERY_LIMIT_MS	10 /*the LCD init alone takes longer*/
+#define TEST_GROUND_VOLTS		1.2 /*the LM35 ground pin lifted by two diodes*/
+#define TEST_NVM_RECORD_SIZE	(sizeof(CONFIG_Type) + 4) /*sequence | configuration | CRC16*/
+#define TEST_NVM_WRITE_MS		(NVM_SLOT_SIZE * 9UL) /*8.5ms per byte*/
+#define TEST_HISTORY_SAMPLES	1500 /*fills the RAM ring about twice*/
+#define TEST_PATH_SIZE			256
+#define TEST_FRAME_COUNT		8
+
+int FIRMWARE_main(void);
+
+static uint32 TEST_g_failed = 0;
+static uint8 TEST_g_tx[TEST_TX_SIZE];
+static uint32 TEST_g_txLength = 0;
+static const char * TEST_g_build = "build";
+static sint16 TEST_g_temperature[TEST_HISTORY_SAMPLES + 1];
+static uint8 TEST_g_duty[TEST_HISTORY_SAMPLES + 1];
+static FRAME_Type TEST_g_frames[TEST_FRAME_COUNT];
+static uint8 TEST_g_frameCount = 0;
+
+/*temperature changes around the 6-bit token and the varint boundaries, the last ones wrap the sint16*/
+static const sint32 TEST_g_historySteps[] = {31, -32, 32, -33, 63, -64, 64, -65, 8191, -8192, 8192, -8193,
+		-20000, -20000, 32767, -65535, 65535, -32768};
+
+static void TEST_check(uint8 a_passed, const char * a_condition, int a_line)
+{
+	if(!a_passed)
+	{
+		printf("port_test.c:%d: check failed: %s\n", a_line, a_condition);
+		TEST_g_failed++;
+	}
+}
+
+static void TEST_onUartByte(uint8 a_data, void * a_context)
+{
+	(void)a_context;
+	if(TEST_g_txLength < TEST_TX_SIZE)
+	{
+		TEST_g_tx[TEST_g_txLength++] = a_data;
+	}
+}
+
+static uint8 TEST_onFrame(const FRAME_Type * a_frame, void * a_context)
+{
+	(void)a_context;
+	if(TEST_g_frameCount < TEST_FRAME_COUNT)
+	{
+		TEST_g_frames[TEST_g_frameCount++] = *a_frame;
+	}
+	return TRUE;
+}
+
+/*
+ * Description:
+ * Read a captured stream with the frame reader of the host tools
+ * */
+static void TEST_readFrames(const uint8 * a_stream, uint32 a_length, FRAME_StatsType * a_stats)
+{
+	int channel[2];
+
+	memset(a_stats, 0, sizeof(FRAME_StatsType));
+	TEST_g_frameCount = 0;
+	if(pipe(channel) != 0)
+	{
+		TEST_CHECK(FALSE);
+		return;
+	}
+	TEST_CHECK(write(channel[1], a_stream, a_length) == (ssize_t)a_length);
+	close(channel[1]);
+	FRAME_read(channel[0], TEST_onFrame, NULL_PTR, a_stats);
+	close(channel[0]);
+}
+
+/*
+ * Description:
+ * Run the firmware for a_ms and return TRUE if a_text was sent on the UART meanwhile,
+ * ASCII responses have no zero byte so COBS leaves them in one piece
+ * */
+static uint8 TEST_runAndFind(uint32 a_ms, const char * a_text)
+{
+	TEST_g_txLength = 0;
+	MCU_run((uint64)a_ms * MCU_CYCLES_PER_MS);
+	return memmem(TEST_g_tx, TEST_g_txLength, a_text, strlen(a_text)) != NULL_PTR;
+}
+
+static void TEST_drivers(void)
+{
+	ADC_configType config = {ADC_INTERNAL, ADC_POLLING, ADC_PRESCALER_8};
+	LM35_TemperatureType temperature = 0;
+	uint16 value = 0;
+	sint16 difference = 0;
+	uint8 done = 0;
+
+	MCU_init();
+	ADC_init(&config);
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.5);
+	TEST_CHECK(ADC_readChannelPolling(LM35_CHANNEL, &done, &value) == ADC_SUCCESS);
+	TEST_CHECK(value == 200); /*0.5V * 1024 / 2.56V*/
+	MCU_setAdcVoltage(LM35_CHANNEL, 3.0);
+	ADC_readChannelPolling(LM35_CHANNEL, &done, &value);
+	TEST_CHECK(value == 1023);
+	TEST_CHECK(ADC_readBandgapPolling(&value) == ADC_SUCCESS && value == ADC_BANDGAP_CODE);
+	ADCSRA &= ~(1 << ADEN); /*a stalled ADC never sets ADIF*/
+	TEST_CHECK(ADC_readChannelPolling(LM35_CHANNEL, &done, &value) == ADC_ERROR_TIMEOUT);
+	ADCSRA |= (1 << ADEN);
+
+	/*a reference 5% above the nominal one, 0.5V is 52.5C and not 50C*/
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.5);
+	LM35_setVrefFactor(LM35_VREF_ONE + (LM35_VREF_ONE / 20));
+	TEST_CHECK(LM35_TO_DEGREES(LM35_getTemperature()) == 52);
+	LM35_setVrefFactor(LM35_VREF_ONE);
+	TEST_CHECK(LM35_TO_DEGREES(LM35_getTemperature()) == 50);
+
+	/*the differential reads are signed, -10C with the ground pin lifted to 0.5V*/
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.1);
+	MCU_setAdcVoltage(LM35_REFERENCE_CHANNEL, 0.05);
+	TEST_CHECK(ADC_readDifferentialPolling(LM35_CHANNEL, LM35_REFERENCE_CHANNEL, ADC_GAIN_10X, &difference) == ADC_SUCCESS);
+	TEST_CHECK(difference == 100); /*0.05V * 10 * 512 / 2.56V*/
+	TEST_CHECK(ADC_readDifferentialPolling(LM35_CHANNEL, LM35_REFERENCE_CHANNEL, ADC_GAIN_1X, &difference) == ADC_SUCCESS);
+	TEST_CHECK(difference == 10);
+	TEST_CHECK(ADC_readDifferentialPolling(LM35_CHANNEL, 0, ADC_GAIN_10X, &difference) == ADC_ERROR_WRONG_CHANNEL);
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.4);
+	MCU_setAdcVoltage(LM35_REFERENCE_CHANNEL, 0.5);
+	TEST_CHECK(abs(LM35_getTemperature() - LM35_FROM_DEGREES(-10)) <= 1); /*40 codes of 1/1023 * 2.56V*/
+	TEST_CHECK(LM35_readFine(&temperature) && abs(temperature - LM35_FROM_DEGREES(-10)) <= 4); /*one code*/
+	MCU_setAdcVoltage(LM35_REFERENCE_CHANNEL, 0.0);
+	TEST_CHECK(!LM35_readFine(&temperature)); /*40C is out of the 10x range*/
+
+	TIMER_init();
+	MCU_delay(10 * MCU_CYCLES_PER_MS);
+	TEST_CHECK(TIMER_getTicks() == 10);
+
+	/*the kick-start boost is ended by the tick, a new speed during it only moves its end*/
+	DC_MOTOR_Init();
+	DC_MOTOR_setBoost(100, 100);
+	DC_MOTOR_Rotate(DC_MOTOR_CW, 25);
+	TEST_CHECK(MCU_getPwmDuty() == 1.0);
+	MCU_delay(99 * MCU_CYCLES_PER_MS);
+	TEST_CHECK(MCU_getPwmDuty() == 1.0);
+	MCU_delay(2 * MCU_CYCLES_PER_MS);
+	TEST_CHECK(fabs(MCU_getPwmDuty() - 0.25) < 0.01);
+	DC_MOTOR_Rotate(DC_MOTOR_CW, 30); /*running, no boost*/
+	TEST_CHECK(fabs(MCU_getPwmDuty() - 0.30) < 0.01);
+
+	/*a reversal: dead time, brake to zero, dead time, then the other way with the boost*/
+	DC_MOTOR_Rotate(DC_MOTOR_ACW, 50);
+	DC_MOTOR_Rotate(DC_MOTOR_ACW, 40);
+	TEST_CHECK(MCU_getPwmDuty() == 0.0);
+	TEST_CHECK(MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN1) == LOGIC_LOW);
+	TEST_CHECK(MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN2) == LOGIC_LOW);
+	MCU_delay(DC_MOTOR_DEAD_TIME_MS * MCU_CYCLES_PER_MS);
+	TEST_CHECK(MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN1) == LOGIC_HIGH);
+	TEST_CHECK(MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN2) == LOGIC_HIGH);
+	TEST_CHECK(MCU_getPwmDuty() == 1.0);
+	MCU_delay((DC_MOTOR_BRAKE_MS + DC_MOTOR_DEAD_TIME_MS) * MCU_CYCLES_PER_MS);
+	TEST_CHECK(MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN1) == LOGIC_LOW);
+	TEST_CHECK(MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN2) == LOGIC_HIGH);
+	TEST_CHECK(MCU_getPwmDuty() == 1.0);
+	MCU_delay(100 * MCU_CYCLES_PER_MS);
+	TEST_CHECK(fabs(MCU_getPwmDuty() - 0.40) < 0.01);
+
+	/*coasting is at once, the same direction starts again without the brake*/
+	DC_MOTOR_Rotate(DC_MOTOR_COAST, 0);
+	TEST_CHECK(MCU_getPwmDuty() == 0.0);
+	DC_MOTOR_Rotate(DC_MOTOR_ACW, 40);
+	MCU_delay(DC_MOTOR_DEAD_TIME_MS * MCU_CYCLES_PER_MS);
+	TEST_CHECK(MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN2) == LOGIC_HIGH);
+	TEST_CHECK(MCU_getPwmDuty() == 1.0);
+
+	/*the brake is held once the fan stopped*/
+	DC_MOTOR_Rotate(DC_MOTOR_BRAKE, 0);
+	MCU_delay((DC_MOTOR_BRAKE_MS + 10) * MCU_CYCLES_PER_MS);
+	TEST_CHECK(MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN1) == LOGIC_HIGH);
+	TEST_CHECK(MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN2) == LOGIC_HIGH);
+	TEST_CHECK(MCU_getPwmDuty() == 1.0);
+	TEST_CHECK(DC_MOTOR_Rotate(DC_MOTOR_BRAKE + 1, 0) == DC_MOTOR_ERROR_STATE);
+	DC_MOTOR_Rotate(DC_MOTOR_COAST, 0);
+	TEST_CHECK(DC_MOTOR_setBoost(100, DC_MOTOR_MAX_BOOST_MS + 1) == DC_MOTOR_ERROR_TIME);
+	TIMER_deInit();
+}
+
+/*
+ * Description:
+ * Jam the fan and measure the time until the PWM output is cut, then check
+ * the back-off of the retries, the stall flag and its release
+ * */
+static void TEST_overCurrent(void)
+{
+	ADC_configType config = {ADC_INTERNAL, ADC_POLLING, ADC_PRESCALER_8};
+	uint32 latency = 0;
+
+	MCU_init();
+	ADC_init(&config);
+	TIMER_init();
+	DC_MOTOR_Init();
+	DC_MOTOR_setBoost(0, 0);
+	DC_MOTOR_Rotate(DC_MOTOR_CW, 50);
+	MCU_delay((DC_MOTOR_BLANKING_MS + 10) * MCU_CYCLES_PER_MS);
+	TEST_CHECK(DC_MOTOR_getCurrent() == 0);
+
+	MCU_setAdcVoltage(DC_MOTOR_CURRENT_CHANNEL, TEST_STALL_VOLTS);
+	while(MCU_getPwmDuty() != 0.0 && latency < TEST_CUT_LIMIT_US * 10)
+	{
+		MCU_delay(10);/*10us*/
+		latency += 10;
+	}
+	printf("port_test: over-current to PWM cut in %lu us\n", (unsigned long)latency);
+	TEST_CHECK(latency <= TEST_CUT_LIMIT_US);
+	TEST_CHECK(MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN1) == LOGIC_LOW);
+	TEST_CHECK(DC_MOTOR_getCurrent() == DC_MOTOR_CURRENT_STALL_CODE);
+	TEST_CHECK(DC_MOTOR_getTrips() == 1);
+	TEST_CHECK(!DC_MOTOR_isStalled());
+
+	/*the retry runs through its blanking, the back-off doubles after every trip*/
+	MCU_delay((DC_MOTOR_TRIP_BACKOFF_MS + 10) * MCU_CYCLES_PER_MS);
+	TEST_CHECK(fabs(MCU_getPwmDuty() - 0.50) < 0.01);
+	MCU_delay(DC_MOTOR_BLANKING_MS * MCU_CYCLES_PER_MS);
+	TEST_CHECK(MCU_getPwmDuty() == 0.0);
+	TEST_CHECK(DC_MOTOR_getTrips() == 2);
+	MCU_delay((DC_MOTOR_TRIP_BACKOFF_MS + 10) * MCU_CYCLES_PER_MS);
+	TEST_CHECK(MCU_getPwmDuty() == 0.0);
+	MCU_delay(DC_MOTOR_TRIP_BACKOFF_MS * MCU_CYCLES_PER_MS);
+	TEST_CHECK(fabs(MCU_getPwmDuty() - 0.50) < 0.01);
+	MCU_delay(DC_MOTOR_BLANKING_MS * MCU_CYCLES_PER_MS);
+	TEST_CHECK(DC_MOTOR_getTrips() == DC_MOTOR_STALL_TRIPS);
+	TEST_CHECK(DC_MOTOR_isStalled());
+
+	/*a free rotor clears the flag at the end of the next blanking*/
+	MCU_setAdcVoltage(DC_MOTOR_CURRENT_CHANNEL, 0.0);
+	MCU_delay(((4 * DC_MOTOR_TRIP_BACKOFF_MS) + DC_MOTOR_BLANKING_MS + 10) * MCU_CYCLES_PER_MS);
+	TEST_CHECK(fabs(MCU_getPwmDuty() - 0.50) < 0.01);
+	TEST_CHECK(!DC_MOTOR_isStalled());
+
+	/*a short is cut even during the blanking*/
+	DC_MOTOR_Rotate(DC_MOTOR_COAST, 0);
+	MCU_delay(DC_MOTOR_DEAD_TIME_MS * MCU_CYCLES_PER_MS);
+	DC_MOTOR_Rotate(DC_MOTOR_CW, 50);
+	MCU_setAdcVoltage(DC_MOTOR_CURRENT_CHANNEL, 2.56);
+	MCU_delay(3 * MCU_CYCLES_PER_MS);
+	TEST_CHECK(MCU_getPwmDuty() == 0.0);
+	TEST_CHECK(DC_MOTOR_getTrips() == DC_MOTOR_STALL_TRIPS + 1);
+	MCU_setAdcVoltage(DC_MOTOR_CURRENT_CHANNEL, 0.0);
+	DC_MOTOR_Rotate(DC_MOTOR_COAST, 0);
+	TIMER_deInit();
+}
+
+/*
+ * Description:
+ * Account a duty for a while, save the counters and load them back
+ * */
+static void TEST_energy(void)
+{
+	ENERGY_CountersType counters;
+
+	MCU_init();
+	TIMER_init();
+	ENERGY_init();
+	ENERGY_setDuty(50);
+	MCU_delay(10000UL * MCU_CYCLES_PER_MS);
+	ENERGY_setDuty(0);
+	ENERGY_setDuty(100);
+	MCU_delay(2000UL * MCU_CYCLES_PER_MS);
+	ENERGY_getCounters(&counters);
+	TEST_CHECK(counters.seconds == 12);
+	TEST_CHECK(counters.fullDutySeconds == 7);
+	TEST_CHECK(counters.binSeconds[4] == 10);
+	TEST_CHECK(counters.binSeconds[ENERGY_DUTY_BINS - 1] == 2);
+	TEST_CHECK(counters.starts == 2);
+	TEST_CHECK(counters.speedChanges == 3);
+	TEST_CHECK(ENERGY_toWattHours(36000UL, CONFIG_DEFAULT_FAN_POWER) == 24);
+
+	/*saved once an hour, the next start continues from the record*/
+	MCU_delay((ENERGY_SAVE_PERIOD_S - 12) * 1000UL * MCU_CYCLES_PER_MS);
+	ENERGY_process();
+	MCU_delay(ENERGY_RECORD_SIZE * 9UL * MCU_CYCLES_PER_MS); /*8.5ms per byte*/
+	TIMER_deInit();
+	TIMER_init();
+	ENERGY_init();
+	ENERGY_getCounters(&counters);
+	TEST_CHECK(counters.seconds == ENERGY_SAVE_PERIOD_S);
+	TEST_CHECK(counters.fullDutySeconds == ENERGY_SAVE_PERIOD_S - 5);
+	TEST_CHECK(counters.starts == 2);
+	TIMER_deInit();
+}
+
+/*
+ * Description:
+ * Write a journal record in a slot of the EEPROM as NVM_process would
+ * */
+static void TEST_writeSlot(uint8 a_slot, uint16 a_sequence, const CONFIG_Type * a_config)
+{
+	uint8 * record = &MCU_getEeprom()[NVM_BASE_ADDRESS + ((uint16)a_slot * NVM_SLOT_SIZE)];
+	uint16 crc = 0;
+
+	record[0] = (uint8)a_sequence;
+	record[1] = (uint8)(a_sequence >> 8);
+	memcpy(&record[2], a_config, sizeof(CONFIG_Type));
+	crc = CRC16_update(CRC16_INITIAL_VALUE, record, TEST_NVM_RECORD_SIZE - 2);
+	record[TEST_NVM_RECORD_SIZE - 2] = (uint8)crc;
+	record[TEST_NVM_RECORD_SIZE - 1] = (uint8)(crc >> 8);
+}
+
+/*
+ * Description:
+ * Change the sample period and save it through the journal
+ * */
+static void TEST_save(uint16 a_period)
+{
+	CONFIG_setSamplePeriod(a_period);
+	NVM_requestSave();
+	MCU_delay(NVM_SAVE_DELAY_MS * MCU_CYCLES_PER_MS);
+	NVM_process();
+	MCU_delay(TEST_NVM_WRITE_MS * MCU_CYCLES_PER_MS);
+}
+
+/*
+ * Description:
+ * Boot with the journal in the EEPROM, return the loaded sample period
+ * */
+static uint16 TEST_boot(NVM_ErrorType * a_error)
+{
+	CONFIG_init();
+	*a_error = NVM_init();
+	return CONFIG_get()->samplePeriod;
+}
+
+/*
+ * Description:
+ * Rotate the configuration journal, wrap its sequence and tear its newest record
+ * */
+static void TEST_journal(void)
+{
+	uint8 * journal = &MCU_getEeprom()[NVM_BASE_ADDRESS];
+	uint8 torn[NVM_SLOTS * NVM_SLOT_SIZE];
+	CONFIG_Type config;
+	NVM_ErrorType error = NVM_SUCCESS;
+	uint8 i = 0, slot = 0;
+
+	MCU_init();
+	TIMER_init();
+
+	/*a blank EEPROM boots on the defaults*/
+	memset(journal, 0xFF, NVM_SLOTS * NVM_SLOT_SIZE);
+	TEST_CHECK(TEST_boot(&error) == CONFIG_DEFAULT_SAMPLE_PERIOD_MS && error == NVM_ERROR_NO_RECORD);
+
+	/*every save goes to the next slot, the ninth one wraps to slot 0*/
+	for(i = 0; i <= NVM_SLOTS; i++)
+	{
+		TEST_save(200 + i);
+		slot = i % NVM_SLOTS;
+		TEST_CHECK(journal[slot * NVM_SLOT_SIZE] == i + 1 && journal[(slot * NVM_SLOT_SIZE) + 1] == 0);
+	}
+	TEST_CHECK(journal[NVM_SLOT_SIZE] == 2); /*slot 1 is the oldest record now*/
+	TEST_CHECK(TEST_boot(&error) == 200 + NVM_SLOTS && error == NVM_SUCCESS);
+	TEST_CHECK(NVM_getSequence() == NVM_SLOTS + 1);
+	TEST_save(300); /*the journal goes on after the newest slot*/
+	TEST_CHECK(journal[NVM_SLOT_SIZE] == NVM_SLOTS + 2);
+
+	/*the sequence wraps: 0x0001 is newer than 0xFFFF*/
+	CONFIG_init();
+	config = *CONFIG_get();
+	memset(journal, 0xFF, NVM_SLOTS * NVM_SLOT_SIZE);
+	for(i = 0; i < 4; i++)
+	{
+		config.samplePeriod = 400 + i;
+		TEST_writeSlot(i + 2, (uint16)(0xFFFE + i), &config); /*0xFFFE 0xFFFF 0x0000 0x0001*/
+	}
+	TEST_CHECK(TEST_boot(&error) == 403 && error == NVM_SUCCESS);
+	TEST_CHECK(NVM_getSequence() == 0x0001);
+	TEST_save(500);
+	TEST_CHECK(journal[6 * NVM_SLOT_SIZE] == 0x02 && journal[(6 * NVM_SLOT_SIZE) + 1] == 0x00);
+
+	/*a corrupted newest record falls back to the previous one*/
+	journal[(6 * NVM_SLOT_SIZE) + 2] ^= 0x01;
+	TEST_CHECK(TEST_boot(&error) == 403 && NVM_getSequence() == 0x0001);
+
+	/*a record torn by a reset half way through its write falls back too*/
+	TEST_save(600); /*slot 6 again*/
+	CONFIG_setSamplePeriod(700);
+	NVM_requestSave();
+	MCU_delay(NVM_SAVE_DELAY_MS * MCU_CYCLES_PER_MS);
+	NVM_process();
+	MCU_delay((TEST_NVM_WRITE_MS / 2) * MCU_CYCLES_PER_MS);
+	memcpy(torn, journal, sizeof(torn)); /*the EEPROM when the reset comes*/
+	MCU_delay(TEST_NVM_WRITE_MS * MCU_CYCLES_PER_MS);
+	TEST_CHECK(TEST_boot(&error) == 700 && journal[7 * NVM_SLOT_SIZE] == 0x03);
+	memcpy(journal, torn, sizeof(torn));
+	TEST_CHECK(TEST_boot(&error) == 600 && NVM_getSequence() == 0x0002 && error == NVM_SUCCESS);
+
+	memset(journal, 0xFF, NVM_SLOTS * NVM_SLOT_SIZE); /*the firmware test starts on a blank journal*/
+	TIMER_deInit();
+}
+
+/*
+ * Description:
+ * Record the errors of wrong driver calls and render their messages
+ * */
+static void TEST_errorLog(void)
+{
+	ERROR_EntryType entry;
+	char message[ERROR_MESSAGE_SIZE];
+
+	MCU_init();
+	TIMER_init();
+	ERROR_init();
+	TEST_CHECK(DC_MOTOR_Rotate(DC_MOTOR_CW, DC_MOTOR_MAX_SPEED + 1) == DC_MOTOR_ERROR_SPEED);
+	MCU_delay(5UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(GPIO_writePin(PORTD_ID, PIN0_ID, 2) == GPIO_ERROR_VALUE);
+	LCD_moveCursor(LCD_ROWS - 1, LCD_COLUMNS - 1); /*the last position of the 2x16 display*/
+	LCD_moveCursor(LCD_ROWS, 0);
+	DC_MOTOR_Rotate(DC_MOTOR_CW, DC_MOTOR_MAX_SPEED + 1);
+	TEST_CHECK(ERROR_getCount() == 3);
+	TEST_CHECK(ERROR_getTotal() == 4);
+	TEST_CHECK(ERROR_getEntry(0, &entry));
+	TEST_CHECK(entry.code == DC_MOTOR_ERROR_SPEED && entry.occurrences == 2);
+	TEST_CHECK(entry.last - entry.first >= 4);
+	TEST_CHECK(ERROR_getEntry(2, &entry) && entry.code == LCD_ERROR_POSITION);
+	TEST_CHECK(!ERROR_getEntry(3, &entry));
+	TEST_CHECK(ERROR_getMessage(DC_MOTOR_ERROR_SPEED, message) == 21);
+	TEST_CHECK(strcmp(message, "Incorrect Motor speed") == 0);
+	ERROR_getMessage(ERROR_CODE(ERROR_MODULE_LCD, 15), message);
+	TEST_CHECK(strcmp(message, "Unknown error") == 0);
+	TIMER_deInit();
+}
+
+/*
+ * Description:
+ * Send frames with runs of zeros through the telemetry encoder and read them back
+ * with frame.c, then check that an over-long COBS block and every corrupted byte
+ * only lose their own frame
+ * */
+static void TEST_frames(void)
+{
+	static const uint8 lengths[TEST_FRAME_COUNT] = {0, TELEMETRY_MAX_PAYLOAD, TELEMETRY_MAX_PAYLOAD,
+			TELEMETRY_MAX_PAYLOAD, TELEMETRY_MAX_PAYLOAD, TELEMETRY_MAX_PAYLOAD, 1, 37};
+	static uint8 payloads[TEST_FRAME_COUNT][TELEMETRY_MAX_PAYLOAD];
+	static uint8 stream[TEST_TX_SIZE];
+	UART_configType uartConfig = {UART_DEFAULT_BAUD_RATE};
+	FRAME_StatsType stats;
+	uint32 i = 0, length = 0, mismatches = 0, undetected = 0;
+
+	for(i = 0; i < TELEMETRY_MAX_PAYLOAD; i++)
+	{
+		payloads[1][i] = 0; /*one code byte per zero*/
+		payloads[2][i] = 0xA5; /*the longest run without a zero, type to CRC*/
+		payloads[3][i] = i == 0 ? 0 : 0x5A;
+		payloads[4][i] = i == TELEMETRY_MAX_PAYLOAD - 1 ? 0 : (uint8)(i + 1);
+		payloads[5][i] = (i / 5) % 2 ? 0 : (uint8)(i + 1); /*runs of 5 zeros between the data*/
+		payloads[6][i] = 0;
+		payloads[7][i] = i % 3 ? 0 : 0xFF;
+	}
+
+	MCU_init();
+	MCU_setUartCallback(TEST_onUartByte, NULL_PTR);
+	TIMER_init();
+	UART_init(&uartConfig);
+	TELEMETRY_init(TELEMETRY_MIN_PERIOD_MS);
+	TEST_g_txLength = 0;
+	for(i = 0; i < TEST_FRAME_COUNT; i++)
+	{
+		TEST_CHECK(TELEMETRY_sendFrame(TELEMETRY_FRAME_RESPONSE, payloads[i], lengths[i]) == TELEMETRY_SUCCESS);
+		MCU_delay(100UL * MCU_CYCLES_PER_MS);
+	}
+	TIMER_deInit();
+	length = TEST_g_txLength;
+
+	TEST_readFrames(TEST_g_tx, length, &stats);
+	TEST_CHECK(stats.frames == TEST_FRAME_COUNT && stats.crcErrors == 0 && stats.cobsErrors == 0);
+	TEST_CHECK(stats.sequenceGaps == 0);
+	for(i = 0; i < TEST_g_frameCount; i++)
+	{
+		mismatches += TEST_g_frames[i].type != TELEMETRY_FRAME_RESPONSE || TEST_g_frames[i].sequence != i
+				|| TEST_g_frames[i].length != lengths[i]
+				|| memcmp(TEST_g_frames[i].payload, payloads[i], lengths[i]) != 0;
+	}
+	TEST_CHECK(TEST_g_frameCount == TEST_FRAME_COUNT && mismatches == 0);
+
+	/*a full COBS block of 254 data bytes is longer than any frame, it is dropped up to the next delimiter*/
+	stream[0] = 0;
+	stream[1] = 0xFF;
+	memset(&stream[2], 0x11, 254);
+	stream[256] = 0;
+	memcpy(&stream[257], TEST_g_tx, length);
+	TEST_readFrames(stream, length + 257, &stats);
+	TEST_CHECK(stats.frames == TEST_FRAME_COUNT && stats.cobsErrors == 1 && stats.crcErrors == 0);
+
+	/*a changed bit anywhere in a frame, code bytes and CRC included, drops this frame only*/
+	for(i = 0; i < length; i++)
+	{
+		if(TEST_g_tx[i] == 0)
+		{
+			continue;
+		}
+		memcpy(stream, TEST_g_tx, length);
+		stream[i] ^= stream[i] == 0x01 ? 0x02 : 0x01; /*a delimiter would split the frame instead*/
+		TEST_readFrames(stream, length, &stats);
+		undetected += stats.frames != TEST_FRAME_COUNT - 1 || stats.crcErrors + stats.cobsErrors != 1;
+	}
+	TEST_CHECK(undetected == 0);
+	memcpy(stream, TEST_g_tx, length);
+	stream[length - 4] ^= 0x01; /*the last payload byte, 0xFF, so the COBS codes stay valid*/
+	TEST_readFrames(stream, length, &stats);
+	TEST_CHECK(stats.frames == TEST_FRAME_COUNT - 1 && stats.crcErrors == 1);
+}
+
+/*
+ * Description:
+ * Record samples across every token and varint boundary until the RAM ring wrapped,
+ * dump it and check that history_decoder gives back every sample still in the ring
+ * */
+static void TEST_history(void)
+{
+	UART_configType uartConfig = {UART_DEFAULT_BAUD_RATE};
+	char path[TEST_PATH_SIZE] = "/tmp/port_test_XXXXXX", line[TEST_PATH_SIZE];
+	unsigned long second = 0, previous = 0, first = 0;
+	long temperature = 0;
+	unsigned int duty = 0;
+	uint32 mismatches = 0;
+	uint16 i = 0, step = 0;
+	FILE * output = NULL_PTR;
+	int fd = 0;
+
+	for(i = 1; i <= TEST_HISTORY_SAMPLES; i++)
+	{
+		TEST_g_temperature[i] = TEST_g_temperature[i - 1];
+		TEST_g_duty[i] = TEST_g_duty[i - 1];
+		if((i / 100) % 4 == 3)
+		{
+			continue; /*100 equal samples, longer than one run token*/
+		}
+		switch(i % 10)
+		{
+		case 0: case 1: case 2: case 3:
+			TEST_g_temperature[i] = (sint16)(TEST_g_temperature[i] +
+					TEST_g_historySteps[step++ % (sizeof(TEST_g_historySteps) / sizeof(TEST_g_historySteps[0]))]);
+			break;
+		case 4:
+			TEST_g_duty[i] = (TEST_g_duty[i] + 37) % 101; /*a full token with no temperature change*/
+			break;
+		case 5:
+			TEST_g_temperature[i] += (i % 7) - 3;
+			break;
+		default:
+			break;
+		}
+	}
+
+	MCU_init();
+	MCU_setUartCallback(TEST_onUartByte, NULL_PTR);
+	TIMER_init();
+	UART_init(&uartConfig);
+	TELEMETRY_init(TELEMETRY_MIN_PERIOD_MS);
+	HISTORY_init();
+	for(i = 1; i <= TEST_HISTORY_SAMPLES; i++)
+	{
+		MCU_delay((uint64)HISTORY_SAMPLE_PERIOD_MS * MCU_CYCLES_PER_MS);
+		HISTORY_update(TEST_g_temperature[i], TEST_g_duty[i]);
+		HISTORY_process();
+	}
+	TEST_CHECK(HISTORY_getBlockCount() == HISTORY_BLOCKS);
+	TEST_g_txLength = 0;
+	TEST_CHECK(HISTORY_startDump());
+	for(i = 0; i < 500; i++)
+	{
+		HISTORY_process();
+		MCU_delay(10UL * MCU_CYCLES_PER_MS);
+	}
+	TEST_CHECK(HISTORY_startDump()); /*the previous dump ended*/
+	TIMER_deInit();
+
+	fd = mkstemp(path);
+	TEST_CHECK(fd >= 0 && write(fd, TEST_g_tx, TEST_g_txLength) == (ssize_t)TEST_g_txLength);
+	close(fd);
+	snprintf(line, sizeof(line), "%s/history_decoder %s 2>/dev/null", TEST_g_build, path);
+	output = popen(line, "r");
+	TEST_CHECK(output != NULL_PTR && fgets(line, sizeof(line), output) != NULL_PTR); /*the CSV header*/
+	while(output != NULL_PTR && fgets(line, sizeof(line), output) != NULL_PTR)
+	{
+		if(sscanf(line, "%lu,%ld,%u", &second, &temperature, &duty) != 3 || second > TEST_HISTORY_SAMPLES
+				|| (previous != 0 && second != previous + 1)
+				|| temperature != TEST_g_temperature[second] || duty != TEST_g_duty[second])
+		{
+			mismatches++;
+		}
+		first = first == 0 ? second : first;
+		previous = second;
+	}
+	TEST_CHECK(output != NULL_PTR && pclose(output) == 0); /*no decode or CRC error*/
+	unlink(path);
+	TEST_CHECK(mismatches == 0);
+	TEST_CHECK(first > 1); /*the oldest blocks were dropped*/
+	TEST_CHECK(previous == TEST_HISTORY_SAMPLES);
+}
+
+/*
+ * Description:
+ * Break the LM35 wire and measure the time until the fan is at full speed,
+ * it must be within one sample period and the conversion
+ * */
+static void TEST_sensorFault(void)
+{
+	uint32 latency = 0;
+
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.0);
+	while(MCU_getPwmDuty() != 1.0 && latency < TEST_FAILSAFE_LIMIT_MS * 10)
+	{
+		MCU_run(MCU_CYCLES_PER_MS / 10);
+		latency++;
+	}
+	printf("port_test: open sensor to full duty in %.1f ms\n", latency / 10.0);
+	TEST_CHECK(latency <= (CONFIG_DEFAULT_SAMPLE_PERIOD_MS + 2) * 10);
+	TEST_CHECK(MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN1) != MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN2));
+	MCU_run(200UL * MCU_CYCLES_PER_MS); /*the LCD takes a few ms per character*/
+	TEST_CHECK(strncmp(MCU_getLcdRow(0), "Fan is ON", 9) == 0);
+	TEST_CHECK(strncmp(MCU_getLcdRow(1), "Sensor open", 11) == 0);
+
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.2);
+	MCU_run(1500UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(strncmp(MCU_getLcdRow(0), "Fan is OFF", 10) == 0);
+	TEST_CHECK(strncmp(MCU_getLcdRow(1), "Temp is 20", 10) == 0);
+	TEST_CHECK(MCU_getPwmDuty() == 0.0);
+
+	MCU_setAdcVoltage(LM35_CHANNEL, 3.0); /*short to VCC, the last code*/
+	MCU_run(300UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(MCU_getPwmDuty() == 1.0);
+	TEST_CHECK(strncmp(MCU_getLcdRow(1), "Sensor short", 12) == 0);
+	MCU_uartReceive((const uint8 *)"get sensor\n", 11);
+	TEST_CHECK(TEST_runAndFind(200, "sensor short 3"));
+
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.2);
+	MCU_run(1500UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(MCU_getPwmDuty() == 0.0);
+}
+
+/*
+ * Description:
+ * Stop the tick as a hung driver would, the watchdog must reset the MCU
+ * and the fan must be back at its duty before the LCD is ready
+ * */
+static void TEST_watchdog(void)
+{
+	uint8 journal[NVM_SLOTS * NVM_SLOT_SIZE];
+	float64 duty = MCU_getPwmDuty();
+	uint32 elapsed = 0, recovery = 0;
+
+	TEST_CHECK(MCU_getWatchdogResets() == 0);
+	TEST_CHECK(duty > 0.0);
+	TIMSK &= ~(1 << OCIE2);
+	while(MCU_getWatchdogResets() == 0 && elapsed < 2 * TEST_FAILSAFE_LIMIT_MS)
+	{
+		MCU_run(MCU_CYCLES_PER_MS);
+		elapsed++;
+	}
+	TEST_CHECK(elapsed > TEST_FAILSAFE_LIMIT_MS && elapsed < 2 * TEST_FAILSAFE_LIMIT_MS); /*about 1s*/
+	while(fabs(MCU_getPwmDuty() - duty) >= 0.01 && recovery < TEST_RECOVERY_LIMIT_MS * 10)
+	{
+		MCU_run(MCU_CYCLES_PER_MS / 10);
+		recovery++;
+	}
+	printf("port_test: watchdog reset to restored duty in %.1f ms\n", recovery / 10.0);
+	TEST_CHECK(recovery < TEST_RECOVERY_LIMIT_MS * 10);
+
+	/*the tick runs again, no more resets*/
+	MCU_uartReceive((const uint8 *)"get resets\n", 11);
+	TEST_CHECK(TEST_runAndFind(3000, "resets 8 1 0 0 1 0"));
+	TEST_CHECK(MCU_getWatchdogResets() == 1);
+	TEST_CHECK(fabs(MCU_getPwmDuty() - duty) < 0.01);
+	TEST_CHECK(strncmp(MCU_getLcdRow(0), "Fan is ON", 9) == 0);
+	TEST_CHECK(MCU_getEeprom()[WATCHDOG_EEPROM_ADDRESS + (2 * WATCHDOG_CAUSE_WATCHDOG)] == 1);
+
+	/*the counts are saved by the module, not by the configuration journal*/
+	memcpy(journal, &MCU_getEeprom()[NVM_BASE_ADDRESS], sizeof(journal));
+	MCU_uartReceive((const uint8 *)"set resets clear\n", 17);
+	TEST_CHECK(TEST_runAndFind(3000, "ok"));
+	TEST_CHECK(memcmp(journal, &MCU_getEeprom()[NVM_BASE_ADDRESS], sizeof(journal)) == 0);
+	TEST_CHECK(MCU_getEeprom()[WATCHDOG_EEPROM_ADDRESS + (2 * WATCHDOG_CAUSE_WATCHDOG)] == 0);
+}
+
+/*
+ * Description:
+ * The sensor checks on the documented circuit, the ground pin of the LM35 is
+ * at TEST_GROUND_VOLTS and every reading is above it
+ * */
+static void TEST_liftedGround(void)
+{
+	MCU_setAdcVoltage(LM35_REFERENCE_CHANNEL, TEST_GROUND_VOLTS);
+	MCU_setAdcVoltage(LM35_CHANNEL, TEST_GROUND_VOLTS + 0.45);
+	MCU_run(2000UL * MCU_CYCLES_PER_MS); /*the step of the raw code is a slew fault first*/
+	TEST_CHECK(strncmp(MCU_getLcdRow(1), "Temp is 45", 10) == 0);
+	TEST_CHECK(fabs(MCU_getPwmDuty() - 0.25) < 0.01);
+
+	MCU_setAdcVoltage(LM35_CHANNEL, TEST_GROUND_VOLTS - 0.095); /*-9.5C, shown rounded down*/
+	MCU_run(2000UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(strncmp(MCU_getLcdRow(1), "Temp is -10", 11) == 0);
+	TEST_CHECK(MCU_getPwmDuty() == 0.0);
+
+	/*inside the fine window a spike of one sample is filtered out of the 10x reading too*/
+	MCU_uartReceive((const uint8 *)"set fine -20 20\n", 16);
+	TEST_CHECK(TEST_runAndFind(500, "ok"));
+	MCU_setAdcVoltage(LM35_CHANNEL, TEST_GROUND_VOLTS - 0.055);
+	MCU_run(100UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(strncmp(MCU_getLcdRow(1), "Temp is -10", 11) == 0);
+	MCU_setAdcVoltage(LM35_CHANNEL, TEST_GROUND_VOLTS - 0.095);
+	MCU_uartReceive((const uint8 *)"set fine 0 0\n", 13);
+	TEST_CHECK(TEST_runAndFind(500, "ok"));
+
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.0); /*broken wire*/
+	MCU_run(300UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(strncmp(MCU_getLcdRow(1), "Sensor open", 11) == 0);
+	TEST_CHECK(MCU_getPwmDuty() == 1.0);
+
+	MCU_setAdcVoltage(LM35_CHANNEL, 3.0); /*short to VCC*/
+	MCU_run(300UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(strncmp(MCU_getLcdRow(1), "Sensor short", 12) == 0);
+
+	MCU_setAdcVoltage(LM35_REFERENCE_CHANNEL, 0.0);
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.2);
+	MCU_run(1500UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(MCU_getPwmDuty() == 0.0);
+}
+
+static void TEST_firmware(void)
+{
+	uint8 journal[NVM_SLOTS * NVM_SLOT_SIZE];
+	uint8 i = 0, saved = FALSE;
+
+	MCU_init();
+	MCU_setUartCallback(TEST_onUartByte, NULL_PTR);
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.455);
+	MCU_start(FIRMWARE_main);
+	MCU_run(1000UL * MCU_CYCLES_PER_MS);
+
+	TEST_CHECK(strncmp(MCU_getLcdRow(0), "Fan is ON", 9) == 0);
+	TEST_CHECK(strncmp(MCU_getLcdRow(1), "Temp is 45", 10) == 0);
+	TEST_CHECK(fabs(MCU_getPwmDuty() - 0.25) < 0.01); /*25% from 30C on the default curve*/
+	TEST_CHECK(MCU_getInterruptCount(TIMER2_COMP_vect_num) >= 990); /*the tick starts after the LCD init*/
+
+	/*a 25C step in one sample is a slew fault, the fan is off once it cleared*/
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.2);
+	MCU_run(1500UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(strncmp(MCU_getLcdRow(0), "Fan is OFF", 10) == 0);
+	TEST_CHECK(MCU_getPwmDuty() == 0.0);
+
+	TEST_sensorFault();
+	TEST_liftedGround();
+
+	/*a jammed fan is shown until a retry runs*/
+	MCU_setAdcVoltage(LM35_CHANNEL, 0.455);
+	MCU_setAdcVoltage(DC_MOTOR_CURRENT_CHANNEL, TEST_STALL_VOLTS);
+	MCU_run(5000UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(strncmp(MCU_getLcdRow(0), "Fan is STALL", 12) == 0);
+	MCU_setAdcVoltage(DC_MOTOR_CURRENT_CHANNEL, 0.0);
+	MCU_run(4000UL * MCU_CYCLES_PER_MS);
+	TEST_CHECK(strncmp(MCU_getLcdRow(0), "Fan is ON ", 10) == 0);
+
+	MCU_uartReceive((const uint8 *)"get filter\n", 11);
+	TEST_CHECK(TEST_runAndFind(200, "filter 5 2"));
+	MCU_uartReceive((const uint8 *)"set filter 4 2\n", 15);
+	TEST_CHECK(TEST_runAndFind(200, "err"));
+	MCU_uartReceive((const uint8 *)"set predict 200\n", 16);
+	TEST_CHECK(TEST_runAndFind(200, "err"));
+	MCU_uartReceive((const uint8 *)"get boost\n", 10);
+	TEST_CHECK(TEST_runAndFind(200, "boost 100 100"));
+	MCU_uartReceive((const uint8 *)"get power\n", 10);
+	TEST_CHECK(TEST_runAndFind(200, "power 24"));
+	MCU_uartReceive((const uint8 *)"get energy\n", 11);
+	TEST_CHECK(TEST_runAndFind(200, "energy "));
+	MCU_uartReceive((const uint8 *)"get errors\n", 11);
+	TEST_CHECK(TEST_runAndFind(200, "errors 0 0"));
+	MCU_uartReceive((const uint8 *)"set fine -30 0\n", 15);
+	TEST_CHECK(TEST_runAndFind(200, "err"));
+	MCU_uartReceive((const uint8 *)"set fine -5 10\n", 15);
+	TEST_CHECK(TEST_runAndFind(200, "ok"));
+	MCU_uartReceive((const uint8 *)"get fine\n", 9);
+	TEST_CHECK(TEST_runAndFind(200, "fine -5 10"));
+	MCU_uartReceive((const uint8 *)"get vref\n", 9);
+	TEST_CHECK(TEST_runAndFind(200, "vref 16384 2560"));
+	TEST_CHECK(MCU_getEeprom()[VREF_EEPROM_ADDRESS] == (uint8)LM35_VREF_ONE); /*measured and saved on the first boot*/
+	MCU_uartReceive((const uint8 *)"get period\n", 11);
+	TEST_CHECK(TEST_runAndFind(200, "period 100"));
+	MCU_uartReceive((const uint8 *)"set period 200\n", 15);
+	TEST_CHECK(TEST_runAndFind(200, "ok"));
+
+	/*the configuration is saved 2s after the change*/
+	MCU_run(3000UL * MCU_CYCLES_PER_MS);
+	for(i = 0; i < NVM_SLOT_SIZE; i++)
+	{
+		saved |= (MCU_getEeprom()[NVM_BASE_ADDRESS + i] != 0xFF);
+	}
+	TEST_CHECK(saved);
+
+	/*clearing the error log is not a configuration change, the journal is not written*/
+	memcpy(journal, &MCU_getEeprom()[NVM_BASE_ADDRESS], sizeof(journal));
+	MCU_uartReceive((const uint8 *)"set errors clear\n", 17);
+	TEST_CHECK(TEST_runAndFind(3000, "ok"));
+	TEST_CHECK(memcmp(journal, &MCU_getEeprom()[NVM_BASE_ADDRESS], sizeof(journal)) == 0);
+
+	TEST_watchdog();
+}
+
+int main(int argc, char * argv[])
+{
+	TEST_g_build = argc > 1 ? argv[1] : TEST_g_build;
+	TEST_drivers();
+	TEST_overCurrent();
+	TEST_energy();
+	TEST_errorLog();
+	TEST_frames();
+	TEST_history();
+	TEST_journal();
+	TEST_firmware();
+	printf("port_test: %lu failed\n", (unsigned long)TEST_g_failed);
+	return TEST_g_failed != 0;
+}
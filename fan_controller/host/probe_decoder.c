@@ -0,0 +1,165 @@
+/*
+ *
+ * Module: Host - Probe decoder
+ *
+ * File Name: probe_decoder.c
+ *
+ * Description: Decode the latency histograms of a "get probes" dump (see probe.h)
+ * to CSV: "stage,count,p50_us,p90_us,p99_us,max_us". A percentile is the upper
+ * bound of the bin where it falls, so it is never under the real value.
+ * With -H the bins are printed instead as "stage,from_us,count".
+ * With -r the "get probes" command is sent first.
+ *
+ * Usage: probe_decoder [-b baud] [-f cpu_hz] [-r] [-H] device|capture|-
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"frame.h"
+#define PROBE_ENABLED	1
+#include"../probe.h"
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+
+typedef struct
+{
+	uint8 bins; /*print the bins instead of the percentiles*/
+	float64 microsecondsPerCount;
+	uint32 errors;
+}PROBE_DECODER_ContextType;
+
+static const char * const PROBE_DECODER_g_names[PROBE_STAGES] =
+{
+	"command", "background", "sensor", "actuation", "latency", "record", "sample", "period", "failsafe", "filter"
+};
+
+/*
+ * Description:
+ * Upper bound of the bin where a_fraction of the values are reached, limited to the maximum
+ * */
+static uint16 PROBE_DECODER_getPercentile(const uint8 * a_payload, float64 a_fraction)
+{
+	uint32 count = FRAME_getUint16(&a_payload[2]), total = 0;
+	uint16 max = FRAME_getUint16(&a_payload[4]);
+	uint8 bin = 0;
+
+	for(bin = 0; bin < PROBE_BINS; bin++)
+	{
+		total += FRAME_getUint16(&a_payload[6 + (2 * bin)]);
+		if((float64)total >= a_fraction * count)
+		{
+			break;
+		}
+	}
+	if(bin + 1 >= PROBE_BINS || PROBE_BIN_LOW(bin + 1) - 1 > max)
+	{
+		return max;
+	}
+	return PROBE_BIN_LOW(bin + 1) - 1;
+}
+
+static uint8 PROBE_DECODER_onFrame(const FRAME_Type * a_frame, void * a_context)
+{
+	PROBE_DECODER_ContextType * context = a_context;
+	const uint8 * payload = a_frame->payload;
+	const char * name = NULL_PTR;
+	uint8 bin = 0;
+
+	if(a_frame->type != TELEMETRY_FRAME_PROBE)
+	{
+		return TRUE; /*samples and responses are mixed with the dump*/
+	}
+	if(a_frame->length != PROBE_PAYLOAD_SIZE || payload[0] >= payload[1])
+	{
+		context->errors++;
+		return TRUE;
+	}
+	name = payload[0] < PROBE_STAGES ? PROBE_DECODER_g_names[payload[0]] : "unknown";
+
+	if(context->bins)
+	{
+		for(bin = 0; bin < PROBE_BINS; bin++)
+		{
+			if(FRAME_getUint16(&payload[6 + (2 * bin)]) != 0)
+			{
+				printf("%s,%.0f,%u\n", name, PROBE_BIN_LOW(bin) * context->microsecondsPerCount,
+						FRAME_getUint16(&payload[6 + (2 * bin)]));
+			}
+		}
+	}
+	else if(FRAME_getUint16(&payload[2]) == 0)
+	{
+		printf("%s,0,,,,\n", name);
+	}
+	else
+	{
+		printf("%s,%u,%.0f,%.0f,%.0f,%.0f\n", name, FRAME_getUint16(&payload[2]),
+				PROBE_DECODER_getPercentile(payload, 0.50) * context->microsecondsPerCount,
+				PROBE_DECODER_getPercentile(payload, 0.90) * context->microsecondsPerCount,
+				PROBE_DECODER_getPercentile(payload, 0.99) * context->microsecondsPerCount,
+				FRAME_getUint16(&payload[4]) * context->microsecondsPerCount);
+	}
+	/*the last stage ends the dump*/
+	return payload[0] + 1 != payload[1];
+}
+
+int main(int argc, char * argv[])
+{
+	PROBE_DECODER_ContextType context = {FALSE, 0, 0};
+	FRAME_StatsType stats = {0, 0, 0, 0};
+	uint32 baudRate = 9600;
+	float64 frequency = 1000000;
+	uint8 request = FALSE;
+	int fd = 0, option = 0;
+
+	while((option = getopt(argc, argv, "b:f:rH")) != -1)
+	{
+		if(option == 'b')
+		{
+			baudRate = strtoul(optarg, NULL_PTR, 10);
+		}
+		else if(option == 'f')
+		{
+			frequency = strtod(optarg, NULL_PTR);
+		}
+		else if(option == 'r')
+		{
+			request = TRUE;
+		}
+		else if(option == 'H')
+		{
+			context.bins = TRUE;
+		}
+		else
+		{
+			break;
+		}
+	}
+	if(argc - optind != 1 || frequency <= 0)
+	{
+		fprintf(stderr, "usage: %s [-b baud] [-f cpu_hz] [-r] [-H] device|capture|-\n", argv[0]);
+		return 2;
+	}
+	context.microsecondsPerCount = PROBE_PRESCALER * 1e6 / frequency;
+
+	fd = FRAME_open(argv[optind], baudRate);
+	if(fd < 0)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+	if(request && write(fd, "get probes\n", 11) != 11)
+	{
+		fprintf(stderr, "probe_decoder: can not send the command\n");
+		return 1;
+	}
+
+	printf(context.bins ? "stage,from_us,count\n" : "stage,count,p50_us,p90_us,p99_us,max_us\n");
+	FRAME_read(fd, PROBE_DECODER_onFrame, &context, &stats);
+	fprintf(stderr, "decode errors: %lu, crc errors: %lu, lost frames: %lu\n",
+			(unsigned long)context.errors, (unsigned long)stats.crcErrors,
+			(unsigned long)stats.sequenceGaps);
+	return context.errors != 0 || stats.crcErrors != 0;
+}
@@ -0,0 +1,207 @@
+/*
+ *
+ * Module: Host - Pseudo-terminal test
+ *
+ * File Name: pty_test.c
+ *
+ * Description: End to end check of the command link of the host build, as on the board:
+ * 	1. fan_controller runs the firmware behind its pseudo-terminal
+ * 	2. fanctl sends get and set commands on it, its output and exit status are checked
+ * 	3. one command is sent on the terminal directly and the raw stream is read back,
+ * 	   every frame in it must be a valid COBS frame with its CRC
+ * 	   and the response must be one of them
+ *
+ * Usage: pty_test [build directory]
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#define _GNU_SOURCE
+#include"frame.h"
+#include<signal.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<sys/wait.h>
+#include<termios.h>
+#include<time.h>
+#include<unistd.h>
+
+#define PTY_CHECK(condition)	PTY_check((condition) ? TRUE : FALSE, #condition, __LINE__)
+#define PTY_PATH_SIZE			256
+#define PTY_OUTPUT_SIZE			256
+#define PTY_STREAM_SIZE			8192
+#define PTY_STREAM_MS			1500 /*real time, the host build runs in real time*/
+#define PTY_RUN_SECONDS			"60" /*fan_controller stops by itself if the test dies*/
+
+typedef struct
+{
+	uint8 found;
+	char payload[TELEMETRY_MAX_PAYLOAD + 1];
+}PTY_ResponseType;
+
+static uint32 PTY_g_failed = 0;
+
+static void PTY_check(uint8 a_passed, const char * a_condition, int a_line)
+{
+	if(!a_passed)
+	{
+		printf("pty_test.c:%d: check failed: %s\n", a_line, a_condition);
+		PTY_g_failed++;
+	}
+}
+
+/*
+ * Description:
+ * Start fan_controller and read the name of its pseudo-terminal from its first line
+ *
+ * Possible return values:
+ * the process id or -1 on failure
+ * */
+static pid_t PTY_startController(const char * a_build, char * a_device, size_t a_size)
+{
+	char path[PTY_PATH_SIZE], line[PTY_PATH_SIZE];
+	FILE * errors = NULL_PTR;
+	int channel[2];
+	pid_t pid = 0;
+
+	snprintf(path, sizeof(path), "%s/fan_controller", a_build);
+	if(pipe(channel) != 0 || (pid = fork()) < 0)
+	{
+		return -1;
+	}
+	if(pid == 0)
+	{
+		dup2(channel[1], STDERR_FILENO);
+		close(channel[0]);
+		execl(path, path, "-q", "-t", PTY_RUN_SECONDS, (char *)NULL_PTR);
+		_exit(127);
+	}
+	close(channel[1]);
+	errors = fdopen(channel[0], "r");
+	if(errors == NULL_PTR || fgets(line, sizeof(line), errors) == NULL_PTR
+			|| sscanf(line, "UART on %255s", a_device) != 1 || strlen(a_device) >= a_size)
+	{
+		kill(pid, SIGTERM);
+		waitpid(pid, NULL_PTR, 0);
+		return -1;
+	}
+	return pid; /*the pipe stays open, fan_controller writes nothing else to it*/
+}
+
+/*
+ * Description:
+ * Run fanctl with one command, return its exit status and its output in a_output
+ * */
+static int PTY_fanctl(const char * a_build, const char * a_device, const char * a_command, char * a_output)
+{
+	char line[PTY_OUTPUT_SIZE];
+	FILE * output = NULL_PTR;
+	size_t length = 0;
+	int status = 0;
+
+	snprintf(line, sizeof(line), "%s/fanctl -t 5 %s '%s'", a_build, a_device, a_command);
+	output = popen(line, "r");
+	if(output == NULL_PTR)
+	{
+		return -1;
+	}
+	length = fread(a_output, 1, PTY_OUTPUT_SIZE - 1, output);
+	a_output[length] = '\0';
+	status = pclose(output);
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/*
+ * Description:
+ * Keep the response frame, the sample frames are skipped
+ * */
+static uint8 PTY_onFrame(const FRAME_Type * a_frame, void * a_context)
+{
+	PTY_ResponseType * response = (PTY_ResponseType *)a_context;
+	if(a_frame->type == TELEMETRY_FRAME_RESPONSE && !response->found)
+	{
+		response->found = TRUE;
+		memcpy(response->payload, a_frame->payload, a_frame->length);
+		response->payload[a_frame->length] = '\0';
+	}
+	return TRUE;
+}
+
+/*
+ * Description:
+ * Send one command on the terminal itself and check the frames of the raw stream
+ * */
+static void PTY_checkFraming(const char * a_device)
+{
+	uint8 stream[PTY_STREAM_SIZE];
+	PTY_ResponseType response;
+	FRAME_StatsType stats;
+	struct timespec start, now;
+	struct termios tty;
+	size_t length = 0;
+	ssize_t count = 0;
+	int fd = FRAME_open(a_device, 9600), frames[2];
+
+	memset(&response, 0, sizeof(response));
+	PTY_CHECK(fd >= 0);
+	if(fd < 0)
+	{
+		return;
+	}
+	/*a read returns after 100ms without bytes, the capture keeps to its time*/
+	tcgetattr(fd, &tty);
+	tty.c_cc[VMIN] = 0;
+	tty.c_cc[VTIME] = 1;
+	tcsetattr(fd, TCSANOW, &tty);
+	/*wait for a quiet line so that the capture starts on a frame boundary*/
+	do
+	{
+		count = read(fd, stream, sizeof(stream));
+	}while(count > 0);
+	PTY_CHECK(write(fd, "get period\n", 11) == 11);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do
+	{
+		count = read(fd, &stream[length], sizeof(stream) - length);
+		length += count > 0 ? (size_t)count : 0;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	}while(length < sizeof(stream) && ((now.tv_sec - start.tv_sec) * 1000
+			+ (now.tv_nsec - start.tv_nsec) / 1000000) < PTY_STREAM_MS);
+	close(fd);
+
+	PTY_CHECK(pipe(frames) == 0);
+	PTY_CHECK(write(frames[1], stream, length) == (ssize_t)length);
+	close(frames[1]);
+	FRAME_read(frames[0], PTY_onFrame, &response, &stats);
+	close(frames[0]);
+	PTY_CHECK(stats.frames >= 1 && stats.cobsErrors == 0 && stats.crcErrors == 0);
+	PTY_CHECK(response.found && strcmp(response.payload, "period 250") == 0);
+}
+
+int main(int argc, char * argv[])
+{
+	const char * build = argc > 1 ? argv[1] : "build";
+	char device[PTY_PATH_SIZE], output[PTY_OUTPUT_SIZE];
+	pid_t controller = PTY_startController(build, device, sizeof(device));
+
+	if(controller < 0)
+	{
+		printf("pty_test: can not start %s/fan_controller\n", build);
+		return 1;
+	}
+
+	/*a get and set round trip, fanctl only prints a frame with a valid CRC*/
+	PTY_CHECK(PTY_fanctl(build, device, "get period", output) == 0 && strcmp(output, "period 100\n") == 0);
+	PTY_CHECK(PTY_fanctl(build, device, "set period 250", output) == 0 && strcmp(output, "ok\n") == 0);
+	PTY_CHECK(PTY_fanctl(build, device, "get period", output) == 0 && strcmp(output, "period 250\n") == 0);
+	PTY_CHECK(PTY_fanctl(build, device, "set period 5", output) == 1 && strcmp(output, "err value\n") == 0);
+	PTY_CHECK(PTY_fanctl(build, device, "get nothing", output) == 1 && strcmp(output, "err unknown\n") == 0);
+	PTY_checkFraming(device);
+
+	kill(controller, SIGTERM);
+	waitpid(controller, NULL_PTR, 0);
+	printf("pty_test: %lu failed\n", (unsigned long)PTY_g_failed);
+	return PTY_g_failed != 0;
+}
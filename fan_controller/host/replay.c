@@ -0,0 +1,363 @@
+/*
+ *
+ * Module: Host - Trace replay
+ *
+ * File Name: replay.c
+ *
+ * Description: Push a recorded temperature trace through the unmodified firmware.
+ * Every sample of the trace is a timestamp and a raw ADC code of the LM35, the code
+ * is fed to LM35_CHANNEL of the simulated ADC at its time and the outputs are
+ * recorded every time they change:
+ *
+ * 	timestamp_ms,duty,fan,lcd_row0,lcd_row1
+ *
+ * duty is the OC0 duty in percent, fan the state of the motor pins (stop, cw, acw).
+ * With -g the output is compared line by line with a golden run, the first
+ * differences are printed and the exit code is 1 if there is one.
+ *
+ * Trace formats:
+ * 	CSV		timestamp_ms,adc per line, a header line names the columns. The CSV of
+ * 			telemetry_decoder works as it is, its timestamp_ms and adc columns are used.
+ * 	binary	(-B) records of timestamp_ms(4) | adc(2), little endian
+ *
+ * The timestamps are relative to the first sample and must not go back. The trace
+ * is streamed, its length is only limited by the time: the firmware is simulated
+ * tick by tick, about 3000 times faster than real time, so a trace of millions of
+ * samples at the 100ms sample period replays in a few minutes.
+ *
+ * Usage: replay [-B] [-o output.csv] [-g golden.csv] [-e eeprom.bin] trace|-
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"port/mcu.h"
+#include"../adc.h"
+#include"../lm35.h"
+#include"../gpio.h"
+#include"../dcMotor.h"
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include<unistd.h>
+
+#define REPLAY_LINE_SIZE		256
+#define REPLAY_RECORD_SIZE		6
+#define REPLAY_SETTLE_MS		1000 /*run after the last sample so its effect is recorded*/
+#define REPLAY_MAX_DIFFERENCES	10
+#define REPLAY_NO_COLUMN		0xFF
+
+typedef struct
+{
+	FILE * file;
+	uint8 binary;
+	uint8 timeColumn;
+	uint8 adcColumn;
+	uint64 line;
+}REPLAY_TraceType;
+
+typedef struct
+{
+	FILE * output;
+	FILE * golden;
+	char last[REPLAY_LINE_SIZE / 2];
+	uint64 lines;
+	uint64 differences;
+}REPLAY_RecorderType;
+
+int FIRMWARE_main(void);
+
+static float64 REPLAY_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (float64)now.tv_sec + ((float64)now.tv_nsec / 1e9);
+}
+
+/*
+ * Description:
+ * Find the columns of the CSV trace from its header, a trace without header
+ * has the timestamp then the code
+ * */
+static void REPLAY_readHeader(REPLAY_TraceType * a_trace, char * a_line)
+{
+	char * field = strtok(a_line, ",\r\n");
+	uint8 column = 0;
+
+	a_trace->timeColumn = REPLAY_NO_COLUMN;
+	a_trace->adcColumn = REPLAY_NO_COLUMN;
+	while(field != NULL_PTR && column < REPLAY_NO_COLUMN)
+	{
+		if(strcmp(field, "timestamp_ms") == 0)
+		{
+			a_trace->timeColumn = column;
+		}
+		else if(strcmp(field, "adc") == 0)
+		{
+			a_trace->adcColumn = column;
+		}
+		field = strtok(NULL_PTR, ",\r\n");
+		column++;
+	}
+}
+
+/*
+ * Description:
+ * Read the next sample of the trace
+ *
+ * Possible return values:
+ * TRUE if a sample was read, FALSE at the end of the trace or on a malformed line
+ * */
+static uint8 REPLAY_readSample(REPLAY_TraceType * a_trace, uint32 * a_timestamp, uint16 * a_code)
+{
+	uint8 record[REPLAY_RECORD_SIZE];
+	char line[REPLAY_LINE_SIZE];
+	char * p = line;
+	uint8 column = 0, found = 0;
+
+	if(a_trace->binary)
+	{
+		if(fread(record, 1, REPLAY_RECORD_SIZE, a_trace->file) != REPLAY_RECORD_SIZE)
+		{
+			return FALSE;
+		}
+		a_trace->line++;
+		*a_timestamp = (uint32)record[0] | ((uint32)record[1] << 8) | ((uint32)record[2] << 16)
+				| ((uint32)record[3] << 24);
+		*a_code = (uint16)(record[4] | (record[5] << 8));
+		return TRUE;
+	}
+
+	while(fgets(line, sizeof(line), a_trace->file) != NULL_PTR)
+	{
+		a_trace->line++;
+		if(line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+		{
+			continue;
+		}
+		if(a_trace->line == 1 && (line[0] < '0' || line[0] > '9'))
+		{
+			REPLAY_readHeader(a_trace, line);
+			if(a_trace->timeColumn == REPLAY_NO_COLUMN || a_trace->adcColumn == REPLAY_NO_COLUMN)
+			{
+				fprintf(stderr, "replay: the header has no timestamp_ms or adc column\n");
+				return FALSE;
+			}
+			continue;
+		}
+		/*walk the fields once, the trace can have millions of lines*/
+		for(column = 0, found = 0; *p != '\0' && found != 3; column++)
+		{
+			if(column == a_trace->timeColumn)
+			{
+				*a_timestamp = (uint32)strtoul(p, NULL_PTR, 10);
+				found |= 1;
+			}
+			if(column == a_trace->adcColumn)
+			{
+				*a_code = (uint16)strtoul(p, NULL_PTR, 10);
+				found |= 2;
+			}
+			while(*p != ',' && *p != '\0')
+			{
+				p++;
+			}
+			if(*p == ',')
+			{
+				p++;
+			}
+		}
+		if(found != 3)
+		{
+			fprintf(stderr, "replay: line %llu: missing field\n", (unsigned long long)a_trace->line);
+			return FALSE;
+		}
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Description:
+ * Voltage in the middle of the step of a_code, the LM35 is read with the internal reference
+ * */
+static float64 REPLAY_getVolts(uint16 a_code)
+{
+	if(a_code > ADC_MAX)
+	{
+		a_code = ADC_MAX;
+	}
+	return ((float64)a_code + 0.5) * MCU_INTERNAL_VREF / (ADC_MAX + 1);
+}
+
+static const char * REPLAY_getFanState(void)
+{
+	uint8 pin1 = MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN1);
+	uint8 pin2 = MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN2);
+	if(pin1 == 0xFF || pin2 == 0xFF || pin1 == pin2)
+	{
+		return "stop";
+	}
+	return pin1 == LOGIC_HIGH ? "cw" : "acw";
+}
+
+/*
+ * Description:
+ * Write the outputs if they changed and compare the line with the golden run
+ * */
+static void REPLAY_record(REPLAY_RecorderType * a_recorder, uint32 a_timestamp)
+{
+	char state[REPLAY_LINE_SIZE / 2], line[REPLAY_LINE_SIZE], golden[REPLAY_LINE_SIZE];
+
+	snprintf(state, sizeof(state), "%.1f,%s,%s,%s", MCU_getPwmDuty() * 100.0, REPLAY_getFanState(),
+			MCU_getLcdRow(0), MCU_getLcdRow(1));
+	if(a_recorder->lines != 0 && strcmp(state, a_recorder->last) == 0)
+	{
+		return;
+	}
+	strcpy(a_recorder->last, state);
+	snprintf(line, sizeof(line), "%lu,%s\n", (unsigned long)a_timestamp, state);
+	a_recorder->lines++;
+
+	if(a_recorder->output != NULL_PTR)
+	{
+		fputs(line, a_recorder->output);
+	}
+	if(a_recorder->golden == NULL_PTR)
+	{
+		return;
+	}
+	if(fgets(golden, sizeof(golden), a_recorder->golden) == NULL_PTR)
+	{
+		golden[0] = '\0';
+	}
+	if(strcmp(line, golden) != 0)
+	{
+		if(a_recorder->differences < REPLAY_MAX_DIFFERENCES)
+		{
+			fprintf(stderr, "line %llu:\n- %s+ %s", (unsigned long long)a_recorder->lines + 1,
+					golden[0] != '\0' ? golden : "(end of the golden run)\n", line);
+		}
+		a_recorder->differences++;
+	}
+}
+
+static FILE * REPLAY_open(const char * a_path, const char * a_mode)
+{
+	FILE * file = fopen(a_path, a_mode);
+	if(file == NULL_PTR)
+	{
+		perror(a_path);
+		exit(2);
+	}
+	return file;
+}
+
+int main(int argc, char * argv[])
+{
+	REPLAY_TraceType trace = {NULL_PTR, FALSE, 0, 1, 0};
+	REPLAY_RecorderType recorder = {stdout, NULL_PTR, "", 0, 0};
+	char golden[REPLAY_LINE_SIZE];
+	uint32 timestamp = 0, first = 0, now = 0;
+	uint16 code = 0;
+	uint64 samples = 0;
+	const char * eepromPath = NULL_PTR;
+	FILE * file = NULL_PTR;
+	float64 start = 0;
+	int option = 0;
+
+	while((option = getopt(argc, argv, "Bo:g:e:")) != -1)
+	{
+		switch(option)
+		{
+		case 'B':
+			trace.binary = TRUE;
+			break;
+		case 'o':
+			recorder.output = REPLAY_open(optarg, "w");
+			break;
+		case 'g':
+			recorder.golden = REPLAY_open(optarg, "r");
+			break;
+		case 'e':
+			eepromPath = optarg;
+			break;
+		default:
+			optind = argc; /*print the usage*/
+			break;
+		}
+	}
+	if(argc - optind != 1)
+	{
+		fprintf(stderr, "usage: %s [-B] [-o output.csv] [-g golden.csv] [-e eeprom.bin] trace|-\n", argv[0]);
+		return 2;
+	}
+	trace.file = strcmp(argv[optind], "-") == 0 ? stdin : REPLAY_open(argv[optind], trace.binary ? "rb" : "r");
+	if(recorder.golden != NULL_PTR && recorder.output == stdout)
+	{
+		recorder.output = NULL_PTR; /*only compare*/
+	}
+
+	MCU_init();
+	if(eepromPath != NULL_PTR && (file = fopen(eepromPath, "rb")) != NULL_PTR)
+	{
+		if(fread(MCU_getEeprom(), 1, MCU_EEPROM_SIZE, file) != MCU_EEPROM_SIZE)
+		{
+			fprintf(stderr, "%s: short EEPROM image\n", eepromPath);
+		}
+		fclose(file);
+	}
+	if(recorder.output != NULL_PTR)
+	{
+		fputs("timestamp_ms,duty,fan,lcd_row0,lcd_row1\n", recorder.output);
+	}
+	if(recorder.golden != NULL_PTR && fgets(golden, sizeof(golden), recorder.golden) == NULL_PTR)
+	{
+		fprintf(stderr, "replay: the golden run is empty\n");
+		return 2;
+	}
+
+	start = REPLAY_now();
+	MCU_start(FIRMWARE_main);
+	while(REPLAY_readSample(&trace, &timestamp, &code))
+	{
+		if(samples == 0)
+		{
+			first = timestamp;
+		}
+		else if(timestamp < now + first)
+		{
+			fprintf(stderr, "replay: line %llu: the timestamp goes back\n", (unsigned long long)trace.line);
+			return 2;
+		}
+		/*the previous code stays on the input until this sample*/
+		if(!MCU_run((uint64)(timestamp - first - now) * MCU_CYCLES_PER_MS))
+		{
+			break; /*main returned*/
+		}
+		now = timestamp - first;
+		REPLAY_record(&recorder, timestamp);
+		MCU_setAdcVoltage(LM35_CHANNEL, REPLAY_getVolts(code));
+		samples++;
+	}
+	if(samples != 0 && MCU_run((uint64)REPLAY_SETTLE_MS * MCU_CYCLES_PER_MS))
+	{
+		REPLAY_record(&recorder, timestamp + REPLAY_SETTLE_MS);
+	}
+
+	fprintf(stderr, "replayed %llu samples (%.1f h) in %.2f s, %llu output lines\n",
+			(unsigned long long)samples, now / 3600000.0, REPLAY_now() - start,
+			(unsigned long long)recorder.lines);
+	if(recorder.golden == NULL_PTR)
+	{
+		return 0;
+	}
+	if(fgets(golden, sizeof(golden), recorder.golden) != NULL_PTR)
+	{
+		fprintf(stderr, "the golden run has more lines\n");
+		recorder.differences++;
+	}
+	fprintf(stderr, "%llu differences with the golden run\n", (unsigned long long)recorder.differences);
+	return recorder.differences != 0;
+}
@@ -0,0 +1,66 @@
+/*
+ *
+ * Module: Host - Fan rotor
+ *
+ * File Name: rotor.c
+ *
+ * Description: Source file of the first order mechanical model of the fan rotor
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"rotor.h"
+#include<math.h>
+
+void ROTOR_init(ROTOR_Type * a_rotor)
+{
+	a_rotor->timeConstant = ROTOR_DEFAULT_TIME_CONSTANT;
+	a_rotor->friction = ROTOR_DEFAULT_FRICTION;
+	a_rotor->breakaway = ROTOR_DEFAULT_BREAKAWAY;
+	a_rotor->drag = ROTOR_DEFAULT_DRAG;
+	a_rotor->speed = 0.0;
+}
+
+float64 ROTOR_getSteadyState(const ROTOR_Type * a_rotor, float64 a_drive)
+{
+	if(fabs(a_drive) <= a_rotor->friction)
+	{
+		return 0.0;
+	}
+	return a_drive > 0.0 ? a_drive - a_rotor->friction : a_drive + a_rotor->friction;
+}
+
+float64 ROTOR_step(ROTOR_Type * a_rotor, float64 a_drive, uint8 a_brake, float64 a_seconds)
+{
+	float64 direction = 0, target = 0, damping = 1.0;
+
+	if(a_brake)
+	{
+		a_drive = 0.0;
+	}
+	else if(a_drive == 0.0)
+	{
+		damping = a_rotor->drag;
+	}
+	if(a_rotor->speed == 0.0)
+	{
+		if(fabs(a_drive) <= a_rotor->breakaway)
+		{
+			return 0.0;/*held by the static friction*/
+		}
+		direction = a_drive > 0.0 ? 1.0 : -1.0;
+	}
+	else
+	{
+		direction = a_rotor->speed > 0.0 ? 1.0 : -1.0;
+	}
+	/*w(t) = wss + (w0 - wss) * e^(-d * t/tau), the friction opposes the current direction*/
+	target = (a_drive - (a_rotor->friction * direction)) / damping;
+	a_rotor->speed = target + ((a_rotor->speed - target) * exp(-a_seconds * damping / a_rotor->timeConstant));
+	if(a_rotor->speed * direction <= 0.0)
+	{
+		a_rotor->speed = 0.0;/*it stopped during the step*/
+	}
+	return a_rotor->speed;
+}
@@ -0,0 +1,66 @@
+/*
+ *
+ * Module: Host - Fan rotor
+ *
+ * File Name: rotor.h
+ *
+ * Description: Header file of a first order mechanical model of the fan rotor.
+ *
+ * The speed w is a fraction of the full speed, signed by the direction. The drive u
+ * is the duty signed by the direction of the motor pins (0 when they are equal):
+ * 	tau * dw/dt = u - d * w - friction * sign(w)
+ * The damping d is 1 while the bridge drives the winding: the back EMF, so a running
+ * fan settles at u - friction. It is 1 as well when the bridge brakes (the winding is
+ * shorted, u = 0) and only the air drag when it coasts (the winding is open, u = 0).
+ * A stopped rotor is held by its static friction and only starts when |u| is above
+ * the breakaway duty, a running rotor that slows down to 0 stops there again.
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef ROTOR_H_
+#define ROTOR_H_
+
+#include"../std_types.h"
+
+/*Defaults, a small fan that needs 30% to start and 0.5s to spin up*/
+#define ROTOR_DEFAULT_TIME_CONSTANT		0.5		/*s*/
+#define ROTOR_DEFAULT_FRICTION			0.05	/*duty lost while running*/
+#define ROTOR_DEFAULT_BREAKAWAY			0.30	/*duty that starts a stopped rotor*/
+#define ROTOR_DEFAULT_DRAG				0.2		/*damping of the air alone, coasting*/
+
+typedef struct
+{
+	float64 timeConstant;
+	float64 friction;
+	float64 breakaway;
+	float64 drag;
+	float64 speed;
+}ROTOR_Type;
+
+/*
+ * Description:
+ * Set the default parameters, the rotor is stopped
+ * */
+void ROTOR_init(ROTOR_Type * a_rotor);
+
+/*
+ * Description:
+ * Advance the model by a_seconds with a constant drive, the exact solution is used
+ * until the speed reaches 0 where the rotor stops.
+ * a_drive is the duty from -1.0 to 1.0, the sign is the direction, 0 coasts
+ * a_brake is TRUE when the bridge shorts the winding, the drive is then ignored
+ *
+ * Possible return values:
+ * the new speed
+ * */
+float64 ROTOR_step(ROTOR_Type * a_rotor, float64 a_drive, uint8 a_brake, float64 a_seconds);
+
+/*
+ * Description:
+ * Speed reached when the drive stays constant forever from a running rotor
+ * */
+float64 ROTOR_getSteadyState(const ROTOR_Type * a_rotor, float64 a_drive);
+
+#endif /* ROTOR_H_ */
@@ -0,0 +1,211 @@
+/*
+ *
+ * Module: Host - Stop and reversal simulation
+ *
+ * File Name: stop_sim.c
+ *
+ * Description: Run the fan of rotor.h at a speed through the DC motor driver of the
+ * firmware on the simulated MCU, then coast it, brake it or reverse it and measure:
+ *
+ * 	mode,speed,latency_ms,dead_ms
+ *
+ * latency_ms is the time from the DC_MOTOR_Rotate call to the stopped rotor (coast,
+ * brake) or to the rotor settled within 10% of its speed the other way (reverse).
+ * dead_ms is the shortest time with the bridge all off between two different driven
+ * states (a direction or the brake), "-" without any change. The bridge is read back
+ * from OC0 and the motor pins every 0.1ms so the dead time of the 1ms tick shows.
+ *
+ * Usage: stop_sim [-t seconds] [-d drag] [-f friction] [-c time_constant]
+ * 	-t	time given to each stop, 8s by default
+ * 	-d	damping of the air alone, 0.2 by default
+ * 	-f	duty lost to the friction of the running rotor, 0.05 by default
+ * 	-c	mechanical time constant in seconds, 0.5 by default
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"port/mcu.h"
+#include"rotor.h"
+#include"../config.h"
+#include"../dcMotor.h"
+#include"../timer.h"
+#include"../gpio.h"
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+
+#define STOP_SIM_STEPS_PER_MS	10
+#define STOP_SIM_SPIN_UP_MS		5000 /*the rotor settles at its speed before the stop*/
+#define STOP_SIM_BAND			0.1
+
+typedef enum
+{
+	STOP_SIM_OFF, STOP_SIM_CW, STOP_SIM_ACW, STOP_SIM_BRAKE
+}STOP_SIM_BridgeType;
+
+static const DcMotor_State STOP_SIM_g_modes[] = {DC_MOTOR_COAST, DC_MOTOR_BRAKE, DC_MOTOR_ACW};
+static const char * const STOP_SIM_g_modeNames[] = {"coast", "brake", "reverse"};
+static const uint8 STOP_SIM_g_speeds[] = {25, 50, 100};
+
+#define STOP_SIM_MODES		(sizeof(STOP_SIM_g_modes) / sizeof(STOP_SIM_g_modes[0]))
+#define STOP_SIM_SPEEDS		(sizeof(STOP_SIM_g_speeds) / sizeof(STOP_SIM_g_speeds[0]))
+
+/*
+ * Description:
+ * What the bridge does, read from the enable (OC0) and the motor pins
+ * */
+static STOP_SIM_BridgeType STOP_SIM_getBridge(void)
+{
+	uint8 pin1 = MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN1);
+	uint8 pin2 = MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN2);
+	if(pin1 == 0xFF || pin2 == 0xFF || MCU_getPwmDuty() == 0.0)
+	{
+		return STOP_SIM_OFF;
+	}
+	if(pin1 == pin2)
+	{
+		return STOP_SIM_BRAKE;
+	}
+	return pin1 ? STOP_SIM_CW : STOP_SIM_ACW;
+}
+
+/*
+ * Description:
+ * Advance the MCU and the rotor by one step, follow the dead time of the bridge
+ * */
+static void STOP_SIM_step(ROTOR_Type * a_rotor, STOP_SIM_BridgeType * a_last, uint32 * a_offSteps,
+		uint32 * a_minDead)
+{
+	STOP_SIM_BridgeType bridge = STOP_SIM_OFF;
+
+	MCU_delay(MCU_CYCLES_PER_MS / STOP_SIM_STEPS_PER_MS);
+	bridge = STOP_SIM_getBridge();
+	if(bridge == STOP_SIM_OFF)
+	{
+		(*a_offSteps)++;
+	}
+	else
+	{
+		if(*a_last != STOP_SIM_OFF && bridge != *a_last && *a_offSteps < *a_minDead)
+		{
+			*a_minDead = *a_offSteps;
+		}
+		*a_last = bridge;
+		*a_offSteps = 0;
+	}
+	if(bridge == STOP_SIM_BRAKE)
+	{
+		ROTOR_step(a_rotor, 0.0, TRUE, 0.001 / STOP_SIM_STEPS_PER_MS);
+	}
+	else if(bridge == STOP_SIM_OFF)
+	{
+		ROTOR_step(a_rotor, 0.0, FALSE, 0.001 / STOP_SIM_STEPS_PER_MS);
+	}
+	else
+	{
+		ROTOR_step(a_rotor, (bridge == STOP_SIM_CW ? 1.0 : -1.0) * MCU_getPwmDuty(), FALSE,
+				0.001 / STOP_SIM_STEPS_PER_MS);
+	}
+}
+
+/*
+ * Description:
+ * Run the rotor CW at a_speed, apply a_mode and print its line
+ * */
+static void STOP_SIM_run(const ROTOR_Type * a_model, uint8 a_mode, uint8 a_speed, uint32 a_ms)
+{
+	ROTOR_Type rotor = *a_model;
+	STOP_SIM_BridgeType last = STOP_SIM_OFF;
+	uint32 step = 0, offSteps = 0, minDead = 0xFFFFFFFF, latency = 0;
+	float64 final = 0;
+
+	MCU_init();
+	TIMER_init();
+	DC_MOTOR_Init();
+	DC_MOTOR_setBoost(CONFIG_DEFAULT_BOOST_SPEED, CONFIG_DEFAULT_BOOST_TIME_MS);
+	rotor.speed = 0.0;
+
+	DC_MOTOR_Rotate(DC_MOTOR_CW, a_speed);
+	for(step = 0; step < STOP_SIM_SPIN_UP_MS * STOP_SIM_STEPS_PER_MS; step++)
+	{
+		STOP_SIM_step(&rotor, &last, &offSteps, &minDead);
+	}
+
+	final = -ROTOR_getSteadyState(&rotor, (float64)a_speed / DC_MOTOR_MAX_SPEED);
+	DC_MOTOR_Rotate(STOP_SIM_g_modes[a_mode], a_speed);
+	latency = a_ms * STOP_SIM_STEPS_PER_MS;
+	for(step = 1; step <= a_ms * STOP_SIM_STEPS_PER_MS; step++)
+	{
+		STOP_SIM_step(&rotor, &last, &offSteps, &minDead);
+		if(STOP_SIM_g_modes[a_mode] == DC_MOTOR_ACW)
+		{
+			if(fabs(rotor.speed - final) > STOP_SIM_BAND * fabs(final))
+			{
+				latency = step;
+			}
+		}
+		else if(rotor.speed == 0.0 && latency == a_ms * STOP_SIM_STEPS_PER_MS)
+		{
+			latency = step;
+		}
+	}
+	TIMER_deInit();
+
+	printf("%s,%u,%.1f,", STOP_SIM_g_modeNames[a_mode], a_speed, (float64)latency / STOP_SIM_STEPS_PER_MS);
+	if(minDead == 0xFFFFFFFF)
+	{
+		printf("-\n");
+	}
+	else
+	{
+		printf("%.1f\n", (float64)minDead / STOP_SIM_STEPS_PER_MS);
+	}
+}
+
+int main(int argc, char * argv[])
+{
+	ROTOR_Type model;
+	float64 seconds = 8.0;
+	uint32 i = 0, j = 0;
+	int option = 0;
+
+	ROTOR_init(&model);
+	while((option = getopt(argc, argv, "t:d:f:c:")) != -1)
+	{
+		switch(option)
+		{
+		case 't':
+			seconds = atof(optarg);
+			break;
+		case 'd':
+			model.drag = atof(optarg);
+			break;
+		case 'f':
+			model.friction = atof(optarg);
+			break;
+		case 'c':
+			model.timeConstant = atof(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-t seconds] [-d drag] [-f friction] [-c time_constant]\n", argv[0]);
+			return 2;
+		}
+	}
+	if(seconds <= 0.0 || model.timeConstant <= 0.0 || model.drag <= 0.0)
+	{
+		fprintf(stderr, "stop_sim: the time, the drag and the time constant must be positive\n");
+		return 2;
+	}
+
+	printf("mode,speed,latency_ms,dead_ms\n");
+	for(i = 0; i < STOP_SIM_MODES; i++)
+	{
+		for(j = 0; j < STOP_SIM_SPEEDS; j++)
+		{
+			STOP_SIM_run(&model, (uint8)i, STOP_SIM_g_speeds[j], (uint32)(seconds * 1000));
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ *
+ * Module: Host - Telemetry decoder
+ *
+ * File Name: telemetry_decoder.c
+ *
+ * Description: Read the telemetry stream from a serial port, a pseudo-terminal or a
+ * captured file and print the sample frames as CSV on the standard output.
+ * The low stack headroom warnings of the SRAM monitor, the energy counters sent
+ * for "get energy" and the error log sent for "get errors" are printed on the standard error.
+ *
+ * Usage: telemetry_decoder [-b baud] [device | file | -]
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"frame.h"
+#include"../sram.h"
+#include"../energy.h"
+#include"../error.h"
+#include"../lm35.h"
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+
+/*
+ * Description:
+ * Print one frame, frames of other types are skipped
+ * */
+static uint8 DECODER_onFrame(const FRAME_Type * a_frame, void * a_context)
+{
+	const uint8 * p = a_frame->payload;
+	uint8 i = 0;
+	if(a_frame->type == TELEMETRY_FRAME_MEMORY && a_frame->length >= SRAM_PAYLOAD_SIZE)
+	{
+		fprintf(stderr, "warning: stack headroom %u bytes (threshold %u), static %u, free now %u\n",
+				FRAME_getUint16(&p[4]), FRAME_getUint16(&p[6]), FRAME_getUint16(&p[0]), FRAME_getUint16(&p[2]));
+		return TRUE;
+	}
+	if(a_frame->type == TELEMETRY_FRAME_ENERGY && a_frame->length >= ENERGY_RECORD_SIZE)
+	{
+		fprintf(stderr, "energy: %lu s, %lu s at 100%%, %lu starts, %lu speed changes, hours per 10%% of duty:",
+				(unsigned long)FRAME_getUint32(&p[2]), (unsigned long)FRAME_getUint32(&p[6]),
+				(unsigned long)FRAME_getUint32(&p[10]), (unsigned long)FRAME_getUint32(&p[14]));
+		for(i = 0; i < ENERGY_DUTY_BINS; i++)
+		{
+			fprintf(stderr, " %.1f", FRAME_getUint32(&p[18 + (4 * i)]) / 3600.0);
+		}
+		fprintf(stderr, "\n");
+		return TRUE;
+	}
+	if(a_frame->type == TELEMETRY_FRAME_ERROR && a_frame->length >= 2)
+	{
+		if(p[1] == 0)
+		{
+			fprintf(stderr, "errors: none\n");
+		}
+		else if(a_frame->length >= ERROR_HEADER_SIZE)
+		{
+			fprintf(stderr, "error %u/%u: 0x%02X x%u, first %lu ms, last %lu ms: %.*s\n", p[0] + 1, p[1], p[2],
+					FRAME_getUint16(&p[3]), (unsigned long)FRAME_getUint32(&p[5]),
+					(unsigned long)FRAME_getUint32(&p[9]), a_frame->length - ERROR_HEADER_SIZE, &p[ERROR_HEADER_SIZE]);
+		}
+		return TRUE;
+	}
+	if(a_frame->type != TELEMETRY_FRAME_SAMPLE || a_frame->length < TELEMETRY_SAMPLE_PAYLOAD_SIZE)
+	{
+		return TRUE;
+	}
+	printf("%u,%lu,%u,%.2f,%u,%u,%u,%u\n", a_frame->sequence,
+			(unsigned long)FRAME_getUint32(&p[0]), FRAME_getUint16(&p[4]),
+			(float64)(sint16)FRAME_getUint16(&p[6]) / LM35_ONE_DEGREE, p[8], p[9], p[10], p[11]);
+	fflush(stdout); /*keep the output live when reading from a device*/
+	return TRUE;
+}
+
+int main(int argc, char * argv[])
+{
+	FRAME_StatsType stats;
+	const char * path = "-";
+	uint32 baudRate = 9600;
+	int fd = 0, option = 0;
+
+	while((option = getopt(argc, argv, "b:")) != -1)
+	{
+		if(option == 'b')
+		{
+			baudRate = strtoul(optarg, NULL_PTR, 10);
+		}
+		else
+		{
+			fprintf(stderr, "usage: %s [-b baud] [device | file | -]\n", argv[0]);
+			return 2;
+		}
+	}
+	if(optind < argc)
+	{
+		path = argv[optind];
+	}
+
+	fd = FRAME_open(path, baudRate);
+	if(fd < 0)
+	{
+		perror(path);
+		return 1;
+	}
+
+	printf("sequence,timestamp_ms,adc,temperature,duty,fan_state,adc_error,motor_error\n");
+	FRAME_read(fd, DECODER_onFrame, NULL_PTR, &stats);
+
+	fprintf(stderr, "frames: %lu, crc errors: %lu, framing errors: %lu, lost frames: %lu\n",
+			(unsigned long)stats.frames, (unsigned long)stats.crcErrors,
+			(unsigned long)stats.cobsErrors, (unsigned long)stats.sequenceGaps);
+	return 0;
+}
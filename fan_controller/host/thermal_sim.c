@@ -0,0 +1,165 @@
+/*
+ *
+ * Module: Host - Closed loop simulation
+ *
+ * File Name: thermal_sim.c
+ *
+ * Description: Run the unmodified firmware against the thermal model of plant.h.
+ * The model temperature is fed to the LM35 input of the simulated ADC and the
+ * fan duty is read back from OC0 and the motor pins, the loop moves in steps of
+ * virtual time so a day of control runs in seconds.
+ *
+ * The scenario is the day of plant.h: a device in a room with a daily ambient
+ * and load profile.
+ *
+ * Usage: thermal_sim [-c] [-t hours] [-s step_ms] [-l limit] [-e eeprom.bin]
+ * 	-c	print a CSV line every virtual minute
+ * 	-t	simulated time, 24 hours by default
+ * 	-s	step of the plant update, 100ms by default
+ * 	-l	fail (exit code 1) if the temperature goes over this limit, 95C by default
+ * 	-e	EEPROM image, loaded at start and saved at exit
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"port/mcu.h"
+#include"plant.h"
+#include"../lm35.h"
+#include"../gpio.h"
+#include"../dcMotor.h"
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<time.h>
+#include<unistd.h>
+
+#define SIM_CSV_PERIOD			60.0
+
+int FIRMWARE_main(void);
+
+/*
+ * Description:
+ * Duty seen by the fan, the PWM only reaches it when the motor pins select a direction
+ * */
+static float64 SIM_getFanDuty(void)
+{
+	uint8 pin1 = MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN1);
+	uint8 pin2 = MCU_getPinOutput(DC_MOTOR_PORT, DC_MOTOR_PIN2);
+	if(pin1 == 0xFF || pin2 == 0xFF || pin1 == pin2)
+	{
+		return 0.0;
+	}
+	return MCU_getPwmDuty();
+}
+
+static float64 SIM_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (float64)now.tv_sec + ((float64)now.tv_nsec / 1e9);
+}
+
+int main(int argc, char * argv[])
+{
+	PLANT_Type plant;
+	uint8 csv = FALSE;
+	uint32 stepMs = 100;
+	float64 hours = 24, limit = 95, seconds = 0, nextCsv = 0, step = 0,
+			duty = 0, power = 0, ambient = 0, start = 0,
+			minimum = 1000, maximum = -1000, sum = 0, dutySum = 0, overLimit = 0;
+	uint64 steps = 0;
+	const char * eepromPath = NULL_PTR;
+	FILE * file = NULL_PTR;
+	int option = 0;
+
+	while((option = getopt(argc, argv, "ct:s:l:e:")) != -1)
+	{
+		switch(option)
+		{
+		case 'c':
+			csv = TRUE;
+			break;
+		case 't':
+			hours = strtod(optarg, NULL_PTR);
+			break;
+		case 's':
+			stepMs = (uint32)strtoul(optarg, NULL_PTR, 10);
+			break;
+		case 'l':
+			limit = strtod(optarg, NULL_PTR);
+			break;
+		case 'e':
+			eepromPath = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-c] [-t hours] [-s step_ms] [-l limit] [-e eeprom.bin]\n", argv[0]);
+			return 2;
+		}
+	}
+	if(stepMs == 0 || hours <= 0)
+	{
+		fprintf(stderr, "%s: the step and the time must be positive\n", argv[0]);
+		return 2;
+	}
+	step = stepMs / 1000.0;
+
+	MCU_init();
+	if(eepromPath != NULL_PTR && (file = fopen(eepromPath, "rb")) != NULL_PTR)
+	{
+		if(fread(MCU_getEeprom(), 1, MCU_EEPROM_SIZE, file) != MCU_EEPROM_SIZE)
+		{
+			fprintf(stderr, "%s: short EEPROM image\n", eepromPath);
+		}
+		fclose(file);
+	}
+	PLANT_init(&plant, PLANT_getDayAmbient(0));
+	MCU_start(FIRMWARE_main);
+	if(csv)
+	{
+		printf("seconds,ambient,power,temperature,duty\n");
+	}
+
+	start = SIM_now();
+	while(seconds < hours * PLANT_SECONDS_PER_HOUR)
+	{
+		MCU_setAdcVoltage(LM35_CHANNEL, plant.temperature * LM35_V_PER_DEGREE);
+		if(!MCU_run((uint64)stepMs * MCU_CYCLES_PER_MS))
+		{
+			break; /*main returned*/
+		}
+		/*the duty applied during the step is the one set at its end, the sample period is shorter than the plant*/
+		duty = SIM_getFanDuty();
+		power = PLANT_getDayLoad(seconds);
+		ambient = PLANT_getDayAmbient(seconds);
+		PLANT_step(&plant, power, ambient, duty, step);
+		seconds += step;
+		steps++;
+
+		minimum = fmin(minimum, plant.temperature);
+		maximum = fmax(maximum, plant.temperature);
+		sum += plant.temperature;
+		dutySum += duty;
+		if(plant.temperature > limit)
+		{
+			overLimit += step;
+		}
+		if(csv && seconds >= nextCsv)
+		{
+			nextCsv += SIM_CSV_PERIOD;
+			printf("%.0f,%.2f,%.1f,%.2f,%.3f\n", seconds, ambient, power, plant.temperature, duty);
+		}
+	}
+
+	fprintf(stderr, "simulated %.1f h in %.2f s\n", seconds / PLANT_SECONDS_PER_HOUR, SIM_now() - start);
+	fprintf(stderr, "temperature min %.2f max %.2f mean %.2f, %.0f s over %.1f\n",
+			minimum, maximum, sum / (float64)steps, overLimit, limit);
+	fprintf(stderr, "fan duty mean %.3f\n", dutySum / (float64)steps);
+
+	if(eepromPath != NULL_PTR && (file = fopen(eepromPath, "wb")) != NULL_PTR)
+	{
+		fwrite(MCU_getEeprom(), 1, MCU_EEPROM_SIZE, file);
+		fclose(file);
+	}
+	return overLimit > 0;
+}
@@ -0,0 +1,193 @@
+/*
+ *
+ * Module: Host - Trace decoder
+ *
+ * File Name: trace_decoder.c
+ *
+ * Description: Convert a "get trace" dump (see trace.h) to the Chrome trace JSON
+ * format, it opens in chrome://tracing and https://ui.perfetto.dev.
+ * The ISR events are on the "isr" thread and the main loop ones on "main".
+ * The 16-bit timestamps are unwrapped, so two events must be less than
+ * 65536 counts (524ms at 1MHz) apart. With -r the "get trace" command is sent first.
+ *
+ * Usage: trace_decoder [-b baud] [-f cpu_hz] [-r] device|capture|- > trace.json
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"frame.h"
+#define TRACE_ENABLED	1
+#include"../trace.h"
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+
+#define TRACE_DECODER_IDS		(TRACE_ID_MASK + 1)
+#define TRACE_DECODER_MAIN_TID	1
+#define TRACE_DECODER_ISR_TID	2
+
+typedef struct
+{
+	float64 microsecondsPerCount;
+	uint64 time; /*unwrapped timestamp of the last record*/
+	uint16 lastTimestamp;
+	uint8 started;
+	uint8 depth[TRACE_DECODER_IDS]; /*open begin events, an end without begin is dropped*/
+	uint32 events;
+	uint32 errors;
+}TRACE_DECODER_ContextType;
+
+static const char * TRACE_DECODER_getName(uint8 a_id)
+{
+	switch(a_id)
+	{
+	case TRACE_ADC_ISR:
+		return "ADC_vect";
+	case TRACE_UART_RX_ISR:
+		return "USART_RXC_vect";
+	case TRACE_UART_TX_IDLE:
+		return "uart tx idle";
+	case TRACE_EEPROM_ISR:
+		return "EE_RDY_vect";
+	case TRACE_SAMPLE:
+		return "sample";
+	case TRACE_SENSOR:
+		return "sensor";
+	case TRACE_MOTOR:
+		return "motor";
+	case TRACE_COMMAND:
+		return "command";
+	case TRACE_TELEMETRY_FRAME:
+		return "telemetry frame";
+	case TRACE_NVM_SAVE:
+		return "nvm save";
+	case TRACE_SENSOR_FAULT:
+		return "sensor fault";
+	default:
+		return "unknown";
+	}
+}
+
+static void TRACE_DECODER_printRecord(TRACE_DECODER_ContextType * a_context, const uint8 * a_record)
+{
+	uint8 id = a_record[0] & TRACE_ID_MASK, flags = a_record[0] & TRACE_FLAGS_MASK;
+	uint16 timestamp = FRAME_getUint16(&a_record[1]);
+	const char * phase = "i";
+
+	if(a_context->started)
+	{
+		a_context->time += (uint16)(timestamp - a_context->lastTimestamp);
+	}
+	a_context->started = TRUE;
+	a_context->lastTimestamp = timestamp;
+
+	if(flags == TRACE_FLAG_BEGIN)
+	{
+		phase = "B";
+		a_context->depth[id]++;
+	}
+	else if(flags == TRACE_FLAG_END)
+	{
+		if(a_context->depth[id] == 0)
+		{
+			return; /*its begin was overwritten in the ring*/
+		}
+		phase = "E";
+		a_context->depth[id]--;
+	}
+	else if(flags != TRACE_FLAG_INSTANT)
+	{
+		a_context->errors++;
+		return;
+	}
+
+	printf(",\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.0f,\"pid\":1,\"tid\":%d,%s\"args\":{\"arg\":%u}}",
+			TRACE_DECODER_getName(id), phase, (float64)a_context->time * a_context->microsecondsPerCount,
+			id < TRACE_FIRST_TASK_ID ? TRACE_DECODER_ISR_TID : TRACE_DECODER_MAIN_TID,
+			flags == TRACE_FLAG_INSTANT ? "\"s\":\"t\"," : "", FRAME_getUint16(&a_record[3]));
+	a_context->events++;
+}
+
+static uint8 TRACE_DECODER_onFrame(const FRAME_Type * a_frame, void * a_context)
+{
+	TRACE_DECODER_ContextType * context = a_context;
+	uint8 i = 0;
+
+	if(a_frame->type != TELEMETRY_FRAME_TRACE)
+	{
+		return TRUE; /*samples and responses are mixed with the dump*/
+	}
+	if(a_frame->length < 2 || (a_frame->length - 2) % TRACE_RECORD_SIZE != 0
+			|| a_frame->payload[0] >= a_frame->payload[1])
+	{
+		context->errors++;
+		return TRUE;
+	}
+	for(i = 2; i < a_frame->length; i += TRACE_RECORD_SIZE)
+	{
+		TRACE_DECODER_printRecord(context, &a_frame->payload[i]);
+	}
+	/*the last frame ends the dump*/
+	return a_frame->payload[0] + 1 != a_frame->payload[1];
+}
+
+int main(int argc, char * argv[])
+{
+	TRACE_DECODER_ContextType context = {0};
+	FRAME_StatsType stats = {0, 0, 0, 0};
+	uint32 baudRate = 9600;
+	float64 frequency = 1000000;
+	uint8 request = FALSE;
+	int fd = 0, option = 0;
+
+	while((option = getopt(argc, argv, "b:f:r")) != -1)
+	{
+		if(option == 'b')
+		{
+			baudRate = strtoul(optarg, NULL_PTR, 10);
+		}
+		else if(option == 'f')
+		{
+			frequency = strtod(optarg, NULL_PTR);
+		}
+		else if(option == 'r')
+		{
+			request = TRUE;
+		}
+		else
+		{
+			break;
+		}
+	}
+	if(argc - optind != 1 || frequency <= 0)
+	{
+		fprintf(stderr, "usage: %s [-b baud] [-f cpu_hz] [-r] device|capture|- > trace.json\n", argv[0]);
+		return 2;
+	}
+	context.microsecondsPerCount = TIMER_TIMESTAMP_PRESCALER * 1e6 / frequency;
+
+	fd = FRAME_open(argv[optind], baudRate);
+	if(fd < 0)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+	if(request && write(fd, "get trace\n", 10) != 10)
+	{
+		fprintf(stderr, "trace_decoder: can not send the command\n");
+		return 1;
+	}
+
+	printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"main\"}},\n",
+			TRACE_DECODER_MAIN_TID);
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"isr\"}}",
+			TRACE_DECODER_ISR_TID);
+	FRAME_read(fd, TRACE_DECODER_onFrame, &context, &stats);
+	printf("\n]}\n");
+	fprintf(stderr, "events: %lu, decode errors: %lu, crc errors: %lu, lost frames: %lu\n",
+			(unsigned long)context.events, (unsigned long)context.errors,
+			(unsigned long)stats.crcErrors, (unsigned long)stats.sequenceGaps);
+	return context.errors != 0 || stats.crcErrors != 0;
+}
@@ -161,12 +161,19 @@ void LCD_displayString(const char *Str)
 
 /*
  * Description :
- * Move the cursor to a specified row and column index on the screen
+ * Move the cursor to a specified row and column index on the screen,
+ * a position out of the screen is recorded as LCD_ERROR_POSITION and ignored
  */
 void LCD_moveCursor(uint8 row,uint8 col)
 {
 	uint8 lcd_memory_address;
 	
+	if((row >= LCD_ROWS) || (col >= LCD_COLUMNS))
+	{
+		ERROR_record(LCD_ERROR_POSITION);
+		return;
+	}
+
 	/* Calculate the required address in the LCD DDRAM */
 	switch(row)
 	{
@@ -180,6 +187,7 @@ void LCD_moveCursor(uint8 row,uint8 col)
 			lcd_memory_address=col+0x10;
 				break;
 		case 3:
+		default:
 			lcd_memory_address=col+0x50;
 				break;
 	}					
@@ -16,6 +16,7 @@
 #define LCD_H_
 
 #include "std_types.h"
+#include "error.h"
 
 /*******************************************************************************
  *                                Definitions                                  *
@@ -32,7 +33,7 @@
 
 /* LCD HW Ports and Pins Ids */
 #define LCD_RS_PORT_ID                 PORTD_ID
-#define LCD_RS_PIN_ID                  PIN0_ID
+#define LCD_RS_PIN_ID                  PIN3_ID /* PD0 is the UART RXD pin */
 
 #define LCD_E_PORT_ID                  PORTD_ID
 #define LCD_E_PIN_ID                   PIN2_ID
@@ -59,6 +60,13 @@
 #define LCD_CURSOR_ON                        0x0E
 #define LCD_SET_CURSOR_LOCATION              0x80
 
+/* LCD size, 2 rows of 16 characters */
+#define LCD_ROWS                             2
+#define LCD_COLUMNS                          16
+
+/* LCD Errors, see error.h */
+#define LCD_ERROR_POSITION                   ERROR_CODE(ERROR_MODULE_LCD, 1)
+
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
@@ -91,7 +99,8 @@ void LCD_displayString(const char *Str);
 
 /*
  * Description :
- * Move the cursor to a specified row and column index on the screen
+ * Move the cursor to a specified row and column index on the screen,
+ * a position out of the screen is recorded as LCD_ERROR_POSITION and ignored
  */
 void LCD_moveCursor(uint8 row,uint8 col);
 
@@ -12,6 +12,18 @@
 #include"lm35.h"
 #include"adc.h"
 
+/*1/64C per single ended code and per 10x differential code at the nominal ADC_VREF*/
+#define LM35_NOMINAL_SCALE		((uint32)((float64)ADC_VREF / ADC_MAX / LM35_V_PER_DEGREE * LM35_ONE_DEGREE \
+		* (1UL << LM35_SCALE_BITS) + 0.5))
+#define LM35_NOMINAL_FINE_SCALE	((uint32)((float64)ADC_VREF / ((ADC_DIFFERENTIAL_MAX + 1) * 10) / LM35_V_PER_DEGREE \
+		* LM35_ONE_DEGREE * (1UL << LM35_SCALE_BITS) + 0.5))
+
+/*Global Variables */
+static uint16 LM35_g_lastDigitalValue = 0;
+static uint16 LM35_g_reference = 0; /*code of the ground pin*/
+static uint8 LM35_g_lastError = ADC_SUCCESS;
+static uint32 LM35_g_scale = LM35_NOMINAL_SCALE;
+static uint32 LM35_g_fineScale = LM35_NOMINAL_FINE_SCALE;
 
 /*
  * Description:
@@ -26,20 +38,153 @@ void LM35_init(void)
 
 /*
  * Description:
- * The function will read an ADC channel for LM35 temperature sensor.
+ * The function will read the LM35 and its reference.
  * Returns the temperature read by the sensor
  * possible return values :
- * a number from LM35_MIN_DEGREE -> LM35_MAX_DEGREE
+ * -(ground pin code) / 4C -> LM35_FROM_DEGREES(LM35_MAX_DEGREE)
+ * */
+LM35_TemperatureType LM35_getTemperature(void)
+{
+	/*Read the ADC value then calculate the temperature */
+	return LM35_toTemperature(LM35_read());
+}
+
+/*
+ * Description:
+ * The function will read the ADC channel of the LM35 without converting it,
+ * for the callers that filter the codes first. The reference is read with it.
+ * Returns the raw ADC code, also kept for LM35_getLastDigitalValue
+ * */
+uint16 LM35_read(void)
+{
+	uint16 digitalValue = 0, reference = 0;
+	uint8 adcDoneFlag = 0;
+	LM35_g_lastError = ADC_readChannelPolling(LM35_CHANNEL,&adcDoneFlag, &digitalValue );
+	if(LM35_g_lastError == ADC_SUCCESS)
+	{
+		/*a failed reference is an error of the reading too, the old one may not be used*/
+		LM35_g_lastError = ADC_readChannelPolling(LM35_REFERENCE_CHANNEL, &adcDoneFlag, &reference);
+	}
+	if(LM35_g_lastError == ADC_SUCCESS)
+	{
+		LM35_g_reference = reference;
+	}
+	LM35_g_lastDigitalValue = digitalValue;
+	return digitalValue;
+}
+
+/*
+ * Description:
+ * Converts a raw ADC code of the LM35 channel to a temperature against the code
+ * of the reference of the last LM35_read, 0 before the first one so the host tools
+ * can use the same conversion.
+ * */
+LM35_TemperatureType LM35_toTemperature(uint16 a_digitalValue)
+{
+	return LM35_toFixed((sint16)a_digitalValue - (sint16)LM35_g_reference);
+}
+
+/*
+ * Description:
+ * Converts a signed difference of single ended codes to a temperature,
+ * it has no side effect. Saturates at LM35_MAX_DEGREE.
+ * */
+LM35_TemperatureType LM35_toFixed(sint16 a_codes)
+{
+	/*at most 1023 * 1.2M, it fits in 32 bits*/
+	sint32 temperature = ((sint32)a_codes * (sint32)LM35_g_scale) >> LM35_SCALE_BITS;
+	/*nothing above the end of the range is measured, a lower ground only gives more codes*/
+	return temperature >= LM35_FROM_DEGREES(LM35_MAX_DEGREE) ? LM35_FROM_DEGREES(LM35_MAX_DEGREE)
+			: (LM35_TemperatureType)temperature;
+}
+
+/*
+ * Description:
+ * Reads the difference of the output and the reference at 10x gain.
+ * Returns FALSE if the ADC failed or the difference is out of the 10x range,
+ * a_temperature is not changed then
+ * */
+uint8 LM35_readFine(LM35_TemperatureType * a_temperature)
+{
+	uint16 code = 0;
+
+	if(!LM35_readFineCode(&code))
+	{
+		return FALSE;
+	}
+	*a_temperature = LM35_fineToTemperature(code);
+	return TRUE;
+}
+
+/*
+ * Description:
+ * Reads the difference of the output and the reference at 10x gain without
+ * converting it, for the callers that filter the codes first. The code is the
+ * difference plus LM35_FINE_ZERO_CODE so the filters of the single ended codes take it.
+ * Returns FALSE if the ADC failed or the difference is out of the 10x range,
+ * a_code is not changed then
  * */
-uint8 LM35_getTemperature(void)
+uint8 LM35_readFineCode(uint16 * a_code)
 {
-	/*Read the ADC value*/
-	uint16 digitalValue = 0;
-	uint8 temperature = 0, adcDoneFlag = 0;
-	ADC_readChannelPolling(LM35_CHANNEL,&adcDoneFlag, &digitalValue );
+	sint16 difference = 0;
 
-	/*Calculate the temperature */
-	temperature = (uint8)((float32)digitalValue  * ((float32)ADC_VREF / ADC_MAX) / (LM35_V_PER_DEGREE));
-	/*Return the value */
-	return temperature;
+	if(ADC_readDifferentialPolling(LM35_CHANNEL, LM35_REFERENCE_CHANNEL, ADC_GAIN_10X, &difference) != ADC_SUCCESS
+			|| difference <= ADC_DIFFERENTIAL_MIN || difference >= ADC_DIFFERENTIAL_MAX)
+	{
+		return FALSE;/*a saturated code is only a bound*/
+	}
+	*a_code = (uint16)(difference + LM35_FINE_ZERO_CODE);
+	return TRUE;
+}
+
+/*
+ * Description:
+ * Converts a code of LM35_readFineCode to a temperature, it has no side effect.
+ * */
+LM35_TemperatureType LM35_fineToTemperature(uint16 a_code)
+{
+	/*VREF / (512 * 10) per code, 0.05C*/
+	return (LM35_TemperatureType)((((sint32)a_code - LM35_FINE_ZERO_CODE) * (sint32)LM35_g_fineScale)
+			>> LM35_SCALE_BITS);
+}
+
+/*
+ * Description:
+ * Sets the correction of the reference measured by vref.h, the conversions
+ * use it from now on with one multiply and shift per code.
+ * LM35_VREF_ONE is the nominal ADC_VREF, the one used before the first call.
+ * */
+void LM35_setVrefFactor(uint16 a_factor)
+{
+	LM35_g_scale = (uint32)(((uint64)LM35_NOMINAL_SCALE * a_factor) >> LM35_VREF_FACTOR_BITS);
+	LM35_g_fineScale = (uint32)(((uint64)LM35_NOMINAL_FINE_SCALE * a_factor) >> LM35_VREF_FACTOR_BITS);
+}
+
+/*
+ * Description:
+ * Returns the raw ADC code of the last LM35_getTemperature call.
+ * */
+uint16 LM35_getLastDigitalValue(void)
+{
+	return LM35_g_lastDigitalValue;
+}
+
+/*
+ * Description:
+ * Returns the raw ADC code of the reference of the last LM35_read call.
+ * */
+uint16 LM35_getReference(void)
+{
+	return LM35_g_reference;
+}
+
+/*
+ * Description:
+ * Returns the ADC error of the last LM35_getTemperature call, of the output or of its reference.
+ * possible return values :
+ * ADC_SUCCESS or one of the ADC error codes
+ * */
+uint8 LM35_getLastError(void)
+{
+	return LM35_g_lastError;
 }
@@ -5,6 +5,20 @@
  *
  * Description: Header file of the lm35 temperature module
  *
+ * The ground pin of the LM35 is lifted by two diodes so its output can go below it
+ * under 0C, the output is on LM35_CHANNEL and the ground pin on LM35_REFERENCE_CHANNEL,
+ * the offset reference. The temperature is the difference of the two:
+ *
+ * 	T = (V(ADC3) - V(ADC2)) / 10mV
+ *
+ * in a signed fixed point LM35_TemperatureType with LM35_FRACTION_BITS bits of fraction.
+ *
+ * The raw code of LM35_read is the single ended code of the output, the sensor checks,
+ * the filter and the prediction work on it, LM35_toTemperature subtracts the code
+ * of the reference read with it (0.25C per code). In a window around the reference
+ * the difference can also be read at 10x gain by LM35_readFine, 0.05C per code up
+ * to +/-25.6C from the ground pin.
+ *
  * Layer: Hardware Abstraction Layer (HAL)
  *
  * Author: Abdullah Mahmoud
@@ -15,10 +29,30 @@
 
 #include"std_types.h"
 
-#define LM35_CHANNEL		2
-#define LM35_MV_PER_DEGREE	10
-#define LM35_V_PER_DEGREE	((float32) LM35_MV_PER_DEGREE / 1000)
+#define LM35_CHANNEL			3 /*output of the sensor*/
+#define LM35_REFERENCE_CHANNEL	2 /*ground pin of the sensor, the offset reference*/
+#define LM35_MV_PER_DEGREE		10
+#define LM35_V_PER_DEGREE		((float32) LM35_MV_PER_DEGREE / 1000)
+#define LM35_MIN_DEGREE			(-55)
+#define LM35_GROUND_VOLTS		1.2 /*two diodes under the ground pin*/
+#define LM35_MAX_DEGREE			136 /*(2.56V - LM35_GROUND_VOLTS) / 10mV, the end of the ADC range*/
+
+/*Signed fixed point temperature*/
+#define LM35_FRACTION_BITS		6 /*1/64C, below the 0.05C of the fine reading*/
+#define LM35_ONE_DEGREE			(1 << LM35_FRACTION_BITS)
+#define LM35_FROM_DEGREES(degrees)	((LM35_TemperatureType)((degrees) * LM35_ONE_DEGREE))
+#define LM35_TO_DEGREES(temperature)	((sint16)((temperature) >> LM35_FRACTION_BITS)) /*rounded down, also below 0*/
+
+/*Fine reading, ADC3 - ADC2 at 10x*/
+#define LM35_FINE_LIMIT			25 /*C from the reference, the 10x range is +/-25.6C*/
+#define LM35_FINE_ZERO_CODE		512 /*fine code of a zero difference, the codes are 1 -> 1022*/
 
+/*Calibration of the reference, the real VREF is ADC_VREF * factor / LM35_VREF_ONE*/
+#define LM35_VREF_FACTOR_BITS	14
+#define LM35_VREF_ONE			(1U << LM35_VREF_FACTOR_BITS)
+#define LM35_SCALE_BITS			16 /*fraction bits of the 1/64C per code scales*/
+
+typedef sint16 LM35_TemperatureType;
 
 /*
  * Description:
@@ -28,11 +62,85 @@ void LM35_init(void);
 
 /*
  * Description:
- * The function will read an ADC channel for LM35 temperature sensor.
+ * The function will read the LM35 and its reference.
  * Returns the temperature read by the sensor
  * possible return values :
- * a number from LM35_MIN_DEGREE -> LM35_MAX_DEGREE
+ * -(ground pin code) / 4C -> LM35_FROM_DEGREES(LM35_MAX_DEGREE)
+ * */
+LM35_TemperatureType LM35_getTemperature(void);
+
+/*
+ * Description:
+ * The function will read the ADC channel of the LM35 without converting it,
+ * for the callers that filter the codes first. The reference is read with it.
+ * Returns the raw ADC code, also kept for LM35_getLastDigitalValue
+ * */
+uint16 LM35_read(void);
+
+/*
+ * Description:
+ * Converts a raw ADC code of the LM35 channel to a temperature against the code
+ * of the reference of the last LM35_read, 0 before the first one so the host tools
+ * can use the same conversion.
+ * */
+LM35_TemperatureType LM35_toTemperature(uint16 a_digitalValue);
+
+/*
+ * Description:
+ * Converts a signed difference of single ended codes to a temperature,
+ * it has no side effect. Saturates at LM35_MAX_DEGREE.
+ * */
+LM35_TemperatureType LM35_toFixed(sint16 a_codes);
+
+/*
+ * Description:
+ * Reads the difference of the output and the reference at 10x gain.
+ * Returns FALSE if the ADC failed or the difference is out of the 10x range,
+ * a_temperature is not changed then
+ * */
+uint8 LM35_readFine(LM35_TemperatureType * a_temperature);
+
+/*
+ * Description:
+ * Reads the difference of the output and the reference at 10x gain without
+ * converting it, for the callers that filter the codes first. The code is the
+ * difference plus LM35_FINE_ZERO_CODE so the filters of the single ended codes take it.
+ * Returns FALSE if the ADC failed or the difference is out of the 10x range,
+ * a_code is not changed then
+ * */
+uint8 LM35_readFineCode(uint16 * a_code);
+
+/*
+ * Description:
+ * Converts a code of LM35_readFineCode to a temperature, it has no side effect.
+ * */
+LM35_TemperatureType LM35_fineToTemperature(uint16 a_code);
+
+/*
+ * Description:
+ * Sets the correction of the reference measured by vref.h, the conversions
+ * use it from now on with one multiply and shift per code.
+ * LM35_VREF_ONE is the nominal ADC_VREF, the one used before the first call.
+ * */
+void LM35_setVrefFactor(uint16 a_factor);
+/*
+ * Description:
+ * Returns the raw ADC code of the last LM35_getTemperature call.
+ * */
+uint16 LM35_getLastDigitalValue(void);
+
+/*
+ * Description:
+ * Returns the raw ADC code of the reference of the last LM35_read call.
+ * */
+uint16 LM35_getReference(void);
+
+/*
+ * Description:
+ * Returns the ADC error of the last LM35_getTemperature call, of the output or of its reference.
+ * possible return values :
+ * ADC_SUCCESS or one of the ADC error codes
  * */
-uint8 LM35_getTemperature(void);
+uint8 LM35_getLastError(void);
 
 #endif
@@ -14,21 +14,45 @@
 
 
 #include"main.h"
+#include<avr/sleep.h>
 
 /*
  * @brief initializes the application and it required modules
  * */
 void MAIN_init(void)
 {
+	UART_configType uartConfig = {UART_DEFAULT_BAUD_RATE};
+	uint8 duty = 0;
 
+	WATCHDOG_init();/*Count the reset causes and stop a watchdog left running*/
+	ERROR_init();/*Clear the error log before any driver can record*/
+	CONFIG_init();/*Load the default configuration*/
+	NVM_init();/*Replace it by the saved one if there is one*/
+	TIMER_init();/*System tick init*/
+	UART_init(&uartConfig);/*Telemetry and command link init*/
+	TELEMETRY_init(CONFIG_get()->telemetryPeriod);
+	COMMAND_init();
+	HISTORY_init();/*Continue the saved summaries*/
+	ENERGY_init();/*Continue the saved energy counters*/
+	PROBE_INIT();/*Loop latency probes, empty unless PROBE_ENABLED*/
+	TRACE_INIT();/*Event trace, empty unless TRACE_ENABLED*/
+	SRAM_INIT();/*Stack high-water mark, the free RAM was painted before main*/
 	LM35_init();/*Temperature sensor init*/
+	DC_MOTOR_Init();/*Fan motor init, after the ADC for its current sensing*/
+	if(WATCHDOG_getRecoveryDuty(&duty) && duty != 0)
+	{
+		/*the fan is still turning after the reset, back to its speed without a kick-start,
+		 * MAIN_applyConfig sets the boost again on the first pass of the loop*/
+		DC_MOTOR_setBoost(0, 0);
+		DC_MOTOR_Rotate(CONFIG_get()->direction, duty);
+	}
+	VREF_init();/*Correct the conversions by the saved or measured reference*/
+	SENSOR_init();/*Sensor fault detection init*/
 	LCD_init();/*LCD init*/
-	DC_MOTOR_Init();/*Fan motor init*/
+	WATCHDOG_start();/*Supervise the control loop from now on*/
 
-	/*initial messages on the screen*/
+	/*initial message on the screen, the second row depends on the display mode*/
 	LCD_displayString("Fan is ");
-	LCD_moveCursor(1,0);
-	LCD_displayString("Temp is ");
 }
 
 /*
@@ -47,12 +71,16 @@ void MAIN_displayFanMessage(uint8 a_fanState, uint8 *a_oldFanState)
 		return;
 	}
 	*a_oldFanState = a_fanState;
-	LCD_displayStringRowColumn(0,7,"   ");/*clear the LCD current fan state*/
+	LCD_displayStringRowColumn(0,7,"     ");/*clear the LCD current fan state*/
 	LCD_moveCursor(0,7); /*back to the correct position to write the new state */
 	if(a_fanState == FAN_OFF)
 	{
 		LCD_displayString("OFF");/*Off state*/
 	}
+	else if(a_fanState == FAN_STALL)
+	{
+		LCD_displayString("STALL");/*on but the motor is stalled*/
+	}
 	else
 	{
 		LCD_displayString("ON ");/*on state*/
@@ -65,21 +93,123 @@ void MAIN_displayFanMessage(uint8 a_fanState, uint8 *a_oldFanState)
  * @brief this function will display the temperature on the LCD screen
  * assuming the LCD was initialized properly.
  *
- * @param uint8 a_temprature indicate the new number
+ * @param LM35_TemperatureType a_temprature indicate the new temperature, shown in whole degrees
+ *
+ * @param sint16* a_oldTemp apointer indicate the old(on the display) number
+ * */
+void MAIN_displayTemperatureMessage(LM35_TemperatureType a_temprature, sint16* a_oldTemp)
+{
+	sint16 degrees = LM35_TO_DEGREES(a_temprature);
+	if(degrees == *a_oldTemp)
+	{
+		/*if both numbers are equal then no need to update it */
+		return;
+	}
+	*a_oldTemp = degrees;
+	LCD_displayStringRowColumn(1,8,"   ");/*clear the old number, -55 fits*/
+	LCD_moveCursor(1,8);
+	LCD_intgerToString(degrees);/*Write the new number*/
+}
+
+/*
+ * @brief this function will display the fan duty on the LCD screen
+ * assuming the LCD was initialized properly.
+ *
+ * @param uint8 a_duty indicate the new duty in percent
  *
- * @param uint8* a_oldTemp apointer indicate the old(on the display) number
+ * @param sint16* a_oldDuty a pointer indicate the old(on the display) duty
  * */
-void MAIN_displayTemperatureMessage(uint8 a_temprature, uint8* a_oldTemp)
+void MAIN_displayDutyMessage(uint8 a_duty, sint16* a_oldDuty)
 {
-	if(a_temprature == *a_oldTemp)
+	if(a_duty == *a_oldDuty)
 	{
 		/*if both numbers are equal then no need to update it */
 		return;
 	}
-	*a_oldTemp = a_temprature;
-	LCD_displayStringRowColumn(1,8,"   ");/*clear the old number*/
+	*a_oldDuty = a_duty;
+	LCD_displayStringRowColumn(1,8,"    ");/*clear the old number*/
 	LCD_moveCursor(1,8);
-	LCD_intgerToString(a_temprature);/*Write the new number*/
+	LCD_intgerToString(a_duty);/*Write the new number*/
+	LCD_displayCharacter('%');
+}
+
+/*
+ * @brief this function will find the fan speed of a temperature
+ * from the fan curve
+ *
+ * @param const CONFIG_CurveType* a_curve the fan curve
+ *
+ * @param LM35_TemperatureType a_temperature the read temperature
+ *
+ * @return uint8 the fan speed in percent, 0 if the fan should be off
+ * */
+uint8 MAIN_getFanSpeed(const CONFIG_CurveType * a_curve, LM35_TemperatureType a_temperature)
+{
+	uint8 i = CONFIG_CURVE_POINTS;
+	/*search from the hottest point, the temperatures are ascending*/
+	while(i > 0)
+	{
+		i--;
+		if(a_temperature >= LM35_FROM_DEGREES(a_curve->temperature[i]))
+		{
+			return a_curve->speed[i];
+		}
+	}
+	return 0;
+}
+
+/*
+ * @brief this function will convert the horizon of the predictive mode
+ * to a number of samples
+ *
+ * @param uint8 a_horizon the horizon in seconds
+ *
+ * @param uint16 a_samplePeriod the sample period in ms
+ *
+ * @return uint16 the horizon in samples
+ * */
+uint16 MAIN_getHorizonSamples(uint8 a_horizon, uint16 a_samplePeriod)
+{
+	return (uint16)(((uint32)a_horizon * 1000) / a_samplePeriod);
+}
+
+/*
+ * @brief this function will apply a changed runtime configuration
+ * to the modules and the display
+ *
+ * @param uint8* a_displayMode a pointer to the mode currently on the display
+ *
+ * @param sint16* a_lcdValue a pointer to the number currently on the display
+ *
+ * @param uint8* a_fanSpeed a pointer to the current fan speed
+ * */
+void MAIN_applyConfig(uint8* a_displayMode, sint16* a_lcdValue, uint8* a_fanSpeed)
+{
+	const CONFIG_Type * config = CONFIG_get();
+
+	PWM_setPrescaler(config->pwmPrescaler);
+	DC_MOTOR_setBoost(config->boostSpeed, config->boostTime);
+	TELEMETRY_setPeriod(config->telemetryPeriod);
+
+	if(*a_fanSpeed != 0)
+	{
+		/*re apply the speed on the next sample in case the direction changed*/
+		*a_fanSpeed = MAIN_NOT_DISPLAYED;
+	}
+
+	if(config->displayMode != *a_displayMode)
+	{
+		*a_displayMode = config->displayMode;
+		if(config->displayMode == CONFIG_DISPLAY_DUTY)
+		{
+			LCD_displayStringRowColumn(1,0,"Duty is     ");
+		}
+		else
+		{
+			LCD_displayStringRowColumn(1,0,"Temp is     ");
+		}
+		*a_lcdValue = MAIN_NOT_DISPLAYED_VALUE;/*the number has been cleared*/
+	}
 }
 
 /*
@@ -92,64 +222,253 @@ void MAIN_displayTemperatureMessage(uint8 a_temprature, uint8* a_oldTemp)
  * @param uint8* a_oldSpeed a pointer to the current fan speed
  *
  * @param uint8* a_fanStatus a pointer to the fanStatus
+ *
+ * @return uint8 the error code returned by DC_MOTOR_Rotate
  * */
-void MAIN_updateFanSpeed(uint8 a_newSpeed, uint8* a_oldSpeed, uint8* a_fanStatus)
+uint8 MAIN_updateFanSpeed(uint8 a_newSpeed, uint8* a_oldSpeed, uint8* a_fanStatus)
 {
+	DC_MOTOR_ErrorType response = DC_MOTOR_NO_ERROR;
 	if(a_newSpeed == *a_oldSpeed)
 	{
 		/*if the current fan speed is equal to the new read speed*/
 		/*then no need to re apply the same speed */
-		return;
+		return response;
 	}
 
 	/*if both speed are different*/
 	*a_oldSpeed = a_newSpeed;/*set the fan speed to the new read speed */
 
-	DC_MOTOR_Rotate(FAN_DIRECTION, a_newSpeed); /*apply the new speed to the motor*/
-	*a_fanStatus = FAN_ON;/*adjust the fan state*/
+	TRACE_BEGIN(TRACE_MOTOR, a_newSpeed);
+	response = DC_MOTOR_Rotate(CONFIG_get()->direction, a_newSpeed); /*apply the new speed to the motor*/
+	TRACE_END(TRACE_MOTOR, response);
+	if(*a_fanStatus != FAN_STALL)
+	{
+		*a_fanStatus = FAN_ON;/*adjust the fan state, a stall stays on the display until it clears*/
+	}
+	return response;
+}
+
+/*
+ * @brief this function will queue a telemetry sample frame with the
+ * current state of the controller, it never waits for the UART.
+ *
+ * @param LM35_TemperatureType a_temperature the last read temperature
+ *
+ * @param uint8 a_speed the current fan speed
+ *
+ * @param uint8 a_fanState the current fan state
+ *
+ * @param uint8 a_motorError the code returned by the last DC_MOTOR_Rotate call
+ * */
+void MAIN_sendTelemetry(LM35_TemperatureType a_temperature, uint8 a_speed, uint8 a_fanState, uint8 a_motorError)
+{
+	TELEMETRY_SampleType sample;
+	sample.timestamp = TIMER_getTicks();
+	sample.adcValue = LM35_getLastDigitalValue();
+	sample.temperature = a_temperature;
+	sample.duty = a_speed;
+	sample.fanState = a_fanState;
+	sample.adcError = LM35_getLastError();
+	sample.motorError = a_motorError;
+	TELEMETRY_sendSample(&sample);
+}
+
+/*
+ * @brief this function will force the fan to full speed on a sensor
+ * fault, it only touches the motor so the fan is on before anything
+ * else of the sample runs.
+ *
+ * @param MAIN_StateType* a_state the state of the controller between samples
+ * */
+void MAIN_failsafe(MAIN_StateType * a_state)
+{
+	if(a_state->fanSpeed != DC_MOTOR_MAX_SPEED)
+	{
+		a_state->fanSpeed = DC_MOTOR_MAX_SPEED;
+		a_state->motorError = DC_MOTOR_Rotate(CONFIG_get()->direction, DC_MOTOR_MAX_SPEED);
+	}
+}
+
+/*
+ * @brief this function will display a sensor fault on the LCD screen
+ * in place of the temperature or the duty, assuming the LCD was
+ * initialized properly.
+ *
+ * @param uint8 a_fault the active SENSOR_FaultType
+ *
+ * @param MAIN_StateType* a_state the state of the controller between samples
+ * */
+void MAIN_displaySensorFault(uint8 a_fault, MAIN_StateType * a_state)
+{
+	MAIN_displayFanMessage(TRUE, &a_state->fanState);
+	if(a_fault == a_state->sensorFault && a_state->displayMode == MAIN_NOT_DISPLAYED)
+	{
+		/*the same fault is already on the display*/
+		return;
+	}
+	if(a_fault != a_state->sensorFault)
+	{
+		TRACE_EVENT(TRACE_SENSOR_FAULT, a_fault);
+	}
+	a_state->sensorFault = a_fault;
+	LCD_displayStringRowColumn(1,0,"Sensor       ");/*replace the label and the number*/
+	LCD_moveCursor(1,7);
+	LCD_displayString(SENSOR_getFaultName(a_fault));
+	a_state->displayMode = MAIN_NOT_DISPLAYED;/*the mode label has been overwritten*/
+}
+
+/*
+ * @brief this function will read the temperature once and apply it
+ * to the fan, the display, the history and the telemetry.
+ *
+ * @param MAIN_StateType* a_state the state of the controller between samples
+ * */
+void MAIN_sample(MAIN_StateType * a_state)
+{
+	uint8 newFanSpeed = 0;
+	LM35_TemperatureType controlTemperature = 0;
+	uint16 code = 0, fineCode = 0;
+	const CONFIG_Type * config = CONFIG_get();
+
+	PROBE_LAP(PROBE_PERIOD);
+	PROBE_START(PROBE_LATENCY);
+	PROBE_START(PROBE_FAILSAFE);
+	PROBE_START(PROBE_SENSOR);
+	TRACE_BEGIN(TRACE_SENSOR, 0);
+	code = LM35_read();/*Read the raw sensor code*/
+	TRACE_END(TRACE_SENSOR, code);
+	PROBE_STOP(PROBE_SENSOR);
+	if(SENSOR_check(code, LM35_getReference(), LM35_getLastError()) != SENSOR_OK)
+	{
+		/*Fast path, the fan goes to full speed before the filter, the display and the records*/
+		a_state->temperature = LM35_toTemperature(code);
+		MAIN_failsafe(a_state);
+		PROBE_STOP(PROBE_FAILSAFE);
+		MAIN_displaySensorFault(SENSOR_getFault(), a_state);
+		if(TELEMETRY_isDue())
+		{
+			MAIN_sendTelemetry(a_state->temperature, a_state->fanSpeed, a_state->fanState, a_state->motorError);
+		}
+		return;/*a faulty temperature is not kept in the history*/
+	}
+	if(a_state->sensorFault != SENSOR_OK)
+	{
+		/*the sensor recovered, back to the normal display and speed*/
+		TRACE_EVENT(TRACE_SENSOR_FAULT, SENSOR_OK);
+		a_state->sensorFault = SENSOR_OK;
+		a_state->displayMode = MAIN_NOT_DISPLAYED;
+		MAIN_applyConfig(&a_state->displayMode, &a_state->lcdValue, &a_state->fanSpeed);
+		FILTER_reset(&a_state->filter);/*the samples before the fault are stale*/
+		FILTER_reset(&a_state->fineFilter);
+		PREDICT_init(&a_state->predict);
+	}
+	PROBE_START(PROBE_FILTER);
+	FILTER_configure(&a_state->filter, CONFIG_get()->filterMedian, CONFIG_get()->filterShift);
+	code = FILTER_update(&a_state->filter, code);
+	a_state->temperature = LM35_toTemperature(code);
+	if(config->fineLow != config->fineHigh && a_state->temperature >= LM35_FROM_DEGREES(config->fineLow)
+			&& a_state->temperature <= LM35_FROM_DEGREES(config->fineHigh) && LM35_readFineCode(&fineCode))
+	{
+		/*inside the window the filtered 10x reading replaces the filtered one*/
+		FILTER_configure(&a_state->fineFilter, config->filterMedian, config->filterShift);
+		a_state->temperature = LM35_fineToTemperature(FILTER_update(&a_state->fineFilter, fineCode));
+	}
+	else
+	{
+		FILTER_reset(&a_state->fineFilter);/*its codes are stale when the window is entered again*/
+	}
+	PREDICT_update(&a_state->predict, code);/*the slope is kept even when the mode is off*/
+	PROBE_STOP(PROBE_FILTER);
+	PROBE_START(PROBE_ACTUATION);
+	if(a_state->displayMode == CONFIG_DISPLAY_TEMPERATURE)
+	{
+		MAIN_displayTemperatureMessage(a_state->temperature, &a_state->lcdValue); /*Display the temperature read*/
+	}
+	controlTemperature = a_state->temperature;
+	if(CONFIG_get()->predictHorizon != 0)
+	{
+		/*predictive mode, the fan follows the temperature projected over the horizon when it is higher,
+		 * the rise of the codes is added to the fine reading too*/
+		controlTemperature += LM35_toFixed((sint16)PREDICT_project(&a_state->predict,
+				MAIN_getHorizonSamples(CONFIG_get()->predictHorizon, CONFIG_get()->samplePeriod)) - (sint16)code);
+	}
+	/*adjust the new fan read based on the temperature*/
+	newFanSpeed = MAIN_getFanSpeed(&CONFIG_get()->curve, controlTemperature);
+	if(controlTemperature < LM35_FROM_DEGREES(CONFIG_get()->curve.temperature[0]))
+	{
+		MAIN_displayFanMessage(FALSE, &a_state->fanState);/*Turn off FAN*/
+		a_state->fanSpeed = 0; /*Set the current fan speed to 0*/
+		TRACE_BEGIN(TRACE_MOTOR, 0);
+		a_state->motorError = DC_MOTOR_Rotate(DC_MOTOR_STOP, 0);/*stopping the motor*/
+		TRACE_END(TRACE_MOTOR, a_state->motorError);
+	}
+	else
+	{
+		MAIN_displayFanMessage(DC_MOTOR_isStalled() ? FAN_STALL : FAN_ON, &a_state->fanState);/*Turn on FAN*/
+		a_state->motorError = MAIN_updateFanSpeed(newFanSpeed, &a_state->fanSpeed, &a_state->fanState);
+	}
+	PROBE_STOP(PROBE_ACTUATION);
+	PROBE_STOP(PROBE_LATENCY);
+	PROBE_START(PROBE_RECORD);
+	if(a_state->displayMode == CONFIG_DISPLAY_DUTY)
+	{
+		MAIN_displayDutyMessage(a_state->fanSpeed, &a_state->lcdValue); /*Display the applied duty*/
+	}
+	HISTORY_update(LM35_TO_DEGREES(a_state->temperature), a_state->fanSpeed);
+
+	if(TELEMETRY_isDue())
+	{
+		/*Only build the frame when it is time to send it*/
+		MAIN_sendTelemetry(a_state->temperature, a_state->fanSpeed, a_state->fanState, a_state->motorError);
+	}
+	PROBE_STOP(PROBE_RECORD);
 }
 
 int main(void)
 {
-	uint8 temperature = 0, fanState = FAN_INIT,
-			lcd_temparture = 0,
-			fanSpeed = 0, newFanSpeed = 0;
+	MAIN_StateType state = {0, FAN_INIT, MAIN_NOT_DISPLAYED_VALUE, MAIN_NOT_DISPLAYED, 0, 0, SENSOR_OK};
+	uint32 lastSample = 0;
 
 	MAIN_init();
 	
 	while(1)
 	{
-		temperature = LM35_getTemperature();/*Read the sensor temperature*/
-		MAIN_displayTemperatureMessage(temperature, &lcd_temparture); /*Display the temperature read*/
-		if(temperature < 30)
+		PROBE_START(PROBE_COMMAND);
+		COMMAND_process();/*Handle the received configuration commands*/
+		PROBE_STOP(PROBE_COMMAND);
+		WATCHDOG_checkIn(WATCHDOG_TASK_COMMAND);
+		if(CONFIG_isChanged())
 		{
-			MAIN_displayFanMessage(FALSE, &fanState);/*Turn off FAN*/
-			fanSpeed = 0; /*Set the current fan speed to 0*/
-			DC_MOTOR_Rotate(DC_MOTOR_STOP, 0);/*stopping the motor*/
+			MAIN_applyConfig(&state.displayMode, &state.lcdValue, &state.fanSpeed);
 		}
-		else
+		PROBE_START(PROBE_BACKGROUND);
+		NVM_process();/*Save a changed configuration in the background*/
+		HISTORY_process();/*Send the history dump and save the summaries in the background*/
+		ENERGY_process();/*Save the energy counters in the background*/
+		ERROR_process();/*Send the error log when it is asked for*/
+		VREF_process();/*Follow the reference with one bandgap conversion at a time*/
+		PROBE_PROCESS();/*Send the latency histograms when they are asked for*/
+		TRACE_PROCESS();/*Send the event trace when it is asked for*/
+		SRAM_PROCESS();/*Follow the stack high-water mark*/
+		WATCHDOG_process();/*Save the reset causes in the background*/
+		PROBE_STOP(PROBE_BACKGROUND);
+		WATCHDOG_checkIn(WATCHDOG_TASK_BACKGROUND);
+
+		if((uint32)(TIMER_getTicks() - lastSample) < CONFIG_get()->samplePeriod)
 		{
-			MAIN_displayFanMessage(TRUE, &fanState);/*Turn on FAN*/
-
-			/*adjust the new fan read based on the temperature*/
-			if(temperature >= 120)
-			{
-				newFanSpeed = 100;
-			}
-			else if(temperature >= 90)
-			{
-				newFanSpeed = 75;
-			}
-			else if(temperature >= 60)
-			{
-				newFanSpeed = 50;
-			}
-			else if(temperature >= 30)
-			{
-				newFanSpeed = 25;
-			}
-			MAIN_updateFanSpeed(newFanSpeed, &fanSpeed, &fanState);
+			WATCHDOG_checkIn(WATCHDOG_TASK_SAMPLE);/*not due yet*/
+			/*Idle until the next tick or received byte, the timers and the UART keep running*/
+			sleep_mode();
+			continue;
 		}
-
+		lastSample = TIMER_getTicks();
+		PROBE_START(PROBE_SAMPLE);
+		TRACE_BEGIN(TRACE_SAMPLE, 0);
+		MAIN_sample(&state);
+		ENERGY_setDuty(state.fanSpeed);/*the tick accounts the applied duty until the next change*/
+		WATCHDOG_setDuty(state.fanSpeed);/*restored by MAIN_init after a reset*/
+		TRACE_END(TRACE_SAMPLE, (uint8)LM35_TO_DEGREES(state.temperature) | ((uint16)state.fanSpeed << 8));
+		PROBE_STOP(PROBE_SAMPLE);
+		WATCHDOG_checkIn(WATCHDOG_TASK_SAMPLE);
 	}
 }
@@ -18,10 +18,43 @@
 #include "dcMotor.h"
 #include"lcd.h"
 #include"lm35.h"
+#include"timer.h"
+#include"uart.h"
+#include"telemetry.h"
+#include"config.h"
+#include"command.h"
+#include"nvm.h"
+#include"history.h"
+#include"probe.h"
+#include"trace.h"
+#include"sram.h"
+#include"sensor.h"
+#include"filter.h"
+#include"predict.h"
+#include"energy.h"
+#include"error.h"
+#include"vref.h"
+#include"watchdog.h"
 #define FAN_OFF 		FALSE
 #define FAN_ON			TRUE
 #define FAN_INIT		0x02
-#define FAN_DIRECTION 	DC_MOTOR_CW
+#define FAN_STALL		0x03 /*on, cut by the over-current protection*/
+#define MAIN_NOT_DISPLAYED	0xFF /*forces the next LCD update*/
+#define MAIN_NOT_DISPLAYED_VALUE	(-32767 - 1) /*forces the next LCD number update*/
+
+typedef struct
+{
+	LM35_TemperatureType temperature;/*last read temperature*/
+	uint8 fanState;/*fan state on the display*/
+	sint16 lcdValue;/*number on the display*/
+	uint8 displayMode;/*mode on the display*/
+	uint8 fanSpeed;/*applied fan speed*/
+	uint8 motorError;/*code of the last DC_MOTOR_Rotate call*/
+	uint8 sensorFault;/*sensor fault on the display*/
+	FILTER_Type filter;/*LM35 filter, set up from the configuration by the first sample*/
+	FILTER_Type fineFilter;/*the same filter for the 10x codes inside the fine window*/
+	PREDICT_Type predict;/*slope of the filtered codes*/
+}MAIN_StateType;
 
 /*
  * @brief initializes the application and it required modules
@@ -42,11 +75,57 @@ void MAIN_displayFanMessage(uint8 a_fanState, uint8 *a_oldFanState);
  * @brief this function will display the temperature on the LCD screen
  * assuming the LCD was initialized properly.
  *
- * @param uint8 a_temprature indicate the new number
+ * @param LM35_TemperatureType a_temprature indicate the new temperature, shown in whole degrees
+ *
+ * @param sint16* a_oldTemp apointer indicate the old(on the display) number
+ * */
+void MAIN_displayTemperatureMessage(LM35_TemperatureType a_temprature, sint16* a_oldTemp);
+
+/*
+ * @brief this function will display the fan duty on the LCD screen
+ * assuming the LCD was initialized properly.
+ *
+ * @param uint8 a_duty indicate the new duty in percent
+ *
+ * @param sint16* a_oldDuty a pointer indicate the old(on the display) duty
+ * */
+void MAIN_displayDutyMessage(uint8 a_duty, sint16* a_oldDuty);
+
+/*
+ * @brief this function will find the fan speed of a temperature
+ * from the fan curve
+ *
+ * @param const CONFIG_CurveType* a_curve the fan curve
+ *
+ * @param LM35_TemperatureType a_temperature the read temperature
+ *
+ * @return uint8 the fan speed in percent, 0 if the fan should be off
+ * */
+uint8 MAIN_getFanSpeed(const CONFIG_CurveType * a_curve, LM35_TemperatureType a_temperature);
+
+/*
+ * @brief this function will convert the horizon of the predictive mode
+ * to a number of samples
+ *
+ * @param uint8 a_horizon the horizon in seconds
+ *
+ * @param uint16 a_samplePeriod the sample period in ms
+ *
+ * @return uint16 the horizon in samples
+ * */
+uint16 MAIN_getHorizonSamples(uint8 a_horizon, uint16 a_samplePeriod);
+
+/*
+ * @brief this function will apply a changed runtime configuration
+ * to the modules and the display
+ *
+ * @param uint8* a_displayMode a pointer to the mode currently on the display
+ *
+ * @param sint16* a_lcdValue a pointer to the number currently on the display
  *
- * @param uint8* a_oldTemp apointer indicate the old(on the display) number
+ * @param uint8* a_fanSpeed a pointer to the current fan speed
  * */
-void MAIN_displayTemperatureMessage(uint8 a_temprature, uint8* a_oldTemp);
+void MAIN_applyConfig(uint8* a_displayMode, sint16* a_lcdValue, uint8* a_fanSpeed);
 
 /*
  * @brief this function adjust the fan speed based on the
@@ -58,6 +137,50 @@ void MAIN_displayTemperatureMessage(uint8 a_temprature, uint8* a_oldTemp);
  * @param uint8* a_oldSpeed a pointer to the current fan speed
  *
  * @param uint8* a_fanStatus a pointer to the fanStatus
+ *
+ * @return uint8 the error code returned by DC_MOTOR_Rotate
+ * */
+uint8 MAIN_updateFanSpeed(uint8 a_newSpeed, uint8* a_oldSpeed, uint8* a_fanStatus);
+
+/*
+ * @brief this function will queue a telemetry sample frame with the
+ * current state of the controller, it never waits for the UART.
+ *
+ * @param LM35_TemperatureType a_temperature the last read temperature
+ *
+ * @param uint8 a_speed the current fan speed
+ *
+ * @param uint8 a_fanState the current fan state
+ *
+ * @param uint8 a_motorError the code returned by the last DC_MOTOR_Rotate call
+ * */
+void MAIN_sendTelemetry(LM35_TemperatureType a_temperature, uint8 a_speed, uint8 a_fanState, uint8 a_motorError);
+
+/*
+ * @brief this function will force the fan to full speed on a sensor
+ * fault, it only touches the motor so the fan is on before anything
+ * else of the sample runs.
+ *
+ * @param MAIN_StateType* a_state the state of the controller between samples
+ * */
+void MAIN_failsafe(MAIN_StateType * a_state);
+
+/*
+ * @brief this function will display a sensor fault on the LCD screen
+ * in place of the temperature or the duty, assuming the LCD was
+ * initialized properly.
+ *
+ * @param uint8 a_fault the active SENSOR_FaultType
+ *
+ * @param MAIN_StateType* a_state the state of the controller between samples
+ * */
+void MAIN_displaySensorFault(uint8 a_fault, MAIN_StateType * a_state);
+
+/*
+ * @brief this function will read the temperature once and apply it
+ * to the fan, the display, the history and the telemetry.
+ *
+ * @param MAIN_StateType* a_state the state of the controller between samples
  * */
-void MAIN_updateFanSpeed(uint8 a_newSpeed, uint8* a_oldSpeed, uint8* a_fanStatus);
+void MAIN_sample(MAIN_StateType * a_state);
 #endif /* MAIN_H_ */
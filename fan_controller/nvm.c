@@ -0,0 +1,153 @@
+/*
+ *
+ * Module: NVM
+ *
+ * File Name: nvm.c
+ *
+ * Description: Source file for the persistent configuration storage
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"nvm.h"
+#include"config.h"
+#include"eeprom.h"
+#include"timer.h"
+#include"crc.h"
+#include"trace.h"
+#include<string.h>
+
+#define NVM_RECORD_SIZE			(sizeof(CONFIG_Type) + 4)
+
+/*Compile time check, the configuration must fit in one slot*/
+typedef char NVM_recordSizeCheck[(NVM_RECORD_SIZE <= NVM_SLOT_SIZE) ? 1 : -1];
+
+/*Global Variables */
+static uint8 NVM_g_record[NVM_RECORD_SIZE]; /*used by the EEPROM ISR while saving*/
+static uint16 NVM_g_sequence = 0;
+static uint8 NVM_g_slot = NVM_SLOTS - 1; /*newest slot, the first save goes to slot 0*/
+static uint8 NVM_g_pending = FALSE;
+static uint32 NVM_g_requestTime = 0;
+
+/*
+ * @brief return the EEPROM address of a slot
+ * */
+static uint16 NVM_getSlotAddress(uint8 a_slot)
+{
+	return NVM_BASE_ADDRESS + ((uint16)a_slot * NVM_SLOT_SIZE);
+}
+
+/*
+ * @brief check the CRC of the record in NVM_g_record
+ * */
+static uint8 NVM_isRecordValid(void)
+{
+	uint16 crc = CRC16_update(CRC16_INITIAL_VALUE, NVM_g_record, NVM_RECORD_SIZE - 2);
+	return (NVM_g_record[NVM_RECORD_SIZE - 2] == (uint8)crc
+			&& NVM_g_record[NVM_RECORD_SIZE - 1] == (uint8)(crc >> 8)) ? TRUE : FALSE;
+}
+
+/*
+ * @brief return the sequence number of the record in NVM_g_record
+ * */
+static uint16 NVM_getRecordSequence(void)
+{
+	return (uint16)(NVM_g_record[0] | ((uint16)NVM_g_record[1] << 8));
+}
+
+/*
+ * @brief scan the journal and load the newest valid configuration.
+ * CONFIG_init must be called before, the defaults are kept if no slot is valid.
+ *
+ * @return NVM_ErrorType NVM_ERROR_NO_RECORD if the defaults are used
+ * */
+NVM_ErrorType NVM_init(void)
+{
+	CONFIG_Type config;
+	uint8 slot = 0, found = FALSE;
+	uint16 sequence = 0;
+
+	NVM_g_pending = FALSE;
+	for(slot = 0; slot < NVM_SLOTS; slot++)
+	{
+		if(EEPROM_readBlock(NVM_getSlotAddress(slot), NVM_g_record, NVM_RECORD_SIZE) != EEPROM_SUCCESS
+				|| NVM_isRecordValid() == FALSE)
+		{
+			continue; /*erased or torn slot*/
+		}
+		sequence = NVM_getRecordSequence();
+		/*serial number arithmetic so the sequence can wrap around*/
+		if(found == FALSE || (sint16)(sequence - NVM_g_sequence) > 0)
+		{
+			found = TRUE;
+			NVM_g_sequence = sequence;
+			NVM_g_slot = slot;
+		}
+	}
+	if(found == FALSE)
+	{
+		return NVM_ERROR_NO_RECORD;
+	}
+
+	/*Read the newest slot again, the scan buffer holds the last read slot*/
+	EEPROM_readBlock(NVM_getSlotAddress(NVM_g_slot), NVM_g_record, NVM_RECORD_SIZE);
+	memcpy(&config, &NVM_g_record[2], sizeof(CONFIG_Type));
+	if(CONFIG_load(&config) != CONFIG_SUCCESS)
+	{
+		/*A valid CRC with invalid values, written by an older firmware*/
+		return NVM_ERROR_NO_RECORD;
+	}
+	return NVM_SUCCESS;
+}
+
+/*
+ * @brief ask for the current configuration to be saved,
+ * the save starts NVM_SAVE_DELAY_MS after the last request
+ * */
+void NVM_requestSave(void)
+{
+	NVM_g_pending = TRUE;
+	NVM_g_requestTime = TIMER_getTicks();
+}
+
+/*
+ * @brief start a pending save once its delay passed and the EEPROM is free,
+ * it must be called from the main loop and never waits for the EEPROM.
+ * */
+void NVM_process(void)
+{
+	uint16 crc = 0;
+	if(NVM_g_pending == FALSE
+			|| (uint32)(TIMER_getTicks() - NVM_g_requestTime) < NVM_SAVE_DELAY_MS
+			|| EEPROM_isBusy())
+	{
+		return;
+	}
+
+	/*Build the next record, the buffer is free since the EEPROM is not busy*/
+	NVM_g_sequence++;
+	NVM_g_slot = (NVM_g_slot + 1) % NVM_SLOTS;
+	NVM_g_record[0] = (uint8)NVM_g_sequence;
+	NVM_g_record[1] = (uint8)(NVM_g_sequence >> 8);
+	memcpy(&NVM_g_record[2], CONFIG_get(), sizeof(CONFIG_Type));
+	crc = CRC16_update(CRC16_INITIAL_VALUE, NVM_g_record, NVM_RECORD_SIZE - 2);
+	NVM_g_record[NVM_RECORD_SIZE - 2] = (uint8)crc;
+	NVM_g_record[NVM_RECORD_SIZE - 1] = (uint8)(crc >> 8);
+
+	if(EEPROM_writeBlock(NVM_getSlotAddress(NVM_g_slot), NVM_g_record, NVM_RECORD_SIZE) == EEPROM_SUCCESS)
+	{
+		TRACE_EVENT(TRACE_NVM_SAVE, NVM_g_sequence);
+		NVM_g_pending = FALSE;
+	}
+}
+
+/*
+ * @brief return the sequence number of the newest saved record
+ * */
+uint16 NVM_getSequence(void)
+{
+	return NVM_g_sequence;
+}
@@ -0,0 +1,68 @@
+/*
+ *
+ * Module: NVM
+ *
+ * File Name: nvm.h
+ *
+ * Description: Header file for the persistent configuration storage.
+ *
+ * The configuration is stored as a journal in a ring of EEPROM slots,
+ * every save goes to the slot after the newest one so the writes are spread
+ * over all the slots (wear leveling):
+ *
+ * 	slot = sequence(2) | CONFIG_Type | CRC16(2)
+ *
+ * The CRC covers the sequence and the configuration, a slot torn by a reset
+ * while being written fails its CRC so the previous slot is used instead.
+ * On boot one linear scan picks the valid slot with the newest sequence.
+ *
+ * EEPROM map:
+ * 	0x000 -> 0x0FF	configuration journal (this module)
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef NVM_H_
+#define NVM_H_
+
+#include"std_types.h"
+
+#define NVM_BASE_ADDRESS		0x000
+#define NVM_SLOT_SIZE			32
+#define NVM_SLOTS				8
+#define NVM_SAVE_DELAY_MS		2000 /*a burst of changes is saved once*/
+
+#define NVM_SUCCESS				0
+#define NVM_ERROR_NO_RECORD		NVM_SUCCESS + 1
+
+typedef uint8 NVM_ErrorType;
+
+/*
+ * @brief scan the journal and load the newest valid configuration.
+ * CONFIG_init must be called before, the defaults are kept if no slot is valid.
+ *
+ * @return NVM_ErrorType NVM_ERROR_NO_RECORD if the defaults are used
+ * */
+NVM_ErrorType NVM_init(void);
+
+/*
+ * @brief ask for the current configuration to be saved,
+ * the save starts NVM_SAVE_DELAY_MS after the last request
+ * */
+void NVM_requestSave(void);
+
+/*
+ * @brief start a pending save once its delay passed and the EEPROM is free,
+ * it must be called from the main loop and never waits for the EEPROM.
+ * */
+void NVM_process(void);
+
+/*
+ * @brief return the sequence number of the newest saved record
+ * */
+uint16 NVM_getSequence(void);
+
+#endif /* NVM_H_ */
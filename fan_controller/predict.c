@@ -0,0 +1,101 @@
+/*
+ *
+ * Module: Predict
+ *
+ * File Name: predict.c
+ *
+ * Description: Source file for the temperature slope estimate of the predictive fan control.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"predict.h"
+#include"adc.h"
+
+/*
+ * @brief clear the window, the slope is 0 until it is full again
+ * */
+void PREDICT_init(PREDICT_Type * a_predict)
+{
+	a_predict->sum = 0;
+	a_predict->weightedSum = 0;
+	a_predict->count = 0;
+	a_predict->oldest = 0;
+}
+
+/*
+ * @brief add the newest filtered code to the window
+ * */
+void PREDICT_update(PREDICT_Type * a_predict, uint16 a_code)
+{
+	uint16 oldest = 0;
+
+	if(a_predict->count < PREDICT_WINDOW)
+	{
+		/*the new code is at x = count*/
+		a_predict->window[a_predict->count] = a_code;
+		a_predict->weightedSum += (uint32)a_predict->count * a_code;
+		a_predict->sum += a_code;
+		a_predict->count++;
+		return;
+	}
+	oldest = a_predict->window[a_predict->oldest];
+	a_predict->window[a_predict->oldest] = a_code;
+	a_predict->oldest = (a_predict->oldest + 1) & (PREDICT_WINDOW - 1);
+	/*every code moves one x down, the oldest one leaves at x = 0*/
+	a_predict->weightedSum = a_predict->weightedSum - a_predict->sum + oldest
+			+ ((uint32)(PREDICT_WINDOW - 1) * a_code);
+	a_predict->sum = a_predict->sum - oldest + a_code;
+}
+
+/*
+ * @brief return the slope in codes per sample with PREDICT_SLOPE_BITS
+ * fraction bits, 0 while the window is not full
+ * */
+sint32 PREDICT_getSlope(const PREDICT_Type * a_predict)
+{
+	sint32 numerator = 0;
+
+	if(a_predict->count < PREDICT_WINDOW)
+	{
+		return 0;
+	}
+	/*at most 2 * 1023 * W^2 / 2, it fits with the fraction bits*/
+	numerator = (sint32)(2 * a_predict->weightedSum) - ((sint32)(PREDICT_WINDOW - 1) * (sint32)a_predict->sum);
+	return (numerator * (1L << PREDICT_SLOPE_BITS)) / PREDICT_DENOMINATOR;
+}
+
+/*
+ * @brief project the newest code a number of samples ahead on the slope
+ *
+ * @param PREDICT_Type* a_predict the estimator
+ *
+ * @param uint16 a_samples the horizon in samples
+ *
+ * @return uint16 the projected code, not below the newest code and not above ADC_MAX
+ * */
+uint16 PREDICT_project(const PREDICT_Type * a_predict, uint16 a_samples)
+{
+	sint32 slope = PREDICT_getSlope(a_predict);
+	uint16 newest = 0;
+	uint32 rise = 0;
+
+	if(a_predict->count == 0)
+	{
+		return 0;
+	}
+	newest = a_predict->window[(a_predict->oldest + a_predict->count - 1) & (PREDICT_WINDOW - 1)];
+	if(slope <= 0)
+	{
+		return newest;
+	}
+	if((uint32)slope > (((uint32)ADC_MAX << PREDICT_SLOPE_BITS) / (a_samples + 1)))
+	{
+		return ADC_MAX;/*the product would overflow, the projection saturates anyway*/
+	}
+	rise = ((uint32)slope * a_samples) >> PREDICT_SLOPE_BITS;
+	return (newest + rise) > ADC_MAX ? ADC_MAX : (uint16)(newest + rise);
+}
@@ -0,0 +1,70 @@
+/*
+ *
+ * Module: Predict
+ *
+ * File Name: predict.h
+ *
+ * Description: Header file for the temperature slope estimate of the predictive fan control.
+ *
+ * The slope is the least squares line of the last PREDICT_WINDOW filtered codes,
+ * in integers. With x = 0..W-1 from the oldest code, S = sum(y) and T = sum(x * y):
+ *
+ * 	slope = (2T - (W - 1)S) / (W(W^2 - 1) / 6)	codes per sample
+ *
+ * S and T slide with the window in constant time: T' = T - S + y_oldest + (W - 1)y_new.
+ * The projection a number of samples ahead only goes up, the predictive mode
+ * raises the fan early for a rising temperature and never lowers it.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef PREDICT_H_
+#define PREDICT_H_
+
+#include"std_types.h"
+
+#define PREDICT_WINDOW			32 /*3.2s at the 100ms sample period*/
+#define PREDICT_DENOMINATOR		((sint32)PREDICT_WINDOW * ((PREDICT_WINDOW * PREDICT_WINDOW) - 1) / 6)
+#define PREDICT_SLOPE_BITS		8 /*fraction bits of the slope*/
+#define PREDICT_MAX_HORIZON_S	120
+
+typedef struct
+{
+	uint16 window[PREDICT_WINDOW]; /*codes in arrival order, a ring*/
+	uint32 sum; /*S*/
+	uint32 weightedSum; /*T*/
+	uint8 count; /*codes in the window*/
+	uint8 oldest; /*index of the oldest code in window*/
+}PREDICT_Type;
+
+/*
+ * @brief clear the window, the slope is 0 until it is full again
+ * */
+void PREDICT_init(PREDICT_Type * a_predict);
+
+/*
+ * @brief add the newest filtered code to the window
+ * */
+void PREDICT_update(PREDICT_Type * a_predict, uint16 a_code);
+
+/*
+ * @brief return the slope in codes per sample with PREDICT_SLOPE_BITS
+ * fraction bits, 0 while the window is not full
+ * */
+sint32 PREDICT_getSlope(const PREDICT_Type * a_predict);
+
+/*
+ * @brief project the newest code a number of samples ahead on the slope
+ *
+ * @param PREDICT_Type* a_predict the estimator
+ *
+ * @param uint16 a_samples the horizon in samples
+ *
+ * @return uint16 the projected code, not below the newest code and not above ADC_MAX
+ * */
+uint16 PREDICT_project(const PREDICT_Type * a_predict, uint16 a_samples);
+
+#endif /* PREDICT_H_ */
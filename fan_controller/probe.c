@@ -0,0 +1,184 @@
+/*
+ *
+ * Module: Probe
+ *
+ * File Name: probe.c
+ *
+ * Description: Source file for the control loop latency and jitter probes
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"probe.h"
+
+#if (PROBE_ENABLED == 1)
+
+#include"telemetry.h"
+
+typedef struct
+{
+	uint16 start;
+	uint16 count;
+	uint16 max;
+	uint16 bins[PROBE_BINS];
+}PROBE_HistogramType;
+
+/*Global Variables */
+static PROBE_HistogramType PROBE_g_stages[PROBE_STAGES];
+static uint16 PROBE_g_lapStarted = 0; /*one bit per stage*/
+static uint8 PROBE_g_dumping = FALSE;
+static uint8 PROBE_g_dumpIndex = 0;
+
+/*
+ * @brief histogram bin of a duration, see the table in probe.h
+ * */
+static uint8 PROBE_getBin(uint16 a_value)
+{
+	uint8 msb = 15;
+	uint8 bin = 0;
+	if(a_value < 4)
+	{
+		return (uint8)a_value;
+	}
+	while(!(a_value & (1U << msb)))
+	{
+		msb--;
+	}
+	bin = (uint8)((msb << 1) + ((a_value >> (msb - 1)) & 1));
+	return bin < PROBE_BINS ? bin : PROBE_BINS - 1;
+}
+
+static void PROBE_record(PROBE_HistogramType * a_histogram, uint16 a_value)
+{
+	uint8 bin = PROBE_getBin(a_value);
+	/*saturate instead of wrapping, a full bin still tells where the values are*/
+	if(a_histogram->bins[bin] != 0xFFFF)
+	{
+		a_histogram->bins[bin]++;
+	}
+	if(a_histogram->count != 0xFFFF)
+	{
+		a_histogram->count++;
+	}
+	if(a_value > a_histogram->max)
+	{
+		a_histogram->max = a_value;
+	}
+}
+
+static void PROBE_clear(PROBE_HistogramType * a_histogram)
+{
+	uint8 i = 0;
+	a_histogram->count = 0;
+	a_histogram->max = 0;
+	for(i = 0; i < PROBE_BINS; i++)
+	{
+		a_histogram->bins[i] = 0;
+	}
+}
+
+static void PROBE_putUint16(uint8 * a_buffer, uint16 a_value)
+{
+	a_buffer[0] = (uint8)a_value;
+	a_buffer[1] = (uint8)(a_value >> 8);
+}
+
+/*
+ * @brief start Timer1 as the free running time base and clear the histograms
+ * */
+void PROBE_init(void)
+{
+	uint8 i = 0;
+	for(i = 0; i < PROBE_STAGES; i++)
+	{
+		PROBE_clear(&PROBE_g_stages[i]);
+	}
+	PROBE_g_lapStarted = 0;
+	PROBE_g_dumping = FALSE;
+
+	TIMER_startTimestamp();
+}
+
+/*
+ * @brief remember the start time of a stage
+ * */
+void PROBE_start(PROBE_StageType a_stage)
+{
+	PROBE_g_stages[a_stage].start = TIMER_getTimestamp();
+}
+
+/*
+ * @brief record the time since PROBE_start of the stage
+ * */
+void PROBE_stop(PROBE_StageType a_stage)
+{
+	PROBE_record(&PROBE_g_stages[a_stage], (uint16)(TIMER_getTimestamp() - PROBE_g_stages[a_stage].start));
+}
+
+/*
+ * @brief record the time since the previous lap of the stage, the first lap only starts it
+ * */
+void PROBE_lap(PROBE_StageType a_stage)
+{
+	uint16 now = TIMER_getTimestamp();
+	if(PROBE_g_lapStarted & (1U << a_stage))
+	{
+		PROBE_record(&PROBE_g_stages[a_stage], (uint16)(now - PROBE_g_stages[a_stage].start));
+	}
+	PROBE_g_lapStarted |= (1U << a_stage);
+	PROBE_g_stages[a_stage].start = now;
+}
+
+/*
+ * @brief start sending the histograms, one frame per stage
+ *
+ * @return uint8 FALSE if a dump is already running
+ * */
+uint8 PROBE_startDump(void)
+{
+	if(PROBE_g_dumping)
+	{
+		return FALSE;
+	}
+	PROBE_g_dumping = TRUE;
+	PROBE_g_dumpIndex = 0;
+	return TRUE;
+}
+
+/*
+ * @brief send the next histogram when the UART has room for it,
+ * it must be called from the main loop.
+ * */
+void PROBE_process(void)
+{
+	uint8 payload[PROBE_PAYLOAD_SIZE];
+	PROBE_HistogramType * histogram = NULL_PTR;
+	uint8 i = 0;
+
+	if(!PROBE_g_dumping || !TELEMETRY_canSend(PROBE_PAYLOAD_SIZE))
+	{
+		return;
+	}
+	histogram = &PROBE_g_stages[PROBE_g_dumpIndex];
+	payload[0] = PROBE_g_dumpIndex;
+	payload[1] = PROBE_STAGES;
+	PROBE_putUint16(&payload[2], histogram->count);
+	PROBE_putUint16(&payload[4], histogram->max);
+	for(i = 0; i < PROBE_BINS; i++)
+	{
+		PROBE_putUint16(&payload[6 + (2 * i)], histogram->bins[i]);
+	}
+	TELEMETRY_sendFrame(TELEMETRY_FRAME_PROBE, payload, PROBE_PAYLOAD_SIZE);
+	PROBE_clear(histogram);/*the next dump shows what happened since this one*/
+
+	PROBE_g_dumpIndex++;
+	if(PROBE_g_dumpIndex == PROBE_STAGES)
+	{
+		PROBE_g_dumping = FALSE;
+	}
+}
+
+#endif /* PROBE_ENABLED */
@@ -0,0 +1,119 @@
+/*
+ *
+ * Module: Probe
+ *
+ * File Name: probe.h
+ *
+ * Description: Header file for the control loop latency and jitter probes.
+ *
+ * PROBE_START(stage)/PROBE_STOP(stage) around a stage of the main loop record
+ * its duration, PROBE_LAP(stage) records the time since its previous lap. The
+ * time base is the Timer1 timestamp of timer.h (8us at 1MHz), so one measure is
+ * up to 65535 timer counts (524ms at 1MHz).
+ *
+ * Every stage keeps a histogram of PROBE_BINS bins, 4 linear ones then 2 per
+ * power of two, values above the last bin are counted in it:
+ *
+ * 	bin	0	1	2	3	4	5	6	7	8	...	2n	2n+1
+ * 	from	0	1	2	3	4	6	8	12	16	...	2^n	3*2^(n-1)
+ *
+ * "get probes" sends one PROBE frame per stage and clears it:
+ *
+ * 	stage(1) | stages(1) | count(2) | max(2) | bins(2 * PROBE_BINS)
+ *
+ * The probes cost 500 bytes of RAM, they are compiled only when PROBE_ENABLED is 1
+ * (-DPROBE_ENABLED=1), otherwise the macros are empty and nothing is left of them.
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef PROBE_H_
+#define PROBE_H_
+
+#include"std_types.h"
+#include"timer.h"
+
+#ifndef PROBE_ENABLED
+#define PROBE_ENABLED			0
+#endif
+
+#define PROBE_PRESCALER			TIMER_TIMESTAMP_PRESCALER
+#define PROBE_BINS				28
+#define PROBE_PAYLOAD_SIZE		(6 + (2 * PROBE_BINS))
+
+typedef enum
+{
+	PROBE_COMMAND,		/*COMMAND_process*/
+	PROBE_BACKGROUND,	/*NVM_process and HISTORY_process*/
+	PROBE_SENSOR,		/*LM35_getTemperature*/
+	PROBE_ACTUATION,	/*from the temperature to the new duty in OCR0*/
+	PROBE_LATENCY,		/*from the ADC sample to the new duty in OCR0*/
+	PROBE_RECORD,		/*duty display, history and telemetry*/
+	PROBE_SAMPLE,		/*the whole MAIN_sample*/
+	PROBE_PERIOD,		/*between two samples, the jitter of the sample period*/
+	PROBE_FAILSAFE,		/*from the faulty ADC sample to the full duty in OCR0*/
+	PROBE_FILTER,		/*median and EMA of the LM35 code*/
+	PROBE_STAGES
+}PROBE_StageType;
+
+/*
+ * @brief first value counted in a bin
+ * */
+#define PROBE_BIN_LOW(bin)		((bin) < 4 ? (uint16)(bin) \
+		: (uint16)((2 + ((bin) & 1)) << (((bin) >> 1) - 1)))
+
+#if (PROBE_ENABLED == 1)
+
+#define PROBE_INIT()			PROBE_init()
+#define PROBE_START(stage)		PROBE_start(stage)
+#define PROBE_STOP(stage)		PROBE_stop(stage)
+#define PROBE_LAP(stage)		PROBE_lap(stage)
+#define PROBE_PROCESS()			PROBE_process()
+
+/*
+ * @brief start Timer1 as the free running time base and clear the histograms
+ * */
+void PROBE_init(void);
+
+/*
+ * @brief remember the start time of a stage
+ * */
+void PROBE_start(PROBE_StageType a_stage);
+
+/*
+ * @brief record the time since PROBE_start of the stage
+ * */
+void PROBE_stop(PROBE_StageType a_stage);
+
+/*
+ * @brief record the time since the previous lap of the stage, the first lap only starts it
+ * */
+void PROBE_lap(PROBE_StageType a_stage);
+
+/*
+ * @brief start sending the histograms, one frame per stage
+ *
+ * @return uint8 FALSE if a dump is already running
+ * */
+uint8 PROBE_startDump(void);
+
+/*
+ * @brief send the next histogram when the UART has room for it,
+ * it must be called from the main loop.
+ * */
+void PROBE_process(void);
+
+#else
+
+#define PROBE_INIT()
+#define PROBE_START(stage)
+#define PROBE_STOP(stage)
+#define PROBE_LAP(stage)
+#define PROBE_PROCESS()
+
+#endif /* PROBE_ENABLED */
+
+#endif /* PROBE_H_ */
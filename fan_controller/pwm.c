@@ -15,6 +15,9 @@
 #include"pwm.h"
 #include"avr/io.h"
 
+/*Global Variables */
+static PWM_PrescalerType PWM_g_prescaler = PWM_DEFAULT_PRESCALER;
+
 /*
  * @brief the function will start timer 0 with pwm mode based on the duty cycle
  *
@@ -27,7 +30,7 @@ void PWM_Timer0_Start(uint8 a_dutyCycle)
 	/*
 	 * Description:
 	 * Generate a PWM signal with frequency 500Hz
-	 * Timer0 will be used with pre-scaler F_CPU/8
+	 * Timer0 will be used with pre-scaler F_CPU/8 by default (see PWM_setPrescaler)
 	 * F_PWM=(F_CPU)/(256*N) = (10^6)/(256*8) = 500Hz
 	 * 64  -> 25 Duty Cycle
 	 * 128 -> 50 Duty Cycle
@@ -44,9 +47,20 @@ void PWM_Timer0_Start(uint8 a_dutyCycle)
 	 * 1. Fast PWM mode FOC0=0
 	 * 2. Fast PWM Mode WGM01=1 & WGM00=1
 	 * 3. Clear OC0 when match occurs (non inverted mode) COM00=0 & COM01=1
-	 * 4. clock = F_CPU/8 CS00=0 CS01=1 CS02=0
+	 * 4. clock = F_CPU/N CS02:0 = the selected pre-scaler
 	 */
-	TCCR0 = (1<<WGM00) | (1<<WGM01) | (1<<COM01) | (1<<CS01);
+	TCCR0 = (1<<WGM00) | (1<<WGM01) | (1<<COM01) | (PWM_g_prescaler << CS00);
+}
+
+/*
+ * @brief change the duty cycle of a running pwm signal without restarting
+ * the timer, it can be called from an ISR
+ *
+ * @param uint8 a_dutyCycle the required duty cycle
+ * */
+void PWM_setDutyCycle(uint8 a_dutyCycle)
+{
+	OCR0 = a_dutyCycle; /*Fast PWM, the new value is taken at the next TOP*/
 }
 
 /*
@@ -59,3 +73,26 @@ void PWM_deInit(void)
 	OCR0 = 0;
 	DDRB = DDRB & ~(1 << PB3);
 }
+
+/*
+ * @brief select the timer 0 clock and so the pwm frequency,
+ * a running pwm signal is updated immediately.
+ *
+ * @param PWM_PrescalerType a_prescaler the required pre-scaler
+ *
+ * @return PWM_ErrorType PWM_SUCCESS or PWM_ERROR_PRESCALER
+ * */
+PWM_ErrorType PWM_setPrescaler(PWM_PrescalerType a_prescaler)
+{
+	if(a_prescaler < PWM_PRESCALER_1 || a_prescaler > PWM_PRESCALER_1024)
+	{
+		return ERROR_record(PWM_ERROR_PRESCALER);
+	}
+	PWM_g_prescaler = a_prescaler;
+	if(TCCR0 != 0)
+	{
+		/*The timer is running, replace the clock select bits only*/
+		TCCR0 = (TCCR0 & ~((1<<CS02) | (1<<CS01) | (1<<CS00))) | (a_prescaler << CS00);
+	}
+	return PWM_SUCCESS;
+}
@@ -16,11 +16,27 @@
 #define PWM_H_
 
 #include"std_types.h"
+#include"error.h"
 
 #define PWM_OUTPUT_PORT		PORTB_ID
 #define PWM_OUTPUT_PIN		PIN3_ID
 #define PWM_MAX_VALUE		0xff
 
+/*Errors, see error.h*/
+#define PWM_SUCCESS				ERROR_NONE
+#define PWM_ERROR_PRESCALER		ERROR_CODE(ERROR_MODULE_PWM, 1)
+
+typedef ERROR_CodeType PWM_ErrorType;
+
+/*Timer0 clock select values, F_PWM = F_CPU / (256 * N)*/
+typedef enum
+{
+	PWM_PRESCALER_1 = 1, PWM_PRESCALER_8 = 2, PWM_PRESCALER_64 = 3,
+	PWM_PRESCALER_256 = 4, PWM_PRESCALER_1024 = 5
+} PWM_PrescalerType;
+
+#define PWM_DEFAULT_PRESCALER	PWM_PRESCALER_8
+
 /*
  * @brief the function will start timer 0 with pwm mode based on the duty cycle
  *
@@ -30,9 +46,27 @@
  * */
 void PWM_Timer0_Start(uint8 a_dutyCycle);
 
+/*
+ * @brief change the duty cycle of a running pwm signal without restarting
+ * the timer, it can be called from an ISR
+ *
+ * @param uint8 a_dutyCycle the required duty cycle
+ * */
+void PWM_setDutyCycle(uint8 a_dutyCycle);
+
 /*
  * @brief reset registers to 0
  * */
 void PWM_deInit(void);
 
+/*
+ * @brief select the timer 0 clock and so the pwm frequency,
+ * a running pwm signal is updated immediately.
+ *
+ * @param PWM_PrescalerType a_prescaler the required pre-scaler
+ *
+ * @return PWM_ErrorType PWM_SUCCESS or PWM_ERROR_PRESCALER
+ * */
+PWM_ErrorType PWM_setPrescaler(PWM_PrescalerType a_prescaler);
+
 #endif /* PWM_H_ */
@@ -0,0 +1,150 @@
+/*
+ *
+ * Module: Sensor health
+ *
+ * File Name: sensor.c
+ *
+ * Description: Source file for the LM35 fault detection.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"sensor.h"
+#include"adc.h"
+
+/*Global Variables */
+static SENSOR_FaultType SENSOR_g_fault = SENSOR_OK;
+static uint16 SENSOR_g_lastCode = 0;
+static uint8 SENSOR_g_started = FALSE; /*no previous sample for the slew check*/
+static uint16 SENSOR_g_sameCount = 0;
+static uint8 SENSOR_g_healthyCount = 0;
+static uint16 SENSOR_g_faultCount = 0;
+
+static const char * const SENSOR_g_names[] = {"ok", "adc", "open", "short", "slew", "stuck"};
+
+/*
+ * @brief clear the fault and the sample history
+ * */
+void SENSOR_init(void)
+{
+	SENSOR_g_fault = SENSOR_OK;
+	SENSOR_g_started = FALSE;
+	SENSOR_g_sameCount = 0;
+	SENSOR_g_healthyCount = 0;
+	SENSOR_g_faultCount = 0;
+}
+
+/*
+ * @brief find the fault of one sample alone
+ * */
+static SENSOR_FaultType SENSOR_classify(uint16 a_code, uint16 a_reference, uint8 a_adcError)
+{
+	uint16 slew = 0;
+	sint16 codes = (sint16)a_code - (sint16)a_reference; /*from the ground pin*/
+
+	if(a_adcError != ADC_SUCCESS)
+	{
+		return SENSOR_FAULT_ADC;
+	}
+	if(a_code < SENSOR_OPEN_CODE || codes < SENSOR_OPEN_CODES)
+	{
+		return SENSOR_FAULT_OPEN;
+	}
+	if(a_code >= ADC_MAX || codes > SENSOR_SHORT_CODES)
+	{
+		return SENSOR_FAULT_SHORT;
+	}
+	if(SENSOR_g_started)
+	{
+		slew = a_code > SENSOR_g_lastCode ? a_code - SENSOR_g_lastCode : SENSOR_g_lastCode - a_code;
+		if(slew > SENSOR_MAX_SLEW_CODES)
+		{
+			return SENSOR_FAULT_SLEW;
+		}
+	}
+#if (SENSOR_STUCK_SAMPLES != 0)
+	if(SENSOR_g_sameCount >= SENSOR_STUCK_SAMPLES)
+	{
+		return SENSOR_FAULT_STUCK;
+	}
+#endif
+	return SENSOR_OK;
+}
+
+/*
+ * @brief check one sample of the LM35
+ *
+ * @param uint16 a_code the raw ADC code
+ *
+ * @param uint16 a_reference the raw ADC code of the ground pin read with it
+ *
+ * @param uint8 a_adcError the error of the conversion
+ *
+ * @return SENSOR_FaultType the active fault, SENSOR_OK if the sensor is healthy
+ * */
+SENSOR_FaultType SENSOR_check(uint16 a_code, uint16 a_reference, uint8 a_adcError)
+{
+	SENSOR_FaultType fault = SENSOR_OK;
+
+	if(SENSOR_g_started && a_code == SENSOR_g_lastCode)
+	{
+		if(SENSOR_g_sameCount != 0xFFFF)
+		{
+			SENSOR_g_sameCount++;
+		}
+	}
+	else
+	{
+		SENSOR_g_sameCount = 1;
+	}
+
+	fault = SENSOR_classify(a_code, a_reference, a_adcError);
+	SENSOR_g_lastCode = a_code;
+	SENSOR_g_started = (a_adcError == ADC_SUCCESS);
+
+	if(fault != SENSOR_OK)
+	{
+		if(SENSOR_g_fault == SENSOR_OK)
+		{
+			SENSOR_g_faultCount++;
+		}
+		SENSOR_g_fault = fault;
+		SENSOR_g_healthyCount = 0;
+	}
+	else if(SENSOR_g_fault != SENSOR_OK)
+	{
+		SENSOR_g_healthyCount++;
+		if(SENSOR_g_healthyCount >= SENSOR_RECOVERY_SAMPLES)
+		{
+			SENSOR_g_fault = SENSOR_OK;
+		}
+	}
+	return SENSOR_g_fault;
+}
+
+/*
+ * @brief return the active fault
+ * */
+SENSOR_FaultType SENSOR_getFault(void)
+{
+	return SENSOR_g_fault;
+}
+
+/*
+ * @brief return the number of faults since the start
+ * */
+uint16 SENSOR_getFaultCount(void)
+{
+	return SENSOR_g_faultCount;
+}
+
+/*
+ * @brief return the name of a fault, at most 5 characters
+ * */
+const char * SENSOR_getFaultName(SENSOR_FaultType a_fault)
+{
+	return a_fault <= SENSOR_FAULT_STUCK ? SENSOR_g_names[a_fault] : "?";
+}
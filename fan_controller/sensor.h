@@ -0,0 +1,84 @@
+/*
+ *
+ * Module: Sensor health
+ *
+ * File Name: sensor.h
+ *
+ * Description: Header file for the LM35 fault detection.
+ *
+ * Every raw ADC code of the LM35 is checked before it is used, the open and short
+ * limits apply to the code above the one of the lifted ground pin (see lm35.h):
+ * 	adc		the conversion failed
+ * 	open	under SENSOR_OPEN_CODE, a broken wire leaves the input at 0V, or more
+ * 			than SENSOR_OPEN_CODES under the ground pin, past the -55C end of the LM35
+ * 	short	the last code, a short to VCC saturates the input, or more than
+ * 			SENSOR_SHORT_CODES above the ground pin, past the 150C end of the LM35
+ * 	slew	more than SENSOR_MAX_SLEW_CODES from the previous sample, no enclosure
+ * 			heats or cools that fast, a loose contact does
+ * 	stuck	the same code for SENSOR_STUCK_SAMPLES samples, a live sensor moves by
+ * 			at least one code of noise
+ *
+ * A fault is reported from the first faulty sample, so the caller can force the
+ * fan on in the same sample. It is cleared after SENSOR_RECOVERY_SAMPLES healthy
+ * samples in a row.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef SENSOR_H_
+#define SENSOR_H_
+
+#include"std_types.h"
+
+#define SENSOR_OPEN_CODE			4 /*raw code, the output is never this low above the lifted ground*/
+#define SENSOR_OPEN_CODES			(-240) /*-60C from the ground pin*/
+#define SENSOR_SHORT_CODES			620 /*155C from the ground pin, only reached with a ground under 0.9V*/
+#define SENSOR_MAX_SLEW_CODES		20 /*5C between two samples*/
+#define SENSOR_RECOVERY_SAMPLES		10
+
+#ifndef SENSOR_STUCK_SAMPLES
+#define SENSOR_STUCK_SAMPLES		6000 /*10 minutes at the 100ms sample period, 0 -> no check*/
+#endif
+
+typedef enum
+{
+	SENSOR_OK, SENSOR_FAULT_ADC, SENSOR_FAULT_OPEN, SENSOR_FAULT_SHORT, SENSOR_FAULT_SLEW, SENSOR_FAULT_STUCK
+}SENSOR_FaultType;
+
+/*
+ * @brief clear the fault and the sample history
+ * */
+void SENSOR_init(void);
+
+/*
+ * @brief check one sample of the LM35
+ *
+ * @param uint16 a_code the raw ADC code
+ *
+ * @param uint16 a_reference the raw ADC code of the ground pin read with it
+ *
+ * @param uint8 a_adcError the error of the conversion
+ *
+ * @return SENSOR_FaultType the active fault, SENSOR_OK if the sensor is healthy
+ * */
+SENSOR_FaultType SENSOR_check(uint16 a_code, uint16 a_reference, uint8 a_adcError);
+
+/*
+ * @brief return the active fault
+ * */
+SENSOR_FaultType SENSOR_getFault(void);
+
+/*
+ * @brief return the number of faults since the start
+ * */
+uint16 SENSOR_getFaultCount(void);
+
+/*
+ * @brief return the name of a fault, at most 5 characters
+ * */
+const char * SENSOR_getFaultName(SENSOR_FaultType a_fault);
+
+#endif /* SENSOR_H_ */
@@ -0,0 +1,120 @@
+/*
+ *
+ * Module: SRAM monitor
+ *
+ * File Name: sram.c
+ *
+ * Description: Source file for the stack high-water mark and SRAM usage monitor
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"sram.h"
+
+#if (SRAM_ENABLED == 1)
+
+#include"telemetry.h"
+#include<avr/io.h>
+
+/*Symbols of the avr-libc linker script*/
+extern uint8 __heap_start; /*end of .bss and .noinit*/
+extern uint8 __stack; /*initial stack pointer, RAMEND*/
+
+#define SRAM_BOTTOM		(&__heap_start)
+
+/*Global Variables */
+static const uint8 * SRAM_g_mark; /*lowest byte the stack has written*/
+static const uint8 * SRAM_g_cursor;
+static uint8 SRAM_g_warningPending = FALSE;
+
+void SRAM_paint(void) __attribute__((naked, used, section(".init1")));
+
+/*
+ * @brief fill the free space with SRAM_CANARY, it runs from .init1 before the
+ * stack pointer and r1 are set up, so it is plain assembly that uses no stack.
+ * */
+void SRAM_paint(void)
+{
+	__asm__ __volatile__(
+			"	ldi r30, lo8(__heap_start)\n"
+			"	ldi r31, hi8(__heap_start)\n"
+			"	ldi r24, %0\n"
+			"	ldi r25, hi8(__stack)\n"
+			"1:	st Z+, r24\n"
+			"	cpi r30, lo8(__stack)\n"
+			"	cpc r31, r25\n"
+			"	brlo 1b\n"
+			:
+			: "M" (SRAM_CANARY)
+			: "r24", "r25", "r30", "r31", "memory");
+}
+
+static void SRAM_putUint16(uint8 * a_buffer, uint16 a_value)
+{
+	a_buffer[0] = (uint8)a_value;
+	a_buffer[1] = (uint8)(a_value >> 8);
+}
+
+/*
+ * @brief start the scan of the painted space, the paint itself runs before main
+ * */
+void SRAM_init(void)
+{
+	SRAM_g_mark = (const uint8 *)SP;
+	SRAM_g_cursor = SRAM_BOTTOM;
+	SRAM_g_warningPending = FALSE;
+}
+
+/*
+ * @brief return the static RAM, the free RAM and the lowest free RAM seen so far
+ * */
+void SRAM_getUsage(SRAM_UsageType * a_usage)
+{
+	a_usage->staticBytes = (uint16)(SRAM_BOTTOM - (const uint8 *)RAMSTART);
+	a_usage->freeBytes = (uint16)((const uint8 *)SP + 1 - SRAM_BOTTOM);
+	a_usage->lowestFreeBytes = (uint16)(SRAM_g_mark - SRAM_BOTTOM);
+}
+
+/*
+ * @brief scan the next SRAM_SCAN_BYTES of the free space and send the warning
+ * frame when the headroom is below SRAM_WARNING_BYTES, it must be called from the main loop.
+ * */
+void SRAM_process(void)
+{
+	SRAM_UsageType usage;
+	uint8 payload[SRAM_PAYLOAD_SIZE];
+	const uint8 * p = SRAM_g_cursor;
+	uint8 i = 0;
+
+	for(i = 0; i < SRAM_SCAN_BYTES && p < SRAM_g_mark; i++, p++)
+	{
+		if(*p != SRAM_CANARY)
+		{
+			/*the stack went deeper since the last pass*/
+			SRAM_g_mark = p;
+			if((uint16)(p - SRAM_BOTTOM) < SRAM_WARNING_BYTES)
+			{
+				SRAM_g_warningPending = TRUE;
+			}
+			break;
+		}
+	}
+	/*a pass ends at the mark, the next one starts again from the bottom*/
+	SRAM_g_cursor = (p < SRAM_g_mark) ? p : SRAM_BOTTOM;
+
+	if(SRAM_g_warningPending && TELEMETRY_canSend(SRAM_PAYLOAD_SIZE))
+	{
+		SRAM_getUsage(&usage);
+		SRAM_putUint16(&payload[0], usage.staticBytes);
+		SRAM_putUint16(&payload[2], usage.freeBytes);
+		SRAM_putUint16(&payload[4], usage.lowestFreeBytes);
+		SRAM_putUint16(&payload[6], SRAM_WARNING_BYTES);
+		TELEMETRY_sendFrame(TELEMETRY_FRAME_MEMORY, payload, SRAM_PAYLOAD_SIZE);
+		SRAM_g_warningPending = FALSE;
+	}
+}
+
+#endif /* SRAM_ENABLED */
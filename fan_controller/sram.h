@@ -0,0 +1,89 @@
+/*
+ *
+ * Module: SRAM monitor
+ *
+ * File Name: sram.h
+ *
+ * Description: Header file for the stack high-water mark and SRAM usage monitor.
+ *
+ * The ATmega32 has 2KB of SRAM: .data and .bss from RAMSTART, then the free
+ * space, then the stack growing down from RAMEND. There is no heap (no malloc).
+ *
+ * 	RAMSTART	.data .bss	__heap_start	free (painted)	SP	stack	RAMEND
+ *
+ * Before .data and .bss are set up the free space is painted with SRAM_CANARY.
+ * The stack and the ISRs overwrite the canary as they grow, so the lowest
+ * overwritten byte is the high-water mark of the stack. SRAM_process scans
+ * at most SRAM_SCAN_BYTES per call from __heap_start up to the mark, a full
+ * pass takes a few hundred loops and no call takes long.
+ *
+ * When the free space under the mark drops below SRAM_WARNING_BYTES a
+ * MEMORY frame is sent, then again for every new lower mark:
+ *
+ * 	static(2) | free now(2) | lowest free(2) | threshold(2)
+ *
+ * "get memory" answers the same numbers in text. The RAM of every module is
+ * listed by the bench Makefile (build/sram.csv).
+ *
+ * The monitor uses the AVR linker symbols, the host port builds without it
+ * (-DSRAM_ENABLED=0) and the macros are then empty.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef SRAM_H_
+#define SRAM_H_
+
+#include"std_types.h"
+
+#ifndef SRAM_ENABLED
+#define SRAM_ENABLED			1
+#endif
+
+#ifndef SRAM_WARNING_BYTES
+#define SRAM_WARNING_BYTES		128 /*stack headroom that raises the warning*/
+#endif
+
+#define SRAM_CANARY				0xC5
+#define SRAM_SCAN_BYTES			16
+#define SRAM_PAYLOAD_SIZE		8
+
+typedef struct
+{
+	uint16 staticBytes; /*.data, .bss and .noinit*/
+	uint16 freeBytes; /*between __heap_start and the stack pointer now*/
+	uint16 lowestFreeBytes; /*between __heap_start and the high-water mark*/
+}SRAM_UsageType;
+
+#if (SRAM_ENABLED == 1)
+
+#define SRAM_INIT()				SRAM_init()
+#define SRAM_PROCESS()			SRAM_process()
+
+/*
+ * @brief start the scan of the painted space, the paint itself runs before main
+ * */
+void SRAM_init(void);
+
+/*
+ * @brief scan the next SRAM_SCAN_BYTES of the free space and send the warning
+ * frame when the headroom is below SRAM_WARNING_BYTES, it must be called from the main loop.
+ * */
+void SRAM_process(void);
+
+/*
+ * @brief return the static RAM, the free RAM and the lowest free RAM seen so far
+ * */
+void SRAM_getUsage(SRAM_UsageType * a_usage);
+
+#else
+
+#define SRAM_INIT()
+#define SRAM_PROCESS()
+
+#endif /* SRAM_ENABLED */
+
+#endif /* SRAM_H_ */
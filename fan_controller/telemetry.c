@@ -0,0 +1,197 @@
+/*
+ *
+ * Module: Telemetry
+ *
+ * File Name: telemetry.c
+ *
+ * Description: Source file for the binary telemetry stream sent over the UART
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"telemetry.h"
+#include"uart.h"
+#include"timer.h"
+#include"crc.h"
+#include"trace.h"
+
+/*
+ * The frame is built and COBS encoded in place:
+ * [COBS code][type][sequence][payload...][CRC low][CRC high][0x00]
+ * */
+#define TELEMETRY_FRAME_OVERHEAD		6
+
+/*Global Variables */
+static uint8 TELEMETRY_g_frame[TELEMETRY_MAX_PAYLOAD + TELEMETRY_FRAME_OVERHEAD];
+static uint8 TELEMETRY_g_sequence = 0;
+static uint16 TELEMETRY_g_period = TELEMETRY_DEFAULT_PERIOD_MS;
+static uint32 TELEMETRY_g_lastSample = 0;
+static uint16 TELEMETRY_g_dropped = 0;
+
+/*
+ * @brief COBS encode a_length bytes starting at a_frame[1] in place
+ * and append the 0x00 delimiter.
+ * a_frame[0] is reserved for the first COBS code byte.
+ * The frame is always shorter than 254 bytes so no extra code bytes are needed.
+ *
+ * @return uint8 the length of the encoded frame including the delimiter
+ * */
+static uint8 TELEMETRY_cobsEncode(uint8 * a_frame, uint8 a_length)
+{
+	uint8 i = 0, codeIndex = 0;
+	for(i = 1; i <= a_length; i++)
+	{
+		if(a_frame[i] == 0)
+		{
+			/*Replace the zero by the distance to the next zero*/
+			a_frame[codeIndex] = i - codeIndex;
+			codeIndex = i;
+		}
+	}
+	a_frame[codeIndex] = i - codeIndex;
+	a_frame[i] = 0; /*frame delimiter*/
+	return i + 1;
+}
+
+/*
+ * @brief write a 16-bit value in little endian order
+ * */
+static void TELEMETRY_putUint16(uint8 * a_buffer, uint16 a_value)
+{
+	a_buffer[0] = (uint8)a_value;
+	a_buffer[1] = (uint8)(a_value >> 8);
+}
+
+/*
+ * @brief initialize the telemetry stream.
+ * The UART must be initialized before sending any frame.
+ *
+ * @param a_periodMs the time between two sample frames
+ * */
+void TELEMETRY_init(uint16 a_periodMs)
+{
+	TELEMETRY_setPeriod(a_periodMs);
+	TELEMETRY_g_sequence = 0;
+	TELEMETRY_g_dropped = 0;
+	TELEMETRY_g_lastSample = TIMER_getTicks();
+}
+
+/*
+ * @brief change the time between two sample frames,
+ * values below TELEMETRY_MIN_PERIOD_MS are clamped to it
+ * */
+void TELEMETRY_setPeriod(uint16 a_periodMs)
+{
+	if(a_periodMs < TELEMETRY_MIN_PERIOD_MS)
+	{
+		/*The UART bandwidth can not keep up with a shorter period*/
+		a_periodMs = TELEMETRY_MIN_PERIOD_MS;
+	}
+	TELEMETRY_g_period = a_periodMs;
+}
+
+/*
+ * @brief return the time between two sample frames
+ * */
+uint16 TELEMETRY_getPeriod(void)
+{
+	return TELEMETRY_g_period;
+}
+
+/*
+ * @brief return TRUE if the period has passed since the last sample frame
+ * */
+uint8 TELEMETRY_isDue(void)
+{
+	/*unsigned subtraction keeps working when the tick counter wraps*/
+	return (uint32)(TIMER_getTicks() - TELEMETRY_g_lastSample) >= TELEMETRY_g_period ? TRUE : FALSE;
+}
+
+/*
+ * @brief encode and queue a frame of any type, the frame is dropped
+ * instead of waiting when the UART buffer has no room for it.
+ *
+ * @param a_type the frame type
+ *
+ * @param a_payload the frame payload, can be NULL_PTR if a_length is 0
+ *
+ * @param a_length the payload length (0 -> TELEMETRY_MAX_PAYLOAD)
+ *
+ * @return TELEMETRY_ErrorType
+ * */
+TELEMETRY_ErrorType TELEMETRY_sendFrame(uint8 a_type, const uint8 * a_payload, uint8 a_length)
+{
+	uint8 i = 0, length = 0;
+	uint16 crc = 0;
+	if(a_length > TELEMETRY_MAX_PAYLOAD)
+	{
+		return TELEMETRY_ERROR_TOO_LONG;
+	}
+
+	TELEMETRY_g_frame[1] = a_type;
+	TELEMETRY_g_frame[2] = TELEMETRY_g_sequence;
+	for(i = 0; i < a_length; i++)
+	{
+		TELEMETRY_g_frame[3 + i] = a_payload[i];
+	}
+	crc = CRC16_update(CRC16_INITIAL_VALUE, &TELEMETRY_g_frame[1], a_length + 2);
+	TELEMETRY_putUint16(&TELEMETRY_g_frame[3 + a_length], crc);
+
+	length = TELEMETRY_cobsEncode(TELEMETRY_g_frame, a_length + 4);
+	if(UART_sendBuffer(TELEMETRY_g_frame, length) != UART_SUCCESS)
+	{
+		/*Never wait for the UART, the control loop has a higher priority*/
+		TELEMETRY_g_dropped++;
+		return TELEMETRY_ERROR_DROPPED;
+	}
+	/*The sequence only moves for sent frames, so a gap on the host side means a lost byte*/
+	TELEMETRY_g_sequence++;
+	TRACE_EVENT(TRACE_TELEMETRY_FRAME, a_type | ((uint16)a_length << 8));
+	return TELEMETRY_SUCCESS;
+}
+
+/*
+ * @brief encode and queue a sample frame
+ *
+ * @param a_sample the values to be sent
+ *
+ * @return TELEMETRY_ErrorType TELEMETRY_ERROR_DROPPED if the UART had no room for the frame
+ * */
+TELEMETRY_ErrorType TELEMETRY_sendSample(const TELEMETRY_SampleType * a_sample)
+{
+	uint8 payload[TELEMETRY_SAMPLE_PAYLOAD_SIZE];
+
+	TELEMETRY_putUint16(&payload[0], (uint16)a_sample->timestamp);
+	TELEMETRY_putUint16(&payload[2], (uint16)(a_sample->timestamp >> 16));
+	TELEMETRY_putUint16(&payload[4], a_sample->adcValue);
+	TELEMETRY_putUint16(&payload[6], (uint16)a_sample->temperature);
+	payload[8] = a_sample->duty;
+	payload[9] = a_sample->fanState;
+	payload[10] = a_sample->adcError;
+	payload[11] = a_sample->motorError;
+
+	/*Keep the rate even if the frame is dropped, a retry would only make the congestion worse*/
+	TELEMETRY_g_lastSample = TIMER_getTicks();
+	return TELEMETRY_sendFrame(TELEMETRY_FRAME_SAMPLE, payload, TELEMETRY_SAMPLE_PAYLOAD_SIZE);
+}
+
+/*
+ * @brief return TRUE if a frame with a_length bytes of payload can be queued now,
+ * modules sending a long dump use it to wait for room instead of losing frames
+ * */
+uint8 TELEMETRY_canSend(uint8 a_length)
+{
+	/*the COBS code byte, type, sequence, CRC and delimiter*/
+	return UART_getTxFree() >= (uint16)a_length + TELEMETRY_FRAME_OVERHEAD ? TRUE : FALSE;
+}
+
+/*
+ * @brief return the number of frames dropped because the UART was busy
+ * */
+uint16 TELEMETRY_getDroppedFrames(void)
+{
+	return TELEMETRY_g_dropped;
+}
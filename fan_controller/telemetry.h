@@ -0,0 +1,123 @@
+/*
+ *
+ * Module: Telemetry
+ *
+ * File Name: telemetry.h
+ *
+ * Description: Header file for the binary telemetry stream sent over the UART
+ *
+ * Frame format (all multi-byte fields are little endian):
+ *
+ * 	raw frame  = type(1) | sequence(1) | payload(0 -> TELEMETRY_MAX_PAYLOAD) | CRC16(2)
+ * 	wire frame = COBS(raw frame) | 0x00
+ *
+ * The CRC is CRC-16/CCITT-FALSE over type, sequence and payload.
+ * COBS removes every 0x00 from the frame so the 0x00 delimiter always marks the
+ * end of a frame and a receiver can re-synchronize after any lost byte.
+ *
+ * Layer: Application Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include"std_types.h"
+
+#define TELEMETRY_DEFAULT_PERIOD_MS		1000
+#define TELEMETRY_MIN_PERIOD_MS			100
+#define TELEMETRY_MAX_PAYLOAD			64
+
+/*Frame types*/
+#define TELEMETRY_FRAME_SAMPLE			0x01
+#define TELEMETRY_FRAME_RESPONSE		0x02 /*ASCII reply to a command line*/
+#define TELEMETRY_FRAME_HISTORY_BLOCK	0x03 /*one RAM block of the history, see history.h*/
+#define TELEMETRY_FRAME_HISTORY_SUMMARY	0x04 /*one EEPROM summary record of the history*/
+#define TELEMETRY_FRAME_HISTORY_END		0x05 /*end of a history dump*/
+#define TELEMETRY_FRAME_PROBE			0x06 /*one latency histogram, see probe.h*/
+#define TELEMETRY_FRAME_TRACE			0x07 /*records of the event trace, see trace.h*/
+#define TELEMETRY_FRAME_MEMORY			0x08 /*low stack headroom warning, see sram.h*/
+#define TELEMETRY_FRAME_ENERGY			0x09 /*record of the energy counters, see energy.h*/
+#define TELEMETRY_FRAME_ERROR			0x0A /*one code of the error log, see error.h*/
+
+/*Size of the sample frame payload on the wire*/
+#define TELEMETRY_SAMPLE_PAYLOAD_SIZE	12
+
+#define TELEMETRY_SUCCESS				0
+#define TELEMETRY_ERROR_TOO_LONG		TELEMETRY_SUCCESS + 1
+#define TELEMETRY_ERROR_DROPPED			TELEMETRY_ERROR_TOO_LONG + 1
+
+typedef uint8 TELEMETRY_ErrorType;
+
+typedef struct
+{
+	uint32 timestamp; /*ms since boot*/
+	uint16 adcValue; /*raw ADC code of the LM35 channel*/
+	sint16 temperature; /*LM35_TemperatureType, 1/64C*/
+	uint8 duty; /*fan speed in percent*/
+	uint8 fanState;
+	uint8 adcError;
+	uint8 motorError;
+}TELEMETRY_SampleType;
+
+/*
+ * @brief initialize the telemetry stream.
+ * The UART must be initialized before sending any frame.
+ *
+ * @param a_periodMs the time between two sample frames
+ * */
+void TELEMETRY_init(uint16 a_periodMs);
+
+/*
+ * @brief change the time between two sample frames,
+ * values below TELEMETRY_MIN_PERIOD_MS are clamped to it
+ * */
+void TELEMETRY_setPeriod(uint16 a_periodMs);
+
+/*
+ * @brief return the time between two sample frames
+ * */
+uint16 TELEMETRY_getPeriod(void);
+
+/*
+ * @brief return TRUE if the period has passed since the last sample frame
+ * */
+uint8 TELEMETRY_isDue(void);
+
+/*
+ * @brief encode and queue a sample frame
+ *
+ * @param a_sample the values to be sent
+ *
+ * @return TELEMETRY_ErrorType TELEMETRY_ERROR_DROPPED if the UART had no room for the frame
+ * */
+TELEMETRY_ErrorType TELEMETRY_sendSample(const TELEMETRY_SampleType * a_sample);
+
+/*
+ * @brief encode and queue a frame of any type, the frame is dropped
+ * instead of waiting when the UART buffer has no room for it.
+ *
+ * @param a_type the frame type
+ *
+ * @param a_payload the frame payload, can be NULL_PTR if a_length is 0
+ *
+ * @param a_length the payload length (0 -> TELEMETRY_MAX_PAYLOAD)
+ *
+ * @return TELEMETRY_ErrorType
+ * */
+TELEMETRY_ErrorType TELEMETRY_sendFrame(uint8 a_type, const uint8 * a_payload, uint8 a_length);
+
+/*
+ * @brief return TRUE if a frame with a_length bytes of payload can be queued now,
+ * modules sending a long dump use it to wait for room instead of losing frames
+ * */
+uint8 TELEMETRY_canSend(uint8 a_length);
+
+/*
+ * @brief return the number of frames dropped because the UART was busy
+ * */
+uint16 TELEMETRY_getDroppedFrames(void);
+
+#endif /* TELEMETRY_H_ */
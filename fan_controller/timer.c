@@ -0,0 +1,140 @@
+/*
+ *
+ * Module: Timer
+ *
+ * File Name: timer.c
+ *
+ * Description: Source file for the AVR system tick timer driver
+ *
+ * Layer: Micro controller Abstraction Layer (MCAL)
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"timer.h"
+#include<avr/io.h>
+#include<avr/interrupt.h>
+
+/*Global Variables */
+static volatile uint32 TIMER_g_ticks = 0;
+static TIMER_CallbackType TIMER_g_callbacks[TIMER_MAX_CALLBACKS] = {NULL_PTR};
+static uint8 TIMER_g_callbacksCount = 0;
+
+/*
+ * @brief will be called every 1ms on the compare match of timer 2
+ * */
+ISR(TIMER2_COMP_vect)
+{
+	uint8 i = 0;
+	TIMER_g_ticks++;
+	for(i = 0; i < TIMER_g_callbacksCount; i++)
+	{
+		TIMER_g_callbacks[i]();
+	}
+}
+
+/*
+ * @brief start timer 2 as a 1ms system tick
+ *
+ * @return void
+ * */
+void TIMER_init(void)
+{
+	TCNT2 = 0; /*Start counting from 0*/
+	OCR2 = TIMER_TICK_COMPARE; /*1ms compare value*/
+
+	/* Configure timer control register
+	 * 1. CTC mode WGM21=1 & WGM20=0
+	 * 2. Normal port operation, OC2 disconnected
+	 * 3. clock = F_CPU/8 CS21=1
+	 */
+	TCCR2 = (1 << WGM21) | (1 << CS21);
+	TIMSK |= (1 << OCIE2); /*Enable the compare match interrupt*/
+
+	SREG |= (1 << SREG_I);/*Set the i-bit*/
+}
+
+/*
+ * @brief stop the system tick and remove all the registered callbacks
+ *
+ * @return void
+ * */
+void TIMER_deInit(void)
+{
+	TCCR2 = 0;
+	TCNT2 = 0;
+	OCR2 = 0;
+	TIMSK &= ~(1 << OCIE2);
+	TIMER_g_callbacksCount = 0;
+}
+
+/*
+ * @brief return the number of milliseconds passed since TIMER_init
+ *
+ * @return uint32 the tick counter
+ * */
+uint32 TIMER_getTicks(void)
+{
+	uint32 ticks = 0;
+	uint8 sreg = SREG;
+	cli(); /*The counter is 4 bytes, it must not change while being copied*/
+	ticks = TIMER_g_ticks;
+	SREG = sreg;
+	return ticks;
+}
+
+/*
+ * @brief register a function to be called from the tick ISR every millisecond.
+ * The callback runs with interrupts disabled so it must be short.
+ *
+ * @param a_callback the function to be called
+ *
+ * @return uint8 TRUE if it was registered, FALSE if there is no free slot
+ * */
+uint8 TIMER_setCallback(TIMER_CallbackType a_callback)
+{
+	uint8 sreg = 0;
+	if(a_callback == NULL_PTR || TIMER_g_callbacksCount >= TIMER_MAX_CALLBACKS)
+	{
+		return FALSE;
+	}
+	sreg = SREG;
+	cli();
+	TIMER_g_callbacks[TIMER_g_callbacksCount] = a_callback;
+	TIMER_g_callbacksCount++;
+	SREG = sreg;
+	return TRUE;
+}
+
+/*
+ * @brief start timer 1 as the free running timestamp counter,
+ * it can be called by every user of the timestamp
+ *
+ * @return void
+ * */
+void TIMER_startTimestamp(void)
+{
+	/* Configure timer control registers
+	 * 1. Normal mode, the counter wraps at 0xFFFF
+	 * 2. OC1A/OC1B disconnected
+	 * 3. clock = F_CPU/8 CS11=1, no interrupt
+	 */
+	TCCR1A = 0;
+	TCCR1B = (1 << CS11);
+}
+
+/*
+ * @brief read the timestamp counter, it can be called from an ISR
+ *
+ * @return uint16 the counter in units of TIMER_TIMESTAMP_PRESCALER cycles
+ * */
+uint16 TIMER_getTimestamp(void)
+{
+	uint16 now = 0;
+	uint8 sreg = SREG;
+	cli(); /*The 16-bit read uses the TEMP register shared by all the Timer1 registers*/
+	now = TCNT1;
+	SREG = sreg;
+	return now;
+}
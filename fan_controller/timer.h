@@ -0,0 +1,82 @@
+/*
+ *
+ * Module: Timer
+ *
+ * File Name: timer.h
+ *
+ * Description: Header file for the AVR system tick timer driver
+ *
+ * Layer: Micro controller Abstraction Layer (MCAL)
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include"std_types.h"
+
+/*
+ * Timer2 is used as the system tick in CTC mode with F_CPU/8 pre-scaler
+ * F_TICK = (F_CPU) / (8 * (OCR2 + 1)) = (10^6) / (8 * 125) = 1000Hz
+ * */
+#define TIMER_TICK_MS				1
+#define TIMER_TICK_COMPARE			((uint8)((F_CPU / 8UL / 1000UL) - 1))
+#define TIMER_MAX_CALLBACKS			4
+
+/*
+ * Timer1 runs free in normal mode with F_CPU/8 pre-scaler as the fine time base
+ * of the probes and the trace: one count is 8us at 1MHz, it wraps every 524ms
+ * */
+#define TIMER_TIMESTAMP_PRESCALER	8
+
+typedef void (*TIMER_CallbackType)(void);
+
+/*
+ * @brief start timer 2 as a 1ms system tick without callbacks
+ *
+ * @return void
+ * */
+void TIMER_init(void);
+
+/*
+ * @brief stop the system tick and remove all the registered callbacks
+ *
+ * @return void
+ * */
+void TIMER_deInit(void);
+
+/*
+ * @brief return the number of milliseconds passed since TIMER_init
+ *
+ * @return uint32 the tick counter
+ * */
+uint32 TIMER_getTicks(void);
+
+/*
+ * @brief register a function to be called from the tick ISR every millisecond.
+ * The callback runs with interrupts disabled so it must be short.
+ *
+ * @param a_callback the function to be called
+ *
+ * @return uint8 TRUE if it was registered, FALSE if there is no free slot
+ * */
+uint8 TIMER_setCallback(TIMER_CallbackType a_callback);
+
+/*
+ * @brief start timer 1 as the free running timestamp counter,
+ * it can be called by every user of the timestamp
+ *
+ * @return void
+ * */
+void TIMER_startTimestamp(void);
+
+/*
+ * @brief read the timestamp counter, it can be called from an ISR
+ *
+ * @return uint16 the counter in units of TIMER_TIMESTAMP_PRESCALER cycles
+ * */
+uint16 TIMER_getTimestamp(void);
+
+#endif /* TIMER_H_ */
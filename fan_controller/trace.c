@@ -0,0 +1,148 @@
+/*
+ *
+ * Module: Trace
+ *
+ * File Name: trace.c
+ *
+ * Description: Source file for the binary event trace
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"trace.h"
+
+#if (TRACE_ENABLED == 1)
+
+#include"telemetry.h"
+#include<avr/io.h>
+#include<avr/interrupt.h>
+
+typedef struct
+{
+	uint8 event;
+	uint16 timestamp;
+	uint16 argument;
+}TRACE_RecordType;
+
+/*Global Variables */
+static TRACE_RecordType TRACE_g_ring[TRACE_RING_SIZE];
+static volatile uint8 TRACE_g_head = 0; /*next slot to write*/
+static volatile uint8 TRACE_g_count = 0;
+static volatile uint8 TRACE_g_running = FALSE;
+static uint8 TRACE_g_dumping = FALSE;
+static uint8 TRACE_g_dumpIndex = 0;
+
+/*
+ * @brief start the timestamp counter and clear the ring
+ * */
+void TRACE_init(void)
+{
+	TIMER_startTimestamp();
+	TRACE_g_head = 0;
+	TRACE_g_count = 0;
+	TRACE_g_dumping = FALSE;
+	TRACE_g_running = TRUE;
+}
+
+/*
+ * @brief write one record, it can be called from an ISR
+ *
+ * @param a_event the id with its flags
+ *
+ * @param a_argument the value attached to the event
+ * */
+void TRACE_record(uint8 a_event, uint16 a_argument)
+{
+	TRACE_RecordType * record = NULL_PTR;
+	uint16 now = 0;
+	uint8 sreg = SREG;
+
+	if(!TRACE_g_running)
+	{
+		return;
+	}
+	/*
+	 * Only the slot and the timestamp are taken with the interrupts disabled,
+	 * so the records are in time order and an ISR never writes the same slot
+	 * */
+	cli();
+	record = &TRACE_g_ring[TRACE_g_head];
+	TRACE_g_head = (TRACE_g_head + 1) & TRACE_RING_MASK;
+	if(TRACE_g_count < TRACE_RING_SIZE)
+	{
+		TRACE_g_count++;
+	}
+	now = TCNT1;
+	SREG = sreg;
+
+	record->event = a_event;
+	record->timestamp = now;
+	record->argument = a_argument;
+}
+
+/*
+ * @brief stop the recording and start sending the ring
+ *
+ * @return uint8 FALSE if a dump is already running
+ * */
+uint8 TRACE_startDump(void)
+{
+	if(TRACE_g_dumping)
+	{
+		return FALSE;
+	}
+	/*called from the main loop, no record of it can be half written*/
+	TRACE_g_running = FALSE;
+	TRACE_g_dumping = TRUE;
+	TRACE_g_dumpIndex = 0;
+	return TRUE;
+}
+
+/*
+ * @brief send the next trace frame when the UART has room for it,
+ * it must be called from the main loop.
+ * */
+void TRACE_process(void)
+{
+	uint8 payload[2 + (TRACE_RECORDS_PER_FRAME * TRACE_RECORD_SIZE)];
+	uint8 frames = 0, first = 0, count = 0, i = 0, length = 2;
+	const TRACE_RecordType * record = NULL_PTR;
+
+	if(!TRACE_g_dumping || !TELEMETRY_canSend(sizeof(payload)))
+	{
+		return;
+	}
+	frames = (TRACE_g_count + TRACE_RECORDS_PER_FRAME - 1) / TRACE_RECORDS_PER_FRAME;
+	frames = (frames == 0) ? 1 : frames; /*an empty trace still ends the dump*/
+	first = TRACE_g_dumpIndex * TRACE_RECORDS_PER_FRAME;
+	count = (TRACE_g_count > first) ? (TRACE_g_count - first) : 0;
+	count = (count > TRACE_RECORDS_PER_FRAME) ? TRACE_RECORDS_PER_FRAME : count;
+
+	payload[0] = TRACE_g_dumpIndex;
+	payload[1] = frames;
+	for(i = 0; i < count; i++)
+	{
+		/*the oldest record is count records behind the head*/
+		record = &TRACE_g_ring[(TRACE_g_head - TRACE_g_count + first + i) & TRACE_RING_MASK];
+		payload[length++] = record->event;
+		payload[length++] = (uint8)record->timestamp;
+		payload[length++] = (uint8)(record->timestamp >> 8);
+		payload[length++] = (uint8)record->argument;
+		payload[length++] = (uint8)(record->argument >> 8);
+	}
+	TELEMETRY_sendFrame(TELEMETRY_FRAME_TRACE, payload, length);
+
+	TRACE_g_dumpIndex++;
+	if(TRACE_g_dumpIndex == frames)
+	{
+		TRACE_g_dumping = FALSE;
+		TRACE_g_head = 0;
+		TRACE_g_count = 0;
+		TRACE_g_running = TRUE;
+	}
+}
+
+#endif /* TRACE_ENABLED */
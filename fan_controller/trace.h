@@ -0,0 +1,117 @@
+/*
+ *
+ * Module: Trace
+ *
+ * File Name: trace.h
+ *
+ * Description: Header file for the binary event trace.
+ *
+ * Events are written by the ISRs and the main loop into a RAM ring that keeps
+ * the last TRACE_RING_SIZE of them. A record is 5 bytes:
+ *
+ * 	event(1) | timestamp(2) | argument(2)
+ *
+ * 	event = flags(2) | id(6), the flags tell an instant event from the
+ * 	begin or the end of a duration
+ *
+ * The timestamp is the Timer1 counter of timer.h (8us at 1MHz). Only the slot
+ * is reserved with the interrupts disabled, so an ISR can write its event in
+ * the middle of the one of the main loop without any lock.
+ *
+ * "get trace" stops the recording and sends the ring oldest first as TRACE frames,
+ * TRACE_RECORDS_PER_FRAME records each, then clears it and records again:
+ *
+ * 	index(1) | frames(1) | records(5 * n)
+ *
+ * The trace takes TRACE_RING_SIZE * 5 bytes of RAM, it is compiled only when
+ * TRACE_ENABLED is 1 (-DTRACE_ENABLED=1), otherwise the macros are empty.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include"std_types.h"
+#include"timer.h"
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED			0
+#endif
+
+#define TRACE_RING_SIZE			64 /*must be a power of 2 up to 128*/
+#define TRACE_RING_MASK			(TRACE_RING_SIZE - 1)
+#define TRACE_RECORD_SIZE		5
+#define TRACE_RECORDS_PER_FRAME	12
+#define TRACE_FRAMES			((TRACE_RING_SIZE + TRACE_RECORDS_PER_FRAME - 1) / TRACE_RECORDS_PER_FRAME)
+
+/*Event flags*/
+#define TRACE_FLAG_INSTANT		0x00
+#define TRACE_FLAG_BEGIN		0x40
+#define TRACE_FLAG_END			0x80
+#define TRACE_FLAGS_MASK		0xC0
+#define TRACE_ID_MASK			0x3F
+
+/*Event ids, the ones below TRACE_FIRST_TASK_ID come from ISRs*/
+#define TRACE_ADC_ISR			1 /*argument: conversion result*/
+#define TRACE_UART_RX_ISR		2 /*argument: received byte*/
+#define TRACE_UART_TX_IDLE		3 /*the last queued byte was sent*/
+#define TRACE_EEPROM_ISR		4 /*argument: bytes left to write*/
+#define TRACE_FIRST_TASK_ID		16
+#define TRACE_SAMPLE			16 /*argument at the end: temperature | fan speed << 8*/
+#define TRACE_SENSOR			17 /*argument: ADC code at the end*/
+#define TRACE_MOTOR				18 /*argument: new fan speed, then the error code*/
+#define TRACE_COMMAND			19 /*argument: line length, then response length*/
+#define TRACE_TELEMETRY_FRAME	20 /*argument: type | length << 8*/
+#define TRACE_NVM_SAVE			21 /*argument: journal sequence*/
+#define TRACE_SENSOR_FAULT		22 /*argument: SENSOR_FaultType, SENSOR_OK when it clears*/
+
+#if (TRACE_ENABLED == 1)
+
+#define TRACE_INIT()					TRACE_init()
+#define TRACE_EVENT(id, argument)		TRACE_record((id) | TRACE_FLAG_INSTANT, (argument))
+#define TRACE_BEGIN(id, argument)		TRACE_record((id) | TRACE_FLAG_BEGIN, (argument))
+#define TRACE_END(id, argument)			TRACE_record((id) | TRACE_FLAG_END, (argument))
+#define TRACE_PROCESS()					TRACE_process()
+
+/*
+ * @brief start the timestamp counter and clear the ring
+ * */
+void TRACE_init(void);
+
+/*
+ * @brief write one record, it can be called from an ISR
+ *
+ * @param a_event the id with its flags
+ *
+ * @param a_argument the value attached to the event
+ * */
+void TRACE_record(uint8 a_event, uint16 a_argument);
+
+/*
+ * @brief stop the recording and start sending the ring
+ *
+ * @return uint8 FALSE if a dump is already running
+ * */
+uint8 TRACE_startDump(void);
+
+/*
+ * @brief send the next trace frame when the UART has room for it,
+ * it must be called from the main loop.
+ * */
+void TRACE_process(void);
+
+#else
+
+#define TRACE_INIT()
+#define TRACE_EVENT(id, argument)
+#define TRACE_BEGIN(id, argument)
+#define TRACE_END(id, argument)
+#define TRACE_PROCESS()
+
+#endif /* TRACE_ENABLED */
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,221 @@
+/*
+ *
+ * Module: UART
+ *
+ * File Name: uart.c
+ *
+ * Description: Source file for the AVR interrupt driven UART driver
+ *
+ * Layer: Micro controller Abstraction Layer (MCAL)
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"uart.h"
+#include<avr/io.h>
+#include<avr/interrupt.h>
+#include"common_macros.h"
+#include"trace.h"
+
+/*Global Variables */
+static uint8 UART_g_txBuffer[UART_TX_BUFFER_SIZE];
+static volatile uint8 UART_g_txHead = 0; /*next free slot, written by the task*/
+static volatile uint8 UART_g_txTail = 0; /*next byte to be sent, written by the ISR*/
+static uint8 UART_g_rxBuffer[UART_RX_BUFFER_SIZE];
+static volatile uint8 UART_g_rxHead = 0; /*next free slot, written by the ISR*/
+static volatile uint8 UART_g_rxTail = 0; /*next byte to be read, written by the task*/
+static volatile uint8 UART_g_rxLost = 0;
+static uint8 UART_g_initialized = FALSE;
+
+/*
+ * @brief will be called every time a byte is received
+ * */
+ISR(USART_RXC_vect)
+{
+	uint8 status = UCSRA; /*the error flags must be read before UDR*/
+	uint8 data = UDR;
+	uint8 head = (UART_g_rxHead + 1) & UART_RX_BUFFER_MASK;
+	TRACE_EVENT(TRACE_UART_RX_ISR, data);
+	if(head == UART_g_rxTail || (status & (1 << DOR)))
+	{
+		/*Keep the ISR short, the parser will see a broken line and reject it*/
+		if(UART_g_rxLost < 0xFF)
+		{
+			UART_g_rxLost++;
+		}
+	}
+	if(head != UART_g_rxTail)
+	{
+		UART_g_rxBuffer[UART_g_rxHead] = data;
+		UART_g_rxHead = head;
+	}
+}
+
+/*
+ * @brief will be called every time the data register is ready for a new byte
+ * */
+ISR(USART_UDRE_vect)
+{
+	if(UART_g_txTail != UART_g_txHead)
+	{
+		UDR = UART_g_txBuffer[UART_g_txTail];
+		UART_g_txTail = (UART_g_txTail + 1) & UART_TX_BUFFER_MASK;
+	}
+	else
+	{
+		/*Nothing left to be sent, stop the interrupt until new data is queued*/
+		CLEAR_BIT(UCSRB, UDRIE);
+		TRACE_EVENT(TRACE_UART_TX_IDLE, 0);
+	}
+}
+
+/*
+ * @brief initialize the UART with 8 data bits, no parity and 1 stop bit
+ * using the double speed mode to get a small baud rate error on a 1MHz clock.
+ * Received bytes are stored by the receive complete ISR.
+ *
+ * @param a_config contain the dynamic configuration for the module
+ *
+ * @return void
+ * */
+void UART_init(const UART_configType * a_config)
+{
+	/*
+	 * Double speed mode
+	 * UBRR = (F_CPU / (8 * BAUD)) - 1 rounded to the nearest value
+	 * 9600 baud -> UBRR = 12 (0.2% error)
+	 * */
+	uint16 ubrr = (uint16)(((F_CPU + (4UL * a_config->baudRate)) / (8UL * a_config->baudRate)) - 1);
+
+	UART_g_txHead = 0;
+	UART_g_txTail = 0;
+	UART_g_rxHead = 0;
+	UART_g_rxTail = 0;
+	UART_g_rxLost = 0;
+
+	UCSRA = (1 << U2X);
+	/*
+	 * Enable the receiver with its interrupt and the transmitter,
+	 * the data register empty interrupt is enabled on demand
+	 * */
+	UCSRB = (1 << RXEN) | (1 << RXCIE) | (1 << TXEN);
+	/*URSEL must be set to write UCSRC, 8-bit data mode UCSZ1=1 & UCSZ0=1*/
+	UCSRC = (1 << URSEL) | (1 << UCSZ1) | (1 << UCSZ0);
+	UBRRH = (uint8)(ubrr >> 8);
+	UBRRL = (uint8)ubrr;
+
+	SREG |= (1 << SREG_I);/*Set the i-bit*/
+
+	UART_g_initialized = TRUE;
+}
+
+/*
+ * @brief disable the UART and drop any bytes still waiting to be sent
+ *
+ * @return void
+ * */
+void UART_deInit(void)
+{
+	UCSRB = 0;
+	UCSRA = 0;
+	UART_g_txHead = 0;
+	UART_g_txTail = 0;
+	UART_g_rxHead = 0;
+	UART_g_rxTail = 0;
+	UART_g_initialized = FALSE;
+}
+
+/*
+ * @brief return the number of free bytes in the transmit buffer
+ * */
+uint8 UART_getTxFree(void)
+{
+	/*One slot is always kept empty to tell a full buffer from an empty one*/
+	return (uint8)((UART_g_txTail - UART_g_txHead - 1) & UART_TX_BUFFER_MASK);
+}
+
+/*
+ * @brief queue one byte to be sent by the data register empty ISR.
+ * The function never waits for the hardware.
+ *
+ * @param a_data the byte to be sent
+ *
+ * @return UART_ErrorType UART_ERROR_BUFFER_FULL if there is no room for the byte
+ * */
+UART_ErrorType UART_sendByte(uint8 a_data)
+{
+	return UART_sendBuffer(&a_data, 1);
+}
+
+/*
+ * @brief queue a whole buffer to be sent by the data register empty ISR.
+ * Either all of the buffer is queued or nothing is queued.
+ *
+ * @param a_data pointer to the bytes to be sent
+ *
+ * @param a_length number of bytes
+ *
+ * @return UART_ErrorType UART_ERROR_BUFFER_FULL if there is no room for the whole buffer
+ * */
+UART_ErrorType UART_sendBuffer(const uint8 * a_data, uint8 a_length)
+{
+	uint8 i = 0, head = 0;
+	if(UART_g_initialized == FALSE)
+	{
+		return UART_ERROR_NOT_INIT;
+	}
+	if(a_data == NULL_PTR)
+	{
+		return UART_ERROR_NULL_PTR;
+	}
+	if(a_length > UART_getTxFree())
+	{
+		/*Never block the caller, it is up to it to drop or retry*/
+		return UART_ERROR_BUFFER_FULL;
+	}
+
+	/*Only the task moves the head, so it is safe to fill the slots before publishing them*/
+	head = UART_g_txHead;
+	for(i = 0; i < a_length; i++)
+	{
+		UART_g_txBuffer[head] = a_data[i];
+		head = (head + 1) & UART_TX_BUFFER_MASK;
+	}
+	UART_g_txHead = head;
+
+	SET_BIT(UCSRB, UDRIE); /*Let the ISR drain the buffer*/
+	return UART_SUCCESS;
+}
+
+/*
+ * @brief take one received byte out of the receive buffer, never waits.
+ *
+ * @param a_data pointer to store the received byte in
+ *
+ * @return uint8 TRUE if a byte was received, FALSE if the buffer is empty
+ * */
+uint8 UART_receiveByte(uint8 * a_data)
+{
+	if(a_data == NULL_PTR || UART_g_rxTail == UART_g_rxHead)
+	{
+		return FALSE;
+	}
+	*a_data = UART_g_rxBuffer[UART_g_rxTail];
+	UART_g_rxTail = (UART_g_rxTail + 1) & UART_RX_BUFFER_MASK;
+	return TRUE;
+}
+
+/*
+ * @brief return the number of received bytes lost because the receive buffer
+ * was full or the hardware overrun, the counter is cleared by reading it
+ * */
+uint8 UART_getRxLost(void)
+{
+	uint8 lost = 0, sreg = SREG;
+	cli();
+	lost = UART_g_rxLost;
+	UART_g_rxLost = 0;
+	SREG = sreg;
+	return lost;
+}
@@ -0,0 +1,98 @@
+/*
+ *
+ * Module: UART
+ *
+ * File Name: uart.h
+ *
+ * Description: Header file for the AVR interrupt driven UART driver
+ *
+ * Layer: Micro controller Abstraction Layer (MCAL)
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef UART_H_
+#define UART_H_
+
+#include"std_types.h"
+
+#define UART_DEFAULT_BAUD_RATE		9600
+#define UART_TX_BUFFER_SIZE			128 /*must be a power of 2*/
+#define UART_TX_BUFFER_MASK			(UART_TX_BUFFER_SIZE - 1)
+#define UART_RX_BUFFER_SIZE			32 /*must be a power of 2*/
+#define UART_RX_BUFFER_MASK			(UART_RX_BUFFER_SIZE - 1)
+
+#define UART_SUCCESS				0
+#define UART_ERROR_NOT_INIT			UART_SUCCESS + 1
+#define UART_ERROR_BUFFER_FULL		UART_ERROR_NOT_INIT + 1
+#define UART_ERROR_NULL_PTR			UART_ERROR_BUFFER_FULL + 1
+
+typedef uint8 UART_ErrorType;
+
+typedef struct
+{
+	uint32 baudRate;
+}UART_configType;
+
+/*
+ * @brief initialize the UART with 8 data bits, no parity and 1 stop bit
+ * using the double speed mode to get a small baud rate error on a 1MHz clock.
+ * Received bytes are stored by the receive complete ISR.
+ *
+ * @param a_config contain the dynamic configuration for the module
+ *
+ * @return void
+ * */
+void UART_init(const UART_configType * a_config);
+
+/*
+ * @brief disable the UART and drop any bytes still waiting to be sent
+ *
+ * @return void
+ * */
+void UART_deInit(void);
+
+/*
+ * @brief queue one byte to be sent by the data register empty ISR.
+ * The function never waits for the hardware.
+ *
+ * @param a_data the byte to be sent
+ *
+ * @return UART_ErrorType UART_ERROR_BUFFER_FULL if there is no room for the byte
+ * */
+UART_ErrorType UART_sendByte(uint8 a_data);
+
+/*
+ * @brief queue a whole buffer to be sent by the data register empty ISR.
+ * Either all of the buffer is queued or nothing is queued.
+ *
+ * @param a_data pointer to the bytes to be sent
+ *
+ * @param a_length number of bytes
+ *
+ * @return UART_ErrorType UART_ERROR_BUFFER_FULL if there is no room for the whole buffer
+ * */
+UART_ErrorType UART_sendBuffer(const uint8 * a_data, uint8 a_length);
+
+/*
+ * @brief return the number of free bytes in the transmit buffer
+ * */
+uint8 UART_getTxFree(void);
+
+/*
+ * @brief take one received byte out of the receive buffer, never waits.
+ *
+ * @param a_data pointer to store the received byte in
+ *
+ * @return uint8 TRUE if a byte was received, FALSE if the buffer is empty
+ * */
+uint8 UART_receiveByte(uint8 * a_data);
+
+/*
+ * @brief return the number of received bytes lost because the receive buffer
+ * was full or the hardware overrun, the counter is cleared by reading it
+ * */
+uint8 UART_getRxLost(void);
+
+#endif /* UART_H_ */
@@ -0,0 +1,132 @@
+/*
+ *
+ * Module: VREF
+ *
+ * File Name: vref.c
+ *
+ * Description: Source file for the self-calibration of the ADC reference.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"vref.h"
+#include"adc.h"
+#include"eeprom.h"
+#include"timer.h"
+#include"crc.h"
+
+/*Global Variables */
+static uint16 VREF_g_factor = LM35_VREF_ONE;
+static uint16 VREF_g_savedFactor = LM35_VREF_ONE;
+static uint32 VREF_g_sum = 0; /*bandgap codes of the current round*/
+static uint8 VREF_g_count = 0;
+static uint32 VREF_g_lastSample = 0;
+static uint8 VREF_g_record[VREF_RECORD_SIZE]; /*used by the EEPROM ISR while saving*/
+
+/*
+ * @brief add one bandgap code to the round, apply the factor of a full round
+ *
+ * @return uint8 TRUE if a new factor was applied
+ * */
+static uint8 VREF_sample(void)
+{
+	uint16 code = 0;
+	uint32 factor = 0;
+
+	if(ADC_readBandgapPolling(&code) != ADC_SUCCESS || code == 0)
+	{
+		return FALSE;
+	}
+	VREF_g_sum += code;
+	VREF_g_count++;
+	if(VREF_g_count < VREF_SAMPLES)
+	{
+		return FALSE;
+	}
+	factor = ((uint32)LM35_VREF_ONE * ADC_BANDGAP_CODE * VREF_SAMPLES) / VREF_g_sum;
+	VREF_g_sum = 0;
+	VREF_g_count = 0;
+	if(factor < VREF_MIN_FACTOR || factor > VREF_MAX_FACTOR)
+	{
+		return FALSE;/*the reference or the bandgap is not what it should be, keep the last factor*/
+	}
+	VREF_g_factor = (uint16)factor;
+	LM35_setVrefFactor(VREF_g_factor);
+	return TRUE;
+}
+
+/*
+ * @brief load the saved factor or measure one, the ADC (LM35_init)
+ * and the EEPROM must be initialized before
+ * */
+void VREF_init(void)
+{
+	uint16 crc = 0, factor = 0;
+	uint8 i = 0;
+
+	VREF_g_sum = 0;
+	VREF_g_count = 0;
+	VREF_g_lastSample = TIMER_getTicks();
+	VREF_g_factor = LM35_VREF_ONE;
+	VREF_g_savedFactor = LM35_VREF_ONE;
+	if(EEPROM_readBlock(VREF_EEPROM_ADDRESS, VREF_g_record, VREF_RECORD_SIZE) == EEPROM_SUCCESS)
+	{
+		crc = CRC16_update(CRC16_INITIAL_VALUE, VREF_g_record, VREF_RECORD_SIZE - 2);
+		factor = (uint16)(VREF_g_record[0] | ((uint16)VREF_g_record[1] << 8));
+		if(VREF_g_record[2] == (uint8)crc && VREF_g_record[3] == (uint8)(crc >> 8)
+				&& factor >= VREF_MIN_FACTOR && factor <= VREF_MAX_FACTOR)
+		{
+			VREF_g_factor = factor;
+			VREF_g_savedFactor = factor;
+			LM35_setVrefFactor(factor);
+			return;
+		}
+	}
+	/*a new chip, the first samples must not wait 16s for their factor, it is saved by VREF_process*/
+	for(i = 0; i < VREF_SAMPLES; i++)
+	{
+		if(VREF_sample())
+		{
+			VREF_g_savedFactor = 0;
+		}
+	}
+}
+
+/*
+ * @brief return the factor in use, LM35_VREF_ONE is the nominal ADC_VREF
+ * */
+uint16 VREF_getFactor(void)
+{
+	return VREF_g_factor;
+}
+
+/*
+ * @brief take one bandgap code when it is time, apply a new factor every VREF_SAMPLES
+ * codes and save it when it moved, it must be called from the main loop.
+ * */
+void VREF_process(void)
+{
+	uint16 crc = 0;
+
+	if((uint32)(TIMER_getTicks() - VREF_g_lastSample) >= VREF_SAMPLE_PERIOD_MS)
+	{
+		VREF_g_lastSample = TIMER_getTicks();
+		(void)VREF_sample();
+	}
+	if((VREF_g_factor >= VREF_g_savedFactor + VREF_SAVE_DELTA
+			|| VREF_g_factor + VREF_SAVE_DELTA <= VREF_g_savedFactor) && !EEPROM_isBusy())
+	{
+		VREF_g_record[0] = (uint8)VREF_g_factor;
+		VREF_g_record[1] = (uint8)(VREF_g_factor >> 8);
+		crc = CRC16_update(CRC16_INITIAL_VALUE, VREF_g_record, VREF_RECORD_SIZE - 2);
+		VREF_g_record[2] = (uint8)crc;
+		VREF_g_record[3] = (uint8)(crc >> 8);
+		if(EEPROM_writeBlock(VREF_EEPROM_ADDRESS, VREF_g_record, VREF_RECORD_SIZE) == EEPROM_SUCCESS)
+		{
+			VREF_g_savedFactor = VREF_g_factor;
+		}
+	}
+}
@@ -0,0 +1,66 @@
+/*
+ *
+ * Module: VREF
+ *
+ * File Name: vref.h
+ *
+ * Description: Header file for the self-calibration of the ADC reference.
+ *
+ * The internal 2.56V reference differs from chip to chip by several percent and
+ * every temperature with it. The 1.22V bandgap channel is read against the reference,
+ * the code is ADC_BANDGAP_CODE when the reference is nominal, so the real reference is:
+ *
+ * 	VREF = ADC_VREF * factor / LM35_VREF_ONE,	factor = LM35_VREF_ONE * ADC_BANDGAP_CODE / code
+ *
+ * The factor is averaged over VREF_SAMPLES codes, one taken by VREF_process every
+ * VREF_SAMPLE_PERIOD_MS, so a conversion of the bandgap never delays a control sample.
+ * It is passed to LM35_setVrefFactor which folds it in the scale of the conversion.
+ * A factor out of VREF_MIN_FACTOR -> VREF_MAX_FACTOR is a failed measurement and is dropped.
+ *
+ * The factor is saved when it moved by VREF_SAVE_DELTA from the saved one and loaded
+ * by VREF_init, without a valid record the first factor is measured there at once:
+ *
+ * 	record = factor(2) | CRC16(2)
+ *
+ * EEPROM map:
+ * 	0x280 -> 0x283	reference factor (this module)
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef VREF_H_
+#define VREF_H_
+
+#include"std_types.h"
+#include"lm35.h"
+
+#define VREF_SAMPLES				16
+#define VREF_SAMPLE_PERIOD_MS		1000 /*a new factor every 16s*/
+#define VREF_MIN_FACTOR				(LM35_VREF_ONE - (LM35_VREF_ONE / 8)) /*2.24V*/
+#define VREF_MAX_FACTOR				(LM35_VREF_ONE + (LM35_VREF_ONE / 8)) /*2.88V*/
+#define VREF_SAVE_DELTA				16 /*0.1%, a drift of the bandgap alone is not saved*/
+
+#define VREF_EEPROM_ADDRESS			0x280
+#define VREF_RECORD_SIZE			4
+
+/*
+ * @brief load the saved factor or measure one, the ADC (LM35_init)
+ * and the EEPROM must be initialized before
+ * */
+void VREF_init(void);
+
+/*
+ * @brief return the factor in use, LM35_VREF_ONE is the nominal ADC_VREF
+ * */
+uint16 VREF_getFactor(void);
+
+/*
+ * @brief take one bandgap code when it is time, apply a new factor every VREF_SAMPLES
+ * codes and save it when it moved, it must be called from the main loop.
+ * */
+void VREF_process(void);
+
+#endif /* VREF_H_ */
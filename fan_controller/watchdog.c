@@ -0,0 +1,210 @@
+/*
+ *
+ * Module: Watchdog
+ *
+ * File Name: watchdog.c
+ *
+ * Description: Source file for the watchdog supervision of the control loop.
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#include"watchdog.h"
+#include"eeprom.h"
+#include"timer.h"
+#include"crc.h"
+#include<avr/io.h>
+#include<avr/interrupt.h>
+#include<avr/wdt.h>
+
+#define WATCHDOG_ALL_TASKS			((1 << WATCHDOG_TASKS) - 1)
+#define WATCHDOG_CAUSES_MASK		((1 << WATCHDOG_CAUSES) - 1) /*PORF -> JTRF*/
+#define WATCHDOG_RAM_LOST			((1 << WATCHDOG_CAUSE_POWER_ON) | (1 << WATCHDOG_CAUSE_BROWN_OUT))
+#define WATCHDOG_MAX_COUNT			0xFFFF /*the counter stops there*/
+
+/*Global Variables */
+static volatile uint8 WATCHDOG_g_tasks = 0; /*checked in since the last kick, set by the tick ISR too*/
+static uint8 WATCHDOG_g_causes = 0;
+static uint16 WATCHDOG_g_counts[WATCHDOG_CAUSES];
+static uint8 WATCHDOG_g_loaded = FALSE;
+static uint8 WATCHDOG_g_savePending = FALSE;
+static uint8 WATCHDOG_g_record[WATCHDOG_RECORD_SIZE]; /*used by the EEPROM ISR while saving*/
+
+/*not cleared by the start up code, they keep the duty over a reset*/
+static uint8 WATCHDOG_g_duty __attribute__((section(".noinit")));
+static uint8 WATCHDOG_g_dutyCheck __attribute__((section(".noinit")));
+
+/*
+ * @brief called every 1ms from the tick ISR
+ * */
+static void WATCHDOG_tick(void)
+{
+	WATCHDOG_checkIn(WATCHDOG_TASK_TICK);
+}
+
+/*
+ * @brief read the saved counts and add the causes of this reset
+ *
+ * @return uint8 FALSE if the EEPROM is still busy with a write started before the reset
+ * */
+static uint8 WATCHDOG_load(void)
+{
+	uint16 crc = 0;
+	uint8 i = 0;
+
+	if(EEPROM_readBlock(WATCHDOG_EEPROM_ADDRESS, WATCHDOG_g_record, WATCHDOG_RECORD_SIZE) != EEPROM_SUCCESS)
+	{
+		return FALSE;
+	}
+	crc = CRC16_update(CRC16_INITIAL_VALUE, WATCHDOG_g_record, WATCHDOG_RECORD_SIZE - 2);
+	for(i = 0; i < WATCHDOG_CAUSES; i++)
+	{
+		WATCHDOG_g_counts[i] = 0;
+		if(WATCHDOG_g_record[WATCHDOG_RECORD_SIZE - 2] == (uint8)crc
+				&& WATCHDOG_g_record[WATCHDOG_RECORD_SIZE - 1] == (uint8)(crc >> 8))
+		{
+			WATCHDOG_g_counts[i] = (uint16)(WATCHDOG_g_record[2 * i] | ((uint16)WATCHDOG_g_record[(2 * i) + 1] << 8));
+		}
+		if((WATCHDOG_g_causes & (1 << i)) && WATCHDOG_g_counts[i] != WATCHDOG_MAX_COUNT)
+		{
+			WATCHDOG_g_counts[i]++;
+		}
+	}
+	WATCHDOG_g_loaded = TRUE;
+	return TRUE;
+}
+
+/*
+ * @brief count and clear the reset causes and stop the watchdog left running,
+ * it must be called first in MAIN_init
+ * */
+void WATCHDOG_init(void)
+{
+	WATCHDOG_g_causes = MCUCSR & WATCHDOG_CAUSES_MASK;
+	MCUCSR &= ~WATCHDOG_CAUSES_MASK; /*the next reset sets its own causes only*/
+	/*timed sequence, WDE is only cleared within 4 cycles of WDTOE*/
+	WDTCR = (1 << WDTOE) | (1 << WDE);
+	WDTCR = 0;
+	WATCHDOG_g_tasks = 0;
+	WATCHDOG_g_loaded = FALSE;
+	WATCHDOG_g_savePending = TRUE;
+	(void)WATCHDOG_load();/*else WATCHDOG_process loads them when the EEPROM is free*/
+}
+
+/*
+ * @brief start the watchdog and the check in of the tick, at the end of MAIN_init
+ * */
+void WATCHDOG_start(void)
+{
+	TIMER_setCallback(WATCHDOG_tick);
+	WDTCR = (1 << WDE) | WATCHDOG_TIMEOUT;
+}
+
+/*
+ * @brief report a healthy stage, the watchdog is kicked when all the stages
+ * reported, it can be called from an ISR
+ * */
+void WATCHDOG_checkIn(WATCHDOG_TaskType a_task)
+{
+	uint8 sreg = SREG;
+
+	cli();/*the tick ISR sets its bit in the same byte*/
+	WATCHDOG_g_tasks |= (1 << a_task);
+	if(WATCHDOG_g_tasks == WATCHDOG_ALL_TASKS)
+	{
+		wdt_reset();
+		WATCHDOG_g_tasks = 0;
+	}
+	SREG = sreg;
+}
+
+/*
+ * @brief keep the duty applied to the fan for the next reset
+ * */
+void WATCHDOG_setDuty(uint8 a_duty)
+{
+	WATCHDOG_g_duty = a_duty;
+	WATCHDOG_g_dutyCheck = (uint8)~a_duty;
+}
+
+/*
+ * @brief give the duty applied before the last reset
+ *
+ * @return uint8 FALSE after a power-on or a brown-out, or if the RAM lost it
+ * */
+uint8 WATCHDOG_getRecoveryDuty(uint8 * a_duty)
+{
+	if((WATCHDOG_g_causes & WATCHDOG_RAM_LOST) || WATCHDOG_g_causes == 0
+			|| WATCHDOG_g_dutyCheck != (uint8)~WATCHDOG_g_duty || WATCHDOG_g_duty > 100)
+	{
+		return FALSE;
+	}
+	*a_duty = WATCHDOG_g_duty;
+	return TRUE;
+}
+
+/*
+ * @brief return the MCUCSR causes of the last reset, 1 << WATCHDOG_CAUSE_x
+ * */
+uint8 WATCHDOG_getCauses(void)
+{
+	return WATCHDOG_g_causes;
+}
+
+/*
+ * @brief return the number of resets of a cause
+ * */
+uint16 WATCHDOG_getCount(uint8 a_cause)
+{
+	return (a_cause < WATCHDOG_CAUSES) ? WATCHDOG_g_counts[a_cause] : 0;
+}
+
+/*
+ * @brief set the counts back to 0, they are saved by WATCHDOG_process
+ * */
+void WATCHDOG_clearCounts(void)
+{
+	uint8 i = 0;
+
+	for(i = 0; i < WATCHDOG_CAUSES; i++)
+	{
+		WATCHDOG_g_counts[i] = 0;
+	}
+	WATCHDOG_g_loaded = TRUE;/*the saved counts are not wanted any more*/
+	WATCHDOG_g_savePending = TRUE;
+}
+
+/*
+ * @brief save the counts when they changed and the EEPROM is free,
+ * it must be called from the main loop.
+ * */
+void WATCHDOG_process(void)
+{
+	uint16 crc = 0;
+	uint8 i = 0;
+
+	if(!WATCHDOG_g_savePending || EEPROM_isBusy())
+	{
+		return;
+	}
+	if(!WATCHDOG_g_loaded && !WATCHDOG_load())
+	{
+		return;
+	}
+	for(i = 0; i < WATCHDOG_CAUSES; i++)
+	{
+		WATCHDOG_g_record[2 * i] = (uint8)WATCHDOG_g_counts[i];
+		WATCHDOG_g_record[(2 * i) + 1] = (uint8)(WATCHDOG_g_counts[i] >> 8);
+	}
+	WATCHDOG_g_record[2 * WATCHDOG_CAUSES] = WATCHDOG_g_causes;
+	crc = CRC16_update(CRC16_INITIAL_VALUE, WATCHDOG_g_record, WATCHDOG_RECORD_SIZE - 2);
+	WATCHDOG_g_record[WATCHDOG_RECORD_SIZE - 2] = (uint8)crc;
+	WATCHDOG_g_record[WATCHDOG_RECORD_SIZE - 1] = (uint8)(crc >> 8);
+	if(EEPROM_writeBlock(WATCHDOG_EEPROM_ADDRESS, WATCHDOG_g_record, WATCHDOG_RECORD_SIZE) == EEPROM_SUCCESS)
+	{
+		WATCHDOG_g_savePending = FALSE;
+	}
+}
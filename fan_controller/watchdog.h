@@ -0,0 +1,113 @@
+/*
+ *
+ * Module: Watchdog
+ *
+ * File Name: watchdog.h
+ *
+ * Description: Header file for the watchdog supervision of the control loop.
+ *
+ * Every stage of the control loop checks in once per pass, the 1ms tick is a stage
+ * too so a stopped timer is caught even though the loop still turns. The hardware
+ * watchdog is only kicked when all the stages checked in since the last kick:
+ *
+ * 	tick ISR | commands | background | sample (ran or not due yet)
+ *
+ * A stage that hangs or stops for WATCHDOG_TIMEOUT resets the MCU.
+ *
+ * The duty applied to the fan is kept with its complement in .noinit, the start up
+ * code does not clear it. After a reset that kept the RAM (watchdog, external or JTAG)
+ * WATCHDOG_getRecoveryDuty gives it back, MAIN_init applies it before the slow LCD
+ * init so the fan does not stop while the firmware starts again.
+ *
+ * The reset causes of MCUCSR are cleared by WATCHDOG_init and counted, the counts
+ * and the causes of the last reset are saved in the background by WATCHDOG_process:
+ *
+ * 	record = power-on(2) | external(2) | brown-out(2) | watchdog(2) | JTAG(2)
+ * 	         | last causes(1) | CRC16(2)
+ *
+ * "get resets" answers them, "set resets clear" sets the counts back to 0.
+ *
+ * EEPROM map:
+ * 	0x290 -> 0x29C	reset causes (this module)
+ *
+ * Layer: Service Layer
+ *
+ * Author: Abdullah Mahmoud
+ *
+ * */
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+#include"std_types.h"
+
+#define WATCHDOG_TIMEOUT			6 /*WDP2:0, 1.0s at 5V*/
+
+/*the causes are counted in the order of their MCUCSR bits*/
+#define WATCHDOG_CAUSE_POWER_ON		0
+#define WATCHDOG_CAUSE_EXTERNAL		1
+#define WATCHDOG_CAUSE_BROWN_OUT	2
+#define WATCHDOG_CAUSE_WATCHDOG		3
+#define WATCHDOG_CAUSE_JTAG			4
+#define WATCHDOG_CAUSES				5
+
+#define WATCHDOG_EEPROM_ADDRESS		0x290
+#define WATCHDOG_RECORD_SIZE		((2 * WATCHDOG_CAUSES) + 1 + 2)
+
+typedef enum
+{
+	WATCHDOG_TASK_TICK, WATCHDOG_TASK_COMMAND, WATCHDOG_TASK_BACKGROUND, WATCHDOG_TASK_SAMPLE,
+	WATCHDOG_TASKS
+}WATCHDOG_TaskType;
+
+/*
+ * @brief count and clear the reset causes and stop the watchdog left running,
+ * it must be called first in MAIN_init
+ * */
+void WATCHDOG_init(void);
+
+/*
+ * @brief start the watchdog and the check in of the tick, at the end of MAIN_init
+ * */
+void WATCHDOG_start(void);
+
+/*
+ * @brief report a healthy stage, the watchdog is kicked when all the stages
+ * reported, it can be called from an ISR
+ * */
+void WATCHDOG_checkIn(WATCHDOG_TaskType a_task);
+
+/*
+ * @brief keep the duty applied to the fan for the next reset
+ * */
+void WATCHDOG_setDuty(uint8 a_duty);
+
+/*
+ * @brief give the duty applied before the last reset
+ *
+ * @return uint8 FALSE after a power-on or a brown-out, or if the RAM lost it
+ * */
+uint8 WATCHDOG_getRecoveryDuty(uint8 * a_duty);
+
+/*
+ * @brief return the MCUCSR causes of the last reset, 1 << WATCHDOG_CAUSE_x
+ * */
+uint8 WATCHDOG_getCauses(void);
+
+/*
+ * @brief return the number of resets of a cause
+ * */
+uint16 WATCHDOG_getCount(uint8 a_cause);
+
+/*
+ * @brief set the counts back to 0, they are saved by WATCHDOG_process
+ * */
+void WATCHDOG_clearCounts(void);
+
+/*
+ * @brief save the counts when they changed and the EEPROM is free,
+ * it must be called from the main loop.
+ * */
+void WATCHDOG_process(void);
+
+#endif /* WATCHDOG_H_ */